@@ -7,8 +7,10 @@
 
 #include <msode/analytic_control/helpers.h>
 #include <msode/analytic_control/optimal_path.h>
+#include <msode/analytic_control/separability.h>
 #include <msode/core/simulation.h>
 
+#include <algorithm>
 #include <iostream>
 #include <random>
 #include <omp.h>
@@ -112,56 +114,45 @@ static real computeConditionNumber(const analytic_control::MatrixReal& V)
 static real computeMeanTimeFromRandomIC(const analytic_control::MatrixReal& V, const std::vector<msode::RigidBody>& bodies)
 {
     const analytic_control::MatrixReal U = V.inverse();
+    const int n = bodies.size();
 
     const real L {50.0_r};
     const real3 boxLo {- 0.5_r * L, 0.0_r, 0.0_r};
     const real3 boxHi {+ 0.5_r * L, 0.0_r, 0.0_r};
-    const real3 direction {1.0_r, 0.0_r, 0.0_r};
 
-    real tSum = 0.0_r;
+    double tSum = 0.0;
     const int nsamples = 50000;
 
-    for (int sample = 0; sample < nsamples; ++sample)
+    // the travel times are computed by batches with one matrix product each
+    const int batchSize = 4096;
+    analytic_control::PositionsMatrix1D X(n, batchSize);
+
+    for (int batchStart = 0; batchStart < nsamples; batchStart += batchSize)
     {
-        const long seed = 242 * sample + 13;
-        const auto initialPositions = analytic_control::generateRandomPositionsBox(bodies.size(), boxLo, boxHi, seed);
-        const auto A = analytic_control::computeA(U, initialPositions);
-        const real t = analytic_control::computeTravelTime(A, direction);
-        tSum += t;
+        const int m = std::min(batchSize, nsamples - batchStart);
+        X.resize(n, m);
+
+        for (int k = 0; k < m; ++k)
+        {
+            const long seed = 242 * (batchStart + k) + 13;
+            const auto initialPositions = analytic_control::generateRandomPositionsBox(n, boxLo, boxHi, seed);
+
+            for (int i = 0; i < n; ++i)
+                X(i, k) = initialPositions[i].x;
+        }
+
+        tSum += analytic_control::computeTravelTimes1D(U, X).sum();
     }
 
-    const real tMean = tSum / nsamples;
+    const real tMean = static_cast<real>(tSum / nsamples);
     return tMean;
 }
 
-static real computeMeanTimeFromTestIC(const analytic_control::MatrixReal& V, const std::vector<msode::RigidBody>& bodies)
+static real computeMeanTimeFromTestIC(const analytic_control::MatrixReal& V)
 {
     const analytic_control::MatrixReal U = V.inverse();
-    const int n = bodies.size();
-    MSODE_Ensure(n < 8*sizeof(int), "must use less than 32 bodies");
-
     const real L {50.0_r};
-    const real3 direction {1.0_r, 0.0_r, 0.0_r};
-
-    real tSum = 0.0_r;
-
-    const int nsamples = 1<<n;
-    std::vector<real3> initialPositions(n);
-
-    for (int sample = 0; sample < nsamples; ++sample)
-    {
-        for (int i = 0; i < n; ++i)
-        {
-            const int isRight = ( sample & (1<<i) ) >> i;
-            initialPositions[i] = isRight ? real3 {L, 0.0_r, 0.0_r} : real3 {-L, 0.0_r, 0.0_r};
-        }
-        const auto A = analytic_control::computeA(U, initialPositions);
-        const real t = analytic_control::computeTravelTime(A, direction);
-        tSum += t;
-    }
-
-    const real tMean = tSum / nsamples;
-    return tMean;
+    return analytic_control::computeMeanTravelTimeCorners1D(U, L);
 }
 
 
@@ -206,7 +197,7 @@ int main(int argc, char **argv)
             const real S = computeSeparability(V);
             const real l = computeLambdaRatio(V);
             const real k = computeConditionNumber(V);
-            const real T = computeMeanTimeFromTestIC(V, bodies);
+            const real T = computeMeanTimeFromTestIC(V);
 
             times  [sSample] = T;
             seps   [sSample] = S;
@@ -2,27 +2,81 @@
 /** ac_stats
 
     Compute mean travel time of multiple swimmers from a random position in a box to the origin.
+    With --execute, the path is also executed with the hybrid analytical/ODE method and the largest
+    final distance to the origin is reported.
+
+    The samples are processed in parallel; each result is written as soon as all the previous samples are
+    done, so the output is in sample order and does not depend on the number of threads. The running mean
+    and its confidence interval are reported periodically. With --ci <half width>, the sampling stops as soon as the 95% confidence interval
+    of the mean time is narrower than the given half width.
  */
 
 #include <msode/analytic_control/optimal_path.h>
 #include <msode/analytic_control/apply_strategy.h>
+#include <msode/core/velocity_field/none.h>
+#include <msode/utils/running_stats.h>
+#include <msode/utils/ordered_async_pool.h>
 
+#include <algorithm>
 #include <iostream>
 
+using namespace msode;
+
+/// The quantities computed for one sample
+struct SampleResult
+{
+    std::vector<real3> initialPositions;
+    real time;
+    real finalDistance; ///< only relevant if the path is executed
+};
+
+static void usage(const char *name)
+{
+    fprintf(stderr, "usage : %s [--execute] [--threads <n>] [--ci <half width>] <nsamples> <outfile> <swimmer0.json> <swimmer1.json>... \n\n", name);
+}
+
 int main(int argc, char **argv)
 {
-    using namespace msode;
+    bool execute {false};
+    int numThreads {0};
+    double targetHalfWidth {0.0};
+
+    int argStart = 1;
+    for (; argStart < argc; ++argStart)
+    {
+        const std::string arg = argv[argStart];
+
+        if (arg == "-h" || arg == "--help")
+        {
+            usage(argv[0]);
+            return 1;
+        }
+        else if (arg == "--execute")
+        {
+            execute = true;
+        }
+        else if (arg == "--threads" && argStart + 1 < argc)
+        {
+            numThreads = atoi(argv[++argStart]);
+        }
+        else if (arg == "--ci" && argStart + 1 < argc)
+        {
+            targetHalfWidth = atof(argv[++argStart]);
+        }
+        else
+        {
+            break;
+        }
+    }
 
-    if (argc < 4                     ||
-        std::string(argv[1]) == "-h" ||
-        std::string(argv[1]) == "--help")
+    if (argc < argStart + 3)
     {
-        fprintf(stderr, "usage : %s <nsamples> <outfile> <swimmer0.json> <swimmer1.json>... \n\n", argv[0]);
+        usage(argv[0]);
         return 1;
     }
 
-    const int nsamples = atoi(argv[1]);
-    const char *outFilename = argv[2];
+    const int nsamples = atoi(argv[argStart]);
+    const char *outFilename = argv[argStart + 1];
 
     const real magneticFieldMagnitude = 1.0_r;
 
@@ -30,7 +84,7 @@ int main(int argc, char **argv)
     const real3 boxHi{+50.0_r, +50.0_r, +50.0_r};
 
     std::vector<RigidBody> bodies;
-    for (int i = 3; i < argc; ++i)
+    for (int i = argStart + 2; i < argc; ++i)
     {
         const auto body = factory::readRigidBodyConfigFromFile(argv[i]);
         bodies.push_back(body);
@@ -39,26 +93,98 @@ int main(int argc, char **argv)
     const analytic_control::MatrixReal V = analytic_control::createVelocityMatrix(magneticFieldMagnitude, bodies);
     const analytic_control::MatrixReal U = V.inverse();
 
-    real tSum = 0.0_r;
-
-    FILE *fout = fopen(outFilename, "w");
-    for (int sample = 0; sample < nsamples; ++sample)
+    auto computeSample = [&](int sample)
     {
+        SampleResult result;
         const long seed = 242 * sample + 13;
         const bool includeReorient {true};
-        auto initialPositions = analytic_control::generateRandomPositionsBox(bodies.size(), boxLo, boxHi, seed);
-        const real t = analytic_control::computeRequiredTime(magneticFieldMagnitude, bodies, initialPositions, U, includeReorient);
-        tSum += t;
+        result.initialPositions = analytic_control::generateRandomPositionsBox(bodies.size(), boxLo, boxHi, seed);
+        result.finalDistance = 0.0_r;
+
+        if (execute)
+        {
+            // the execution plans the path: report the time of the executed plan instead of optimizing it again
+            const int numQuadraturePoints = 0; // no background flow
+            const auto execution = analytic_control::executeOptimalPathHybrid(magneticFieldMagnitude, bodies, result.initialPositions,
+                                                                              std::make_unique<VelocityFieldNone>(), U,
+                                                                              numQuadraturePoints);
+            result.time = execution.requiredTime;
+            for (auto r : execution.finalPositions)
+                result.finalDistance = std::max(result.finalDistance, length(r));
+        }
+        else
+        {
+            result.time = analytic_control::computeRequiredTime(magneticFieldMagnitude, bodies, result.initialPositions, U, includeReorient);
+        }
+        return result;
+    };
+
+    // the CI is not trusted below this number of samples
+    constexpr long minSamplesEarlyStop = 30;
+
+    utils::OrderedAsyncPool<SampleResult> pool(numThreads);
+    utils::RunningStats timeStats, distanceStats;
+
+    // bound the number of samples in flight so that an early stop does not leave much work behind
+    const int maxInFlight = 4 * pool.getNumThreads();
+    const long reportEvery = 16 * pool.getNumThreads();
 
-        for (auto r : initialPositions)
+    FILE *fout = fopen(outFilename, "w");
+    if (fout == nullptr)
+        msode_die("Could not open the file '%s'", outFilename);
+
+    auto report = [&]()
+    {
+        fflush(fout);
+        printf("%ld samples: mean time %g, std %g, 95%% CI +- %g\n",
+               timeStats.getCount(), timeStats.getMean(),
+               std::sqrt(timeStats.getVariance()), timeStats.getConfidenceHalfWidth());
+        fflush(stdout);
+    };
+
+    int numSubmitted {0};
+    bool converged {false};
+    SampleResult result;
+
+    while (!converged && timeStats.getCount() < nsamples)
+    {
+        for (; numSubmitted < nsamples && pool.getNumPending() < maxInFlight; ++numSubmitted)
+        {
+            const int sample = numSubmitted;
+            pool.submit([&computeSample, sample]() {return computeSample(sample);});
+        }
+
+        pool.pop(result);
+
+        for (auto r : result.initialPositions)
             fprintf(fout, "%g ", length(r));
-        fprintf(fout, "%g\n", t);
+        fprintf(fout, "%g", result.time);
+
+        timeStats.add(result.time);
+
+        if (execute)
+        {
+            distanceStats.add(result.finalDistance);
+            fprintf(fout, " %g", result.finalDistance);
+        }
+        fprintf(fout, "\n");
+
+        converged = targetHalfWidth > 0.0 &&
+            timeStats.getCount() >= minSamplesEarlyStop &&
+            timeStats.getConfidenceHalfWidth() <= targetHalfWidth;
+
+        if (converged || timeStats.getCount() % reportEvery == 0 || timeStats.getCount() == nsamples)
+            report();
     }
     fclose(fout);
 
-    const real tMean = tSum / nsamples;
+    if (converged)
+        printf("Reached the target confidence interval after %ld samples\n", timeStats.getCount());
+
+    printf("Average time %g\n", timeStats.getMean());
 
-    printf("Average time %g\n", tMean);
+    if (execute)
+        printf("Average final distance %g\n", distanceStats.getMean());
 
     return 0;
 }
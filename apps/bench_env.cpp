@@ -0,0 +1,275 @@
+// Copyright 2020 ETH Zurich. All Rights Reserved.
+/** bench_env
+
+    Measure the throughput of the RL environments built from the given configs (e.g. launch_scripts/rl/config),
+    driven by built-in policies instead of a learning framework:
+    - random: uniform actions within the action bounds
+    - constant: the middle of the action bounds
+    - ac: feedback policy derived from the analytic control (requires the "Direct" field action)
+
+    The time spent in each component of the environment loop (reset, policy, physics, state, reward) is measured
+    separately. The results are written in json format to the standard output.
+ */
+
+#include <msode/core/log.h>
+#include <msode/rl/factory.h>
+#include <msode/rl/policies/factory.h>
+
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+using namespace msode;
+
+using Clock = std::chrono::steady_clock;
+
+namespace {
+
+/// Time spent in each component of the environment loop, in seconds
+struct ComponentTimes
+{
+    double reset  {0.0};
+    double policy {0.0};
+    double physics{0.0};
+    double state  {0.0};
+    double reward {0.0};
+};
+
+struct BenchResult
+{
+    long numEpisodes  {0};
+    long numTruncated {0}; ///< episodes that reached the maximum number of actions
+    long numSuccesses {0};
+    long numActions   {0};
+    long numSteps     {0};
+    ComponentTimes times;
+};
+
+} // anonymous namespace
+
+static void usage(const char *name)
+{
+    fprintf(stderr, "usage : %s [--episodes <n>] [--max-actions <n>] [--policies <p1,p2...>] [--seed <s>] <config0.json> <config1.json>...\n"
+            "        policies: random, constant, ac (default: all)\n\n", name);
+}
+
+static double elapsedSince(Clock::time_point start)
+{
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+static std::vector<std::string> split(const std::string& s, char delimiter)
+{
+    std::vector<std::string> tokens;
+    std::istringstream stream(s);
+    std::string token;
+
+    while (std::getline(stream, token, delimiter))
+        tokens.push_back(token);
+
+    return tokens;
+}
+
+/// json config of the policy with the given short name, to be passed to rl::factory::createPolicy()
+static Config createPolicyConfig(const std::string& name, const rl::MSodeEnvironment& env, long seed)
+{
+    if (name == "random")
+        return {{"__type", "Random"}, {"seed", seed}};
+
+    if (name == "constant")
+    {
+        std::vector<double> lo, hi;
+        std::tie(lo, hi) = env.getActionBounds();
+
+        std::vector<double> action(lo.size());
+        for (size_t i = 0; i < action.size(); ++i)
+            action[i] = 0.5 * (lo[i] + hi[i]);
+
+        return {{"__type", "Constant"}, {"action", action}};
+    }
+
+    if (name == "ac")
+        return {{"__type", "AnalyticControl"}};
+
+    msode_die("Unknown policy '%s'", name.c_str());
+    return {};
+}
+
+static BenchResult runBenchmark(rl::MSodeEnvironment& env, rl::Policy& policy,
+                                long numEpisodes, long maxActions, long seed)
+{
+    using Status = rl::MSodeEnvironment::Status;
+
+    BenchResult result;
+    ComponentTimes& times = result.times;
+    std::vector<double> action(env.numActions());
+
+    for (long episodeId = 0; episodeId < numEpisodes; ++episodeId)
+    {
+        std::seed_seq seq {seed, episodeId};
+        std::mt19937 gen(seq);
+
+        auto start = Clock::now();
+        const bool successfulPreviousTry {true};
+        env.reset(gen, rl::MSodeEnvironment::NO_DUMP, successfulPreviousTry);
+        env.sim->setNoiseSeed(gen());
+        times.reset += elapsedSince(start);
+
+        start = Clock::now();
+        policy.reset(env, episodeId);
+        times.policy += elapsedSince(start);
+
+        start = Clock::now();
+        const std::vector<double>* state = &env.getState();
+        times.state += elapsedSince(start);
+
+        Status status {Status::Running};
+        long actionId {0};
+
+        for (; status == Status::Running && (maxActions <= 0 || actionId < maxActions); ++actionId)
+        {
+            start = Clock::now();
+            policy.computeAction(env, *state, action);
+            times.policy += elapsedSince(start);
+
+            start = Clock::now();
+            status = env.advance(action);
+            times.physics += elapsedSince(start);
+
+            start = Clock::now();
+            state = &env.getState();
+            times.state += elapsedSince(start);
+
+            start = Clock::now();
+            env.getReward();
+            times.reward += elapsedSince(start);
+        }
+
+        ++result.numEpisodes;
+        result.numActions += actionId;
+        result.numSteps   += env.sim->getCurrentTimeStep();
+
+        if (status == Status::Running)
+            ++result.numTruncated;
+        else if (status == Status::Success)
+            ++result.numSuccesses;
+    }
+
+    return result;
+}
+
+static Config componentToJson(double seconds, const BenchResult& r)
+{
+    Config c;
+    c["seconds"]        = seconds;
+    c["steps_per_s"]    = r.numSteps    / seconds;
+    c["actions_per_s"]  = r.numActions  / seconds;
+    c["episodes_per_s"] = r.numEpisodes / seconds;
+    return c;
+}
+
+static Config toJson(const std::string& policyName, const BenchResult& r)
+{
+    const ComponentTimes& t = r.times;
+    const double total = t.reset + t.policy + t.physics + t.state + t.reward;
+
+    Config c;
+    c["policy"]    = policyName;
+    c["episodes"]  = r.numEpisodes;
+    c["truncated"] = r.numTruncated;
+    c["successes"] = r.numSuccesses;
+    c["actions"]   = r.numActions;
+    c["steps"]     = r.numSteps;
+
+    c["components"]["reset"]   = componentToJson(t.reset,   r);
+    c["components"]["policy"]  = componentToJson(t.policy,  r);
+    c["components"]["physics"] = componentToJson(t.physics, r);
+    c["components"]["state"]   = componentToJson(t.state,   r);
+    c["components"]["reward"]  = componentToJson(t.reward,  r);
+    c["components"]["total"]   = componentToJson(total,     r);
+    return c;
+}
+
+int main(int argc, char **argv)
+{
+    long numEpisodes {20};
+    long maxActions {0};
+    long seed {424242};
+    std::vector<std::string> policyNames {"random", "constant", "ac"};
+
+    int argStart = 1;
+    for (; argStart < argc; ++argStart)
+    {
+        const std::string arg = argv[argStart];
+
+        if (arg == "-h" || arg == "--help")
+        {
+            usage(argv[0]);
+            return 1;
+        }
+        else if (arg == "--episodes" && argStart + 1 < argc)
+        {
+            numEpisodes = atol(argv[++argStart]);
+        }
+        else if (arg == "--max-actions" && argStart + 1 < argc)
+        {
+            maxActions = atol(argv[++argStart]);
+        }
+        else if (arg == "--policies" && argStart + 1 < argc)
+        {
+            policyNames = split(argv[++argStart], ',');
+        }
+        else if (arg == "--seed" && argStart + 1 < argc)
+        {
+            seed = atol(argv[++argStart]);
+        }
+        else
+        {
+            break;
+        }
+    }
+
+    if (argStart >= argc)
+    {
+        usage(argv[0]);
+        return 1;
+    }
+
+    Config output;
+    output["episodes"]    = numEpisodes;
+    output["max_actions"] = maxActions;
+    output["seed"]        = seed;
+    output["configs"]     = Config::array();
+
+    for (int i = argStart; i < argc; ++i)
+    {
+        std::ifstream confFile(argv[i]);
+
+        if (!confFile.is_open())
+            msode_die("Could not open the config file '%s'", argv[i]);
+
+        Config config = json::parse(confFile);
+        config["dumpEvery"] = 0; // the benchmark must not write trajectories
+
+        auto env = rl::factory::createEnvironment(config, ConfPointer(""));
+
+        Config configOutput;
+        configOutput["config"]   = argv[i];
+        configOutput["bodies"]   = env->getBodies().size();
+        configOutput["policies"] = Config::array();
+
+        for (const auto& name : policyNames)
+        {
+            auto policy = rl::factory::createPolicy(createPolicyConfig(name, *env, seed));
+            const auto result = runBenchmark(*env, *policy, numEpisodes, maxActions, seed);
+            configOutput["policies"].push_back(toJson(name, result));
+        }
+
+        output["configs"].push_back(configOutput);
+    }
+
+    std::cout << output.dump(4) << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,88 @@
+// Copyright 2020 ETH Zurich. All Rights Reserved.
+/** bench_rewards
+
+    Measure the number of rewards (distances to the targets) that can be computed per second
+    for the bodies of the given config, at random positions in a box of half size L.
+ */
+
+#include <msode/analytic_control/helpers.h>
+#include <msode/rl/target_distances/euclidean_tt.h>
+#include <msode/rl/target_distances/travel_time.h>
+
+#include <chrono>
+#include <iostream>
+
+using namespace msode;
+
+static std::vector<RigidBody> readBodies(const Config& config)
+{
+    if (!config.is_array())
+        msode_die("Expected an array of bodies in config");
+
+    std::vector<RigidBody> bodies;
+
+    for (const auto& c : config)
+        bodies.push_back(msode::factory::readRigidBodyFromConfig(c));
+
+    return bodies;
+}
+
+static void benchmark(const std::string& name, const rl::TargetDistance& distance,
+                      std::vector<RigidBody> bodies, real L, long numRewards)
+{
+    const real3 boxLo{-L, -L, -L};
+    const real3 boxHi{+L, +L, +L};
+    const long seed = 42424242;
+    const auto positions = analytic_control::generateRandomPositionsBox(static_cast<int>(numRewards * bodies.size()), boxLo, boxHi, seed);
+
+    // initialization (velocity matrix) is not part of the measurements
+    distance.compute(bodies);
+
+    real checksum {0.0_r};
+    const auto start = std::chrono::steady_clock::now();
+
+    for (long i = 0; i < numRewards; ++i)
+    {
+        for (size_t j = 0; j < bodies.size(); ++j)
+            bodies[j].r = positions[i * bodies.size() + j];
+
+        checksum += distance.compute(bodies);
+    }
+
+    const auto end = std::chrono::steady_clock::now();
+    const double elapsed = std::chrono::duration<double>(end - start).count();
+
+    std::cout << name << " : " << numRewards / elapsed << " rewards/s"
+              << " (checksum " << checksum << ")" << std::endl;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc != 4                    ||
+        std::string(argv[1]) == "-h" ||
+        std::string(argv[1]) == "--help")
+    {
+        fprintf(stderr, "usage : %s <config.json> <L> <numRewards>\n\n", argv[0]);
+        return 1;
+    }
+
+    std::ifstream confFile(argv[1]);
+    const real L = static_cast<real>(std::atof(argv[2]));
+    const long numRewards = std::atol(argv[3]);
+
+    if (!confFile.is_open())
+        msode_die("Could not open the config file '%s'", argv[1]);
+
+    const Config config = json::parse(confFile);
+
+    const real magneticFieldMagnitude = config.at("fieldMagnitude");
+    const auto bodies = readBodies(config.at("bodies"));
+
+    std::cout << bodies.size() << " bodies" << std::endl;
+
+    // the travel time runs an optimization per reward; use fewer samples
+    benchmark("travel_time ", rl::TargetDistanceTravelTime (magneticFieldMagnitude), bodies, L, std::max(1L, numRewards / 10000));
+    benchmark("euclidean_tt", rl::TargetDistanceEuclideanTT(magneticFieldMagnitude), bodies, L, numRewards);
+
+    return 0;
+}
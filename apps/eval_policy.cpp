@@ -0,0 +1,171 @@
+// Copyright 2020 ETH Zurich. All Rights Reserved.
+/** eval_policy
+
+    Evaluate an exported MLP policy (see rl::readMLPFromConfig()) on many episodes, without smarties.
+    The environments are advanced in lock step so that the network is evaluated on batches of states.
+
+    The output has the same format as `run_rl_comp`: one line per episode, in episode order, with
+    simId timeAC timeRL maxDistance initDistance
+    With --no-ac, the analytic control is not simulated and timeAC is reported as 0.
+ */
+
+#include <msode/analytic_control/apply_strategy.h>
+#include <msode/analytic_control/optimal_path.h>
+#include <msode/core/log.h>
+#include <msode/core/velocity_field/factory.h>
+#include <msode/rl/episode_runner.h>
+#include <msode/rl/factory.h>
+#include <msode/rl/policies/mlp.h>
+#include <msode/utils/thread_pool.h>
+
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <sstream>
+
+using namespace msode;
+
+static inline std::string generateACfname(long simId)
+{
+    std::ostringstream ss;
+    ss << std::setw(6) << std::setfill('0') << simId;
+    return "ac_trajectories_" + ss.str() + ".dat";
+}
+
+static inline std::vector<real3> extractPositions(const std::vector<RigidBody>& bodies)
+{
+    std::vector<real3> positions;
+    positions.reserve(bodies.size());
+
+    for (const auto& b : bodies)
+        positions.push_back(b.r);
+
+    return positions;
+}
+
+static real computeMinDistance(const std::vector<RigidBody>& bodies)
+{
+    real minDistance = std::numeric_limits<real>::max();
+    for (const auto& b : bodies)
+        minDistance = std::min(minDistance, length(b.r));
+    return minDistance;
+}
+
+static void usage(const char *name)
+{
+    fprintf(stderr, "usage : %s [--envs <n>] [--threads <n>] [--seed <s>] [--no-ac] <config.json> <policy.json> <numEpisodes>\n\n", name);
+}
+
+int main(int argc, char **argv)
+{
+    int numEnvironments {256};
+    int numThreads {0};
+    long seed {424242};
+    bool runAC {true};
+
+    int argStart = 1;
+    for (; argStart < argc; ++argStart)
+    {
+        const std::string arg = argv[argStart];
+
+        if (arg == "-h" || arg == "--help")
+        {
+            usage(argv[0]);
+            return 1;
+        }
+        else if (arg == "--envs" && argStart + 1 < argc)
+        {
+            numEnvironments = atoi(argv[++argStart]);
+        }
+        else if (arg == "--threads" && argStart + 1 < argc)
+        {
+            numThreads = atoi(argv[++argStart]);
+        }
+        else if (arg == "--seed" && argStart + 1 < argc)
+        {
+            seed = atol(argv[++argStart]);
+        }
+        else if (arg == "--no-ac")
+        {
+            runAC = false;
+        }
+        else
+        {
+            break;
+        }
+    }
+
+    if (argc != argStart + 3)
+    {
+        usage(argv[0]);
+        return 1;
+    }
+
+    std::ifstream confFile(argv[argStart]);
+
+    if (!confFile.is_open())
+        msode_die("Could not open the config file '%s'", argv[argStart]);
+
+    const Config config = json::parse(confFile);
+    const rl::MLP mlp = rl::readMLPFromFile(argv[argStart + 1]);
+    const long numEpisodes = atol(argv[argStart + 2]);
+
+    const real magneticFieldMagnitude = config.at("fieldMagnitude").get<real>();
+    const long dumpEvery = config.at("dumpEvery").get<long>();
+
+    rl::BatchEpisodeRunner runner([&config]() {return rl::factory::createEnvironment(config, ConfPointer(""));},
+                                  numEnvironments, numThreads, seed);
+
+    {
+        const auto env = runner.getEnvironment(0);
+        MSODE_Expect(mlp.getNumInputs() == static_cast<int>(env->getState().size()),
+                     "the network has %d inputs but the state has %zu variables",
+                     mlp.getNumInputs(), env->getState().size());
+        MSODE_Expect(mlp.getNumOutputs() == env->numActions(),
+                     "the network has %d outputs but the environment has %d actions",
+                     mlp.getNumOutputs(), env->numActions());
+    }
+
+    std::vector<rl::MLP::Workspace> workspaces(runner.getNumThreads());
+    std::vector<std::vector<RigidBody>> initialBodies(numEpisodes);
+
+    auto policy = [&](int workerId, long n, const double *states, double *actions)
+    {
+        mlp.forward(n, states, actions, workspaces[workerId]);
+    };
+
+    auto onEpisodeStart = [&](long episodeId, const rl::MSodeEnvironment& env)
+    {
+        initialBodies[episodeId] = env.getBodies();
+    };
+
+    const auto results = runner.run(numEpisodes, policy, 0, onEpisodeStart);
+
+    std::vector<real> timesAC(numEpisodes, 0.0_r);
+
+    if (runAC && numEpisodes > 0)
+    {
+        const auto V = analytic_control::createVelocityMatrix(magneticFieldMagnitude, initialBodies[0]);
+        const analytic_control::MatrixReal U = V.inverse();
+
+        utils::ThreadPool pool(numThreads);
+        pool.run(numEpisodes, [&](long simId, int)
+        {
+            const auto& bodies = initialBodies[simId];
+            auto velocityField = factory::createVelocityField(config, ConfPointer("/velocityField"));
+            timesAC[simId] = analytic_control::simulateOptimalPath(magneticFieldMagnitude, bodies, extractPositions(bodies),
+                                                                   std::move(velocityField), U, generateACfname(simId), dumpEvery);
+        });
+    }
+
+    for (long simId = 0; simId < numEpisodes; ++simId)
+    {
+        const auto& r = results[simId];
+        std::cout << simId << " " << timesAC[simId] << " " << r.time << " "
+                  << r.finalMaxDistance << " " << computeMinDistance(initialBodies[simId]) << "\n";
+    }
+    std::cout << std::flush;
+
+    return 0;
+}
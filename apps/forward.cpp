@@ -2,11 +2,16 @@
 /** forward
 
     ABF in a field rotating with frequency `omega` in the yz plane.
+    If a checkpoint file is given, the state is saved to it every 10 minutes of wall time,
+    and the run resumes from that file if it exists. The resumed run must write the same trajectory file.
  */
 
 #include <msode/core/simulation.h>
 #include <msode/core/factory.h>
+#include <msode/core/checkpoint.h>
+#include <msode/core/log.h>
 
+#include <fstream>
 #include <iostream>
 
 using namespace msode;
@@ -14,7 +19,9 @@ using namespace msode;
 constexpr real magneticFieldMagnitude {1.0_r};
 constexpr real dt {1e-3_r};
 
-static void runAndDump(RigidBody body, real omega, const std::string& out, int dumpEvery)
+constexpr double checkpointEvery {600.0}; // seconds of wall time
+
+static void runAndDump(RigidBody body, real omega, const std::string& out, int dumpEvery, const std::string& checkpoint)
 {
     const int nRevolutions = 25;
     const real tEnd = nRevolutions * 2 * M_PI / omega;
@@ -31,15 +38,29 @@ static void runAndDump(RigidBody body, real omega, const std::string& out, int d
     const std::vector<RigidBody> rigidBodies {body};
     Simulation simulation {rigidBodies, magneticField, kBT};
 
-    simulation.activateDump(out, dumpEvery);
-    simulation.runForwardEuler(nsteps, dt);
+    if (!checkpoint.empty() && std::ifstream(checkpoint).good())
+    {
+        const std::string dumpFileName = readCheckpoint(checkpoint).dumpFileName;
+        if (dumpFileName != out)
+            msode_die("The checkpoint '%s' continues the trajectory '%s', not '%s'",
+                      checkpoint.c_str(), dumpFileName.c_str(), out.c_str());
+        simulation.restartFromCheckpoint(checkpoint);
+    }
+    else
+        simulation.activateDump(out, dumpEvery);
+
+    if (!checkpoint.empty())
+        simulation.activateCheckpoint(checkpoint, checkpointEvery);
+
+    if (simulation.getCurrentTimeStep() < nsteps)
+        simulation.runForwardEuler(nsteps - simulation.getCurrentTimeStep(), dt);
 }
 
 int main(int argc, char **argv)
 {
-    if (argc != 5)
+    if (argc != 5 && argc != 6)
     {
-        fprintf(stderr, "usage : %s <swimmer.json> <omega> <fps> <trajectory_file> \n\n", argv[0]);
+        fprintf(stderr, "usage : %s <swimmer.json> <omega> <fps> <trajectory_file> [checkpoint_file]\n\n", argv[0]);
         return 1;
     }
 
@@ -47,11 +68,12 @@ int main(int argc, char **argv)
     const real omega   = static_cast<real>(std::stod(argv[2]));
     const int fps      = std::stoi(argv[3]);
     const std::string out (argv[4]);
+    const std::string checkpoint (argc == 6 ? argv[5] : "");
 
     const real tDumpEvery = 1.0_r / fps;
     const int dumpEvery = static_cast<int>(tDumpEvery / dt);
 
-    runAndDump(body, omega, out, dumpEvery);
+    runAndDump(body, omega, out, dumpEvery, checkpoint);
 
     return 0;
 }
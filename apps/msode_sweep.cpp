@@ -0,0 +1,181 @@
+// Copyright 2020 ETH Zurich. All Rights Reserved.
+/** msode_sweep
+
+    Evaluate a policy on a grid of variants of an environment config (see ParameterGrid for the format of the grid),
+    e.g. to measure the robustness of a trained policy to perturbations of the background flow:
+    \code
+    {"parameters": [{"pointer": "/velocityField/fields/1/magnitude", "factors": [0.0, 0.5, 1.0]},
+                    {"pointer": "/velocityField/fields/1/invPeriod", "factors": [0.5, 1.0, 2.0]}]}
+    \endcode
+    The variants are built in memory and all (variant x episode) tasks are scheduled on a single thread pool
+    (see rl::runSweep()).
+    The policy is given by a json config passed to rl::factory::createPolicy(), e.g. {"__type": "MLP", "file": "policy.json"};
+    by default, the feedback policy derived from the analytic control is used.
+    Unless --no-ac is passed, the travel time of the analytic control from the same initial conditions is also computed.
+    No trajectories are written.
+
+    The results are written as a csv table with one row per (variant, episode), in this order.
+    The parameter columns contain the value of the parameter, or its factor for parameters given by factors.
+ */
+
+#include <msode/core/log.h>
+#include <msode/core/parameter_grid.h>
+#include <msode/rl/policies/factory.h>
+#include <msode/rl/sweep.h>
+
+#include <fstream>
+#include <iostream>
+
+using namespace msode;
+
+static void usage(const char *name)
+{
+    fprintf(stderr, "usage : %s [--episodes <n>] [--threads <n>] [--seed <s>] [--policy <policy.json>] [--no-ac] [--out <results.csv>]"
+            " <config.json> <sweep.json>\n\n", name);
+}
+
+static Config readConfig(const std::string& fileName)
+{
+    std::ifstream file(fileName);
+
+    if (!file.is_open())
+        msode_die("Could not open the config file '%s'", fileName.c_str());
+
+    return json::parse(file);
+}
+
+static const char* statusToString(rl::MSodeEnvironment::Status status)
+{
+    using Status = rl::MSodeEnvironment::Status;
+
+    switch (status)
+    {
+    case Status::Running:         return "Running";
+    case Status::MaxTimeEllapsed: return "MaxTimeEllapsed";
+    case Status::Success:         return "Success";
+    };
+    return "Unknown";
+}
+
+/// quote a csv field if needed
+static std::string toCsvField(const std::string& s)
+{
+    if (s.find_first_of(",\"\n") == std::string::npos)
+        return s;
+
+    std::string quoted = "\"";
+    for (char c : s)
+    {
+        if (c == '"')
+            quoted += '"';
+        quoted += c;
+    }
+    return quoted + "\"";
+}
+
+static void writeResults(std::ostream& stream, const ParameterGrid& grid, long numEpisodes,
+                         const std::vector<rl::SweepResult>& results)
+{
+    const auto& parameters = grid.getParameters();
+
+    stream << "variant";
+    for (const auto& p : parameters)
+        stream << "," << toCsvField(p.pointer.to_string());
+    stream << ",episode,status,time_rl,time_ac,num_actions,total_reward,initial_max_distance,final_max_distance\n";
+
+    for (long variantId = 0; variantId < grid.getNumVariants(); ++variantId)
+    {
+        const auto indices = grid.getValueIndices(variantId);
+
+        std::string parameterFields;
+        for (size_t i = 0; i < parameters.size(); ++i)
+            parameterFields += "," + toCsvField(parameters[i].values[indices[i]].dump());
+
+        for (long episodeId = 0; episodeId < numEpisodes; ++episodeId)
+        {
+            const rl::SweepResult& r = results[variantId * numEpisodes + episodeId];
+
+            stream << variantId << parameterFields << ","
+                   << episodeId << ","
+                   << statusToString(r.rl.status) << ","
+                   << r.rl.time << ","
+                   << r.timeAC << ","
+                   << r.rl.numActions << ","
+                   << r.rl.totalReward << ","
+                   << r.rl.initialMaxDistance << ","
+                   << r.rl.finalMaxDistance << "\n";
+        }
+    }
+}
+
+int main(int argc, char **argv)
+{
+    long numEpisodes {100};
+    int numThreads {0};
+    long seed {424242};
+    bool runAC {true};
+    std::string policyFileName;
+    std::string outFileName {"sweep.csv"};
+
+    int argStart = 1;
+    for (; argStart < argc; ++argStart)
+    {
+        const std::string arg = argv[argStart];
+
+        if (arg == "-h" || arg == "--help")
+        {
+            usage(argv[0]);
+            return 1;
+        }
+        else if (arg == "--episodes" && argStart + 1 < argc)
+        {
+            numEpisodes = atol(argv[++argStart]);
+        }
+        else if (arg == "--threads" && argStart + 1 < argc)
+        {
+            numThreads = atoi(argv[++argStart]);
+        }
+        else if (arg == "--seed" && argStart + 1 < argc)
+        {
+            seed = atol(argv[++argStart]);
+        }
+        else if (arg == "--policy" && argStart + 1 < argc)
+        {
+            policyFileName = argv[++argStart];
+        }
+        else if (arg == "--no-ac")
+        {
+            runAC = false;
+        }
+        else if (arg == "--out" && argStart + 1 < argc)
+        {
+            outFileName = argv[++argStart];
+        }
+        else
+        {
+            break;
+        }
+    }
+
+    if (argc != argStart + 2)
+    {
+        usage(argv[0]);
+        return 1;
+    }
+
+    const Config baseConfig = readConfig(argv[argStart]);
+    const ParameterGrid grid(readConfig(argv[argStart + 1]));
+    const Config policyConfig = policyFileName.empty() ? Config{{"__type", "AnalyticControl"}} : readConfig(policyFileName);
+
+    const auto policy = rl::factory::createPolicy(policyConfig);
+    const auto results = rl::runSweep(baseConfig, grid, numEpisodes, *policy, runAC, numThreads, seed);
+
+    std::ofstream out(outFileName);
+
+    if (!out.is_open())
+        msode_die("Could not open the output file '%s'", outFileName.c_str());
+
+    writeResults(out, grid, numEpisodes, results);
+
+    return 0;
+}
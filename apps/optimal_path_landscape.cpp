@@ -3,8 +3,11 @@
 
     A tool to visualize the function to optimize in the analytical control setup.
     It corresponds to the travel time with respect to 3 given angles.
+    The landscape is evaluated on a coarse grid and refined adaptively near its kinks and local minima.
+    The local minima and the size of their basins of attraction are listed in a separate file.
  */
 #include <msode/analytic_control/helpers.h>
+#include <msode/analytic_control/landscape.h>
 #include <msode/analytic_control/optimal_path.h>
 
 #include <iostream>
@@ -52,32 +55,61 @@ static std::vector<real3> createIC(const std::string& mode, int n)
     return {};
 }
 
-static inline Quaternion quaternionFromAngles(real theta, real phi, real psi)
+static void usage(const char *name)
 {
-    const real3 normal {std::cos(theta) * std::sin(phi),
-                        std::sin(theta) * std::sin(phi),
-                        std::cos(phi)};
-
-    const auto q = Quaternion::createFromRotation(psi, normal);
-    return q.normalized();
+    fprintf(stderr,
+            "usage : %s <config.json> <initial conditions> [options]\n"
+            "where:\n"
+            "\t<config.json> contains the list of bodies\n"
+            "\t<initial conditions> is either \"random\" or \"aligned\"\n"
+            "options:\n"
+            "\t--res <n>        resolution of the coarse grid (default: 32)\n"
+            "\t--refine <n>     refinement factor near kinks and minima (default: 4)\n"
+            "\t--threads <n>    number of threads (default: all hardware threads)\n"
+            "\t--out <file>     output binary vtk file (default: out.vtk)\n"
+            "\t--minima <file>  output list of local minima (default: minima.txt)\n"
+            "\n",
+            name);
 }
 
 int main(int argc, char **argv)
 {
-    if (argc != 3                    ||
+    if (argc < 3                     ||
         std::string(argv[1]) == "-h" ||
         std::string(argv[1]) == "--help")
     {
-        fprintf(stderr,
-                "usage : %s <config.json> <initial conditions>\n"
-                "where:\n"
-                "\t<config.json> contains the list of bodies\n"
-                "\t<initial conditions> is either \"random\" or \"aligned\"\n"
-                "\n",
-                argv[0]);
+        usage(argv[0]);
         return 1;
     }
 
+    int coarseRes {32};
+    int refinement {4};
+    int numThreads {0};
+    std::string outFileName {"out.vtk"};
+    std::string minimaFileName {"minima.txt"};
+
+    for (int i = 3; i < argc; ++i)
+    {
+        const std::string arg = argv[i];
+
+        if (i + 1 >= argc)
+        {
+            usage(argv[0]);
+            return 1;
+        }
+
+        if      (arg == "--res")     coarseRes      = atoi(argv[++i]);
+        else if (arg == "--refine")  refinement     = atoi(argv[++i]);
+        else if (arg == "--threads") numThreads     = atoi(argv[++i]);
+        else if (arg == "--out")     outFileName    = argv[++i];
+        else if (arg == "--minima")  minimaFileName = argv[++i];
+        else
+        {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
     std::ifstream confFile(argv[1]);
 
     if (!confFile.is_open())
@@ -95,60 +127,29 @@ int main(int argc, char **argv)
     const auto positions = createIC(icMode, bodies.size());
     const auto A = analytic_control::computeA(U, positions);
 
-    auto F = [&](real theta, real phi, real psi)
-    {
-        return analytic_control::computeTravelTime(A, quaternionFromAngles(theta, phi, psi));
-    };
-
-    const int res = 128;
-
-    const int ntheta = 2*res;
-    const int nphi = res;
-    const int npsi = res;
-
-    const real dtheta = 2 * M_PI / ntheta;
-    const real dphi   = M_PI     / nphi;
-    const real dpsi   = 2 * M_PI / npsi;
-
-    // values on the grid
-    std::vector<real> Fvals(ntheta * nphi * npsi);
-
-    for (int ips = 0, i = 0; ips < npsi; ++ips)
-    {
-        const real psi = ips * dpsi;
-        for (int iph = 0; iph < nphi; ++iph)
-        {
-            const real phi = iph * dphi;
-            for (int ith = 0; ith < ntheta; ++ith, ++i)
-            {
-                const real theta = ith * dtheta;
-                Fvals[i] = F(theta, phi, psi);
-            }
-        }
-    }
+    utils::ThreadPool pool(numThreads);
 
-    // dump to vtk
+    const auto grid = analytic_control::computeLandscape(A, coarseRes, refinement, pool);
 
-    const char *outFileName = "out.vtk";
-    std::ofstream f {outFileName};
+    std::cout << "grid " << grid.ntheta << " x " << grid.nphi << " x " << grid.npsi << ": "
+              << grid.numEvaluations << " evaluations for " << grid.values.size() << " points ("
+              << 100.0 * grid.numEvaluations / grid.values.size() << "%)" << std::endl;
 
-    MSODE_Ensure(f.is_open(), "Error opening file '%s'", outFileName);
+    analytic_control::dumpToBinaryVtk(grid, outFileName);
 
-    f << "# vtk DataFile Version 2.0\n"
-      << "Velocity field dumped from msode\n"
-      << "ASCII\n";
+    const auto minima = analytic_control::findLocalMinima(grid);
 
-    f << "DATASET STRUCTURED_POINTS\n"
-      << "DIMENSIONS " << ntheta << ' ' << nphi << ' ' << npsi << '\n'
-      << "ORIGIN " << 0 << ' ' << 0 << ' ' << 0 << '\n'
-      << "SPACING " << dtheta << ' ' << dphi << ' ' << dpsi << '\n';
+    FILE *fmin = fopen(minimaFileName.c_str(), "w");
+    if (fmin == nullptr)
+        msode_die("Could not open the file '%s'", minimaFileName.c_str());
 
-    f << "POINT_DATA " << Fvals.size() << "\n"
-      << "SCALARS travelTime float 1\n"
-      << "LOOKUP_TABLE default\n";
+    fprintf(fmin, "# theta phi psi travelTime basinFraction\n");
+    for (const auto& m : minima)
+        fprintf(fmin, "%g %g %g %g %g\n", m.theta, m.phi, m.psi, m.travelTime, m.basinFraction);
+    fclose(fmin);
 
-    for (auto v : Fvals)
-        f << v << '\n';
+    std::cout << minima.size() << " local minima, global minimum " << minima.front().travelTime
+              << " with basin fraction " << minima.front().basinFraction << std::endl;
 
     return 0;
 }
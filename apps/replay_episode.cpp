@@ -0,0 +1,108 @@
+// Copyright 2020 ETH Zurich. All Rights Reserved.
+/** replay_episode
+
+    Re-simulate an episode recorded by `run_rl` (config key `episodeLog`) and dump its full trajectory.
+    The config must be the one used during the recording.
+    The replay is checked against the final state stored in the log: the program fails if they are not bitwise identical.
+    With --list, print the recorded episodes instead: episodeId status time numActions
+ */
+
+#include <msode/core/log.h>
+#include <msode/rl/episode_log.h>
+#include <msode/rl/factory.h>
+
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <string>
+
+using namespace msode;
+
+static const char* toString(rl::MSodeEnvironment::Status status)
+{
+    using Status = rl::MSodeEnvironment::Status;
+    switch (status)
+    {
+    case Status::Running:         return "running";
+    case Status::MaxTimeEllapsed: return "max_time";
+    case Status::Success:         return "success";
+    }
+    return "unknown";
+}
+
+static inline std::string generateFileName(long episodeId)
+{
+    std::ostringstream ss;
+    ss << std::setw(6) << std::setfill('0') << episodeId;
+    return "replay_" + ss.str() + ".dat";
+}
+
+static void usage(const char *name)
+{
+    fprintf(stderr, "usage : %s [--dump-every <n>] <config.json> <episodes.log> <episodeId> [trajectory_file]\n"
+            "        %s --list <episodes.log>\n\n", name, name);
+}
+
+int main(int argc, char **argv)
+{
+    if (argc == 3 && std::string(argv[1]) == "--list")
+    {
+        for (const auto& record : rl::readEpisodeLog(argv[2]))
+            printf("%ld %s %g %ld\n", record.episodeId, toString(record.status),
+                   static_cast<double>(record.time), record.getNumActions());
+        return 0;
+    }
+
+    long dumpEvery {1};
+    int argStart = 1;
+
+    if (argc > 2 && std::string(argv[1]) == "--dump-every")
+    {
+        dumpEvery = atol(argv[2]);
+        argStart = 3;
+    }
+
+    if (argc != argStart + 3 && argc != argStart + 4)
+    {
+        usage(argv[0]);
+        return 1;
+    }
+
+    std::ifstream confFile(argv[argStart]);
+
+    if (!confFile.is_open())
+        msode_die("Could not open the config file '%s'", argv[argStart]);
+
+    const Config config = json::parse(confFile);
+    const auto records = rl::readEpisodeLog(argv[argStart + 1]);
+    const long episodeId = atol(argv[argStart + 2]);
+    const std::string fileName = argc == argStart + 4 ? argv[argStart + 3] : generateFileName(episodeId);
+
+    const rl::EpisodeRecord *record {nullptr};
+    for (const auto& r : records)
+        if (r.episodeId == episodeId)
+            record = &r;
+
+    if (record == nullptr)
+        msode_die("Episode %ld is not in the log '%s'", episodeId, argv[argStart + 1]);
+
+    auto env = rl::factory::createEnvironment(config, ConfPointer(""));
+    const auto status = rl::replayEpisode(*env, *record, fileName, dumpEvery);
+
+    const bool identical = status == record->status
+        && env->getSimulationTime() == record->time
+        && rl::matchesFinalState(*env, *record);
+
+    printf("episode %ld: %s at time %g after %ld actions, trajectory in %s\n",
+           episodeId, toString(status), static_cast<double>(env->getSimulationTime()),
+           record->getNumActions(), fileName.c_str());
+
+    if (!identical)
+    {
+        fprintf(stderr, "the replay differs from the recorded episode (different config or build?)\n");
+        return 1;
+    }
+
+    return 0;
+}
@@ -2,25 +2,46 @@
 /** rotating
 
     ABF in a rotating field with direction changing direction over time (describes a circle).
+
+    With --checkpoint, the state is saved periodically to the given file (every --checkpoint-every seconds of wall time,
+    default 600) and the run resumes from that file if it exists.
 */
 
 #include <msode/core/simulation.h>
 #include <msode/core/factory.h>
+#include <msode/core/checkpoint.h>
+#include <msode/core/log.h>
+
+#include <fstream>
+#include <string>
 
 int main(int argc, char **argv)
 {
     using namespace msode;
 
-    if (argc < 2)
+    std::string checkpointFileName;
+    double checkpointEvery {600.0};
+
+    int argStart = 1;
+    for (; argStart + 1 < argc; argStart += 2)
+    {
+        const std::string arg = argv[argStart];
+
+        if      (arg == "--checkpoint")       checkpointFileName = argv[argStart + 1];
+        else if (arg == "--checkpoint-every") checkpointEvery = std::stod(argv[argStart + 1]);
+        else break;
+    }
+
+    if (argc <= argStart)
     {
-        fprintf(stderr, "usage : ./main <config0> <config1>...");
+        fprintf(stderr, "usage : ./main [--checkpoint <file>] [--checkpoint-every <seconds>] <config0> <config1>...");
         return 1;
     }
 
     const real kBT{0.0_r};
     std::vector<RigidBody> rigidBodies;
 
-    for (int i = 1; i < argc; ++i)
+    for (int i = argStart; i < argc; ++i)
         rigidBodies.push_back(factory::readRigidBodyConfigFromFile(argv[i]));
 
     const real magneticFieldMagnitude {1.0_r};
@@ -44,9 +65,26 @@ int main(int argc, char **argv)
     const real tDump = 0.1_r;
     const real dt {0.001_r};
     const long nsteps = tEnd / dt;
+    const std::string trajectoryFileName {"out.dat"};
+
+    if (!checkpointFileName.empty() && std::ifstream(checkpointFileName).good())
+    {
+        const std::string dumpFileName = readCheckpoint(checkpointFileName).dumpFileName;
+        if (dumpFileName != trajectoryFileName)
+            msode_die("The checkpoint '%s' continues the trajectory '%s', not '%s'",
+                      checkpointFileName.c_str(), dumpFileName.c_str(), trajectoryFileName.c_str());
+        simulation.restartFromCheckpoint(checkpointFileName);
+    }
+    else
+    {
+        simulation.activateDump(trajectoryFileName, tDump / dt);
+    }
+
+    if (!checkpointFileName.empty())
+        simulation.activateCheckpoint(checkpointFileName, checkpointEvery);
 
-    simulation.activateDump("out.dat", tDump / dt);
-    simulation.runForwardEuler(nsteps, dt);
+    if (simulation.getCurrentTimeStep() < nsteps)
+        simulation.runForwardEuler(nsteps - simulation.getCurrentTimeStep(), dt);
 
     return 0;
 }
@@ -0,0 +1,160 @@
+// Copyright 2020 ETH Zurich. All Rights Reserved.
+/** run_mpc
+
+    Drive the environment described by a RL config (e.g. launch_scripts/rl/config) with the receding horizon
+    controller mpc::Controller, without training.
+    The rollouts of the controller run on a thread pool; with --budget, each decision stops evaluating candidates once
+    the given wall-clock time (in seconds) is exhausted.
+
+    Trajectories are dumped as in run_rl if "dumpEvery" is positive in the config.
+    The output has one line per episode:
+    simId time status numActions finalMaxDistance meanDecisionSeconds maxDecisionSeconds meanRolloutsPerDecision
+ */
+
+#include <msode/core/log.h>
+#include <msode/mpc/controller.h>
+#include <msode/rl/episode_runner.h>
+#include <msode/rl/factory.h>
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+
+using namespace msode;
+
+static void usage(const char *name)
+{
+    fprintf(stderr, "usage : %s [--episodes <n>] [--threads <n>] [--budget <seconds>] [--horizon <n>]"
+            " [--candidates <n>] [--iterations <n>] [--elites <n>] [--seed <s>] <config.json>\n\n", name);
+}
+
+static const char* statusToString(rl::MSodeEnvironment::Status status)
+{
+    using Status = rl::MSodeEnvironment::Status;
+
+    switch (status)
+    {
+    case Status::Running:         return "Running";
+    case Status::MaxTimeEllapsed: return "MaxTimeEllapsed";
+    case Status::Success:         return "Success";
+    };
+    return "Unknown";
+}
+
+int main(int argc, char **argv)
+{
+    long numEpisodes {1};
+    int numThreads {0};
+    long seed {424242};
+    mpc::Params params;
+
+    int argStart = 1;
+    for (; argStart < argc; ++argStart)
+    {
+        const std::string arg = argv[argStart];
+
+        if (arg == "-h" || arg == "--help")
+        {
+            usage(argv[0]);
+            return 1;
+        }
+        else if (arg == "--episodes" && argStart + 1 < argc)
+        {
+            numEpisodes = atol(argv[++argStart]);
+        }
+        else if (arg == "--threads" && argStart + 1 < argc)
+        {
+            numThreads = atoi(argv[++argStart]);
+        }
+        else if (arg == "--budget" && argStart + 1 < argc)
+        {
+            params.timeBudget = atof(argv[++argStart]);
+        }
+        else if (arg == "--horizon" && argStart + 1 < argc)
+        {
+            params.horizon = atoi(argv[++argStart]);
+        }
+        else if (arg == "--candidates" && argStart + 1 < argc)
+        {
+            params.numCandidates = atoi(argv[++argStart]);
+        }
+        else if (arg == "--iterations" && argStart + 1 < argc)
+        {
+            params.numIterations = atoi(argv[++argStart]);
+        }
+        else if (arg == "--elites" && argStart + 1 < argc)
+        {
+            params.numElites = atoi(argv[++argStart]);
+        }
+        else if (arg == "--seed" && argStart + 1 < argc)
+        {
+            seed = atol(argv[++argStart]);
+        }
+        else
+        {
+            break;
+        }
+    }
+
+    if (argc != argStart + 1)
+    {
+        usage(argv[0]);
+        return 1;
+    }
+
+    std::ifstream confFile(argv[argStart]);
+
+    if (!confFile.is_open())
+        msode_die("Could not open the config file '%s'", argv[argStart]);
+
+    const Config config = json::parse(confFile);
+    params.seed = seed;
+
+    auto env = rl::factory::createEnvironment(config, ConfPointer(""));
+
+    // the rollouts do not dump their trajectories
+    Config rolloutConfig = config;
+    rolloutConfig["dumpEvery"] = 0;
+
+    mpc::Controller controller([&rolloutConfig]() {return rl::factory::createEnvironment(rolloutConfig, ConfPointer(""));},
+                               params, numThreads);
+
+    double sumDecisionSeconds {0.0}, maxDecisionSeconds {0.0};
+    long numRollouts {0};
+
+    auto policy = [&](const rl::EpisodeContext& context, const rl::MSodeEnvironment& e,
+                      const std::vector<double>&, std::vector<double>& action)
+    {
+        if (context.actionId == 0)
+            controller.reset(context.episodeId);
+
+        controller.computeAction(e, action);
+
+        const auto& info = controller.getLastDecisionInfo();
+        sumDecisionSeconds += info.seconds;
+        maxDecisionSeconds = std::max(maxDecisionSeconds, info.seconds);
+        numRollouts += info.numRollouts;
+    };
+
+    std::vector<double> action;
+
+    for (long episodeId = 0; episodeId < numEpisodes; ++episodeId)
+    {
+        sumDecisionSeconds = maxDecisionSeconds = 0.0;
+        numRollouts = 0;
+
+        const auto r = rl::runEpisode(*env, seed, episodeId, 0, policy, action);
+        const long numDecisions = std::max(1L, r.numActions);
+
+        std::cout << episodeId << " "
+                  << r.time << " "
+                  << statusToString(r.status) << " "
+                  << r.numActions << " "
+                  << r.finalMaxDistance << " "
+                  << sumDecisionSeconds / numDecisions << " "
+                  << maxDecisionSeconds << " "
+                  << static_cast<double>(numRollouts) / numDecisions << std::endl;
+    }
+
+    return 0;
+}
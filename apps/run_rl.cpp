@@ -2,14 +2,20 @@
 /** run_rl
 
     Use smarties to find optimal policy for the problem stated in `run_ac`.
+
+    If the config has an `episodeLog` entry, every episode is recorded to that file (one per worker directory),
+    and no trajectory is written, whatever the value of `dumpEvery`. The trajectories of chosen episodes can be
+    recomputed from the log with the `replay_episode` app.
  */
 
 #include "rl_helpers.h"
 
 #include <msode/core/log.h>
+#include <msode/rl/episode_log.h>
 #include <msode/rl/factory.h>
 
 #include <fstream>
+#include <memory>
 #include <type_traits>
 
 inline void appMain(smarties::Communicator *const comm, int /*argc*/, char **/*argv*/)
@@ -31,6 +37,10 @@ inline void appMain(smarties::Communicator *const comm, int /*argc*/, char **/*a
     setActionBounds(env.get(), comm);
     setStateBounds (env.get(), comm);
 
+    std::unique_ptr<rl::EpisodeLogWriter> episodeLog;
+    if (config.contains("episodeLog"))
+        episodeLog = std::make_unique<rl::EpisodeLogWriter>(config["episodeLog"].get<std::string>());
+
     bool isTraining {true};
     long simId {0};
 
@@ -43,7 +53,17 @@ inline void appMain(smarties::Communicator *const comm, int /*argc*/, char **/*a
         auto status {Status::Running};
 
         const bool succesfulPreviousTry = previousStatus == Status::Success;
-        env->reset(comm->getPRNG(), simId, succesfulPreviousTry);
+        const long dumpId = episodeLog ? static_cast<long>(rl::MSodeEnvironment::NO_DUMP) : simId;
+        env->reset(comm->getPRNG(), dumpId, succesfulPreviousTry);
+
+        if (episodeLog)
+        {
+            // seed the noise of every episode so that it can be replayed independently of the previous ones
+            const unsigned long noiseSeed = comm->getPRNG()();
+            env->sim->setNoiseSeed(noiseSeed);
+            episodeLog->beginEpisode(simId, noiseSeed, *env);
+        }
+
         comm->sendInitState(env->getState());
 
         while (status == Status::Running) // simulation loop
@@ -53,6 +73,9 @@ inline void appMain(smarties::Communicator *const comm, int /*argc*/, char **/*a
             if (comm->terminateTraining())
                 return;
 
+            if (episodeLog)
+                episodeLog->recordAction(action);
+
             status = env->advance(action);
 
             const auto& state  = env->getState();
@@ -72,6 +95,9 @@ inline void appMain(smarties::Communicator *const comm, int /*argc*/, char **/*a
             }
         }
 
+        if (episodeLog)
+            episodeLog->endEpisode(*env, status);
+
         previousStatus = status;
         ++simId;
     }
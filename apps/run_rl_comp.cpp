@@ -2,6 +2,8 @@
 /** run_rl_comp
 
     Use smarties to find optimal policy for the problem stated in `run_ac` and compare to the `run_ac` results for the same setup.
+    The analytic control of each episode is simulated on background threads (config key "numThreadsAC", default 1),
+    so that the communication with smarties never waits for it. The comparisons are written in episode order.
  */
 
 #include "rl_helpers.h"
@@ -11,7 +13,9 @@
 #include <msode/core/log.h>
 #include <msode/core/velocity_field/factory.h>
 #include <msode/rl/factory.h>
+#include <msode/utils/ordered_async_pool.h>
 
+#include <deque>
 #include <fstream>
 #include <iomanip>
 #include <type_traits>
@@ -54,10 +58,41 @@ static real computeMaxDistance(const std::vector<RigidBody>& bodies)
     return maxDistance;
 }
 
-static inline void dumpComparisonInfos(std::ostream& stream, int simId, real timeAC, real timeRL, const std::vector<RigidBody>& bodiesRL, real initDistance)
+/// The outcome of one RL episode, waiting for the analytic control result of the same episode
+struct EpisodeInfosRL
 {
-    const real maxDistance = computeMaxDistance(bodiesRL);
-    stream << simId << " " << timeAC << " " << timeRL << " " << maxDistance << " " << initDistance << std::endl;
+    long simId;
+    real timeRL;
+    real maxDistance;
+    real initDistance;
+};
+
+static inline void dumpComparisonInfos(std::ostream& stream, const EpisodeInfosRL& infos, real timeAC)
+{
+    stream << infos.simId << " " << timeAC << " " << infos.timeRL << " "
+           << infos.maxDistance << " " << infos.initDistance << std::endl;
+}
+
+/** \brief Write the comparisons of the finished episodes whose analytic control is done.
+    Wait for the oldest analytic control results while more than \p maxPending jobs are pending, so that the
+    backlog of finished episodes stays bounded when the analytic control is slower than the RL episodes.
+ */
+static void dumpAvailableComparisons(std::ostream& stream, std::deque<EpisodeInfosRL>& finishedRL,
+                                     utils::OrderedAsyncPool<real>& poolAC, long maxPending)
+{
+    // the analytic control results come in episode order, as the RL episodes
+    while (!finishedRL.empty())
+    {
+        real tAC;
+
+        if (poolAC.getNumPending() > maxPending)
+            poolAC.pop(tAC);
+        else if (!poolAC.tryPop(tAC))
+            break;
+
+        dumpComparisonInfos(stream, finishedRL.front(), tAC);
+        finishedRL.pop_front();
+    }
 }
 
 
@@ -77,6 +112,7 @@ inline void appMain(smarties::Communicator *const comm, int /*argc*/, char **/*a
     auto env = rl::factory::createEnvironment(config, ConfPointer(""));
 
     const int dumpEvery = 1000;
+    const int numThreadsAC = config.contains("numThreadsAC") ? config.at("numThreadsAC").get<int>() : 1;
 
     const analytic_control::MatrixReal V = analytic_control::createVelocityMatrix(magneticFieldMagnitude, env->getBodies());
     const analytic_control::MatrixReal U = V.inverse();
@@ -92,6 +128,10 @@ inline void appMain(smarties::Communicator *const comm, int /*argc*/, char **/*a
 
     Status previousStatus {Status::Success};
 
+    utils::OrderedAsyncPool<real> poolAC(numThreadsAC);
+    std::deque<EpisodeInfosRL> finishedRL;
+    const long maxPendingAC = 4 * poolAC.getNumThreads();
+
     while (isTraining)
     {
         auto status {Status::Running};
@@ -101,20 +141,23 @@ inline void appMain(smarties::Communicator *const comm, int /*argc*/, char **/*a
         comm->sendInitState(env->getState());
 
         const real initDistance = computeMinDistance(env->getBodies());
-        const real tAC =  [&]()
+
+        poolAC.submit([&config, &U, magneticFieldMagnitude, dumpEvery, simId, envBodies = env->getBodies()]()
         {
-            const auto envBodies = env->getBodies();
             auto velocityField = factory::createVelocityField(config, ConfPointer("/velocityField"));
             return analytic_control::simulateOptimalPath(magneticFieldMagnitude, envBodies, extractPositions(envBodies),
                                                          std::move(velocityField), U, generateACfname(simId), dumpEvery);
-        }();
+        });
 
         while (status == Status::Running) // simulation loop
         {
             const auto action = comm->recvAction();
 
             if (comm->terminateTraining())
+            {
+                dumpAvailableComparisons(std::cout, finishedRL, poolAC, 0);
                 return;
+            }
 
             status = env->advance(action);
 
@@ -136,12 +179,13 @@ inline void appMain(smarties::Communicator *const comm, int /*argc*/, char **/*a
 
             if (status != Status::Running)
             {
-                const auto envBodies = env->getBodies();
-                const real tRL = env->getSimulationTime();
-                dumpComparisonInfos(std::cout, simId, tAC, tRL, envBodies, initDistance);
+                const real maxDistance = computeMaxDistance(env->getBodies());
+                finishedRL.push_back({simId, env->getSimulationTime(), maxDistance, initDistance});
             }
         }
 
+        dumpAvailableComparisons(std::cout, finishedRL, poolAC, maxPendingAC);
+
         previousStatus = status;
         ++simId;
     }
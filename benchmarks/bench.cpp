@@ -0,0 +1,121 @@
+// Copyright 2020 ETH Zurich. All Rights Reserved.
+#include "bench.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <thread>
+#include <type_traits>
+
+namespace msode {
+namespace bench {
+
+Runner::Runner(Options options) :
+    options_(std::move(options))
+{
+    MSODE_Expect(options_.repetitions > 0, "expect a positive number of repetitions, got %d", options_.repetitions);
+}
+
+bool Runner::isEnabled(const std::string& name) const
+{
+    return name.find(options_.filter) != std::string::npos;
+}
+
+void Runner::_addResult(Result result, std::vector<double> nsPerCall)
+{
+    std::sort(nsPerCall.begin(), nsPerCall.end());
+
+    const double median = nsPerCall[nsPerCall.size() / 2];
+    result.nsPerCall = median;
+    result.relSpread = median > 0 ? (nsPerCall.back() - nsPerCall.front()) / median : 0.0;
+
+    std::string params;
+    for (const auto& p : result.params)
+        params += " " + p.first + "=" + std::to_string(p.second);
+
+    fprintf(stderr, "%-52s %-24s %14.1f ns/call %14.3f ns/item  +-%5.1f%%\n",
+            result.name.c_str(), params.c_str(), result.nsPerCall,
+            result.nsPerCall / result.itemsPerCall, 100.0 * result.relSpread);
+
+    results_.push_back(std::move(result));
+}
+
+const std::vector<Result>& Runner::getResults() const
+{
+    return results_;
+}
+
+static const char* getPrecisionName()
+{
+#if defined(MSODE_MIXED_PRECISION)
+    return "mixed";
+#else
+    return std::is_same<real, float>::value ? "single" : "double";
+#endif
+}
+
+void Runner::writeJson(std::ostream& stream) const
+{
+    json benchmarks = json::array();
+
+    for (const auto& r : results_)
+    {
+        json params = json::object();
+        for (const auto& p : r.params)
+            params[p.first] = p.second;
+
+        benchmarks.push_back({
+                {"name", r.name},
+                {"params", params},
+                {"items_per_call", r.itemsPerCall},
+                {"calls", r.numCalls},
+                {"ns_per_call", r.nsPerCall},
+                {"ns_per_item", r.nsPerCall / r.itemsPerCall},
+                {"items_per_second", 1e9 * r.itemsPerCall / r.nsPerCall},
+                {"rel_spread", r.relSpread}
+            });
+    }
+
+    const json context {
+        {"precision", getPrecisionName()},
+        {"hardware_threads", std::thread::hardware_concurrency()},
+        {"min_time", options_.minTime},
+        {"repetitions", options_.repetitions}
+    };
+
+    const json root {
+        {"context", context},
+        {"benchmarks", benchmarks}
+    };
+
+    stream << root.dump(2) << std::endl;
+}
+
+std::vector<RigidBody> generateRandomBodies(int n, std::mt19937& gen)
+{
+    std::uniform_real_distribution<real> unif(0.8_r, 1.2_r);
+    std::vector<RigidBody> bodies;
+
+    for (int i = 0; i < n; ++i)
+    {
+        PropulsionMatrix P;
+        P.A[0]          = 0.3_r * unif(gen);
+        P.A[1] = P.A[2] = 0.2_r * unif(gen);
+
+        P.B[0] = 0.2_r;
+        P.B[1] = P.B[2] = 0.0_r;
+
+        P.C[0]          = 6.3_r * unif(gen);
+        P.C[1] = P.C[2] = 1.2_r * unif(gen);
+
+        const auto q = Quaternion::createIdentity();
+        const real3 r {0.0_r, 0.0_r, 0.0_r};
+        const real3 m {0.0_r, 2.0_r, 0.0_r};
+
+        bodies.push_back({q, r, m, P, 1.0_r});
+    }
+
+    return bodies;
+}
+
+} // namespace bench
+} // namespace msode
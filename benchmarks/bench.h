@@ -0,0 +1,117 @@
+// Copyright 2020 ETH Zurich. All Rights Reserved.
+#pragma once
+
+#include <msode/core/config.h>
+#include <msode/core/simulation.h>
+
+#include <algorithm>
+#include <chrono>
+#include <ostream>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace msode {
+namespace bench {
+
+/// Parameters of a benchmark instance (e.g. number of bodies, number of threads); part of its identity in the reports
+using Params = std::vector<std::pair<std::string, long>>;
+
+struct Options
+{
+    double minTime {0.05};   ///< minimum duration of one repetition, in seconds
+    int repetitions {5};     ///< number of timed repetitions; the median is reported
+    std::string filter;      ///< only run the benchmarks whose name contains this string
+};
+
+struct Result
+{
+    std::string name;
+    Params params;
+    double itemsPerCall {1.0}; ///< units of work performed by one call, e.g. bodies x time steps
+    long numCalls {0};         ///< number of calls per repetition
+    double nsPerCall {0.0};    ///< median over the repetitions
+    double relSpread {0.0};    ///< (max - min) / median of the time per call over the repetitions
+};
+
+/// prevent the compiler from optimizing away the computation of \p value
+template <class T>
+inline void doNotOptimize(const T& value)
+{
+    asm volatile("" : : "g"(&value) : "memory");
+}
+
+/** Run microbenchmarks and collect their results.
+    The number of calls per repetition is calibrated so that a repetition lasts at least Options::minTime.
+ */
+class Runner
+{
+public:
+    explicit Runner(Options options);
+
+    /// \return true if the benchmark \p name passes the filter; used to skip expensive setups
+    bool isEnabled(const std::string& name) const;
+
+    /** \brief Measure the time per call of \p f.
+        \param name The name of the benchmark, e.g. "stepper/forward_euler"
+        \param params The parameters of this instance of the benchmark
+        \param itemsPerCall The units of work performed by one call, used for the throughput
+        \param f The kernel; called many times without arguments
+     */
+    template <class F>
+    void run(const std::string& name, const Params& params, double itemsPerCall, F&& f)
+    {
+        if (!isEnabled(name))
+            return;
+
+        auto timeCalls = [&f](long n)
+        {
+            const auto start = Clock::now();
+            for (long i = 0; i < n; ++i)
+                f();
+            return std::chrono::duration<double>(Clock::now() - start).count();
+        };
+
+        long numCalls {1};
+        double t = timeCalls(numCalls); // also warms up the caches
+
+        while (t < options_.minTime)
+        {
+            const double estimate = t > 0 ? 1.2 * options_.minTime / t * numCalls : 10.0 * numCalls;
+            numCalls = std::max(2 * numCalls, static_cast<long>(std::min(estimate, 100.0 * numCalls)));
+            t = timeCalls(numCalls);
+        }
+
+        std::vector<double> times(options_.repetitions);
+        for (auto& time : times)
+            time = timeCalls(numCalls) * 1e9 / numCalls;
+
+        _addResult(Result{name, params, itemsPerCall, numCalls, 0.0, 0.0}, std::move(times));
+    }
+
+    const std::vector<Result>& getResults() const;
+
+    /// write the results and the build context in json format
+    void writeJson(std::ostream& stream) const;
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    void _addResult(Result result, std::vector<double> nsPerCall);
+
+private:
+    const Options options_;
+    std::vector<Result> results_;
+};
+
+/// \return \p n bodies with random propulsion matrices and distinct step out frequencies, at the origin
+std::vector<RigidBody> generateRandomBodies(int n, std::mt19937& gen);
+
+/// the benchmarks of each library
+void runCoreBenchmarks(Runner& runner);
+void runAnalyticControlBenchmarks(Runner& runner);
+void runRLBenchmarks(Runner& runner);
+
+} // namespace bench
+} // namespace msode
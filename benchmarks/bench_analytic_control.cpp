@@ -0,0 +1,68 @@
+// Copyright 2020 ETH Zurich. All Rights Reserved.
+#include "bench.h"
+
+#include <msode/analytic_control/helpers.h>
+#include <msode/analytic_control/optimal_path.h>
+
+namespace msode {
+namespace bench {
+
+using namespace analytic_control;
+
+void runAnalyticControlBenchmarks(Runner& runner)
+{
+    const real magneticFieldMagnitude = 1.0_r;
+
+    for (int numBodies : {2, 4, 8, 16})
+    {
+        const Params params {{"bodies", numBodies}};
+
+        std::mt19937 gen(4242);
+        const auto bodies = generateRandomBodies(numBodies, gen);
+        const auto positions = generateRandomPositionsBox(numBodies, {-50.0_r, -50.0_r, -50.0_r}, {50.0_r, 50.0_r, 50.0_r});
+
+        runner.run("analytic_control/create_velocity_matrix", params, 1, [&]()
+        {
+            const auto V = createVelocityMatrix(magneticFieldMagnitude, bodies);
+            doNotOptimize(V);
+        });
+
+        const MatrixReal U = createVelocityMatrix(magneticFieldMagnitude, bodies).inverse();
+        const auto A = computeA(U, positions);
+
+        const int numRotations = 256;
+        std::vector<Quaternion> rotations;
+        std::uniform_real_distribution<real> unif(-1.0_r, 1.0_r);
+        for (int i = 0; i < numRotations; ++i)
+        {
+            const real3 axis = normalized(real3{unif(gen), unif(gen), unif(gen)});
+            rotations.push_back(Quaternion::createFromRotation(M_PI * unif(gen), axis));
+        }
+
+        runner.run("analytic_control/compute_travel_time", params, numRotations, [&]()
+        {
+            real sum {0.0_r};
+            for (const auto& q : rotations)
+                sum += computeTravelTime(A, q);
+            doNotOptimize(sum);
+        });
+
+        if (numBodies <= 8)
+        {
+            runner.run("analytic_control/find_best_path_lbfgs", params, 1, [&]()
+            {
+                const auto q = findBestPathLBFGS(A);
+                doNotOptimize(q);
+            });
+
+            runner.run("analytic_control/find_best_path_cmaes", params, 1, [&]()
+            {
+                const auto q = findBestPathCMAES(A);
+                doNotOptimize(q);
+            });
+        }
+    }
+}
+
+} // namespace bench
+} // namespace msode
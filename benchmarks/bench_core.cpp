@@ -0,0 +1,145 @@
+// Copyright 2020 ETH Zurich. All Rights Reserved.
+#include "bench.h"
+
+#include <msode/core/velocity_field/constant.h>
+#include <msode/core/velocity_field/none.h>
+#include <msode/core/velocity_field/shear.h>
+#include <msode/core/velocity_field/sum.h>
+#include <msode/core/velocity_field/taylor_green_vortex.h>
+
+#include <memory>
+#include <sstream>
+
+namespace msode {
+namespace bench {
+
+static std::unique_ptr<BaseVelocityField> createTaylorGreenVortex()
+{
+    return std::make_unique<VelocityFieldTaylorGreenVortex>(real3{1.0_r, 1.0_r, -1.0_r}, real3{0.05_r, 0.05_r, 0.1_r});
+}
+
+static std::unique_ptr<Simulation> createSimulation(int numBodies, real kBT, std::unique_ptr<BaseVelocityField> flow)
+{
+    std::mt19937 gen(4242);
+    const auto bodies = generateRandomBodies(numBodies, gen);
+    const real omega = 0.5_r * bodies[0].stepOutFrequency(1.0_r);
+
+    MagneticField field(1.0_r,
+                        [omega](real) {return omega;},
+                        [](real) {return real3{1.0_r, 0.0_r, 0.0_r};});
+
+    return std::make_unique<Simulation>(bodies, field, kBT, std::move(flow));
+}
+
+static void runStepperBenchmarks(Runner& runner)
+{
+    const long stepsPerCall = 100;
+    const real dt = 1e-3_r;
+
+    for (int numBodies : {1, 2, 4, 8, 16, 32})
+    {
+        const Params params {{"bodies", numBodies}};
+        const double items = static_cast<double>(stepsPerCall * numBodies); // ns per item = ns per body per step
+
+        {
+            auto sim = createSimulation(numBodies, 0.0_r, std::make_unique<VelocityFieldNone>());
+            runner.run("stepper/forward_euler", params, items, [&]() {sim->runForwardEuler(stepsPerCall, dt);});
+        }
+        {
+            auto sim = createSimulation(numBodies, 0.1_r, std::make_unique<VelocityFieldNone>());
+            runner.run("stepper/forward_euler_noise", params, items, [&]() {sim->runForwardEuler(stepsPerCall, dt);});
+        }
+        {
+            auto sim = createSimulation(numBodies, 0.0_r, createTaylorGreenVortex());
+            runner.run("stepper/forward_euler_flow", params, items, [&]() {sim->runForwardEuler(stepsPerCall, dt);});
+        }
+        {
+            auto sim = createSimulation(numBodies, 0.0_r, std::make_unique<VelocityFieldNone>());
+            runner.run("stepper/rk4", params, items, [&]() {sim->runRK4(stepsPerCall, dt);});
+        }
+        {
+            auto sim = createSimulation(numBodies, 0.0_r, createTaylorGreenVortex());
+            runner.run("stepper/rk4_flow", params, items, [&]() {sim->runRK4(stepsPerCall, dt);});
+        }
+    }
+}
+
+static void runVelocityFieldBenchmarks(Runner& runner)
+{
+    const int numPoints = 1024;
+
+    std::mt19937 gen(4242);
+    std::uniform_real_distribution<real> unif(-50.0_r, 50.0_r);
+    std::vector<real3> points(numPoints);
+    for (auto& r : points)
+        r = {unif(gen), unif(gen), unif(gen)};
+
+    std::vector<std::pair<std::string, std::unique_ptr<BaseVelocityField>>> fields;
+    fields.emplace_back("none",     std::make_unique<VelocityFieldNone>());
+    fields.emplace_back("constant", std::make_unique<VelocityFieldConstant>(real3{0.1_r, 0.2_r, 0.3_r}));
+    fields.emplace_back("shear",    std::make_unique<VelocityFieldShear>(0.1_r));
+    fields.emplace_back("taylor_green_vortex", createTaylorGreenVortex());
+    {
+        std::vector<std::unique_ptr<BaseVelocityField>> terms;
+        terms.push_back(createTaylorGreenVortex());
+        terms.push_back(std::make_unique<VelocityFieldShear>(0.1_r));
+        fields.emplace_back("sum", std::make_unique<VelocityFieldSum>(std::move(terms)));
+    }
+
+    const real t = 1.0_r;
+
+    for (const auto& entry : fields)
+    {
+        const BaseVelocityField *field = entry.second.get();
+        const std::string prefix = "velocity_field/" + entry.first;
+
+        runner.run(prefix + "/velocity", {}, numPoints, [&]()
+        {
+            real3 sum {0.0_r, 0.0_r, 0.0_r};
+            for (const auto& r : points)
+                sum += field->getVelocity(r, t);
+            doNotOptimize(sum);
+        });
+
+        runner.run(prefix + "/vorticity", {}, numPoints, [&]()
+        {
+            real3 sum {0.0_r, 0.0_r, 0.0_r};
+            for (const auto& r : points)
+                sum += field->getVorticity(r, t);
+            doNotOptimize(sum);
+        });
+
+        runner.run(prefix + "/deformation_rate", {}, numPoints, [&]()
+        {
+            real sum {0.0_r};
+            for (const auto& r : points)
+                sum += field->getDeformationRateTensor(r, t).xy;
+            doNotOptimize(sum);
+        });
+    }
+
+    const auto tgv = createTaylorGreenVortex();
+
+    for (int n : {16, 32})
+    {
+        const int3 dimensions {n, n, n};
+        const real3 start {-50.0_r, -50.0_r, -50.0_r};
+        const real3 size {100.0_r, 100.0_r, 100.0_r};
+
+        runner.run("velocity_field/dump_vtk_uniform_grid", {{"n", n}}, n * n * n, [&]()
+        {
+            std::ostringstream stream;
+            tgv->dumpToVtkUniformGrid(stream, dimensions, start, size, t);
+            doNotOptimize(stream);
+        });
+    }
+}
+
+void runCoreBenchmarks(Runner& runner)
+{
+    runStepperBenchmarks(runner);
+    runVelocityFieldBenchmarks(runner);
+}
+
+} // namespace bench
+} // namespace msode
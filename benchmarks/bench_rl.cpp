@@ -0,0 +1,218 @@
+// Copyright 2020 ETH Zurich. All Rights Reserved.
+#include "bench.h"
+
+#include <msode/core/log.h>
+#include <msode/core/velocity_field/none.h>
+#include <msode/rl/environment.h>
+#include <msode/rl/episode_runner.h>
+#include <msode/rl/field_from_action/direct.h>
+#include <msode/rl/policies/mlp.h>
+#include <msode/rl/pos_ic/ball.h>
+#include <msode/rl/target_distances/square.h>
+
+#include <limits>
+#include <thread>
+
+namespace msode {
+namespace bench {
+
+using namespace rl;
+
+/** \param endless If true, the episodes never end: the targets cannot be reached and the time is unbounded.
+           Used to time advance() without the resets at the end of the episodes.
+ */
+static std::unique_ptr<MSodeEnvironment> createEnvironment(int numBodies, bool endless = false)
+{
+    const real magneticFieldMagnitude = 1.0_r;
+    const real domainRadius = 20.0_r;
+
+    std::mt19937 gen(4242);
+    auto bodies = generateRandomBodies(numBodies, gen);
+
+    real omegaMax {0.0_r};
+    for (const auto& b : bodies)
+        omegaMax = std::max(omegaMax, b.stepOutFrequency(magneticFieldMagnitude));
+
+    TimeParams timeParams;
+    timeParams.dt              = 2.0_r * M_PI / (2.0_r * omegaMax) / 20;
+    timeParams.tmax            = endless ? std::numeric_limits<real>::max() : 200.0_r;
+    timeParams.nstepsPerAction = 100;
+    timeParams.dumpEvery       = 0;
+
+    RewardParams rewardParams;
+    rewardParams.distCoeff        = 1.0_r;
+    rewardParams.timeCoeff        = 0.1_r;
+    rewardParams.terminationBonus = 10.0_r;
+
+    const real distanceThreshold = endless ? 0.0_r : 2.0_r;
+    const rl::Params envParams(timeParams, rewardParams, magneticFieldMagnitude, distanceThreshold, 0.0_r);
+
+    return std::make_unique<MSodeEnvironment>(envParams,
+                                              std::make_unique<EnvPosICBall>(domainRadius),
+                                              std::move(bodies),
+                                              std::make_unique<FieldFromActionDirect>(0.0_r, 2.0_r * omegaMax),
+                                              std::make_unique<VelocityFieldNone>(),
+                                              std::make_unique<TargetDistanceSquare>());
+}
+
+/// action with the field rotating at half the maximum frequency around a fixed axis
+static std::vector<double> createAction(const MSodeEnvironment& env)
+{
+    const auto bounds = env.getActionBounds();
+    const auto& lo = std::get<0>(bounds);
+    const auto& hi = std::get<1>(bounds);
+
+    std::vector<double> action(lo.size());
+    for (size_t i = 0; i < action.size(); ++i)
+        action[i] = 0.5 * (lo[i] + hi[i]);
+    action[1] = 1.0; // axis along x
+    return action;
+}
+
+static void runEnvironmentBenchmarks(Runner& runner)
+{
+    for (int numBodies : {1, 2, 4, 8})
+    {
+        const Params params {{"bodies", numBodies}};
+
+        const bool endless = true;
+        auto env = createEnvironment(numBodies, endless);
+        const auto action = createAction(*env);
+        std::mt19937 gen(4242);
+
+        runner.run("rl/env_reset", params, 1, [&]()
+        {
+            env->reset(gen, MSodeEnvironment::NO_DUMP, true);
+        });
+
+        env->reset(gen, MSodeEnvironment::NO_DUMP, true);
+
+        // ns per item = ns per time step
+        runner.run("rl/env_advance", params, 100, [&]()
+        {
+            if (env->advance(action) != MSodeEnvironment::Status::Running)
+                msode_die("the episode ended while timing advance()");
+        });
+
+        // the state and reward are cached per action step: invalidate them by moving the bodies in place
+        std::vector<real3> positions = env->getPositions();
+
+        runner.run("rl/env_get_state", params, 1, [&]()
+        {
+            env->setPositions(positions);
+            doNotOptimize(env->getState().data());
+        });
+
+        runner.run("rl/env_get_reward", params, 1, [&]()
+        {
+            env->setPositions(positions);
+            doNotOptimize(env->getReward());
+        });
+    }
+}
+
+static void runEpisodeRunnerBenchmarks(Runner& runner)
+{
+    const std::string name = "rl/episode_runner";
+    if (!runner.isEnabled(name))
+        return;
+
+    const int numBodies = 2;
+    const int maxThreads = std::max(1u, std::thread::hardware_concurrency());
+
+    std::vector<int> threadCounts;
+    for (int n = 1; n < maxThreads; n *= 2)
+        threadCounts.push_back(n);
+    threadCounts.push_back(maxThreads);
+
+    const auto actionTemplate = createAction(*createEnvironment(numBodies));
+
+    EpisodeRunner::Policy policy = [&actionTemplate](const EpisodeContext&, const MSodeEnvironment&,
+                                                     const std::vector<double>&, std::vector<double>& action)
+    {
+        action = actionTemplate;
+    };
+
+    for (int numThreads : threadCounts)
+    {
+        const long numEpisodes = 4 * numThreads;
+        EpisodeRunner episodeRunner([numBodies]() {return createEnvironment(numBodies);}, numThreads);
+
+        // the episodes are seeded by their id only: every call performs the same actions
+        long numActions {0};
+        for (const auto& r : episodeRunner.run(numEpisodes, policy))
+            numActions += r.numActions;
+
+        // ns per item = ns per action
+        runner.run(name, {{"bodies", numBodies}, {"threads", numThreads}}, static_cast<double>(numActions), [&]()
+        {
+            const auto results = episodeRunner.run(numEpisodes, policy);
+            doNotOptimize(results.data());
+        });
+    }
+}
+
+/// a network of the size of the trained policies: 21 state variables, two hidden layers of 128 units, 4 actions
+static MLP createMLP(std::mt19937& gen)
+{
+    const std::vector<int> sizes {21, 128, 128, 4};
+    std::uniform_real_distribution<real> distr(-0.1_r, 0.1_r);
+
+    Config config;
+    config["layers"] = Config::array();
+
+    for (size_t l = 0; l + 1 < sizes.size(); ++l)
+    {
+        std::vector<std::vector<real>> weights(sizes[l+1], std::vector<real>(sizes[l]));
+        std::vector<real> biases(sizes[l+1]);
+
+        for (auto& row : weights)
+            for (auto& w : row)
+                w = distr(gen);
+        for (auto& b : biases)
+            b = distr(gen);
+
+        const bool last = l + 2 == sizes.size();
+        config["layers"].push_back({{"weights", weights}, {"biases", biases}, {"activation", last ? "Linear" : "SoftSign"}});
+    }
+
+    return readMLPFromConfig(config);
+}
+
+static void runMLPBenchmarks(Runner& runner)
+{
+    const std::string name = "rl/mlp_forward";
+    if (!runner.isEnabled(name))
+        return;
+
+    std::mt19937 gen(4242);
+    const MLP mlp = createMLP(gen);
+    MLP::Workspace work;
+    std::uniform_real_distribution<double> distr(-1.0, 1.0);
+
+    for (int batchSize : {1, 64, 1024})
+    {
+        std::vector<double> inputs(batchSize * mlp.getNumInputs());
+        std::vector<double> outputs(batchSize * mlp.getNumOutputs());
+
+        for (auto& x : inputs)
+            x = distr(gen);
+
+        // ns per item = ns per sample
+        runner.run(name, {{"batch", batchSize}}, batchSize, [&]()
+        {
+            mlp.forward(batchSize, inputs.data(), outputs.data(), work);
+            doNotOptimize(outputs.data());
+        });
+    }
+}
+
+void runRLBenchmarks(Runner& runner)
+{
+    runEnvironmentBenchmarks(runner);
+    runMLPBenchmarks(runner);
+    runEpisodeRunnerBenchmarks(runner);
+}
+
+} // namespace bench
+} // namespace msode
@@ -0,0 +1,76 @@
+// Copyright 2020 ETH Zurich. All Rights Reserved.
+/** msode_bench
+
+    Microbenchmarks of the hot kernels of the library: time steppers, velocity fields, analytic control and
+    RL environments, with their scaling in the number of bodies and threads.
+    A summary is printed to stderr; the results are written in json format to the given file (default: stdout).
+    Compare two runs with tools/compare_benchmarks.py.
+ */
+
+#include "bench.h"
+
+#include <msode/core/log.h>
+
+#include <fstream>
+#include <iostream>
+
+using namespace msode;
+
+static void usage(const char *name)
+{
+    fprintf(stderr, "usage : %s [--filter <substring>] [--min-time <seconds>] [--repetitions <n>] [--out <file.json>]\n\n",
+            name);
+}
+
+int main(int argc, char **argv)
+{
+    bench::Options options;
+    std::string outFileName;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::string arg = argv[i];
+
+        if (arg == "--filter" && i + 1 < argc)
+        {
+            options.filter = argv[++i];
+        }
+        else if (arg == "--min-time" && i + 1 < argc)
+        {
+            options.minTime = atof(argv[++i]);
+        }
+        else if (arg == "--repetitions" && i + 1 < argc)
+        {
+            options.repetitions = atoi(argv[++i]);
+        }
+        else if (arg == "--out" && i + 1 < argc)
+        {
+            outFileName = argv[++i];
+        }
+        else
+        {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    bench::Runner runner(options);
+
+    bench::runCoreBenchmarks(runner);
+    bench::runAnalyticControlBenchmarks(runner);
+    bench::runRLBenchmarks(runner);
+
+    if (outFileName.empty())
+    {
+        runner.writeJson(std::cout);
+    }
+    else
+    {
+        std::ofstream out(outFileName);
+        if (!out.is_open())
+            msode_die("Could not open the file '%s'", outFileName.c_str());
+        runner.writeJson(out);
+    }
+
+    return 0;
+}
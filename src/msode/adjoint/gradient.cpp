@@ -0,0 +1,700 @@
+// Copyright 2020 ETH Zurich. All Rights Reserved.
+#include "gradient.h"
+
+#include <msode/core/dual.h>
+#include <msode/core/dynamics.h>
+#include <msode/core/log.h>
+#include <msode/core/stepper.h>
+#include <msode/core/velocity_field/none.h>
+#include <msode/core/velocity_field/shear.h>
+#include <msode/core/velocity_field/taylor_green_vortex.h>
+
+#include <algorithm>
+#include <cmath>
+
+namespace msode {
+namespace adjoint {
+
+constexpr int numStateVars = 7; ///< adjoint variables of one body: position and orientation
+
+template <class T>
+static inline T wrapPhase(T phase)
+{
+    constexpr real_acc twoPi = 2 * M_PI;
+    if (phase >= twoPi) phase -= twoPi;
+    if (phase < 0)      phase += twoPi;
+    return phase;
+}
+
+/// advance one body by one time step; same operations as Stepper without thermal noise
+template <class T, class FieldT>
+static void step(schemes::ForwardEuler, RigidBodyT<T>& b, T phase, T /* omega */, const Vector3<T>& axis, real magnitude,
+                 const FieldT *field, real time, real dt)
+{
+    const Vector3<T> B = computeRotatingField(T(magnitude), phase, normalized(axis));
+
+    Vector3<T> v, w;
+    std::tie(v, w) = computeVelocities(b, B, field, time);
+    const QuaternionT<T> dq_dt = quaternionDerivative(b.q, w);
+
+    b.r += dt * v;
+    b.q += dt * dq_dt;
+    b.q = b.q.normalized();
+}
+
+template <class T, class FieldT>
+static void step(schemes::RK4, RigidBodyT<T>& b, T phase, T omega, const Vector3<T>& axis, real magnitude,
+                 const FieldT *field, real time, real dt)
+{
+    const real dt_half = 0.5_r * dt;
+    const T phaseh = phase  + omega * dt_half;
+    const T phase1 = phaseh + omega * dt_half;
+
+    const Vector3<T> direction = normalized(axis);
+    const Vector3<T> B0 = computeRotatingField(T(magnitude), phase,  direction);
+    const Vector3<T> Bh = computeRotatingField(T(magnitude), phaseh, direction);
+    const Vector3<T> B1 = computeRotatingField(T(magnitude), phase1, direction);
+
+    Vector3<T> v1, v2, v3, v4, w;
+    RigidBodyT<T> bWork = b;
+
+    std::tie(v1, w) = computeVelocities(bWork, B0, field, time);
+    const auto dq_dt1 = quaternionDerivative(bWork.q, w);
+
+    bWork.r = b.r + dt_half * v1;
+    bWork.q = (b.q + dt_half * dq_dt1).normalized();
+
+    std::tie(v2, w) = computeVelocities(bWork, Bh, field, time + dt_half);
+    const auto dq_dt2 = quaternionDerivative(bWork.q, w);
+
+    bWork.r = b.r + dt_half * v2;
+    bWork.q = (b.q + dt_half * dq_dt2).normalized();
+
+    std::tie(v3, w) = computeVelocities(bWork, Bh, field, time + dt_half);
+    const auto dq_dt3 = quaternionDerivative(bWork.q, w);
+
+    bWork.r = b.r + dt * v3;
+    bWork.q = (b.q + dt * dq_dt3).normalized();
+
+    std::tie(v4, w) = computeVelocities(bWork, B1, field, time + dt);
+    const auto dq_dt4 = quaternionDerivative(b.q, w);
+
+    constexpr real one_third = 1.0_r / 3.0_r;
+    constexpr real one_sixth = 1.0_r / 6.0_r;
+
+    b.r += dt * (one_sixth * (v1     + v4    ) + one_third * (v2     + v3    ));
+    b.q += dt * (one_sixth * (dq_dt1 + dq_dt4) + one_third * (dq_dt2 + dq_dt3));
+    b.q = b.q.normalized();
+}
+
+/*
+    Reverse mode derivatives of the step kernels.
+    Each function below takes the adjoints of the outputs of the corresponding forward operation (suffix Bar) and
+    accumulates the adjoints of its inputs, i.e. it computes a vector-Jacobian product. The forward values needed
+    are recomputed locally from the inputs.
+*/
+
+static inline Quaternion zeroQuaternion()
+{
+    return Quaternion::createFromComponents(0.0_r, 0.0_r, 0.0_r, 0.0_r);
+}
+
+static inline void addTo(Quaternion& a, const Quaternion& b)
+{
+    a.w += b.w;
+    a.x += b.x;
+    a.y += b.y;
+    a.z += b.z;
+}
+
+/// y = q.rotate(v), valid for any (not necessarily unit) quaternion q
+static inline void rotateAdjoint(const Quaternion& q, const real3& v, const real3& yBar, Quaternion& qBar, real3& vBar)
+{
+    // y = (w^2 - |u|^2) v + 2 (u.v) u + 2 w (u x v)
+    const real w = q.w;
+    const real3 u = q.vectorPart();
+    const real uy = dot(u, yBar);
+    const real uv = dot(u, v);
+    const real vy = dot(v, yBar);
+
+    vBar += (2 * uy) * u + (w * w - dot(u, u)) * yBar - (2 * w) * cross(u, yBar);
+
+    qBar.w += 2 * w * vy + 2 * dot(yBar, cross(u, v));
+    const real3 uBar = (2 * uy) * v + (2 * uv) * yBar - (2 * vy) * u + (2 * w) * cross(v, yBar);
+    qBar.x += uBar.x;
+    qBar.y += uBar.y;
+    qBar.z += uBar.z;
+}
+
+/// y = q.conjugate().rotate(v)
+static inline void conjugateRotateAdjoint(const Quaternion& q, const real3& v, const real3& yBar,
+                                          Quaternion& qBar, real3& vBar)
+{
+    Quaternion qcBar = zeroQuaternion();
+    rotateAdjoint(q.conjugate(), v, yBar, qcBar, vBar);
+    addTo(qBar, qcBar.conjugate());
+}
+
+/// y = q.normalized()
+static inline void normalizeAdjoint(const Quaternion& q, const Quaternion& yBar, Quaternion& qBar)
+{
+    const real invNorm = 1.0_r / q.norm();
+    const Quaternion y = invNorm * q;
+    const real yyBar = y.w * yBar.w + y.x * yBar.x + y.y * yBar.y + y.z * yBar.z;
+
+    addTo(qBar, invNorm * (yBar - yyBar * y));
+}
+
+/// dq = quaternionDerivative(q, omega)
+static inline void quaternionDerivativeAdjoint(const Quaternion& q, const real3& omega, const Quaternion& dqBar,
+                                               Quaternion& qBar, real3& omegaBar)
+{
+    // dq = 0.5 q * (0, omega); the adjoint of a product a * b is (abar * conj(b), conj(a) * abar)
+    const Quaternion qw = Quaternion::createPureVector(omega);
+    addTo(qBar, 0.5_r * (dqBar * qw.conjugate()));
+    omegaBar += 0.5_r * (q.conjugate() * dqBar).vectorPart();
+}
+
+/// addFlowContribution() without flow
+static inline void addFlowContributionAdjoint(const NoFlow * /* field */, const RigidBody& /* b */, real /* time */,
+                                              const real3& /* vBar */, const real3& /* omegaBar */,
+                                              real3& /* rBar */, Quaternion& /* qBar */)
+{}
+
+/// addFlowContribution(); the derivatives of the flow with respect to the position are obtained with Dual numbers
+template <class FieldT>
+static inline void addFlowContributionAdjoint(const FieldT *field, const RigidBody& b, real time,
+                                              const real3& vBar, const real3& omegaBar,
+                                              real3& rBar, Quaternion& qBar)
+{
+    using D3 = Dual<3>;
+    auto toDual = [](const real3& a) -> Vector3<D3> {return {D3(a.x), D3(a.y), D3(a.z)};};
+
+    const real3 ex {1.0_r, 0.0_r, 0.0_r};
+    const real3 p = b.q.conjugate().rotate(ex);
+    const real L = (b.aspectRatio*b.aspectRatio - 1.0_r) / (b.aspectRatio*b.aspectRatio + 1.0_r);
+    const real3 wxp = cross(omegaBar, p);
+
+    // omega += L p x (E p): omegaBar . (p x E p) = (omegaBar x p) . (E p)
+    const Vector3<D3> r {D3::createVariable(b.r.x, 0), D3::createVariable(b.r.y, 1), D3::createVariable(b.r.z, 2)};
+    const D3 s =
+        dot(toDual(vBar), field->getVelocity(r, time)) +
+        0.5_r * dot(toDual(omegaBar), field->getVorticity(r, time)) +
+        L * dot(toDual(wxp), multiply(field->getDeformationRateTensor(r, time), toDual(p)));
+
+    rBar += real3{s.d[0], s.d[1], s.d[2]};
+
+    const auto E = field->getDeformationRateTensor(b.r, time);
+    const real3 pBar = L * (cross(multiply(E, p), omegaBar) + multiply(E, wxp));
+    real3 exBar {0.0_r, 0.0_r, 0.0_r};
+    conjugateRotateAdjoint(b.q, ex, pBar, qBar, exBar);
+}
+
+/** computeVelocities() of the body \p b in the magnetic field \p B.
+    Accumulates the adjoints of the position and orientation of the body in rBar and qBar, of its properties in gBody,
+    and of the magnetic field in BBar.
+ */
+template <class FieldT>
+static void computeVelocitiesAdjoint(const RigidBody& b, const real3& B, const FieldT *field, real time,
+                                     const real3& vBar, const real3& omegaBar,
+                                     real3& rBar, Quaternion& qBar, real3& BBar, BodyGradient& gBody)
+{
+    const Quaternion& q = b.q;
+    const PropulsionMatrix& P = b.propulsion;
+
+    // forward: the force is zero, hence the velocities do not depend on the matrix A
+    const real3 m      = q.conjugate().rotate(b.magnMoment);
+    const real3 torque = cross(m, B);
+    const real3 T_     = q.rotate(torque);
+    const real3 vBody  = P.B * T_;
+    const real3 wBody  = P.C * T_;
+
+    addFlowContributionAdjoint(field, b, time, vBar, omegaBar, rBar, qBar);
+
+    // v = qInv.rotate(vBody), omega = qInv.rotate(wBody)
+    real3 vBodyBar {0.0_r, 0.0_r, 0.0_r}, wBodyBar {0.0_r, 0.0_r, 0.0_r};
+    conjugateRotateAdjoint(q, vBody, vBar,     qBar, vBodyBar);
+    conjugateRotateAdjoint(q, wBody, omegaBar, qBar, wBodyBar);
+
+    real3 TBar {0.0_r, 0.0_r, 0.0_r};
+    for (int k = 0; k < 3; ++k)
+    {
+        const real Tk   = k == 0 ? T_.x : k == 1 ? T_.y : T_.z;
+        const real vk   = k == 0 ? vBodyBar.x : k == 1 ? vBodyBar.y : vBodyBar.z;
+        const real wk   = k == 0 ? wBodyBar.x : k == 1 ? wBodyBar.y : wBodyBar.z;
+        gBody.propulsion.B[k] += vk * Tk;
+        gBody.propulsion.C[k] += wk * Tk;
+    }
+    TBar += P.B * vBodyBar;
+    TBar += P.C * wBodyBar;
+
+    real3 torqueBar {0.0_r, 0.0_r, 0.0_r};
+    rotateAdjoint(q, torque, TBar, qBar, torqueBar);
+
+    // torque = m x B
+    const real3 mBar = cross(B, torqueBar);
+    BBar += cross(torqueBar, m);
+
+    conjugateRotateAdjoint(q, b.magnMoment, mBar, qBar, gBody.magnMoment);
+}
+
+/// the state of a body with \p r and \p q, and the properties of \p b
+static inline RigidBody withState(RigidBody b, const real3& r, const Quaternion& q)
+{
+    b.r = r;
+    b.q = q;
+    return b;
+}
+
+/** The phases of the magnetic fields evaluated in one step, computed as in step().
+    \param derivatives Receives the derivatives of each phase with respect to omega; those with respect to the initial
+           phase are one.
+    \return the number of fields
+ */
+static inline int fieldPhases(schemes::ForwardEuler, real phase, real /* omega */, real /* dt */,
+                              real *phases, real *derivatives)
+{
+    phases[0] = phase;
+    derivatives[0] = 0.0_r;
+    return 1;
+}
+
+static inline int fieldPhases(schemes::RK4, real phase, real omega, real dt, real *phases, real *derivatives)
+{
+    const real dt_half = 0.5_r * dt;
+    phases[0] = phase;
+    phases[1] = phase     + omega * dt_half;
+    phases[2] = phases[1] + omega * dt_half;
+    derivatives[0] = 0.0_r;
+    derivatives[1] = dt_half;
+    derivatives[2] = dt;
+    return 3;
+}
+
+/** Adjoint of step() for forward Euler.
+    \param fields The magnetic fields of the step, see fieldPhases()
+    \param rBar, qBar On input, the adjoints of the state after the step; on output, those of the state before the step
+    \param fieldsBar Accumulates the adjoints of the fields
+    \param gBody Accumulates the adjoints of the properties of the body
+ */
+template <class FieldT>
+static void stepAdjoint(schemes::ForwardEuler, const RigidBody& b, const real3 *fields, const FieldT *field,
+                        real time, real dt, real3& rBar, Quaternion& qBar, real3 *fieldsBar, BodyGradient& gBody)
+{
+    real3 v, w;
+    std::tie(v, w) = computeVelocities(b, fields[0], field, time);
+    const Quaternion dq_dt = quaternionDerivative(b.q, w);
+    const Quaternion qNew = b.q + dt * dq_dt;
+
+    // q = (q + dt * dq_dt).normalized(), r = r + dt * v
+    Quaternion qNewBar = zeroQuaternion();
+    normalizeAdjoint(qNew, qBar, qNewBar);
+
+    const real3 vBar = dt * rBar;
+    real3 wBar {0.0_r, 0.0_r, 0.0_r};
+    qBar = qNewBar;
+    quaternionDerivativeAdjoint(b.q, w, dt * qNewBar, qBar, wBar);
+
+    computeVelocitiesAdjoint(b, fields[0], field, time, vBar, wBar, rBar, qBar, fieldsBar[0], gBody);
+}
+
+/// Adjoint of step() for RK4; see the forward Euler version
+template <class FieldT>
+static void stepAdjoint(schemes::RK4, const RigidBody& b, const real3 *fields, const FieldT *field,
+                        real time, real dt, real3& rBar, Quaternion& qBar, real3 *fieldsBar, BodyGradient& gBody)
+{
+    const real dt_half = 0.5_r * dt;
+    const real3& B0 = fields[0];
+    const real3& Bh = fields[1];
+    const real3& B1 = fields[2];
+
+    // forward, keeping the stages
+    real3 v1, v2, v3, v4, w1, w2, w3, w4;
+
+    std::tie(v1, w1) = computeVelocities(b, B0, field, time);
+    const auto dq_dt1 = quaternionDerivative(b.q, w1);
+
+    const real3 r2 = b.r + dt_half * v1;
+    const Quaternion q2Raw = b.q + dt_half * dq_dt1;
+    const RigidBody b2 = withState(b, r2, q2Raw.normalized());
+    std::tie(v2, w2) = computeVelocities(b2, Bh, field, time + dt_half);
+    const auto dq_dt2 = quaternionDerivative(b2.q, w2);
+
+    const real3 r3 = b.r + dt_half * v2;
+    const Quaternion q3Raw = b.q + dt_half * dq_dt2;
+    const RigidBody b3 = withState(b, r3, q3Raw.normalized());
+    std::tie(v3, w3) = computeVelocities(b3, Bh, field, time + dt_half);
+    const auto dq_dt3 = quaternionDerivative(b3.q, w3);
+
+    const real3 r4 = b.r + dt * v3;
+    const Quaternion q4Raw = b.q + dt * dq_dt3;
+    const RigidBody b4 = withState(b, r4, q4Raw.normalized());
+    std::tie(v4, w4) = computeVelocities(b4, B1, field, time + dt);
+    const auto dq_dt4 = quaternionDerivative(b.q, w4);
+
+    constexpr real one_third = 1.0_r / 3.0_r;
+    constexpr real one_sixth = 1.0_r / 6.0_r;
+
+    const Quaternion qNew = b.q + dt * (one_sixth * (dq_dt1 + dq_dt4) + one_third * (dq_dt2 + dq_dt3));
+
+    // backward
+    Quaternion qNewBar = zeroQuaternion();
+    normalizeAdjoint(qNew, qBar, qNewBar);
+
+    const real3 rNewBar = rBar;
+    qBar = qNewBar;
+
+    real3 vBar1 = (dt * one_sixth) * rNewBar, vBar4 = vBar1;
+    real3 vBar2 = (dt * one_third) * rNewBar, vBar3 = vBar2;
+    Quaternion dqBar1 = (dt * one_sixth) * qNewBar, dqBar4 = dqBar1;
+    Quaternion dqBar2 = (dt * one_third) * qNewBar, dqBar3 = dqBar2;
+
+    const real3 zero {0.0_r, 0.0_r, 0.0_r};
+
+    // stage 4: note that its quaternion derivative uses the initial orientation
+    {
+        real3 wBar = zero, rStageBar = zero;
+        Quaternion qStageBar = zeroQuaternion(), qRawBar = zeroQuaternion();
+        quaternionDerivativeAdjoint(b.q, w4, dqBar4, qBar, wBar);
+        computeVelocitiesAdjoint(b4, B1, field, time + dt, vBar4, wBar, rStageBar, qStageBar, fieldsBar[2], gBody);
+        normalizeAdjoint(q4Raw, qStageBar, qRawBar);
+        rBar += rStageBar;
+        vBar3 += dt * rStageBar;
+        addTo(qBar, qRawBar);
+        addTo(dqBar3, dt * qRawBar);
+    }
+    // stage 3
+    {
+        real3 wBar = zero, rStageBar = zero;
+        Quaternion qStageBar = zeroQuaternion(), qRawBar = zeroQuaternion();
+        quaternionDerivativeAdjoint(b3.q, w3, dqBar3, qStageBar, wBar);
+        computeVelocitiesAdjoint(b3, Bh, field, time + dt_half, vBar3, wBar, rStageBar, qStageBar, fieldsBar[1], gBody);
+        normalizeAdjoint(q3Raw, qStageBar, qRawBar);
+        rBar += rStageBar;
+        vBar2 += dt_half * rStageBar;
+        addTo(qBar, qRawBar);
+        addTo(dqBar2, dt_half * qRawBar);
+    }
+    // stage 2
+    {
+        real3 wBar = zero, rStageBar = zero;
+        Quaternion qStageBar = zeroQuaternion(), qRawBar = zeroQuaternion();
+        quaternionDerivativeAdjoint(b2.q, w2, dqBar2, qStageBar, wBar);
+        computeVelocitiesAdjoint(b2, Bh, field, time + dt_half, vBar2, wBar, rStageBar, qStageBar, fieldsBar[1], gBody);
+        normalizeAdjoint(q2Raw, qStageBar, qRawBar);
+        rBar += rStageBar;
+        vBar1 += dt_half * rStageBar;
+        addTo(qBar, qRawBar);
+        addTo(dqBar1, dt_half * qRawBar);
+    }
+    // stage 1
+    {
+        real3 wBar = zero;
+        quaternionDerivativeAdjoint(b.q, w1, dqBar1, qBar, wBar);
+        computeVelocitiesAdjoint(b, B0, field, time, vBar1, wBar, rBar, qBar, fieldsBar[0], gBody);
+    }
+}
+
+/** Forward and adjoint simulations of a Problem, compiled for a given scheme and flow type.
+    The state of one body is stored as 7 reals (position and orientation); the phase of the field separately.
+ */
+template <class Scheme, class FieldT>
+class Solver
+{
+public:
+    Solver(const Problem& problem, const std::vector<Control>& controls, const FieldT *field) :
+        problem_(problem),
+        controls_(controls),
+        field_(field),
+        numBodies_(static_cast<int>(problem.bodies.size())),
+        numSteps_(static_cast<long>(controls.size()) * problem.nstepsPerControl)
+    {}
+
+    real computeCost()
+    {
+        _initialize();
+        for (long i = 0; i < numSteps_; ++i)
+            _step(i);
+        return _cost();
+    }
+
+    Gradient computeGradient(long checkpointEvery)
+    {
+        if (checkpointEvery <= 0)
+            checkpointEvery = std::max(1L, static_cast<long>(std::ceil(std::sqrt(static_cast<double>(numSteps_)))));
+
+        const long numCheckpoints = (numSteps_ + checkpointEvery - 1) / checkpointEvery;
+        const int stateSize = numStateVars * numBodies_;
+
+        // forward pass, storing the state at the start of every interval
+        std::vector<real> checkpoints(numCheckpoints * stateSize);
+        std::vector<real_acc> checkpointPhases(numCheckpoints);
+
+        _initialize();
+        for (long i = 0; i < numSteps_; ++i)
+        {
+            if (i % checkpointEvery == 0)
+            {
+                _save(checkpoints.data() + (i / checkpointEvery) * stateSize);
+                checkpointPhases[i / checkpointEvery] = phase_;
+            }
+            _step(i);
+        }
+
+        Gradient g;
+        g.cost = _cost();
+        g.controls.assign(controls_.size(), Control{0.0_r, {0.0_r, 0.0_r, 0.0_r}});
+        g.bodies.assign(numBodies_, BodyGradient{{{0.0_r, 0.0_r, 0.0_r}, {0.0_r, 0.0_r, 0.0_r}, {0.0_r, 0.0_r, 0.0_r}},
+                                                 {0.0_r, 0.0_r, 0.0_r}});
+
+        // adjoint variables: derivatives of the cost with respect to the state and the phase after the current step
+        std::vector<real> lambda(stateSize, 0.0_r);
+        real mu {0.0_r};
+
+        for (int i = 0; i < numBodies_; ++i)
+        {
+            const real3 dr = bodies_[i].r - problem_.targets[i];
+            lambda[numStateVars * i + 0] = dr.x;
+            lambda[numStateVars * i + 1] = dr.y;
+            lambda[numStateVars * i + 2] = dr.z;
+        }
+
+        // backward pass, one interval at a time
+        std::vector<real> states(checkpointEvery * stateSize);
+        std::vector<real_acc> phases(checkpointEvery);
+        std::vector<real> newLambda(stateSize);
+
+        for (long c = numCheckpoints - 1; c >= 0; --c)
+        {
+            const long start = c * checkpointEvery;
+            const long end = std::min(numSteps_, start + checkpointEvery);
+
+            _load(checkpoints.data() + c * stateSize);
+            phase_ = checkpointPhases[c];
+
+            for (long i = start; i < end; ++i)
+            {
+                _save(states.data() + (i - start) * stateSize);
+                phases[i - start] = phase_;
+                _step(i);
+            }
+
+            for (long i = end - 1; i >= start; --i)
+            {
+                _load(states.data() + (i - start) * stateSize);
+                phase_ = phases[i - start];
+                mu = _adjointStep(i, lambda.data(), mu, newLambda.data(), g);
+                std::swap(lambda, newLambda);
+            }
+        }
+
+        return g;
+    }
+
+private:
+    void _initialize()
+    {
+        bodies_ = problem_.bodies;
+        phase_ = 0;
+    }
+
+    real _cost() const
+    {
+        real cost {0.0_r};
+        for (int i = 0; i < numBodies_; ++i)
+        {
+            const real3 dr = bodies_[i].r - problem_.targets[i];
+            cost += 0.5_r * dot(dr, dr);
+        }
+        return cost;
+    }
+
+    real _time(long stepId) const
+    {
+        return static_cast<real>(stepId * static_cast<real_acc>(problem_.dt));
+    }
+
+    const Control& _control(long stepId) const
+    {
+        return controls_[stepId / problem_.nstepsPerControl];
+    }
+
+    void _step(long stepId)
+    {
+        const Control& control = _control(stepId);
+        const real phase = static_cast<real>(phase_);
+
+        for (auto& b : bodies_)
+            step(Scheme{}, b, phase, control.omega, control.axis, problem_.magneticFieldMagnitude,
+                 field_, _time(stepId), problem_.dt);
+
+        phase_ = wrapPhase(phase_ + control.omega * problem_.dt);
+    }
+
+    /** propagate the adjoint variables backwards through the step stepId, starting from the state before that step.
+        Accumulates the derivatives with respect to the control and the body properties in g.
+        \return the adjoint variable of the phase before the step
+     */
+    real _adjointStep(long stepId, const real *lambda, real mu, real *newLambda, Gradient& g) const
+    {
+        const long controlId = stepId / problem_.nstepsPerControl;
+        const Control& control = controls_[controlId];
+        Control& gControl = g.controls[controlId];
+
+        // the fields depend only on the phase and the control: their derivatives are shared by all bodies
+        using D4 = Dual<4>;
+        constexpr int maxFields = 3;
+        real phases[maxFields], dPhases_dOmega[maxFields];
+        const int numFields = fieldPhases(Scheme{}, static_cast<real>(phase_), control.omega, problem_.dt,
+                                          phases, dPhases_dOmega);
+
+        const Vector3<D4> axis = normalized(Vector3<D4>{D4::createVariable(control.axis.x, 1),
+                                                        D4::createVariable(control.axis.y, 2),
+                                                        D4::createVariable(control.axis.z, 3)});
+        Vector3<D4> fieldsD[maxFields];
+        real3 fields[maxFields], fieldsBar[maxFields];
+
+        for (int k = 0; k < numFields; ++k)
+        {
+            fieldsD[k] = computeRotatingField(D4(problem_.magneticFieldMagnitude), D4::createVariable(phases[k], 0), axis);
+            fields[k] = {fieldsD[k].x.val, fieldsD[k].y.val, fieldsD[k].z.val};
+            fieldsBar[k] = {0.0_r, 0.0_r, 0.0_r};
+        }
+
+        for (int i = 0; i < numBodies_; ++i)
+        {
+            const real *l = lambda + numStateVars * i;
+            real3 rBar {l[0], l[1], l[2]};
+            Quaternion qBar = Quaternion::createFromComponents(l[3], l[4], l[5], l[6]);
+
+            stepAdjoint(Scheme{}, bodies_[i], fields, field_, _time(stepId), problem_.dt,
+                        rBar, qBar, fieldsBar, g.bodies[i]);
+
+            real *nl = newLambda + numStateVars * i;
+            nl[0] = rBar.x;
+            nl[1] = rBar.y;
+            nl[2] = rBar.z;
+            nl[3] = qBar.w;
+            nl[4] = qBar.x;
+            nl[5] = qBar.y;
+            nl[6] = qBar.z;
+        }
+
+        // phase after the step: phase + omega * dt
+        real newMu = mu;
+        gControl.omega += mu * problem_.dt;
+
+        for (int k = 0; k < numFields; ++k)
+        {
+            const Vector3<D4>& B = fieldsD[k];
+            const real3& BBar = fieldsBar[k];
+            auto contract = [&](int var) {return BBar.x * B.x.d[var] + BBar.y * B.y.d[var] + BBar.z * B.z.d[var];};
+
+            const real phaseBar = contract(0);
+            newMu          += phaseBar;
+            gControl.omega += dPhases_dOmega[k] * phaseBar;
+            gControl.axis.x += contract(1);
+            gControl.axis.y += contract(2);
+            gControl.axis.z += contract(3);
+        }
+
+        return newMu;
+    }
+
+    void _save(real *dst) const
+    {
+        for (const auto& b : bodies_)
+        {
+            *dst++ = b.r.x;
+            *dst++ = b.r.y;
+            *dst++ = b.r.z;
+            *dst++ = b.q.w;
+            *dst++ = b.q.x;
+            *dst++ = b.q.y;
+            *dst++ = b.q.z;
+        }
+    }
+
+    void _load(const real *src)
+    {
+        for (auto& b : bodies_)
+        {
+            b.r.x = *src++;
+            b.r.y = *src++;
+            b.r.z = *src++;
+            b.q.w = *src++;
+            b.q.x = *src++;
+            b.q.y = *src++;
+            b.q.z = *src++;
+        }
+    }
+
+private:
+    const Problem& problem_;
+    const std::vector<Control>& controls_;
+    const FieldT *field_;
+    const int numBodies_;
+    const long numSteps_;
+
+    std::vector<RigidBody> bodies_; ///< current state of the bodies
+    real_acc phase_ {0};            ///< current phase of the magnetic field
+};
+
+/// call f with the Solver specialized for the scheme and the flow of the problem
+template <class F>
+static auto dispatch(const Problem& problem, const std::vector<Control>& controls, F f)
+{
+    MSODE_Expect(problem.targets.size() == problem.bodies.size(),
+                 "expect one target per body, got %zu targets and %zu bodies",
+                 problem.targets.size(), problem.bodies.size());
+    MSODE_Expect(problem.nstepsPerControl > 0, "expect a positive number of steps per control");
+
+    auto withScheme = [&](auto scheme)
+    {
+        using Scheme = decltype(scheme);
+        const BaseVelocityField *field = problem.velocityField;
+
+        if (field == nullptr || dynamic_cast<const VelocityFieldNone*>(field))
+        {
+            Solver<Scheme, NoFlow> solver(problem, controls, nullptr);
+            return f(solver);
+        }
+        if (auto tgv = dynamic_cast<const VelocityFieldTaylorGreenVortex*>(field))
+        {
+            Solver<Scheme, VelocityFieldTaylorGreenVortex> solver(problem, controls, tgv);
+            return f(solver);
+        }
+        if (auto shear = dynamic_cast<const VelocityFieldShear*>(field))
+        {
+            Solver<Scheme, VelocityFieldShear> solver(problem, controls, shear);
+            return f(solver);
+        }
+        msode_die("The adjoint supports no flow, the Taylor-Green vortex and the shear flow only");
+        Solver<Scheme, NoFlow> solver(problem, controls, nullptr);
+        return f(solver);
+    };
+
+    switch (problem.scheme)
+    {
+    case Simulation::ODEScheme::ForwardEuler:
+        return withScheme(schemes::ForwardEuler{});
+    case Simulation::ODEScheme::RK4:
+        return withScheme(schemes::RK4{});
+    };
+
+    msode_die("Unknown ODE scheme");
+    return withScheme(schemes::ForwardEuler{});
+}
+
+real computeCost(const Problem& problem, const std::vector<Control>& controls)
+{
+    return dispatch(problem, controls, [](auto& solver) {return solver.computeCost();});
+}
+
+Gradient computeGradient(const Problem& problem, const std::vector<Control>& controls, long checkpointEvery)
+{
+    return dispatch(problem, controls, [checkpointEvery](auto& solver) {return solver.computeGradient(checkpointEvery);});
+}
+
+} // namespace adjoint
+} // namespace msode
@@ -0,0 +1,77 @@
+// Copyright 2020 ETH Zurich. All Rights Reserved.
+#pragma once
+
+#include <msode/core/simulation.h>
+
+#include <vector>
+
+namespace msode {
+namespace adjoint {
+
+/// A piecewise constant control of the magnetic field, held during Problem::nstepsPerControl time steps
+struct Control
+{
+    real omega; ///< rotation frequency of the field
+    real3 axis; ///< rotation direction of the field; need not be normalized, must not be opposite to the z axis
+};
+
+/// A deterministic trajectory optimization problem: the bodies are driven towards their targets by a sequence of controls
+struct Problem
+{
+    std::vector<RigidBody> bodies;        ///< initial state and properties of the bodies
+    std::vector<real3> targets;           ///< target position of each body
+    real magneticFieldMagnitude {1.0_r};
+    real dt {1e-3_r};                     ///< time step
+    long nstepsPerControl {1};            ///< number of time steps during which each control is held
+    Simulation::ODEScheme scheme {Simulation::ODEScheme::ForwardEuler};
+
+    /** background flow. Only nullptr (no flow), VelocityFieldNone, VelocityFieldTaylorGreenVortex and
+        VelocityFieldShear are supported: the adjoint kernels are compiled for these types only.
+        computeCost() and computeGradient() fail with any other flow.
+     */
+    const BaseVelocityField *velocityField {nullptr};
+};
+
+/// Derivatives of the cost with respect to the properties of one body
+struct BodyGradient
+{
+    PropulsionMatrix propulsion;
+    real3 magnMoment;
+};
+
+/// The cost of a control sequence and its derivatives
+struct Gradient
+{
+    real cost;
+    std::vector<Control> controls;     ///< derivatives with respect to the frequency and the axis of each control
+    std::vector<BodyGradient> bodies;  ///< derivatives with respect to the properties of each body
+};
+
+/** \brief Simulate the problem and compute the cost of a control sequence.
+    \param problem The problem to solve
+    \param controls The sequence of controls, starting at time 0 with a field phase of 0
+    \return Half the sum over the bodies of the squared distance between their final position and their target
+
+    The dynamics are the ones of Simulation without thermal noise, with the given scheme.
+ */
+real computeCost(const Problem& problem, const std::vector<Control>& controls);
+
+/** \brief Compute the cost of a control sequence and its derivatives with the discrete adjoint method.
+    \param problem The problem to solve
+    \param controls The sequence of controls, starting at time 0 with a field phase of 0
+    \param checkpointEvery The number of time steps between two stored states; non positive values select the square
+           root of the number of time steps
+    \return The cost (see computeCost()) and its derivatives
+
+    The derivatives are the exact ones of the discretized dynamics. The states are stored only every
+    \p checkpointEvery steps during the forward pass; the backward pass recomputes the states of one interval at a
+    time from its checkpoint, and propagates the adjoint variables backwards through each step with a hand-written
+    vector-Jacobian product of the step kernels (reverse mode), which recomputes the intermediate stages of the step.
+    The cost is independent of the number of controls and amounts to about 6 to 7 forward simulations: the forward
+    pass, the recomputation and one reverse sweep per time step.
+    Only the flows listed in Problem::velocityField are supported.
+ */
+Gradient computeGradient(const Problem& problem, const std::vector<Control>& controls, long checkpointEvery = 0);
+
+} // namespace adjoint
+} // namespace msode
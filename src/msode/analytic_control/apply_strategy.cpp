@@ -4,7 +4,11 @@
 #include "helpers.h"
 #include "optimal_path.h"
 
+#include <msode/core/field_schedule.h>
+
 #include <algorithm>
+#include <array>
+#include <cmath>
 #include <limits>
 
 namespace msode {
@@ -33,6 +37,142 @@ static inline real computeMinOmega(int dir, const std::vector<RigidBody>& bodies
     return minVal;
 }
 
+/** Append the reorientation phase to the schedule:
+    the field rotates back and forth around \p dir at half the minimal step out frequency.
+ */
+static void addReorientSegments(FieldSchedule& schedule, real tReorient, real omegaCMin, real3 dir)
+{
+    const real period = 2.0_r * 2.0_r * M_PI / omegaCMin;
+    const int numPeriods = static_cast<int>(std::ceil(tReorient / period));
+
+    for (int id = 0; id < numPeriods; ++id)
+    {
+        const real sign = (id % 2) ? 1 : -1;
+        const real duration = std::min(period, tReorient - id * period);
+        schedule.addSegment(duration, sign * omegaCMin * 0.5_r, dir);
+    }
+}
+
+/** Append the propulsion phase to the schedule:
+    the field rotates around \p dir successively at the step out frequency of each body i during |beta_i|,
+    in the direction given by the sign of beta_i.
+    If \p addedIds is not null, the indices i of the segments that were not discarded by the schedule are appended to it.
+ */
+static void addPropulsionSegments(FieldSchedule& schedule, const std::vector<real>& betas,
+                                  const std::vector<real>& omegas, real3 dir,
+                                  std::vector<int> *addedIds = nullptr)
+{
+    for (size_t i = 0; i < betas.size(); ++i)
+    {
+        const real beta = betas[i];
+        const bool added = schedule.addSegment(std::fabs(beta), beta > 0 ? +omegas[i] : -omegas[i], dir);
+
+        if (added && addedIds)
+            addedIds->push_back(static_cast<int>(i));
+    }
+}
+
+namespace {
+
+/// The quantities describing the optimal path for given initial positions
+struct OptimalPlan
+{
+    Quaternion q;                              ///< the rotation from the reference frame to the swimming directions frame
+    std::array<real3, 3> dirs;                 ///< the three successive swimming directions
+    std::array<std::vector<real>, 3> betas;    ///< the time spent at each step out frequency along each direction (signed)
+    std::array<real, 3> travelTimes;           ///< the time spent swimming along each direction
+    std::vector<real> omegas;                  ///< the step out frequencies of the bodies
+    real tReorient;                            ///< the duration of each reorientation window
+    real omegaCMin;                            ///< the rotation frequency used during reorientation windows
+    real dt;                                   ///< the time step used to integrate the ODEs
+};
+
+/// Description of the schedule of an OptimalPlan, for each direction
+struct ScheduleLayout
+{
+    std::array<real, 3> reorientEndTimes;              ///< the end time of each reorientation window
+    std::array<std::vector<int>, 3> propulsionBodies;  ///< the body whose frequency is used by each propulsion segment
+};
+
+} // anonymous namespace
+
+/// \return the total time of a path made of a reorientation window of \p tReorient before each travel time
+static real computeTotalTime(real tReorient, const std::array<real, 3>& travelTimes)
+{
+    const real scan1 = tReorient + travelTimes[0];
+    const real scan2 = scan1 + tReorient + travelTimes[1];
+    return scan2 + tReorient + travelTimes[2];
+}
+
+static OptimalPlan computeOptimalPlan(real magneticFieldMagnitude, const std::vector<RigidBody>& bodies,
+                                      const std::vector<real3>& initialPositions, const MatrixReal& U, bool verbose)
+{
+    const auto A = computeA(U, initialPositions);
+    const Quaternion q = findBestPathCMAES(A);
+
+    OptimalPlan plan;
+    plan.q = q;
+    plan.omegas = computeStepOutFrequencies(magneticFieldMagnitude, bodies);
+
+    const real3 e1 {1.0_r, 0.0_r, 0.0_r};
+    const real3 e2 {0.0_r, 1.0_r, 0.0_r};
+    const real3 e3 {0.0_r, 0.0_r, 1.0_r};
+
+    plan.dirs = {{q.rotate(e1), q.rotate(e2), q.rotate(e3)}};
+
+    if (verbose)
+    {
+        std::cout << "dir1 " << plan.dirs[0] << std::endl
+                  << "dir2 " << plan.dirs[1] << std::endl
+                  << "dir3 " << plan.dirs[2] << std::endl;
+    }
+
+    for (int k = 0; k < 3; ++k)
+    {
+        plan.betas[k] = computeBetas(initialPositions, U, plan.dirs[k]);
+        plan.travelTimes[k] = computeTravelTime(A, plan.dirs[k]);
+    }
+
+    const real omegaPerpMin = computeMinOmega(2, bodies, magneticFieldMagnitude);
+    constexpr real secureFactor = 5.0_r;
+    plan.tReorient = secureFactor * 2.0_r * M_PI / omegaPerpMin;
+    plan.omegaCMin = computeMinOmega(0, bodies, magneticFieldMagnitude);
+
+    const real omegaMax = *std::max_element(plan.omegas.begin(), plan.omegas.end());
+    plan.dt = 1.0_r / (omegaMax * 20);
+
+    return plan;
+}
+
+/** \return The schedule of the optimal path: a reorientation window followed by the propulsion along each direction
+    \param plan The optimal path
+    \param layout If not null, will contain the description of the segments of the schedule
+ */
+static FieldSchedule createSchedule(const OptimalPlan& plan, ScheduleLayout *layout = nullptr)
+{
+    FieldSchedule schedule;
+    for (int k = 0; k < 3; ++k)
+    {
+        addReorientSegments(schedule, plan.tReorient, plan.omegaCMin, plan.dirs[k]);
+
+        if (layout)
+            layout->reorientEndTimes[k] = schedule.getEndTime();
+
+        addPropulsionSegments(schedule, plan.betas[k], plan.omegas, plan.dirs[k],
+                              layout ? &layout->propulsionBodies[k] : nullptr);
+    }
+    return schedule;
+}
+
+static std::vector<real3> extractPositions(const std::vector<RigidBody>& bodies)
+{
+    std::vector<real3> positions;
+    positions.reserve(bodies.size());
+    for (const auto& b : bodies)
+        positions.push_back(b.r);
+    return positions;
+}
+
 real simulateOptimalPath(real magneticFieldMagnitude,
                          std::vector<RigidBody> bodies, // by copy because will be modified (IC)
                          const std::vector<real3>& initialPositions,
@@ -41,103 +181,122 @@ real simulateOptimalPath(real magneticFieldMagnitude,
                          bool verbose)
 {
     const real kBT{0.0_r};
-    const auto A = computeA(U, initialPositions);
-    const Quaternion q = findBestPathCMAES(A);
-
-    const std::vector<real> omegas = computeStepOutFrequencies(magneticFieldMagnitude, bodies);
+    const OptimalPlan plan = computeOptimalPlan(magneticFieldMagnitude, bodies, initialPositions, U, verbose);
 
     for (size_t i = 0; i < bodies.size(); ++i)
     {
         bodies[i].r = initialPositions[i];
-        bodies[i].q = q;
+        bodies[i].q = plan.q;
     }
 
-    const real3 e1 {1.0_r, 0.0_r, 0.0_r};
-    const real3 e2 {0.0_r, 1.0_r, 0.0_r};
-    const real3 e3 {0.0_r, 0.0_r, 1.0_r};
+    const FieldSchedule schedule = createSchedule(plan);
 
-    const real3 dir1 = q.rotate(e1);
-    const real3 dir2 = q.rotate(e2);
-    const real3 dir3 = q.rotate(e3);
+    Simulation sim(bodies, schedule.createMagneticField(magneticFieldMagnitude), kBT, std::move(velocityField));
 
-    if (verbose)
-    {
-        std::cout << "dir1 " << dir1 << std::endl
-                  << "dir2 " << dir2 << std::endl
-                  << "dir3 " << dir3 << std::endl;
-    }
+    const real tTot = 3 * plan.tReorient + plan.travelTimes[0] + plan.travelTimes[1] + plan.travelTimes[2];
 
-    const auto betas1 = computeBetas(initialPositions, U, dir1);
-    const auto betas2 = computeBetas(initialPositions, U, dir2);
-    const auto betas3 = computeBetas(initialPositions, U, dir3);
+    if (dumpEvery > 0)
+        sim.activateDump(fname, dumpEvery);
 
-    const real t1 = computeTravelTime(A, dir1);
-    const real t2 = computeTravelTime(A, dir2);
-    const real t3 = computeTravelTime(A, dir3);
+    sim.runForwardEulerUntil(tTot, plan.dt, schedule.getSwitchTimes());
 
-    const real omegaPerpMin = computeMinOmega(2, bodies, magneticFieldMagnitude);
-    constexpr real secureFactor = 5.0_r;
-    const real tReorient = secureFactor * 2.0_r * M_PI / omegaPerpMin;
-    const real omegaCMin = computeMinOmega(0, bodies, magneticFieldMagnitude);
+    return tTot;
+}
 
-    const real scan1 = tReorient + t1;
-    const real scan2 = scan1 + tReorient + t2;
+/** Move the bodies until the next switching time, during which the field rotates at the constant frequency \p omega around \p dir.
+    The bodies swim at their mean velocity (\p meanVelocities, as in the velocity matrix) along \p dir and rotate with the field.
+    The drift of the background flow is added with a midpoint rule of \p numQuadraturePoints points; ignored if zero.
+ */
+static void propagateSegment(Simulation& sim, const std::vector<real>& switchTimes, const std::vector<real>& meanVelocities,
+                             real omega, real3 dir, int numQuadraturePoints, bool dump)
+{
+    const auto *velocityField = sim.getVelocityField();
+    auto& bodies = sim.getBodies();
+
+    const real tStart = sim.getCurrentTime();
+    const auto next = std::upper_bound(switchTimes.begin(), switchTimes.end(), tStart);
+    MSODE_Expect(next != switchTimes.end(), "No segment left in the schedule");
+    const real tEnd = *next;
 
-    auto getOmega = [&](real t, const std::vector<real>& betas)
+    const int n = std::max(1, numQuadraturePoints);
+    const real h = (tEnd - tStart) / n;
+    const Quaternion dq = Quaternion::createFromRotation(omega * h, dir);
+
+    for (int step = 0; step < n; ++step)
     {
-        if (t < tReorient)
-        {
-            const real period = 2.0_r * 2.0_r * M_PI / omegaCMin;
-            const int id = t / period;
-            const real sign = (id % 2) ? 1 : -1;
-            return sign * omegaCMin * 0.5_r;
-        }
+        const real tMid = tStart + (step + 0.5_r) * h;
 
-        t -= tReorient;
-        real tcum = 0.0_r;
-        for (size_t i = 0; i < betas.size(); ++i)
+        for (size_t i = 0; i < bodies.size(); ++i)
         {
-            const real beta = betas[i];
-            tcum += fabs(beta);
-            if (tcum > t)
-            {
-                return (beta > 0)
-                    ? +omegas[i]
-                    : -omegas[i];
-            }
+            auto& b = bodies[i];
+            const real3 v = meanVelocities[i] * dir;
+            real3 dr = h * v;
+
+            if (numQuadraturePoints > 0)
+                dr += h * velocityField->getVelocity(b.r + 0.5_r * dr, tMid);
+
+            b.r += dr;
+            b.q = (dq * b.q).normalized();
         }
-        return 0.0_r; // default, should not happen
-    };
 
-    std::function<real(real)> omega = [&](real t)
-    {
-        if      (t < scan1) return getOmega(t,       betas1);
-        else if (t < scan2) return getOmega(t-scan1, betas2);
-        else                return getOmega(t-scan2, betas3);
-    };
+        sim.skipUntil(step + 1 < n ? tStart + (step + 1) * h : tEnd, switchTimes);
 
-    std::function<real3(real)> rotatingDirection = [&](real t)
-    {
-        if      (t < scan1) return dir1;
-        else if (t < scan2) return dir2;
-        else                return dir3;
-    };
+        if (dump)
+            sim.dump();
+    }
+}
+
+ExecutionResult executeOptimalPathHybrid(real magneticFieldMagnitude,
+                                         std::vector<RigidBody> bodies, // by copy because will be modified (IC)
+                                         const std::vector<real3>& initialPositions,
+                                         std::unique_ptr<BaseVelocityField> velocityField,
+                                         const MatrixReal& U, int numQuadraturePoints,
+                                         const std::string& fname, int dumpEvery,
+                                         bool verbose)
+{
+    MSODE_Expect(numQuadraturePoints >= 0, "expect non negative number of quadrature points");
+
+    const real kBT{0.0_r};
+    const OptimalPlan plan = computeOptimalPlan(magneticFieldMagnitude, bodies, initialPositions, U, verbose);
+    const MatrixReal V = U.inverse();
+    const int n = static_cast<int>(bodies.size());
 
-    MagneticField magnField(magneticFieldMagnitude, omega, rotatingDirection);
-    Simulation sim(bodies, magnField, kBT, std::move(velocityField));
+    for (int i = 0; i < n; ++i)
+    {
+        bodies[i].r = initialPositions[i];
+        bodies[i].q = plan.q;
+    }
 
-    const real tTot = scan2 + tReorient + t3;
-    const real omegaMax = *std::max_element(omegas.begin(), omegas.end());
+    ScheduleLayout layout;
+    const FieldSchedule schedule = createSchedule(plan, &layout);
+    const auto& switchTimes = schedule.getSwitchTimes();
 
-    const real dt = 1.0_r / (omegaMax * 20);
-    const long nsteps = static_cast<long>(tTot/dt);
+    Simulation sim(bodies, schedule.createMagneticField(magneticFieldMagnitude), kBT, std::move(velocityField));
 
     if (dumpEvery > 0)
         sim.activateDump(fname, dumpEvery);
 
-    sim.runForwardEuler(nsteps, dt);
+    std::vector<real> meanVelocities(n);
 
-    return tTot;
+    for (int k = 0; k < 3; ++k)
+    {
+        sim.runForwardEulerUntil(layout.reorientEndTimes[k], plan.dt, switchTimes);
+
+        for (int j : layout.propulsionBodies[k])
+        {
+            const real beta = plan.betas[k][j];
+
+            // the mean velocities are odd functions of the frequency
+            const real sign = beta > 0 ? 1.0_r : -1.0_r;
+            for (int i = 0; i < n; ++i)
+                meanVelocities[i] = -sign * V(i,j);
+
+            propagateSegment(sim, switchTimes, meanVelocities, sign * plan.omegas[j],
+                             plan.dirs[k], numQuadraturePoints, dumpEvery > 0);
+        }
+    }
+
+    return {sim.getCurrentTime(), computeTotalTime(plan.tReorient, plan.travelTimes), extractPositions(sim.getBodies())};
 }
 
 static void reorientAllBodies(std::vector<RigidBody>& bodies, real3 dir)
@@ -156,100 +315,39 @@ real simulateOptimalPathForceReorient(real magneticFieldMagnitude,
                                       const MatrixReal& U, const std::string& fname, int dumpEvery,
                                       bool verbose)
 {
-    const auto A = computeA(U, initialPositions);
-    const Quaternion q = findBestPathCMAES(A);
     const real kBT{0.0_r};
-
-    const std::vector<real> omegas = computeStepOutFrequencies(magneticFieldMagnitude, bodies);
+    const OptimalPlan plan = computeOptimalPlan(magneticFieldMagnitude, bodies, initialPositions, U, verbose);
 
     for (size_t i = 0; i < bodies.size(); ++i)
     {
         bodies[i].r = initialPositions[i];
-        bodies[i].q = q;
-    }
-
-    const real3 e1 {1.0_r, 0.0_r, 0.0_r};
-    const real3 e2 {0.0_r, 1.0_r, 0.0_r};
-    const real3 e3 {0.0_r, 0.0_r, 1.0_r};
-
-    const real3 dir1 = q.rotate(e1);
-    const real3 dir2 = q.rotate(e2);
-    const real3 dir3 = q.rotate(e3);
-
-    if (verbose)
-    {
-        std::cout << "dir1 " << dir1 << std::endl
-                  << "dir2 " << dir2 << std::endl
-                  << "dir3 " << dir3 << std::endl;
+        bodies[i].q = plan.q;
     }
 
-    const auto betas1 = computeBetas(initialPositions, U, dir1);
-    const auto betas2 = computeBetas(initialPositions, U, dir2);
-    const auto betas3 = computeBetas(initialPositions, U, dir3);
-
-    const real t1 = computeTravelTime(A, dir1);
-    const real t2 = computeTravelTime(A, dir2);
-    const real t3 = computeTravelTime(A, dir3);
-
-    const real scan1 = t1;
-    const real scan2 = scan1 + t2;
-
-    auto getOmega = [&](real t, const std::vector<real>& betas)
-    {
-        real tcum = 0.0_r;
-        for (size_t i = 0; i < betas.size(); ++i)
-        {
-            const real beta = betas[i];
-            tcum += fabs(beta);
-            if (tcum > t)
-            {
-                return (beta > 0)
-                    ? +omegas[i]
-                    : -omegas[i];
-            }
-        }
-        return 0.0_r; // default, should not happen
-    };
-
-    std::function<real(real)> omega = [&](real t)
-    {
-        if      (t < scan1) return getOmega(t,       betas1);
-        else if (t < scan2) return getOmega(t-scan1, betas2);
-        else                return getOmega(t-scan2, betas3);
-    };
-
-    std::function<real3(real)> rotatingDirection = [&](real t)
-    {
-        if      (t < scan1) return dir1;
-        else if (t < scan2) return dir2;
-        else                return dir3;
-    };
+    const real scan1 = plan.travelTimes[0];
+    const real scan2 = scan1 + plan.travelTimes[1];
 
-    MagneticField magnField(magneticFieldMagnitude, omega, rotatingDirection);
-    Simulation sim(bodies, magnField, kBT, std::move(velocityField));
+    FieldSchedule schedule;
+    for (int k = 0; k < 3; ++k)
+        addPropulsionSegments(schedule, plan.betas[k], plan.omegas, plan.dirs[k]);
 
-    const real tTot = scan2 + t3;
-    const real omegaMax = *std::max_element(omegas.begin(), omegas.end());
+    Simulation sim(bodies, schedule.createMagneticField(magneticFieldMagnitude), kBT, std::move(velocityField));
 
-    const real dt = 1.0_r / (omegaMax * 20);
+    const real tTot = scan2 + plan.travelTimes[2];
 
     if (dumpEvery > 0)
         sim.activateDump(fname, dumpEvery);
 
-    auto run = [&](real t)
-    {
-        const long nsteps = static_cast<long>(t/dt);
-        sim.runForwardEuler(nsteps, dt);
-    };
+    const auto& switchTimes = schedule.getSwitchTimes();
 
-    reorientAllBodies(sim.getBodies(), dir1);
-    run(t1);
+    reorientAllBodies(sim.getBodies(), plan.dirs[0]);
+    sim.runForwardEulerUntil(scan1, plan.dt, switchTimes);
 
-    reorientAllBodies(sim.getBodies(), dir2);
-    run(t2);
+    reorientAllBodies(sim.getBodies(), plan.dirs[1]);
+    sim.runForwardEulerUntil(scan2, plan.dt, switchTimes);
 
-    reorientAllBodies(sim.getBodies(), dir3);
-    run(t3);
+    reorientAllBodies(sim.getBodies(), plan.dirs[2]);
+    sim.runForwardEulerUntil(tTot, plan.dt, switchTimes);
 
     return tTot;
 }
@@ -273,9 +371,9 @@ real computeRequiredTime(real magneticFieldMagnitude,
     const real3 dir2 = q.rotate(e2);
     const real3 dir3 = q.rotate(e3);
 
-    const real t1 = computeTravelTime(A, dir1);
-    const real t2 = computeTravelTime(A, dir2);
-    const real t3 = computeTravelTime(A, dir3);
+    const std::array<real, 3> travelTimes {{computeTravelTime(A, dir1),
+                                             computeTravelTime(A, dir2),
+                                             computeTravelTime(A, dir3)}};
 
     real tReorient {0.0_r};
     if (includeReorient)
@@ -285,11 +383,7 @@ real computeRequiredTime(real magneticFieldMagnitude,
         tReorient = secureFactor * 2.0_r * M_PI / omegaPerpMin;
     }
 
-    const real scan1 = tReorient + t1;
-    const real scan2 = scan1 + tReorient + t2;
-    const real tTot = scan2 + tReorient + t3;
-
-    return tTot;
+    return computeTotalTime(tReorient, travelTimes);
 }
 
 } // namespace analytic_control
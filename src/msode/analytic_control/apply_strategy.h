@@ -35,6 +35,38 @@ real simulateOptimalPathForceReorient(real magneticFieldMagnitude,
                                       const MatrixReal& U, const std::string& fname, int dumpEvery,
                                       bool verbose=false);
 
+/// Outcome of the execution of the optimal path
+struct ExecutionResult
+{
+    real time;                         ///< the total time of the path
+    real requiredTime;                 ///< the time of the planned path, as computeRequiredTime() with reorientation
+    std::vector<real3> finalPositions; ///< the positions of the bodies at the end of the path
+};
+
+/** Execute the optimal path of simulateOptimalPath() with a hybrid analytical/ODE approach.
+    Only the reorientation windows are integrated with the ODE solver. The propulsion segments are propagated
+    analytically: each body swims along the current direction at its mean velocity given by the velocity matrix.
+    \param magneticFieldMagnitude The magnetic field magnitude
+    \param bodies The list of all RigidBody objects (positions are irrelevant)
+    \param initialPositions The initial positions of each RigidBody. Must have the same dimensions as \p bodies
+    \param velocityField Background velocity field, used during the reorientation windows.
+    \param U the inverse of the velocity matrix associated to \p bodies
+    \param numQuadraturePoints Number of midpoint quadrature points per propulsion segment used to add the drift
+           of \p velocityField to the analytical propagation. The drift is neglected if zero.
+    \param fname Output file name of the trajectories. Only relevant if \p dumpEvery > 0
+    \param dumpEvery Dump trajectory point every this amount of time steps during reorientation windows,
+           and after each quadrature point during propulsion segments. if <= 0, will not dump anything.
+    \param verbose If true, print to console more information
+    \return the outcome of the execution; its requiredTime comes from the same optimization as the executed path
+ */
+ExecutionResult executeOptimalPathHybrid(real magneticFieldMagnitude,
+                                         std::vector<RigidBody> bodies,
+                                         const std::vector<real3>& initialPositions,
+                                         std::unique_ptr<BaseVelocityField> velocityField,
+                                         const MatrixReal& U, int numQuadraturePoints,
+                                         const std::string& fname = "", int dumpEvery = 0,
+                                         bool verbose=false);
+
 
 /** Compute the time taken bty the analytical method to bring the bodies to the target in free space, zero flow.
     \param magneticFieldMagnitude The magnetic field magnitude
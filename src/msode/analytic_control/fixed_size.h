@@ -0,0 +1,55 @@
+// Copyright 2020 ETH Zurich. All Rights Reserved.
+#pragma once
+
+#include <msode/core/types.h>
+
+#include <Eigen/Core>
+#include <type_traits>
+
+namespace msode {
+namespace analytic_control {
+
+/// Largest number of bodies for which the kernels are specialized at compile time
+constexpr int maxFixedSize = 8;
+
+/// Number of bodies known at compile time; Eigen::Dynamic if only known at run time
+template <int N>
+using SizeTag = std::integral_constant<int, N>;
+
+/// Square matrix of size N (Eigen::Dynamic for a run time size), with the same layout as MatrixReal
+template <int N>
+using MatrixRealN = Eigen::Matrix<real, N, N, Eigen::RowMajor>;
+
+/// \return \p N if it is a compile time size, \p n otherwise
+template <int N>
+constexpr int fixedOr(SizeTag<N>, int n)
+{
+    return N == Eigen::Dynamic ? n : N;
+}
+
+/** \brief Call a generic callable with the number of bodies known at compile time.
+    \param n The number of bodies
+    \param f Called as f(SizeTag<n>{}) if 1 <= n <= maxFixedSize, as f(SizeTag<Eigen::Dynamic>{}) otherwise
+    \return The value returned by \p f
+ */
+template <class F>
+inline auto dispatchFixedSize(int n, F&& f)
+{
+    static_assert(maxFixedSize == 8, "the cases below must cover all fixed sizes");
+
+    switch (n)
+    {
+    case 1: return f(SizeTag<1>{});
+    case 2: return f(SizeTag<2>{});
+    case 3: return f(SizeTag<3>{});
+    case 4: return f(SizeTag<4>{});
+    case 5: return f(SizeTag<5>{});
+    case 6: return f(SizeTag<6>{});
+    case 7: return f(SizeTag<7>{});
+    case 8: return f(SizeTag<8>{});
+    default: return f(SizeTag<Eigen::Dynamic>{});
+    };
+}
+
+} // namespace analytic_control
+} // namespace msode
@@ -0,0 +1,389 @@
+// Copyright 2020 ETH Zurich. All Rights Reserved.
+#include "landscape.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+namespace msode {
+namespace analytic_control {
+
+Quaternion quaternionFromLandscapeAngles(real theta, real phi, real psi)
+{
+    const real3 normal {std::cos(theta) * std::sin(phi),
+                        std::sin(theta) * std::sin(phi),
+                        std::cos(phi)};
+
+    const auto q = Quaternion::createFromRotation(psi, normal);
+    return q.normalized();
+}
+
+int getNumSignWords(int n)
+{
+    return (3 * n + 63) / 64;
+}
+
+void computeTravelTimes(const std::vector<real3>& A, const std::vector<Quaternion>& qs,
+                        std::vector<real>& times, std::vector<uint64_t> *signs)
+{
+    using MatrixN3 = Eigen::Matrix<real, Eigen::Dynamic, 3, Eigen::RowMajor>;
+    using Directions = Eigen::Matrix<real, 3, Eigen::Dynamic>;
+    using Projections = Eigen::Matrix<real, Eigen::Dynamic, Eigen::Dynamic>;
+
+    const int n = static_cast<int>(A.size());
+    const long m = static_cast<long>(qs.size());
+
+    MatrixN3 Am(n, 3);
+    for (int i = 0; i < n; ++i)
+        Am.row(i) << A[i].x, A[i].y, A[i].z;
+
+    // the three directions of each rotation
+    Directions D(3, 3 * m);
+    for (long s = 0; s < m; ++s)
+    {
+        const real3 d1 = qs[s].rotate({1.0_r, 0.0_r, 0.0_r});
+        const real3 d2 = qs[s].rotate({0.0_r, 1.0_r, 0.0_r});
+        const real3 d3 = qs[s].rotate({0.0_r, 0.0_r, 1.0_r});
+        D.col(3*s + 0) << d1.x, d1.y, d1.z;
+        D.col(3*s + 1) << d2.x, d2.y, d2.z;
+        D.col(3*s + 2) << d3.x, d3.y, d3.z;
+    }
+
+    // P(i, 3s+k) = dot(A_i, d_k(q_s))
+    const Projections P = Am * D;
+    const Eigen::Matrix<real, 1, Eigen::Dynamic> columnSums = P.cwiseAbs().colwise().sum();
+
+    times.resize(m);
+    for (long s = 0; s < m; ++s)
+        times[s] = columnSums[3*s] + columnSums[3*s + 1] + columnSums[3*s + 2];
+
+    if (signs)
+    {
+        const int numWords = getNumSignWords(n);
+        signs->assign(m * numWords, 0);
+
+        for (long s = 0; s < m; ++s)
+        {
+            uint64_t *word = signs->data() + s * numWords;
+            for (int i = 0; i < n; ++i)
+                for (int k = 0; k < 3; ++k)
+                {
+                    const int bit = 3 * i + k;
+                    if (P(i, 3*s + k) >= 0.0_r)
+                        word[bit / 64] |= uint64_t(1) << (bit % 64);
+                }
+        }
+    }
+}
+
+namespace {
+
+/// Per-worker buffers used to evaluate the travel times by batches
+struct BatchBuffers
+{
+    std::vector<Quaternion> qs;
+    std::vector<long> ids;
+    std::vector<real> times;
+    std::vector<uint64_t> signs;
+};
+
+} // anonymous namespace
+
+static inline int wrap(int i, int n)
+{
+    return (i % n + n) % n;
+}
+
+/** Call f(neighbourIndex) for the (up to) 26 neighbours of the point (ith, iph, ips) of a grid periodic in theta and psi.
+    Neighbours outside of [0, nphi) in phi are skipped.
+ */
+template <class F>
+static inline void forEachNeighbour(int ntheta, int nphi, int npsi, int ith, int iph, int ips, F f)
+{
+    for (int dps = -1; dps <= 1; ++dps)
+        for (int dph = -1; dph <= 1; ++dph)
+        {
+            const int jph = iph + dph;
+            if (jph < 0 || jph >= nphi)
+                continue;
+
+            for (int dth = -1; dth <= 1; ++dth)
+            {
+                if (dth == 0 && dph == 0 && dps == 0)
+                    continue;
+
+                const int jth = wrap(ith + dth, ntheta);
+                const int jps = wrap(ips + dps, npsi);
+                f(jth + ntheta * (jph + nphi * static_cast<long>(jps)));
+            }
+        }
+}
+
+LandscapeGrid computeLandscape(const std::vector<real3>& A, int coarseRes, int refinement, utils::ThreadPool& pool)
+{
+    MSODE_Expect(coarseRes > 0, "expect a positive resolution, got %d", coarseRes);
+    MSODE_Expect(refinement > 0, "expect a positive refinement factor, got %d", refinement);
+
+    const int numWords = getNumSignWords(static_cast<int>(A.size()));
+    std::vector<BatchBuffers> buffers(pool.getNumThreads());
+
+    // coarse grid; includes the row phi = pi so that all the cells of the fine grid have 8 corners
+    const int ntc = 2 * coarseRes;
+    const int npc = coarseRes + 1;
+    const int nsc = coarseRes;
+
+    const real dtheta = 2 * M_PI / ntc;
+    const real dphi   =     M_PI / coarseRes;
+    const real dpsi   = 2 * M_PI / nsc;
+
+    auto coarseIndex = [&](int ith, int iph, int ips)
+    {
+        return ith + ntc * (iph + npc * static_cast<long>(ips));
+    };
+
+    const long numCoarse = static_cast<long>(ntc) * npc * nsc;
+    std::vector<real> coarseValues(numCoarse);
+    std::vector<uint64_t> coarseSigns(numCoarse * numWords);
+
+    pool.run(nsc, [&](long ips, int workerId)
+    {
+        auto& b = buffers[workerId];
+        b.qs.clear();
+
+        for (int iph = 0; iph < npc; ++iph)
+            for (int ith = 0; ith < ntc; ++ith)
+                b.qs.push_back(quaternionFromLandscapeAngles(ith * dtheta, iph * dphi, ips * dpsi));
+
+        computeTravelTimes(A, b.qs, b.times, &b.signs);
+
+        const long start = coarseIndex(0, 0, static_cast<int>(ips));
+        std::copy(b.times.begin(), b.times.end(), coarseValues.begin() + start);
+        std::copy(b.signs.begin(), b.signs.end(), coarseSigns.begin() + start * numWords);
+    });
+
+    // flag the cells to refine
+    std::vector<char> isCoarseMinimum(numCoarse, 0);
+
+    pool.run(nsc, [&](long ips, int)
+    {
+        for (int iph = 0; iph < npc; ++iph)
+            for (int ith = 0; ith < ntc; ++ith)
+            {
+                const long id = coarseIndex(ith, iph, static_cast<int>(ips));
+                bool isMin = true;
+                forEachNeighbour(ntc, npc, nsc, ith, iph, static_cast<int>(ips), [&](long j)
+                {
+                    isMin &= coarseValues[id] <= coarseValues[j];
+                });
+                isCoarseMinimum[id] = isMin;
+            }
+    });
+
+    // cell (ith, iph, ips) has corners (ith + {0,1}, iph + {0,1}, ips + {0,1})
+    const long numCells = static_cast<long>(ntc) * coarseRes * nsc;
+    std::vector<char> refineCell(numCells, 0);
+
+    auto cellIndex = [&](int ith, int iph, int ips)
+    {
+        return ith + ntc * (iph + coarseRes * static_cast<long>(ips));
+    };
+
+    pool.run(nsc, [&](long ips, int)
+    {
+        for (int iph = 0; iph < coarseRes; ++iph)
+            for (int ith = 0; ith < ntc; ++ith)
+            {
+                const long first = coarseIndex(ith, iph, static_cast<int>(ips));
+                bool refine = false;
+
+                for (int corner = 0; corner < 8 && !refine; ++corner)
+                {
+                    const long id = coarseIndex(wrap(ith + (corner & 1), ntc),
+                                                iph + ((corner >> 1) & 1),
+                                                wrap(static_cast<int>(ips) + ((corner >> 2) & 1), nsc));
+
+                    refine |= isCoarseMinimum[id] != 0;
+                    refine |= !std::equal(coarseSigns.begin() + first * numWords,
+                                          coarseSigns.begin() + (first + 1) * numWords,
+                                          coarseSigns.begin() + id * numWords);
+                }
+                refineCell[cellIndex(ith, iph, static_cast<int>(ips))] = refine;
+            }
+    });
+
+    // fine grid: exact values in the refined cells, trilinear interpolation elsewhere
+    LandscapeGrid grid;
+    grid.ntheta = ntc * refinement;
+    grid.nphi   = coarseRes * refinement;
+    grid.npsi   = nsc * refinement;
+    grid.dtheta = dtheta / refinement;
+    grid.dphi   = dphi   / refinement;
+    grid.dpsi   = dpsi   / refinement;
+    grid.values.resize(static_cast<long>(grid.ntheta) * grid.nphi * grid.npsi);
+
+    std::vector<long> numEvaluationsPerSlice(grid.npsi, 0);
+
+    pool.run(grid.npsi, [&](long kps, int workerId)
+    {
+        auto& b = buffers[workerId];
+        b.qs.clear();
+        b.ids.clear();
+
+        const int ips = static_cast<int>(kps) / refinement;
+        const real fps = static_cast<real>(kps % refinement) / refinement;
+
+        for (int kph = 0; kph < grid.nphi; ++kph)
+        {
+            const int iph = kph / refinement;
+            const real fph = static_cast<real>(kph % refinement) / refinement;
+
+            for (int kth = 0; kth < grid.ntheta; ++kth)
+            {
+                const int ith = kth / refinement;
+                const real fth = static_cast<real>(kth % refinement) / refinement;
+                const long id = grid.index(kth, kph, static_cast<int>(kps));
+
+                const bool onCoarseGrid = kth % refinement == 0 && kph % refinement == 0 && kps % refinement == 0;
+
+                if (refineCell[cellIndex(ith, iph, ips)] && !onCoarseGrid)
+                {
+                    b.qs.push_back(quaternionFromLandscapeAngles(kth * grid.dtheta, kph * grid.dphi, kps * grid.dpsi));
+                    b.ids.push_back(id);
+                    continue;
+                }
+
+                real v {0.0_r};
+                for (int corner = 0; corner < 8; ++corner)
+                {
+                    const int cth = corner & 1;
+                    const int cph = (corner >> 1) & 1;
+                    const int cps = (corner >> 2) & 1;
+                    const real w = (cth ? fth : 1 - fth) * (cph ? fph : 1 - fph) * (cps ? fps : 1 - fps);
+                    v += w * coarseValues[coarseIndex(wrap(ith + cth, ntc), iph + cph, wrap(ips + cps, nsc))];
+                }
+                grid.values[id] = v;
+            }
+        }
+
+        computeTravelTimes(A, b.qs, b.times);
+
+        for (size_t i = 0; i < b.ids.size(); ++i)
+            grid.values[b.ids[i]] = b.times[i];
+
+        numEvaluationsPerSlice[kps] = static_cast<long>(b.ids.size());
+    });
+
+    grid.numEvaluations = numCoarse;
+    for (auto n : numEvaluationsPerSlice)
+        grid.numEvaluations += n;
+
+    return grid;
+}
+
+std::vector<LocalMinimum> findLocalMinima(const LandscapeGrid& grid)
+{
+    const long numPoints = static_cast<long>(grid.values.size());
+    const auto& values = grid.values;
+
+    // steepest descent: each point points to its lowest neighbour, or to itself if it is a local minimum
+    std::vector<long> next(numPoints);
+
+    for (int ips = 0; ips < grid.npsi; ++ips)
+        for (int iph = 0; iph < grid.nphi; ++iph)
+            for (int ith = 0; ith < grid.ntheta; ++ith)
+            {
+                const long id = grid.index(ith, iph, ips);
+                long best = id;
+                forEachNeighbour(grid.ntheta, grid.nphi, grid.npsi, ith, iph, ips, [&](long j)
+                {
+                    // ties are broken by index so that flat regions (e.g. at psi = 0) drain to a single point
+                    if (values[j] < values[best] || (values[j] == values[best] && j < best))
+                        best = j;
+                });
+                next[id] = best;
+            }
+
+    // follow the paths to the minima, with path compression
+    for (long id = 0; id < numPoints; ++id)
+    {
+        long root = id;
+        while (next[root] != root)
+            root = next[root];
+
+        for (long p = id; next[p] != root; )
+        {
+            const long q = next[p];
+            next[p] = root;
+            p = q;
+        }
+    }
+
+    std::vector<long> basinSizes(numPoints, 0);
+    for (long id = 0; id < numPoints; ++id)
+        ++basinSizes[next[id]];
+
+    std::vector<LocalMinimum> minima;
+    for (long id = 0; id < numPoints; ++id)
+    {
+        if (basinSizes[id] == 0)
+            continue;
+
+        const int ith = static_cast<int>(id % grid.ntheta);
+        const int iph = static_cast<int>((id / grid.ntheta) % grid.nphi);
+        const int ips = static_cast<int>(id / (static_cast<long>(grid.ntheta) * grid.nphi));
+
+        minima.push_back({ith * grid.dtheta, iph * grid.dphi, ips * grid.dpsi,
+                          values[id], static_cast<real>(basinSizes[id]) / numPoints});
+    }
+
+    // every descent path ends at a minimum, so a non empty grid has at least one
+    MSODE_Ensure(!minima.empty(), "no local minimum found on a grid of %ld points", numPoints);
+
+    std::sort(minima.begin(), minima.end(), [](const LocalMinimum& a, const LocalMinimum& b)
+    {
+        return a.travelTime < b.travelTime;
+    });
+
+    return minima;
+}
+
+/// append the big endian representation of \p v (as expected by legacy binary vtk files)
+static inline void appendBigEndian(std::vector<char>& buffer, float v)
+{
+    uint32_t u;
+    std::memcpy(&u, &v, sizeof(u));
+
+    for (int shift = 24; shift >= 0; shift -= 8)
+        buffer.push_back(static_cast<char>((u >> shift) & 0xff));
+}
+
+void dumpToBinaryVtk(const LandscapeGrid& grid, const std::string& fileName)
+{
+    std::ofstream f(fileName, std::ios::binary);
+    MSODE_Ensure(f.is_open(), "Error opening file '%s'", fileName.c_str());
+
+    f << "# vtk DataFile Version 2.0\n"
+      << "Travel time landscape dumped from msode\n"
+      << "BINARY\n";
+
+    f << "DATASET STRUCTURED_POINTS\n"
+      << "DIMENSIONS " << grid.ntheta << ' ' << grid.nphi << ' ' << grid.npsi << '\n'
+      << "ORIGIN " << 0 << ' ' << 0 << ' ' << 0 << '\n'
+      << "SPACING " << grid.dtheta << ' ' << grid.dphi << ' ' << grid.dpsi << '\n';
+
+    f << "POINT_DATA " << grid.values.size() << "\n"
+      << "SCALARS travelTime float 1\n"
+      << "LOOKUP_TABLE default\n";
+
+    std::vector<char> buffer;
+    buffer.reserve(grid.values.size() * sizeof(float));
+
+    for (auto v : grid.values)
+        appendBigEndian(buffer, static_cast<float>(v));
+
+    f.write(buffer.data(), buffer.size());
+    f << '\n';
+}
+
+} // namespace analytic_control
+} // namespace msode
@@ -0,0 +1,79 @@
+// Copyright 2020 ETH Zurich. All Rights Reserved.
+#pragma once
+
+#include "helpers.h"
+
+#include <msode/core/quaternion.h>
+#include <msode/utils/thread_pool.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace msode {
+namespace analytic_control {
+
+/** \brief The rotation parametrized by the landscape angles.
+    \param theta The azimuthal angle of the rotation axis, in [0, 2pi)
+    \param phi The polar angle of the rotation axis, in [0, pi]
+    \param psi The rotation angle, in [0, 2pi)
+ */
+Quaternion quaternionFromLandscapeAngles(real theta, real phi, real psi);
+
+/** \brief Compute computeTravelTime(A, q) for a batch of rotations with a single matrix product.
+    \param A see computeA()
+    \param qs The rotations
+    \param times Output; resized to the number of rotations
+    \param signs If not null, receives for each rotation the signs of all the terms dot(A_i, d_k),
+           packed in getNumSignWords(A.size()) words per rotation (bit 3*i+k is set if the term is non negative).
+ */
+void computeTravelTimes(const std::vector<real3>& A, const std::vector<Quaternion>& qs,
+                        std::vector<real>& times, std::vector<uint64_t> *signs = nullptr);
+
+/// \return the number of 64 bits words needed to store the signs of the 3*n terms of the travel time
+int getNumSignWords(int n);
+
+/** The travel time sampled on a uniform grid of the landscape angles.
+    theta and psi are periodic with ntheta = 2 * res and npsi = res points; phi has nphi = res points in [0, pi).
+    Points are stored with theta running fastest, then phi, then psi.
+ */
+struct LandscapeGrid
+{
+    int ntheta, nphi, npsi;
+    real dtheta, dphi, dpsi;
+    std::vector<real> values;
+    long numEvaluations; ///< number of points where the travel time was evaluated exactly
+
+    long index(int ith, int iph, int ips) const {return ith + ntheta * (iph + nphi * static_cast<long>(ips));}
+};
+
+/** \brief Compute the travel time landscape with adaptive refinement.
+    \param A see computeA()
+    \param coarseRes The resolution of the coarse grid, evaluated everywhere
+    \param refinement The refinement factor; the output grid has a resolution coarseRes * refinement
+    \param pool The threads used for the evaluations
+
+    A coarse cell is refined (evaluated exactly at every fine point) if one of the terms |dot(A_i, d_k)| changes
+    sign between its corners (kink of the travel time) or if one of its corners is a local minimum of the coarse grid.
+    Elsewhere the travel time is smooth and is interpolated trilinearly from the coarse grid.
+ */
+LandscapeGrid computeLandscape(const std::vector<real3>& A, int coarseRes, int refinement, utils::ThreadPool& pool);
+
+/// A local minimum of the landscape
+struct LocalMinimum
+{
+    real theta, phi, psi;
+    real travelTime;
+    real basinFraction; ///< fraction of the grid points that reach this minimum by steepest descent
+};
+
+/** \brief Find the local minima of the grid and their basins of attraction.
+    \return The minima (over the 26 neighbours of each point), sorted by increasing travel time; never empty.
+ */
+std::vector<LocalMinimum> findLocalMinima(const LandscapeGrid& grid);
+
+/// Dump the grid to a binary legacy vtk file (structured points, scalar "travelTime").
+void dumpToBinaryVtk(const LandscapeGrid& grid, const std::string& fileName);
+
+} // namespace analytic_control
+} // namespace msode
@@ -1,5 +1,6 @@
 // Copyright 2020 ETH Zurich. All Rights Reserved.
 #include "optimal_path.h"
+#include "fixed_size.h"
 #include "helpers.h"
 
 #include <msode/utils/optimizers/cmaes.h>
@@ -18,21 +19,40 @@ namespace analytic_control {
 
 std::vector<real3> computeA(const MatrixReal& U, const std::vector<real3>& positions)
 {
-    const size_t n = positions.size();
     std::vector<real3> A;
-    A.reserve(n);
+    computeA(U, positions, A);
+    return A;
+}
 
-    for (size_t i = 0; i < n; ++i)
+template <int N>
+static inline void computeA(SizeTag<N> size, const MatrixReal& U, const real3 *positions, real3 *A)
+{
+    const int n = fixedOr(size, static_cast<int>(U.rows()));
+    const Eigen::Map<const MatrixRealN<N>> Un(U.data(), n, n);
+
+    for (int i = 0; i < n; ++i)
     {
         auto ai = make_real3(0.0_r);
 
-        for (size_t j = 0; j < n; ++j)
-            ai += U(i,j) * positions[j];
+        for (int j = 0; j < n; ++j)
+            ai += Un(i,j) * positions[j];
 
-        A.push_back(ai);
+        A[i] = ai;
     }
+}
 
-    return A;
+void computeA(const MatrixReal& U, const std::vector<real3>& positions, std::vector<real3>& A)
+{
+    const int n = static_cast<int>(positions.size());
+    MSODE_Expect(U.rows() == n && U.cols() == n,
+                 "Expect a %d x %d matrix, got %d x %d",
+                 n, n, static_cast<int>(U.rows()), static_cast<int>(U.cols()));
+    A.resize(n);
+
+    dispatchFixedSize(n, [&](auto size)
+    {
+        computeA(size, U, positions.data(), A.data());
+    });
 }
 
 
@@ -48,16 +68,51 @@ real computeTravelTime(const std::vector<real3>& A, real3 direction)
     return t;
 }
 
-real computeTravelTime(const std::vector<real3>& A, Quaternion q)
+template <int N>
+static inline real computeTravelTime(SizeTag<N> size, const real3 *A, int n, Quaternion q)
 {
     constexpr real3 e1 {1.0_r, 0.0_r, 0.0_r};
     constexpr real3 e2 {0.0_r, 1.0_r, 0.0_r};
     constexpr real3 e3 {0.0_r, 0.0_r, 1.0_r};
 
-    return
-        computeTravelTime(A, q.rotate(e1)) +
-        computeTravelTime(A, q.rotate(e2)) +
-        computeTravelTime(A, q.rotate(e3));
+    const real3 d1 = q.rotate(e1);
+    const real3 d2 = q.rotate(e2);
+    const real3 d3 = q.rotate(e3);
+
+    // one sum per direction, in the same order as computeTravelTime(A, direction)
+    real t1 {0._r}, t2 {0._r}, t3 {0._r};
+    for (int i = 0; i < fixedOr(size, n); ++i)
+    {
+        t1 += std::fabs(dot(A[i], d1));
+        t2 += std::fabs(dot(A[i], d2));
+        t3 += std::fabs(dot(A[i], d3));
+    }
+    return t1 + t2 + t3;
+}
+
+real computeTravelTime(const std::vector<real3>& A, Quaternion q)
+{
+    const int n = static_cast<int>(A.size());
+
+    return dispatchFixedSize(n, [&](auto size)
+    {
+        return computeTravelTime(size, A.data(), n, q);
+    });
+}
+
+real computeTravelTimeLowerBound(const std::vector<real3>& A, const std::vector<real>& tolerances)
+{
+    MSODE_Expect(tolerances.empty() || tolerances.size() == A.size(),
+                 "Expect one tolerance per entry of A, got %zu and %zu",
+                 tolerances.size(), A.size());
+
+    real t {0._r};
+    for (size_t i = 0; i < A.size(); ++i)
+    {
+        const real tolerance = tolerances.empty() ? 0.0_r : tolerances[i];
+        t += std::max(0.0_r, length(A[i]) - tolerance);
+    }
+    return t;
 }
 
 /** \brief maps from euler angles to quaternion
@@ -79,9 +134,10 @@ int sgn(T val)
     return (T(0) < val) - (val < T(0));
 }
 
-Quaternion findBestPathCMAES(const std::vector<real3>& A, long seed, bool verbose)
+template <int N>
+static Quaternion findBestPathCMAES(SizeTag<N> size, const std::vector<real3>& A, long seed, bool verbose)
 {
-    using namespace utils;
+    using CMAES = utils::CMAES<3>; // theta, phi, psi
 
     CMAES::Info info;
     info.fval = std::numeric_limits<real>::max();
@@ -89,20 +145,22 @@ Quaternion findBestPathCMAES(const std::vector<real3>& A, long seed, bool verbos
     const int maxIterations = 500;
     std::mt19937 gen(seed);
 
-    auto travelTime = [&](const CMAES::Vector& x) -> real
+    const int n = static_cast<int>(A.size());
+    const real3 *Adata = A.data();
+
+    auto travelTime = [size, n, Adata](const CMAES::Vector& x) -> real
     {
         const auto q = anglesToQuaternion(x(0), x(1), x(2));
-        return computeTravelTime(A, q);
+        return computeTravelTime(size, Adata, n, q);
     };
 
     const int lambda = 16;
     const real sigma = 0.5 * M_PI;
     const real tolerance = 1e-5_r;
-    std::uniform_real_distribution<real> dist(0, M_PI);
 
     for (int i = 0; i < maxTries; ++i)
     {
-        const CMAES::Vector initialGuess = CMAES::Vector::Zero(3);
+        const CMAES::Vector initialGuess = CMAES::Vector::Zero();
 
         CMAES cma(travelTime, lambda, initialGuess, sigma, gen());
         auto currInfo = cma.runMinimization(tolerance, maxIterations, verbose);
@@ -115,6 +173,14 @@ Quaternion findBestPathCMAES(const std::vector<real3>& A, long seed, bool verbos
     return anglesToQuaternion(info.x(0), info.x(1), info.x(2));
 }
 
+Quaternion findBestPathCMAES(const std::vector<real3>& A, long seed, bool verbose)
+{
+    return dispatchFixedSize(static_cast<int>(A.size()), [&](auto size)
+    {
+        return findBestPathCMAES(size, A, seed, verbose);
+    });
+}
+
 
 real3 computeTravelTimeGradient(const std::vector<real3>& A, real theta, real phi, real psi)
 {
@@ -173,6 +239,8 @@ real3 computeTravelTimeGradient(const std::vector<real3>& A, real theta, real ph
     return gradient;
 }
 
+using VectorReal = Eigen::Matrix<real, Eigen::Dynamic, 1>;
+
 class TravelTimeSmoothFunction
 {
 public:
@@ -181,7 +249,7 @@ public:
         epsilon_(epsilon)
     {}
 
-    real operator()(const Eigen::VectorXd& x, Eigen::VectorXd& grad) const
+    real operator()(const VectorReal& x, VectorReal& grad) const
     {
         const real theta = x[0];
         const real phi = x[1];
@@ -265,7 +333,6 @@ private:
 
 Quaternion findBestPathLBFGS(const std::vector<real3>& A)
 {
-    using Eigen::VectorXd;
     using namespace LBFGSpp;
 
     TravelTimeSmoothFunction func(A, 5e-1_r);
@@ -281,7 +348,7 @@ Quaternion findBestPathLBFGS(const std::vector<real3>& A)
     LBFGSSolver<real, LineSearchBracketing> solver(param);
 
     // Initial guess
-    VectorXd x = VectorXd::Zero(n);
+    VectorReal x = VectorReal::Zero(n);
     // x will be overwritten to be the best point found
     real fx;
     // const int niter =
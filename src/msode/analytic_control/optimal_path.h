@@ -11,6 +11,13 @@ namespace analytic_control {
 /// \return A = U * positions
 std::vector<real3> computeA(const MatrixReal& U, const std::vector<real3>& positions);
 
+/** \brief Compute A = U * positions into a caller-owned buffer.
+    \param U The inverse of the velocity matrix
+    \param positions The positions of the bodies
+    \param A Output; resized to the number of positions. Does not allocate if its capacity is large enough.
+ */
+void computeA(const MatrixReal& U, const std::vector<real3>& positions, std::vector<real3>& A);
+
 /** \brief Compute the time it takes to bring the swimmers on the plane perpendicular to the given direction
     \param A see computeA()
     \param direction the normal to the plane; must be of unit length
@@ -23,7 +30,19 @@ real computeTravelTime(const std::vector<real3>& A, real3 direction);
  */
 real computeTravelTime(const std::vector<real3>& A, Quaternion q);
 
+/** \brief Compute a lower bound of computeTravelTime(A, q) over all rotations q.
+    \param A see computeA()
+    \param tolerances Optional; the distance along each entry of A that does not need to be travelled
+                      (e.g. because the target has a finite radius). Must be empty or have the same size as A.
+    \return sum_i max(0, |a_i| - tolerance_i)
+
+    This follows from |a.e1| + |a.e2| + |a.e3| >= |a| for any orthonormal basis e1, e2, e3.
+ */
+real computeTravelTimeLowerBound(const std::vector<real3>& A, const std::vector<real>& tolerances = {});
+
 /** \brief Find the rotation that minimizes computeTravelTime() with CMA-ES
+    Uses fixed size kernels for small numbers of bodies; the result matches the dynamic size
+    implementation up to round-off (the covariance matrix is decomposed iteratively in both cases).
  */
 Quaternion findBestPathCMAES(const std::vector<real3>& A, long seed = 42424242, bool verbose=false);
 
@@ -0,0 +1,75 @@
+// Copyright 2020 ETH Zurich. All Rights Reserved.
+#include "separability.h"
+
+#include <cstdint>
+
+namespace msode {
+namespace analytic_control {
+
+using VectorReal1D = Eigen::Matrix<real, Eigen::Dynamic, 1>;
+
+ArrayReal computeTravelTimes1D(const MatrixReal& U, const PositionsMatrix1D& X)
+{
+    MSODE_Expect(U.cols() == X.rows(),
+                 "Expect %d positions per configuration, got %d",
+                 static_cast<int>(U.cols()), static_cast<int>(X.rows()));
+
+    const PositionsMatrix1D A = U * X;
+    return A.cwiseAbs().colwise().sum().transpose();
+}
+
+/// \return The index of the bit that differs between the Gray codes of k-1 and k (k > 0)
+static inline int flippedBit(uint64_t k)
+{
+    return __builtin_ctzll(k);
+}
+
+real computeMeanTravelTimeCorners1D(const MatrixReal& U, real L)
+{
+    const int n = static_cast<int>(U.rows());
+    MSODE_Expect(U.cols() == n, "Expect a square matrix");
+    MSODE_Expect(n >= 1 && n < 64, "Expect between 1 and 63 bodies, got %d", n);
+
+    // the travel time is the same for X and -X: only enumerate the configurations where the last body is at -L
+    const uint64_t numConfigs = uint64_t(1) << (n - 1);
+
+    // contiguous columns for the updates
+    const PositionsMatrix1D twoLU = 2.0_r * L * U;
+    const VectorReal1D aAllLeft = -L * U.rowwise().sum();
+
+    // A is recomputed from scratch at this frequency to bound the accumulation of round off errors
+    constexpr uint64_t resyncPeriod = 4096;
+
+    VectorReal1D a(n);
+    double tSum {0.0};
+
+    for (uint64_t k = 0; k < numConfigs; ++k)
+    {
+        // bit j is set if body j is at +L
+        const uint64_t gray = k ^ (k >> 1);
+
+        if (k % resyncPeriod == 0)
+        {
+            a = aAllLeft;
+            for (int j = 0; j < n - 1; ++j)
+                if ((gray >> j) & 1)
+                    a += twoLU.col(j);
+        }
+        else
+        {
+            const int j = flippedBit(k);
+
+            if ((gray >> j) & 1)
+                a += twoLU.col(j);
+            else
+                a -= twoLU.col(j);
+        }
+
+        tSum += a.cwiseAbs().sum();
+    }
+
+    return static_cast<real>(tSum / numConfigs);
+}
+
+} // namespace analytic_control
+} // namespace msode
@@ -0,0 +1,33 @@
+// Copyright 2020 ETH Zurich. All Rights Reserved.
+#pragma once
+
+#include "helpers.h"
+
+namespace msode {
+namespace analytic_control {
+
+/// Positions of the bodies along one direction, one configuration per column (column major)
+using PositionsMatrix1D = Eigen::Matrix<real, Eigen::Dynamic, Eigen::Dynamic>;
+
+/** \brief Compute the travel times along one direction of many configurations at once.
+    \param U The inverse of the velocity matrix
+    \param X The positions of the n bodies along the direction of travel; a n x numConfigs matrix
+    \return The travel time of each configuration, sum_i |(U X)_i|
+
+    Equivalent to computeTravelTime(computeA(U, positions), direction) for each column of \p X,
+    but performed as a single matrix product.
+ */
+ArrayReal computeTravelTimes1D(const MatrixReal& U, const PositionsMatrix1D& X);
+
+/** \brief Compute the mean travel time along one direction over all the configurations where each body
+           starts either at -L or at +L.
+    \param U The inverse of the velocity matrix of n < 64 bodies
+    \param L The distance of the bodies to the target
+
+    The 2^n configurations are enumerated in Gray code order, so that two consecutive ones differ by a single
+    body and A = U X is updated in O(n). The symmetry X -> -X halves the enumeration.
+ */
+real computeMeanTravelTimeCorners1D(const MatrixReal& U, real L);
+
+} // namespace analytic_control
+} // namespace msode
@@ -0,0 +1,83 @@
+// Copyright 2020 ETH Zurich. All Rights Reserved.
+#pragma once
+
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace msode {
+namespace binary_io {
+
+/** Helpers to write and read plain values in the native binary representation, e.g. for checkpoints and logs.
+    The floating point values are stored bitwise. The files are not portable across architectures.
+    The read functions do not check for errors: the caller must check the state of the stream.
+ */
+
+template <class T>
+inline void write(std::ostream& stream, const T& value)
+{
+    static_assert(std::is_trivially_copyable<T>::value, "can only write trivially copyable types");
+    stream.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template <class T>
+inline void write(std::ostream& stream, const std::vector<T>& values)
+{
+    static_assert(std::is_trivially_copyable<T>::value, "can only write trivially copyable types");
+    write(stream, static_cast<std::uint64_t>(values.size()));
+    stream.write(reinterpret_cast<const char*>(values.data()), values.size() * sizeof(T));
+}
+
+inline void write(std::ostream& stream, const std::string& s)
+{
+    write(stream, static_cast<std::uint64_t>(s.size()));
+    stream.write(s.data(), s.size());
+}
+
+
+template <class T>
+inline void read(std::istream& stream, T& value)
+{
+    static_assert(std::is_trivially_copyable<T>::value, "can only read trivially copyable types");
+    stream.read(reinterpret_cast<char*>(&value), sizeof(T));
+}
+
+template <class T>
+inline void read(std::istream& stream, std::vector<T>& values)
+{
+    static_assert(std::is_trivially_copyable<T>::value, "can only read trivially copyable types");
+    std::uint64_t size {0};
+    read(stream, size);
+    if (!stream) return;
+    values.resize(size);
+    stream.read(reinterpret_cast<char*>(values.data()), size * sizeof(T));
+}
+
+/** \brief Read a vector written by write() into \p values, which must already have the size of the stored vector.
+    \return \c false if the sizes differ; \p values is then not modified. Does not allocate memory.
+ */
+template <class T>
+inline bool readSameSize(std::istream& stream, std::vector<T>& values)
+{
+    static_assert(std::is_trivially_copyable<T>::value, "can only read trivially copyable types");
+    std::uint64_t size {0};
+    read(stream, size);
+    if (!stream || size != values.size()) return false;
+    stream.read(reinterpret_cast<char*>(values.data()), size * sizeof(T));
+    return true;
+}
+
+inline void read(std::istream& stream, std::string& s)
+{
+    std::uint64_t size {0};
+    read(stream, size);
+    if (!stream) return;
+    s.resize(size);
+    stream.read(&s[0], size);
+}
+
+} // namespace binary_io
+} // namespace msode
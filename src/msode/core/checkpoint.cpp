@@ -0,0 +1,178 @@
+// Copyright 2020 ETH Zurich. All Rights Reserved.
+#include "checkpoint.h"
+#include "binary_io.h"
+#include "log.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+namespace msode
+{
+
+static constexpr char checkpointMagic[8] = {'M', 'S', 'O', 'D', 'E', 'C', 'K', 'P'};
+static constexpr std::uint32_t checkpointVersion = 2;
+
+/// the standard text representation of the random engines and distributions restores their exact state
+template <class T>
+static std::string toText(const T& value)
+{
+    std::ostringstream ss;
+    ss << value;
+    return ss.str();
+}
+
+template <class T>
+static void fromText(const std::string& text, T& value)
+{
+    std::istringstream ss(text);
+    ss >> value;
+    if (ss.fail())
+        msode_die("Could not parse the random number generator state from the checkpoint");
+}
+
+
+/// \return an empty string on success, the error message otherwise
+static std::string tryWriteCheckpoint(const std::string& fileName, const Checkpoint& checkpoint)
+{
+    const std::string tmpFileName = fileName + ".tmp";
+
+    {
+        std::ofstream stream(tmpFileName, std::ios::binary | std::ios::trunc);
+        if (!stream.is_open())
+            return "Could not open the file '" + tmpFileName + "'";
+
+        const SimulationState& state = checkpoint.state;
+
+        stream.write(checkpointMagic, sizeof(checkpointMagic));
+        binary_io::write(stream, checkpointVersion);
+        binary_io::write(stream, static_cast<std::uint32_t>(sizeof(real)));
+        binary_io::write(stream, static_cast<std::uint32_t>(sizeof(real_acc)));
+
+        binary_io::write(stream, state.currentTime);
+        binary_io::write(stream, static_cast<std::int64_t>(state.currentTimeStep));
+        binary_io::write(stream, state.fieldPhase);
+        binary_io::write(stream, state.bodies);
+        binary_io::write(stream, state.positions);
+        binary_io::write(stream, toText(state.gen));
+        binary_io::write(stream, toText(state.normal));
+
+        binary_io::write(stream, checkpoint.dumpFileName);
+        binary_io::write(stream, static_cast<std::int64_t>(checkpoint.dumpEvery));
+        binary_io::write(stream, static_cast<std::int64_t>(checkpoint.dumpSize));
+
+        binary_io::write(stream, static_cast<std::uint64_t>(checkpoint.observerStates.size()));
+        for (const auto& observerState : checkpoint.observerStates)
+            binary_io::write(stream, observerState);
+
+        stream.flush();
+        if (!stream)
+            return "Error while writing the file '" + tmpFileName + "'";
+    }
+
+    if (std::rename(tmpFileName.c_str(), fileName.c_str()) != 0)
+        return "Could not move '" + tmpFileName + "' to '" + fileName + "'";
+
+    return "";
+}
+
+void writeCheckpoint(const std::string& fileName, const Checkpoint& checkpoint)
+{
+    const std::string error = tryWriteCheckpoint(fileName, checkpoint);
+    if (!error.empty())
+        msode_die("%s", error.c_str());
+}
+
+Checkpoint readCheckpoint(const std::string& fileName)
+{
+    std::ifstream stream(fileName, std::ios::binary);
+    if (!stream.is_open())
+        msode_die("Could not open the file '%s'", fileName.c_str());
+
+    char magic[sizeof(checkpointMagic)];
+    std::uint32_t version {0}, realSize {0}, realAccSize {0};
+
+    stream.read(magic, sizeof(magic));
+    binary_io::read(stream, version);
+    binary_io::read(stream, realSize);
+    binary_io::read(stream, realAccSize);
+
+    if (!stream || std::memcmp(magic, checkpointMagic, sizeof(magic)) != 0)
+        msode_die("'%s' is not a checkpoint file", fileName.c_str());
+
+    if (version != checkpointVersion)
+        msode_die("'%s': unsupported checkpoint version %u (expected %u)",
+                  fileName.c_str(), version, checkpointVersion);
+
+    if (realSize != sizeof(real) || realAccSize != sizeof(real_acc))
+        msode_die("'%s' was written with another floating point precision", fileName.c_str());
+
+    Checkpoint checkpoint;
+    SimulationState& state = checkpoint.state;
+    std::int64_t currentTimeStep {0}, dumpEvery {0}, dumpSize {0};
+    std::string genText, normalText;
+
+    binary_io::read(stream, state.currentTime);
+    binary_io::read(stream, currentTimeStep);
+    binary_io::read(stream, state.fieldPhase);
+    binary_io::read(stream, state.bodies);
+    binary_io::read(stream, state.positions);
+    binary_io::read(stream, genText);
+    binary_io::read(stream, normalText);
+
+    binary_io::read(stream, checkpoint.dumpFileName);
+    binary_io::read(stream, dumpEvery);
+    binary_io::read(stream, dumpSize);
+
+    std::uint64_t numObservers {0};
+    binary_io::read(stream, numObservers);
+    for (std::uint64_t i = 0; i < numObservers && stream; ++i)
+    {
+        checkpoint.observerStates.emplace_back();
+        binary_io::read(stream, checkpoint.observerStates.back());
+    }
+
+    if (!stream)
+        msode_die("The checkpoint file '%s' is truncated", fileName.c_str());
+
+    state.currentTimeStep = currentTimeStep;
+    fromText(genText, state.gen);
+    fromText(normalText, state.normal);
+    checkpoint.dumpEvery = dumpEvery;
+    checkpoint.dumpSize = dumpSize;
+
+    return checkpoint;
+}
+
+
+CheckpointWriter::CheckpointWriter(std::string fileName) :
+    fileName_(std::move(fileName))
+{}
+
+CheckpointWriter::~CheckpointWriter()
+{
+    wait();
+}
+
+void CheckpointWriter::writeAsync(Checkpoint checkpoint)
+{
+    wait();
+    thread_ = std::thread([this, checkpoint = std::move(checkpoint)]()
+    {
+        // do not exit from this thread while the simulation is running: the error is raised by wait()
+        error_ = tryWriteCheckpoint(fileName_, checkpoint);
+    });
+}
+
+void CheckpointWriter::wait()
+{
+    if (thread_.joinable())
+        thread_.join();
+
+    if (!error_.empty())
+        msode_die("%s", error_.c_str());
+}
+
+} // namespace msode
@@ -0,0 +1,68 @@
+// Copyright 2020 ETH Zurich. All Rights Reserved.
+#pragma once
+
+#include "simulation.h"
+
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace msode
+{
+
+/** Everything needed to resume a Simulation after an interruption: its dynamic state (time, bodies, field phase,
+    random number generator), the position in the trajectory dump and the states of the observers.
+    The floating point values are stored bitwise, so that a restarted run continues bit-identically.
+    The binary format depends on the precision the library is compiled with (see real and real_acc).
+ */
+struct Checkpoint
+{
+    SimulationState state;
+    std::string dumpFileName; ///< empty if the dump was not active
+    long dumpEvery {0};
+    long dumpSize {0};        ///< size in bytes of the dump file at the time of the checkpoint
+    std::vector<std::string> observerStates; ///< the states of the observers in the order of attachment (see BaseObserver::saveState())
+};
+
+/** \brief Write a checkpoint to a file.
+    \param fileName The destination file name.
+    The checkpoint is first written to a temporary file which then replaces \p fileName,
+    so that an interruption during the write never leaves a corrupted checkpoint.
+    This method will fail if it cannot write to the file.
+ */
+void writeCheckpoint(const std::string& fileName, const Checkpoint& checkpoint);
+
+/** \brief Read a checkpoint written by writeCheckpoint().
+    This method will fail if the file can not be read or was written with another precision.
+ */
+Checkpoint readCheckpoint(const std::string& fileName);
+
+
+/** Write checkpoints on a background thread, so that the simulation keeps stepping during the file operations.
+    At most one write is in flight: a new write first waits for the previous one.
+    A failed write is reported on the calling thread, by the next call to wait() or writeAsync().
+ */
+class CheckpointWriter
+{
+public:
+    explicit CheckpointWriter(std::string fileName);
+    ~CheckpointWriter();
+
+    CheckpointWriter(const CheckpointWriter&) = delete;
+    CheckpointWriter& operator=(const CheckpointWriter&) = delete;
+
+    /// start writing \p checkpoint to the file
+    void writeAsync(Checkpoint checkpoint);
+
+    /// block until the last write is complete; fails if that write failed
+    void wait();
+
+    const std::string& getFileName() const {return fileName_;}
+
+private:
+    const std::string fileName_;
+    std::thread thread_;
+    std::string error_; ///< error of the last write, set by the writing thread; empty on success
+};
+
+} // namespace msode
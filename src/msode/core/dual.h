@@ -0,0 +1,156 @@
+// Copyright 2020 ETH Zurich. All Rights Reserved.
+#pragma once
+
+#include "types.h"
+
+#include <array>
+#include <cmath>
+
+namespace msode
+{
+
+/** Dual number for forward mode automatic differentiation: a value and its derivatives with respect to N variables.
+    The generic kernels (see Vector3, QuaternionT, RigidBodyT and computeVelocities()) can be evaluated with Dual
+    numbers to obtain the derivatives of their results with respect to the seeded variables.
+    Comparisons only involve the values.
+ */
+template <int N>
+struct Dual
+{
+    Dual() = default; // create an UNINITIALIZED number
+
+    /// implicit conversion from a constant: all derivatives are zero
+    Dual(real a) :
+        val(a)
+    {
+        d.fill(0.0_r);
+    }
+
+    /// \return the variable \p i with value \p a: its derivative with respect to itself is one
+    static Dual createVariable(real a, int i)
+    {
+        Dual x(a);
+        x.d[i] = 1.0_r;
+        return x;
+    }
+
+    Dual& operator+=(const Dual& b)
+    {
+        val += b.val;
+        for (int i = 0; i < N; ++i) d[i] += b.d[i];
+        return *this;
+    }
+
+    Dual& operator-=(const Dual& b)
+    {
+        val -= b.val;
+        for (int i = 0; i < N; ++i) d[i] -= b.d[i];
+        return *this;
+    }
+
+    Dual& operator*=(const Dual& b)
+    {
+        for (int i = 0; i < N; ++i) d[i] = d[i] * b.val + val * b.d[i];
+        val *= b.val;
+        return *this;
+    }
+
+    Dual& operator/=(const Dual& b)
+    {
+        const real inv = 1.0_r / b.val;
+        const real q = val * inv;
+        for (int i = 0; i < N; ++i) d[i] = (d[i] - q * b.d[i]) * inv;
+        val = q;
+        return *this;
+    }
+
+    Dual& operator+=(real a) {val += a; return *this;}
+    Dual& operator-=(real a) {val -= a; return *this;}
+
+    Dual& operator*=(real a)
+    {
+        val *= a;
+        for (int i = 0; i < N; ++i) d[i] *= a;
+        return *this;
+    }
+
+    Dual& operator/=(real a)
+    {
+        return *this *= 1.0_r / a;
+    }
+
+    friend inline Dual operator+(Dual a, const Dual& b) {return a += b;}
+    friend inline Dual operator-(Dual a, const Dual& b) {return a -= b;}
+    friend inline Dual operator*(Dual a, const Dual& b) {return a *= b;}
+    friend inline Dual operator/(Dual a, const Dual& b) {return a /= b;}
+
+    friend inline Dual operator+(Dual a, real b) {return a += b;}
+    friend inline Dual operator+(real a, Dual b) {return b += a;}
+    friend inline Dual operator-(Dual a, real b) {return a -= b;}
+    friend inline Dual operator-(real a, const Dual& b) {return Dual(a) -= b;}
+    friend inline Dual operator*(Dual a, real b) {return a *= b;}
+    friend inline Dual operator*(real a, Dual b) {return b *= a;}
+    friend inline Dual operator/(Dual a, real b) {return a /= b;}
+    friend inline Dual operator/(real a, const Dual& b) {return Dual(a) /= b;}
+
+    friend inline Dual operator-(Dual a)
+    {
+        a.val = -a.val;
+        for (int i = 0; i < N; ++i) a.d[i] = -a.d[i];
+        return a;
+    }
+
+    friend inline bool operator< (const Dual& a, const Dual& b) {return a.val <  b.val;}
+    friend inline bool operator> (const Dual& a, const Dual& b) {return a.val >  b.val;}
+    friend inline bool operator<=(const Dual& a, const Dual& b) {return a.val <= b.val;}
+    friend inline bool operator>=(const Dual& a, const Dual& b) {return a.val >= b.val;}
+    friend inline bool operator==(const Dual& a, const Dual& b) {return a.val == b.val;}
+    friend inline bool operator!=(const Dual& a, const Dual& b) {return a.val != b.val;}
+
+    real val;                ///< value
+    std::array<real, N> d;   ///< derivatives with respect to the N variables
+};
+
+/// apply the chain rule to a function of value f and derivative df at x
+template <int N>
+inline Dual<N> chainRule(const Dual<N>& x, real f, real df)
+{
+    Dual<N> y;
+    y.val = f;
+    for (int i = 0; i < N; ++i) y.d[i] = df * x.d[i];
+    return y;
+}
+
+template <int N>
+inline Dual<N> sqrt(const Dual<N>& x)
+{
+    const real s = std::sqrt(x.val);
+    return chainRule(x, s, 0.5_r / s);
+}
+
+template <int N>
+inline Dual<N> sin(const Dual<N>& x)
+{
+    return chainRule(x, std::sin(x.val), std::cos(x.val));
+}
+
+template <int N>
+inline Dual<N> cos(const Dual<N>& x)
+{
+    return chainRule(x, std::cos(x.val), -std::sin(x.val));
+}
+
+template <int N>
+inline Dual<N> abs(const Dual<N>& x)
+{
+    return x.val < 0 ? -x : x;
+}
+
+/// \return the value of a Dual number, e.g. to print it
+template <int N>
+inline double scalarValue(const Dual<N>& x)
+{
+    return x.val;
+}
+
+} // namespace msode
@@ -0,0 +1,94 @@
+// Copyright 2020 ETH Zurich. All Rights Reserved.
+#pragma once
+
+#include "math.h"
+#include "simulation.h"
+
+#include <tuple>
+
+namespace msode
+{
+
+/** The right hand side of the deterministic equations of motion of the rigid bodies.
+    The kernels are generic over the scalar type (see Vector3), so that they are shared by the time steppers
+    (see Stepper) and by the differentiable simulations propagating Dual numbers (see adjoint::computeGradient()).
+ */
+
+/// Flow type for simulations without background flow; all hydrodynamic coupling terms are removed at compile time
+struct NoFlow {};
+
+template <class T>
+static inline Vector3<T> operator*(const std::array<T,3>& A, const Vector3<T>& v)
+{
+    return {A[0] * v.x,
+            A[1] * v.y,
+            A[2] * v.z};
+}
+
+template <class T>
+static inline std::tuple<Vector3<T>, Vector3<T>> computeVelocities(const PropulsionMatrixT<T>& m,
+                                                                   const Vector3<T>& F, const Vector3<T>& T_)
+{
+    const Vector3<T> v = m.A * F + m.B * T_;
+    const Vector3<T> w = m.B * F + m.C * T_;
+    return {v, w};
+}
+
+template <class T>
+static inline void addFlowContribution(const NoFlow * /* field */, const RigidBodyT<T>& /* b */, real /* time */,
+                                       Vector3<T>& /* v */, Vector3<T>& /* omega */)
+{}
+
+template <class FieldT, class T>
+static inline void addFlowContribution(const FieldT *velocityField, const RigidBodyT<T>& b, real time,
+                                       Vector3<T>& v, Vector3<T>& omega)
+{
+    v     +=         velocityField->getVelocity (b.r, time);
+    omega += 0.5_r * velocityField->getVorticity(b.r, time);
+
+    const auto T_ = velocityField->getDeformationRateTensor(b.r, time);
+    const Vector3<T> p = b.q.conjugate().rotate({T(1), T(0), T(0)});
+    const T L = (b.aspectRatio*b.aspectRatio - 1.0_r) / (b.aspectRatio*b.aspectRatio + 1.0_r);
+    omega += L * cross(p, multiply(T_, p));
+}
+
+/** \brief Compute the linear and angular velocities of a rigid body.
+    \param b The rigid body
+    \param B The magnetic field
+    \param velocityField The background flow, or NoFlow
+    \param time The current time
+    \return the linear and angular velocities of the body
+ */
+template <class FieldT, class T>
+static inline std::tuple<Vector3<T>, Vector3<T>>
+computeVelocities(const RigidBodyT<T>& b, Vector3<T> B,
+                  const FieldT *velocityField,
+                  real time)
+{
+    const QuaternionT<T> q = b.q;
+    const QuaternionT<T> qInv = q.conjugate();
+
+    const Vector3<T> m      = qInv.rotate(b.magnMoment);
+    const Vector3<T> torque = cross(m, B);
+    const Vector3<T> force {T(0), T(0), T(0)};
+
+    Vector3<T> v, omega;
+    std::tie(v, omega) = computeVelocities(b.propulsion,
+                                           q.rotate(force),
+                                           q.rotate(torque));
+
+    v     = qInv.rotate(v    );
+    omega = qInv.rotate(omega);
+
+    addFlowContribution(velocityField, b, time, v, omega);
+
+    return {v, omega};
+}
+
+template <class T>
+static inline QuaternionT<T> quaternionDerivative(const QuaternionT<T>& q, const Vector3<T>& omega)
+{
+    return 0.5_r * q * QuaternionT<T>::createPureVector(omega);
+}
+
+} // namespace msode
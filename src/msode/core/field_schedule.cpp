@@ -0,0 +1,74 @@
+// Copyright 2020 ETH Zurich. All Rights Reserved.
+#include "field_schedule.h"
+#include "log.h"
+
+#include <algorithm>
+
+namespace msode
+{
+
+bool FieldSchedule::addSegment(real duration, real omega, real3 direction)
+{
+    const real start = getEndTime();
+    const real end = start + duration;
+
+    // also discards segments shorter than the round off error of the end time
+    if (end <= start)
+        return false;
+
+    MSODE_Expect(length(direction) > 0.0_r, "Rotating direction must be different than 0");
+
+    switchTimes_.push_back(end);
+    omegas_     .push_back(omega);
+    directions_ .push_back(direction);
+    return true;
+}
+
+int FieldSchedule::getNumSegments() const
+{
+    return static_cast<int>(switchTimes_.size());
+}
+
+real FieldSchedule::getEndTime() const
+{
+    return switchTimes_.empty() ? 0.0_r : switchTimes_.back();
+}
+
+const std::vector<real>& FieldSchedule::getSwitchTimes() const
+{
+    return switchTimes_;
+}
+
+real FieldSchedule::getOmega(real t) const
+{
+    const int id = _findSegment(t);
+    return id >= 0 ? omegas_[id] : 0.0_r;
+}
+
+real3 FieldSchedule::getDirection(real t) const
+{
+    MSODE_Expect(!directions_.empty(), "The schedule is empty");
+
+    const int id = _findSegment(t);
+    return id >= 0 ? directions_[id] : directions_.back();
+}
+
+MagneticField FieldSchedule::createMagneticField(real magnitude) const
+{
+    return MagneticField(magnitude,
+                         [this](real t) {return getOmega(t);},
+                         [this](real t) {return getDirection(t);});
+}
+
+int FieldSchedule::_findSegment(real t) const
+{
+    // the segment i covers [switchTimes_[i-1], switchTimes_[i])
+    const auto it = std::upper_bound(switchTimes_.begin(), switchTimes_.end(), t);
+
+    if (it == switchTimes_.end())
+        return -1;
+
+    return static_cast<int>(it - switchTimes_.begin());
+}
+
+} // namespace msode
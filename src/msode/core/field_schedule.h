@@ -0,0 +1,60 @@
+// Copyright 2020 ETH Zurich. All Rights Reserved.
+#pragma once
+
+#include "simulation.h"
+
+#include <vector>
+
+namespace msode
+{
+
+/** A piecewise constant magnetic field control: a sequence of segments with constant rotation frequency and
+    rotation direction.
+    The switching times are precomputed, so that the lookups are O(log N) and a Simulation can align its
+    time steps on them (see Simulation::runForwardEulerUntil()).
+ */
+class FieldSchedule
+{
+public:
+    FieldSchedule() = default;
+
+    /** \brief Append a segment at the end of the schedule.
+        \param duration The duration of the segment; segments too short to change the end time are ignored
+        \param omega The rotation frequency of the field during the segment
+        \param direction The rotation direction of the field during the segment
+        \return \c true if the segment was added, \c false if it was ignored
+     */
+    bool addSegment(real duration, real omega, real3 direction);
+
+    /// \return The number of segments
+    int getNumSegments() const;
+
+    /// \return The time at which the last segment ends
+    real getEndTime() const;
+
+    /// \return The start times of all segments but the first one, followed by the end time, in increasing order
+    const std::vector<real>& getSwitchTimes() const;
+
+    /// \return The rotation frequency at time \p t; zero after the end of the schedule
+    real getOmega(real t) const;
+
+    /// \return The rotation direction at time \p t; the one of the last segment after the end of the schedule
+    real3 getDirection(real t) const;
+
+    /** \brief Create a MagneticField that follows this schedule.
+        \param magnitude The magnitude of the magnetic field
+        \note The returned field references this object, which must outlive it.
+     */
+    MagneticField createMagneticField(real magnitude) const;
+
+private:
+    /// \return the index of the segment containing t, -1 if t is after the end time
+    int _findSegment(real t) const;
+
+private:
+    std::vector<real> switchTimes_; ///< end time of each segment
+    std::vector<real> omegas_;      ///< rotation frequency of each segment
+    std::vector<real3> directions_; ///< rotation direction of each segment
+};
+
+} // namespace msode
@@ -0,0 +1,97 @@
+// Copyright 2020 ETH Zurich. All Rights Reserved.
+#include "frame_buffer.h"
+#include "log.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace msode
+{
+
+FrameBuffer::FrameBuffer(int frameSize, long capacity, bool singlePrecision) :
+    frameSize_(frameSize),
+    capacity_(capacity),
+    singlePrecision_(singlePrecision)
+{
+    MSODE_Expect(frameSize_ > 0, "expect a positive frame size, got %d", frameSize_);
+    MSODE_Expect(capacity_ > 0, "expect a positive capacity, got %ld", capacity_);
+
+    if (singlePrecision_)
+        dataSingle_.resize(frameSize_ * capacity_);
+    else
+        data_.resize(frameSize_ * capacity_);
+}
+
+void FrameBuffer::push(const double *frame)
+{
+    const long offset = (numPushed_ % capacity_) * frameSize_;
+
+    if (singlePrecision_)
+        std::copy(frame, frame + frameSize_, dataSingle_.data() + offset);
+    else
+        std::memcpy(data_.data() + offset, frame, frameSize_ * sizeof(double));
+
+    ++numPushed_;
+}
+
+void FrameBuffer::clear()
+{
+    numPushed_ = 0;
+}
+
+int FrameBuffer::getFrameSize() const
+{
+    return frameSize_;
+}
+
+long FrameBuffer::getCapacity() const
+{
+    return capacity_;
+}
+
+long FrameBuffer::size() const
+{
+    return std::min(numPushed_, capacity_);
+}
+
+long FrameBuffer::getNumPushed() const
+{
+    return numPushed_;
+}
+
+long FrameBuffer::_slot(long frameId) const
+{
+    const long oldest = numPushed_ > capacity_ ? numPushed_ % capacity_ : 0;
+    return (oldest + frameId) % capacity_;
+}
+
+double FrameBuffer::get(long frameId, int valueId) const
+{
+    MSODE_Expect(frameId >= 0 && frameId < size(), "frame %ld out of range [0, %ld)", frameId, size());
+    MSODE_Expect(valueId >= 0 && valueId < frameSize_, "value %d out of range [0, %d)", valueId, frameSize_);
+
+    const long i = _slot(frameId) * frameSize_ + valueId;
+    return singlePrecision_ ? static_cast<double>(dataSingle_[i]) : data_[i];
+}
+
+void FrameBuffer::writeText(std::ostream& stream) const
+{
+    for (long frameId = 0; frameId < size(); ++frameId)
+    {
+        const long offset = _slot(frameId) * frameSize_;
+
+        for (int j = 0; j < frameSize_; ++j)
+        {
+            if (j > 0)
+                stream << ' ';
+
+            if (singlePrecision_)
+                stream << dataSingle_[offset + j];
+            else
+                stream << data_[offset + j];
+        }
+        stream << '\n';
+    }
+}
+
+} // namespace msode
@@ -0,0 +1,58 @@
+// Copyright 2020 ETH Zurich. All Rights Reserved.
+#pragma once
+
+#include <ostream>
+#include <vector>
+
+namespace msode
+{
+
+/** Fixed size ring buffer of the frames of a trajectory, kept in binary in memory (see Simulation::activateBufferedDump()).
+    A frame is a fixed number of values. Once the buffer is full, every new frame overwrites the oldest one.
+    The frames are stored in double precision, or in single precision to halve the memory.
+    Pushing a frame does not allocate memory; in double precision it is a single memcpy.
+ */
+class FrameBuffer
+{
+public:
+    /** \brief Construct a FrameBuffer
+        \param frameSize The number of values of a frame
+        \param capacity The maximum number of frames kept
+        \param singlePrecision If true, store the values in float32
+     */
+    FrameBuffer(int frameSize, long capacity, bool singlePrecision);
+
+    /// add a frame of getFrameSize() values, overwriting the oldest frame if the buffer is full
+    void push(const double *frame);
+
+    /// remove all frames; does not free memory
+    void clear();
+
+    int getFrameSize() const;
+    long getCapacity() const;
+
+    /// \return The number of frames currently held
+    long size() const;
+
+    /// \return The total number of frames pushed since the last clear(), including the overwritten ones
+    long getNumPushed() const;
+
+    /// \return The value \p valueId of the frame \p frameId, in [0, size()), with 0 the oldest frame
+    double get(long frameId, int valueId) const;
+
+    /// write the frames, oldest first, as text: one line per frame with space separated values
+    void writeText(std::ostream& stream) const;
+
+private:
+    long _slot(long frameId) const;
+
+private:
+    const int frameSize_;
+    const long capacity_;
+    const bool singlePrecision_;
+    std::vector<double> data_;
+    std::vector<float> dataSingle_;
+    long numPushed_ {0};
+};
+
+} // namespace msode
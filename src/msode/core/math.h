@@ -5,11 +5,30 @@
 #include "types.h"
 
 #include <cmath>
+#include <type_traits>
 
 namespace msode
 {
 
-inline real3& operator+=(real3& a, const real3& b)
+/** The vector operations are generic over the scalar type T of the vectors (see Vector3).
+    The scalar factors may be of any type convertible to T, e.g. real factors of vectors of Dual numbers.
+    The math functions are called unqualified, so that the overloads of the scalar type are found by ADL.
+ */
+template <class S, class T>
+using EnableIfScalarOf = std::enable_if_t<std::is_convertible<S, T>::value>;
+
+/// Type used for a scalar factor S of a vector of T: arithmetic factors of arithmetic vectors are converted to T first
+template <class S, class T>
+using ScalarFactor = std::conditional_t<std::is_arithmetic<T>::value, T, S>;
+
+/// \return the value of a scalar as a double, e.g. to print it; see also the overload for Dual numbers
+inline double scalarValue(double a)
+{
+    return a;
+}
+
+template <class T>
+inline Vector3<T>& operator+=(Vector3<T>& a, const Vector3<T>& b)
 {
     a.x += b.x;
     a.y += b.y;
@@ -17,35 +36,41 @@ inline real3& operator+=(real3& a, const real3& b)
     return a;
 }
 
-inline real3 operator+(real3 a, real3 b)
+template <class T>
+inline Vector3<T> operator+(Vector3<T> a, const Vector3<T>& b)
 {
     a += b;
     return a;
 }
 
-inline real3& operator*=(real3& v, real a)
+template <class T, class S, class = EnableIfScalarOf<S, T>>
+inline Vector3<T>& operator*=(Vector3<T>& v, const S& a)
 {
-    v.x *= a;
-    v.y *= a;
-    v.z *= a;
+    const ScalarFactor<S, T> s = a;
+    v.x *= s;
+    v.y *= s;
+    v.z *= s;
     return v;
 }
 
-inline real3 operator*(real a, real3 v)
+template <class S, class T, class = EnableIfScalarOf<S, T>>
+inline Vector3<T> operator*(const S& a, Vector3<T> v)
 {
     return v *= a;
 }
 
-inline real3& operator/=(real3& v, real a)
+template <class T, class S, class = EnableIfScalarOf<S, T>>
+inline Vector3<T>& operator/=(Vector3<T>& v, const S& a)
 {
-    const real s = 1.0_r / a;
+    const T s = T(1) / static_cast<ScalarFactor<S, T>>(a);
     v.x *= s;
     v.y *= s;
     v.z *= s;
     return v;
 }
 
-inline real3& operator-=(real3& a, const real3& b)
+template <class T>
+inline Vector3<T>& operator-=(Vector3<T>& a, const Vector3<T>& b)
 {
     a.x -= b.x;
     a.y -= b.y;
@@ -53,52 +78,61 @@ inline real3& operator-=(real3& a, const real3& b)
     return a;
 }
 
-inline real3 operator-(real3 a, real3 b)
+template <class T>
+inline Vector3<T> operator-(Vector3<T> a, const Vector3<T>& b)
 {
     a -= b;
     return a;
 }
 
-inline real3 operator-(real3 a)
+template <class T>
+inline Vector3<T> operator-(const Vector3<T>& a)
 {
     return {-a.x, -a.y, -a.z};
 }
 
-inline real dot(real3 a, real3 b)
+template <class T>
+inline T dot(const Vector3<T>& a, const Vector3<T>& b)
 {
     return a.x * b.x + a.y * b.y + a.z * b.z;
 }
 
-inline real3 cross(real3 a, real3 b)
+template <class T>
+inline Vector3<T> cross(const Vector3<T>& a, const Vector3<T>& b)
 {
     return {a.y * b.z - a.z * b.y,
             a.z * b.x - a.x * b.z,
             a.x * b.y - a.y * b.x};
 }
 
-inline real length(real3 v)
+template <class T>
+inline T length(const Vector3<T>& v)
 {
-    return std::sqrt(dot(v, v));
+    using std::sqrt;
+    return sqrt(dot(v, v));
 }
 
-inline real3 normalized(real3 v)
+template <class T>
+inline Vector3<T> normalized(const Vector3<T>& v)
 {
-    const auto l = length(v);
-    MSODE_Expect(l > 0, "can not normalize the vector %g %g %g", v.x, v.y, v.z);
-    return ( 1.0_r / l ) * v;
+    const T l = length(v);
+    MSODE_Expect(l > 0, "can not normalize the vector %g %g %g", scalarValue(v.x), scalarValue(v.y), scalarValue(v.z));
+    return ( T(1) / l ) * v;
 }
 
-static inline real3 anyOrthogonal(real3 v)
+template <class T>
+static inline Vector3<T> anyOrthogonal(const Vector3<T>& v)
 {
-    const real x = std::abs(v.x);
-    const real y = std::abs(v.y);
-    const real z = std::abs(v.z);
+    using std::abs;
+    const T x = abs(v.x);
+    const T y = abs(v.y);
+    const T z = abs(v.z);
 
-    constexpr real3 ex {1.0_r, 0.0_r, 0.0_r};
-    constexpr real3 ey {0.0_r, 1.0_r, 0.0_r};
-    constexpr real3 ez {0.0_r, 0.0_r, 1.0_r};
+    const Vector3<T> ex {T(1), T(0), T(0)};
+    const Vector3<T> ey {T(0), T(1), T(0)};
+    const Vector3<T> ez {T(0), T(0), T(1)};
 
-    const real3 other = x < y ? (x < z ? ex : ez) : (y < z ? ey : ez);
+    const Vector3<T> other = x < y ? (x < z ? ex : ez) : (y < z ? ey : ez);
     return cross(v, other);
 }
 
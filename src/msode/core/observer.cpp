@@ -0,0 +1,20 @@
+// Copyright 2020 ETH Zurich. All Rights Reserved.
+#include "observer.h"
+#include "log.h"
+
+#include <fstream>
+
+namespace msode
+{
+
+BaseObserver::~BaseObserver() = default;
+
+void BaseObserver::writeToFile(const std::string& fileName) const
+{
+    std::ofstream stream {fileName};
+    MSODE_Ensure(stream.is_open(), "Error opening %s", fileName.c_str());
+
+    write(stream);
+}
+
+} // namespace msode
@@ -0,0 +1,48 @@
+// Copyright 2020 ETH Zurich. All Rights Reserved.
+#pragma once
+
+#include <istream>
+#include <ostream>
+#include <string>
+
+namespace msode
+{
+
+class Simulation;
+
+/** Base class of the in-situ analyses of a Simulation.
+    An observer is called periodically during the runs of the simulation (see Simulation::addObserver()) and reduces
+    the states it sees to a few statistics, which are written once at the end instead of dumping the whole trajectory.
+ */
+class BaseObserver
+{
+public:
+    virtual ~BaseObserver();
+
+    /** \brief Process the current state of the simulation.
+        Called often during long runs; implementations should not allocate memory.
+     */
+    virtual void observe(const Simulation& sim) = 0;
+
+    /// write the results of the analysis to \p stream
+    virtual void write(std::ostream& stream) const = 0;
+
+    /** \brief Write the internal state of the analysis in binary, so that it can be resumed (see Simulation::writeCheckpoint()).
+        The format is private to the observer; it only needs to be readable by loadState().
+     */
+    virtual void saveState(std::ostream& stream) const = 0;
+
+    /** \brief Restore a state written by saveState().
+        \param stream The state, written by an observer constructed with the same parameters.
+        This method will fail if the state does not match the observer.
+     */
+    virtual void loadState(std::istream& stream) = 0;
+
+    /** \brief Write the results of the analysis to a file.
+        \param fileName The destination file name.
+        This method will fail if it cannot write to the file.
+     */
+    void writeToFile(const std::string& fileName) const;
+};
+
+} // namespace msode
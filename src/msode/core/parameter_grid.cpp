@@ -0,0 +1,111 @@
+// Copyright 2020 ETH Zurich. All Rights Reserved.
+#include "parameter_grid.h"
+#include "log.h"
+
+namespace msode
+{
+
+static ParameterGrid::Parameter readParameter(const Config& config)
+{
+    const bool hasValues  = config.contains("values");
+    const bool hasFactors = config.contains("factors");
+
+    if (hasValues == hasFactors)
+        msode_die("Expected exactly one of 'values' and 'factors' in the sweep parameter %s", config.dump().c_str());
+
+    ParameterGrid::Parameter p;
+    p.pointer  = ConfPointer(config.at("pointer").get<std::string>());
+    p.isFactor = hasFactors;
+
+    for (const auto& v : config.at(hasFactors ? "factors" : "values"))
+    {
+        if (hasFactors && !v.is_number())
+            msode_die("Expected numbers as factors of the sweep parameter %s", config.dump().c_str());
+        p.values.push_back(v);
+    }
+
+    if (p.values.empty())
+        msode_die("Expected at least one value for the sweep parameter %s", config.dump().c_str());
+
+    return p;
+}
+
+ParameterGrid::ParameterGrid(const Config& config)
+{
+    for (const auto& p : config.at("parameters"))
+        parameters_.push_back(readParameter(p));
+}
+
+const std::vector<ParameterGrid::Parameter>& ParameterGrid::getParameters() const
+{
+    return parameters_;
+}
+
+long ParameterGrid::getNumVariants() const
+{
+    long n = 1;
+    for (const auto& p : parameters_)
+        n *= static_cast<long>(p.values.size());
+    return n;
+}
+
+std::vector<int> ParameterGrid::getValueIndices(long variantId) const
+{
+    MSODE_Expect(variantId >= 0 && variantId < getNumVariants(), "wrong variant id %ld", variantId);
+
+    std::vector<int> indices(parameters_.size());
+
+    for (int i = static_cast<int>(parameters_.size()) - 1; i >= 0; --i)
+    {
+        const long n = static_cast<long>(parameters_[i].values.size());
+        indices[i] = static_cast<int>(variantId % n);
+        variantId /= n;
+    }
+
+    return indices;
+}
+
+static void scale(Config& value, real factor, const ConfPointer& pointer)
+{
+    if (value.is_number())
+    {
+        value = value.get<real>() * factor;
+    }
+    else if (value.is_array())
+    {
+        for (auto& v : value)
+            scale(v, factor, pointer);
+    }
+    else
+    {
+        msode_die("Can not scale the non numeric value at '%s'", pointer.to_string().c_str());
+    }
+}
+
+Config ParameterGrid::createVariant(const Config& base, long variantId) const
+{
+    const auto indices = getValueIndices(variantId);
+    Config config = base;
+
+    for (size_t i = 0; i < parameters_.size(); ++i)
+    {
+        const Parameter& p = parameters_[i];
+        const Config& value = p.values[indices[i]];
+
+        if (p.isFactor)
+        {
+            if (!config.contains(p.pointer))
+                msode_die("The config has no value to scale at '%s'", p.pointer.to_string().c_str());
+
+            scale(config[p.pointer], value.get<real>(), p.pointer);
+        }
+        else
+        {
+            config[p.pointer] = value;
+        }
+    }
+
+    return config;
+}
+
+} // namespace msode
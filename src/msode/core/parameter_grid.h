@@ -0,0 +1,65 @@
+// Copyright 2020 ETH Zurich. All Rights Reserved.
+#pragma once
+
+#include "config.h"
+
+#include <string>
+#include <vector>
+
+namespace msode
+{
+
+/** The cartesian product of the values taken by several parameters of a config.
+
+    Each parameter is a location in the config, given by a json pointer, and either
+    - a list of "values" that replace (or add) the value of the base config; or
+    - a list of "factors" that multiply the value of the base config (a number, or an array of numbers, possibly nested).
+
+    Example:
+    \code
+    {
+        "parameters": [
+            {"pointer": "/velocityField/magnitude", "values": [[1.0, 1.0, -2.0], [2.0, 2.0, -4.0]]},
+            {"pointer": "/velocityField/invPeriod", "factors": [0.5, 1.0, 2.0]},
+            {"pointer": "/kBT", "values": [0.0, 0.01]}
+        ]
+    }
+    \endcode
+    describes 12 variants. The variants are numbered with the last parameter varying fastest.
+ */
+class ParameterGrid
+{
+public:
+    /// One dimension of the grid
+    struct Parameter
+    {
+        ConfPointer pointer;
+        bool isFactor;              ///< true if the values multiply the value of the base config
+        std::vector<Config> values; ///< the values (or factors) taken by the parameter
+    };
+
+    /** \brief Construct a ParameterGrid from its json description (see class description).
+        Dies if the description is invalid.
+     */
+    ParameterGrid(const Config& config);
+
+    const std::vector<Parameter>& getParameters() const;
+
+    /// \return The number of variants, that is the product of the number of values of all parameters
+    long getNumVariants() const;
+
+    /// \return The index of the value taken by each parameter in the given variant
+    std::vector<int> getValueIndices(long variantId) const;
+
+    /** \brief Create one variant of a config
+        \param base The base config; must contain the locations of the parameters given by factors
+        \param variantId The variant, in [0, getNumVariants())
+        \return A copy of \p base with the parameters set to their value in the given variant
+     */
+    Config createVariant(const Config& base, long variantId) const;
+
+private:
+    std::vector<Parameter> parameters_;
+};
+
+} // namespace msode
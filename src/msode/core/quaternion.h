@@ -12,62 +12,70 @@
 namespace msode
 {
 
-using RotMatrix = std::array<std::array<real, 3>, 3>;
+template <class T>
+using RotMatrixT = std::array<std::array<T, 3>, 3>;
 
-struct Quaternion
+using RotMatrix = RotMatrixT<real>;
+
+/// Quaternion generic over the scalar type, see Vector3
+template <class T>
+struct QuaternionT
 {
-    static inline Quaternion createIdentity()
+    static inline QuaternionT createIdentity()
     {
-        return {0.0_r, 1.0_r, 0.0_r, 0.0_r};
+        return {T(0), T(1), T(0), T(0)};
     }
 
-    static inline Quaternion createFromComponents(real w, real x, real y, real z)
+    static inline QuaternionT createFromComponents(T w, T x, T y, T z)
     {
         return {w, x, y, z};
     }
 
-    static inline Quaternion createFromComponents(real w, real3 v)
+    static inline QuaternionT createFromComponents(T w, Vector3<T> v)
     {
         return {w, v};
     }
 
-    static inline Quaternion createPureScalar(real w)
+    static inline QuaternionT createPureScalar(T w)
     {
-        return {w, 0.0_r, 0.0_r, 0.0_r};
+        return {w, T(0), T(0), T(0)};
     }
 
-    static inline Quaternion createPureVector(real3 v)
+    static inline QuaternionT createPureVector(Vector3<T> v)
     {
-        return {0.0_r, v};
+        return {T(0), v};
     }
 
-    static inline Quaternion createFromRotation(real angle, real3 axis)
+    static inline QuaternionT createFromRotation(T angle, Vector3<T> axis)
     {
-        const real alpha = 0.5_r * angle;
-        const real3 u = msode::normalized(axis);
-        return {std::cos(alpha), std::sin(alpha) * u};
+        using std::cos;
+        using std::sin;
+        const T alpha = 0.5_r * angle;
+        const Vector3<T> u = msode::normalized(axis);
+        return {cos(alpha), sin(alpha) * u};
     }
 
 
     // https://d3cw3dd2w32x2b.cloudfront.net/wp-content/uploads/2015/01/matrix-to-quat.pdf
-    static inline Quaternion createFromMatrix(const RotMatrix& R)
+    static inline QuaternionT createFromMatrix(const RotMatrixT<T>& R)
     {
-        auto makeQ = [](real t, real _w, real _x, real _y, real _z)
+        auto makeQ = [](T t, T _w, T _x, T _y, T _z)
         {
+            using std::sqrt;
             const auto q = createFromComponents(_w, _x, _y, _z);
-            return q * (0.5_r / std::sqrt(t));
+            return q * (0.5_r / sqrt(t));
         };
 
         if (R[2][2] < 0.0_r)
         {
             if (R[0][0] > R[1][1])
             {
-                const real t = 1.0_r + R[0][0] - R[1][1] - R[2][2];
+                const T t = 1.0_r + R[0][0] - R[1][1] - R[2][2];
                 return makeQ(t, R[2][1] - R[1][2], t, R[1][0] + R[0][1], R[0][2] + R[2][0]);
             }
             else
             {
-                const real t = 1.0_r - R[0][0] + R[1][1] - R[2][2];
+                const T t = 1.0_r - R[0][0] + R[1][1] - R[2][2];
                 return makeQ(t, R[0][2] - R[2][0], R[1][0] + R[0][1], t, R[2][1] + R[1][2]);
             }
         }
@@ -75,58 +83,63 @@ struct Quaternion
         {
             if (R[0][0] < -R[1][1])
             {
-                const real t = 1.0_r - R[0][0] - R[1][1] + R[2][2];
+                const T t = 1.0_r - R[0][0] - R[1][1] + R[2][2];
                 return makeQ(t, R[1][0] - R[0][1], R[0][2] + R[2][0], R[2][1] + R[1][2], t);
             }
             else
             {
-                const real t = 1.0_r + R[0][0] + R[1][1] + R[2][2];
+                const T t = 1.0_r + R[0][0] + R[1][1] + R[2][2];
                 return makeQ(t, t, R[2][1] - R[1][2], R[0][2] - R[2][0], R[1][0] - R[0][1]);
             }
         }
     }
 
-    static inline Quaternion createFromVectors(real3 from, real3 to)
+    static inline QuaternionT createFromVectors(Vector3<T> from, Vector3<T> to)
     {
         return {from, to};
     }
 
-    Quaternion() = default; // create an UNINITIALIZED quaternion
-    Quaternion(const Quaternion& q) = default;
-    Quaternion& operator=(const Quaternion& q) = default;
+    QuaternionT() = default; // create an UNINITIALIZED quaternion
+    QuaternionT(const QuaternionT& q) = default;
+    QuaternionT& operator=(const QuaternionT& q) = default;
 
-    ~Quaternion() = default;
+    ~QuaternionT() = default;
 
-    real realPart() const {return w;}
-    real3 vectorPart() const {return {x, y, z};}
+    T realPart() const {return w;}
+    Vector3<T> vectorPart() const {return {x, y, z};}
 
-    RotMatrix getRotationMatrix() const
+    RotMatrixT<T> getRotationMatrix() const
     {
-        const std::array<real, 3> row0 {1.0_r - 2*y*y - 2*z*z, 2*x*y - 2*z*w, 2*x*z + 2*y*w};
-        const std::array<real, 3> row1 {2*x*y + 2*z*w, 1.0_r - 2*x*x - 2*z*z, 2*y*z - 2*x*w};
-        const std::array<real, 3> row2 {2*x*z - 2*y*w, 2*y*z + 2*x*w, 1.0_r - 2*x*x - 2*y*y};
+        const std::array<T, 3> row0 {1.0_r - 2*y*y - 2*z*z, 2*x*y - 2*z*w, 2*x*z + 2*y*w};
+        const std::array<T, 3> row1 {2*x*y + 2*z*w, 1.0_r - 2*x*x - 2*z*z, 2*y*z - 2*x*w};
+        const std::array<T, 3> row2 {2*x*z - 2*y*w, 2*y*z + 2*x*w, 1.0_r - 2*x*x - 2*y*y};
         return {row0, row1, row2};
     }
 
-    Quaternion conjugate() const {return {w, -x, -y, -z};}
+    QuaternionT conjugate() const {return {w, -x, -y, -z};}
 
-    real norm() const {return std::sqrt(w*w + x*x + y*y + z*z);}
+    T norm() const
+    {
+        using std::sqrt;
+        return sqrt(w*w + x*x + y*y + z*z);
+    }
 
-    Quaternion& normalize()
+    QuaternionT& normalize()
     {
-        MSODE_Expect(norm() > 0, "can not normalize the quaternion %g %g %g %g", w, x, y, z);
-        const real factor = 1.0_r / norm();
+        MSODE_Expect(norm() > 0, "can not normalize the quaternion %g %g %g %g",
+                     scalarValue(w), scalarValue(x), scalarValue(y), scalarValue(z));
+        const T factor = 1.0_r / norm();
         return *this *= factor;
     }
 
-    Quaternion normalized() const
+    QuaternionT normalized() const
     {
-        Quaternion ret = *this;
+        QuaternionT ret = *this;
         ret.normalize();
         return ret;
     }
 
-    Quaternion& operator+=(const Quaternion& q)
+    QuaternionT& operator+=(const QuaternionT& q)
     {
         x += q.x;
         y += q.y;
@@ -135,7 +148,7 @@ struct Quaternion
         return *this;
     }
 
-    Quaternion& operator-=(const Quaternion& q)
+    QuaternionT& operator-=(const QuaternionT& q)
     {
         x -= q.x;
         y -= q.y;
@@ -144,7 +157,7 @@ struct Quaternion
         return *this;
     }
 
-    Quaternion& operator*=(real a)
+    QuaternionT& operator*=(T a)
     {
         x *= a;
         y *= a;
@@ -153,13 +166,13 @@ struct Quaternion
         return *this;
     }
 
-    friend inline Quaternion operator+(Quaternion q1, const Quaternion& q2) {q1 += q2; return q1;}
-    friend inline Quaternion operator-(Quaternion q1, const Quaternion& q2) {q1 -= q2; return q1;}
+    friend inline QuaternionT operator+(QuaternionT q1, const QuaternionT& q2) {q1 += q2; return q1;}
+    friend inline QuaternionT operator-(QuaternionT q1, const QuaternionT& q2) {q1 -= q2; return q1;}
 
-    friend inline Quaternion operator*(real a, Quaternion q) {q *= a; return q;}
-    friend inline Quaternion operator*(Quaternion q, real a) {return a * q;}
+    friend inline QuaternionT operator*(T a, QuaternionT q) {q *= a; return q;}
+    friend inline QuaternionT operator*(QuaternionT q, T a) {return a * q;}
 
-    friend inline Quaternion operator*(const Quaternion& q1, const Quaternion& q2)
+    friend inline QuaternionT operator*(const QuaternionT& q1, const QuaternionT& q2)
     {
         return {q1.w * q2.w - q1.x * q2.x - q1.y * q2.y - q1.z * q2.z,
                 q1.w * q2.x + q1.x * q2.w + q1.y * q2.z - q1.z * q2.y,
@@ -167,56 +180,59 @@ struct Quaternion
                 q1.w * q2.z + q1.x * q2.y - q1.y * q2.x + q1.z * q2.w};
     }
 
-    Quaternion& operator*=(const Quaternion& q)
+    QuaternionT& operator*=(const QuaternionT& q)
     {
         *this = (*this) * q;
         return *this;
     }
 
-    real3 rotate(real3 v) const
+    Vector3<T> rotate(Vector3<T> v) const
     {
-        Quaternion qv(0.0_r, v);
+        QuaternionT qv(T(0), v);
         const auto& q = *this;
         return (q * qv * q.conjugate()).vectorPart();
     }
 
-    real3 inverseRotate(real3 v) const
+    Vector3<T> inverseRotate(Vector3<T> v) const
     {
-        Quaternion qv(0.0_r, v);
+        QuaternionT qv(T(0), v);
         const auto& q = *this;
         return (q.conjugate() * qv * q).vectorPart();
     }
 
-    friend inline std::ostream& operator<<(std::ostream& stream, const Quaternion& q)
+    friend inline std::ostream& operator<<(std::ostream& stream, const QuaternionT& q)
     {
         return stream << q.realPart() << " " << q.vectorPart();
     }
 
-    real w;       // real part
-    real x, y, z; // vector part
+    T w;       // real part
+    T x, y, z; // vector part
 
 private:
-    Quaternion(real w_, real x_, real y_, real z_) :
+    QuaternionT(T w_, T x_, T y_, T z_) :
         w(w_), x(x_), y(y_), z(z_)
     {}
 
-    Quaternion(real w_, real3 u) :
+    QuaternionT(T w_, Vector3<T> u) :
         w(w_), x(u.x), y(u.y), z(u.z)
     {}
 
     // https://stackoverflow.com/a/11741520/11630848
-    Quaternion(real3 u, real3 v)
+    QuaternionT(Vector3<T> u, Vector3<T> v)
     {
+        using std::abs;
+        using std::sqrt;
+
         MSODE_Expect(length(u) > 0._r && length(v) > 0._r,
                      "vector lengths must be greater than zero");
 
-        const real k_cos_theta = dot(u, v);
-        const real k = std::sqrt(dot(u, u) * dot(v, v));
+        const T k_cos_theta = dot(u, v);
+        const T k = sqrt(dot(u, u) * dot(v, v));
 
-        if (std::abs(k_cos_theta + k) == 0.0_r) // opposite directions
+        if (abs(k_cos_theta + k) == 0.0_r) // opposite directions
         {
-            w = 0.0_r;
-            const real3 n = anyOrthogonal(u);
+            w = T(0);
+            const Vector3<T> n = anyOrthogonal(u);
             x = n.x;
             y = n.y;
             z = n.z;
@@ -224,14 +240,17 @@ private:
         else
         {
             w = k_cos_theta + k;
-            const real3 n = cross(u, v);
+            const Vector3<T> n = cross(u, v);
             x = n.x;
             y = n.y;
             z = n.z;
         }
         this->normalize();
-        MSODE_Ensure(length(rotate(u)-v) < 1e-6_r, "constructor from 2 vectors failed by %g", length(rotate(u)-v));
+        MSODE_Ensure(length(rotate(u)-v) < 1e-6_r, "constructor from 2 vectors failed by %g",
+                     scalarValue(length(rotate(u)-v)));
     }
 };
 
+using Quaternion = QuaternionT<real>;
+
 } // namespace msode
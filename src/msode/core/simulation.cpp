@@ -1,13 +1,21 @@
 // Copyright 2020 ETH Zurich. All Rights Reserved.
 #include "simulation.h"
+#include "checkpoint.h"
 #include "math.h"
+#include "stepper.h"
 #include "velocity_field/none.h"
 
-#include <tuple>
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+#include <unistd.h>
 
 namespace msode
 {
 
+/// number of steps between two reads of the clock to decide if a checkpoint is due
+static constexpr long stepsPerCheckpointPoll = 1000;
+
 Simulation::Simulation(std::vector<RigidBody> initialRBs,
                        MagneticField initialMF, real kBT) :
     Simulation(std::move(initialRBs), std::move(initialMF), kBT, std::make_unique<VelocityFieldNone>())
@@ -19,24 +27,12 @@ Simulation::Simulation(std::vector<RigidBody> initialRBs, MagneticField initialM
     magneticField_(std::move(initialMF)),
     velocityField_(std::move(velocityField)),
     kBT_(kBT)
-{}
-
-
-
-static inline real3 operator*(const PropulsionMatrix::SubMatrix& A, const real3& v)
 {
-    return {A[0] * v.x,
-            A[1] * v.y,
-            A[2] * v.z};
+    eulerStepper_ = createStepper(ODEScheme::ForwardEuler, velocityField_.get(), kBT_);
+    rk4Stepper_   = createStepper(ODEScheme::RK4,          velocityField_.get(), kBT_);
 }
 
-static inline std::tuple<real3, real3> computeVelocities(const PropulsionMatrix& m,
-                                                         const real3& F, const real3& T)
-{
-    const real3 v = m.A * F + m.B * T;
-    const real3 w = m.B * F + m.C * T;
-    return {v, w};
-}
+Simulation::~Simulation() = default;
 
 void Simulation::reset(std::vector<RigidBody> initialRBs, MagneticField initialMF)
 {
@@ -44,215 +40,336 @@ void Simulation::reset(std::vector<RigidBody> initialRBs, MagneticField initialM
     currentTime_     = 0._r;
     rigidBodies_ = std::move(initialRBs);
     magneticField_ = std::move(initialMF);
+
+    if (frameBuffer_)
+        frameBuffer_->clear();
+}
+
+void Simulation::reset()
+{
+    currentTimeStep_ = 0;
+    currentTime_     = 0._r;
+    magneticField_.phase = 0.0_r;
+
+    if (frameBuffer_)
+        frameBuffer_->clear();
+}
+
+void Simulation::setNoiseSeed(unsigned long seed)
+{
+    gen_.seed(seed);
+    normal_.reset();
+}
+
+void Simulation::snapshot(SimulationState& state) const
+{
+    state.currentTime     = currentTime_;
+    state.currentTimeStep = currentTimeStep_;
+    state.fieldPhase      = magneticField_.phase;
+    state.gen             = gen_;
+    state.normal          = normal_;
+
+    state.bodies.resize(rigidBodies_.size());
+
+    for (size_t i = 0; i < rigidBodies_.size(); ++i)
+    {
+        const RigidBody& b = rigidBodies_[i];
+        state.bodies[i] = RigidBodyState{b.q, b.r, b.v, b.omega};
+    }
+
+    state.positions = positions_;
+}
+
+void Simulation::restore(const SimulationState& state)
+{
+    MSODE_Expect(state.bodies.size() == rigidBodies_.size(),
+                 "expected a state with %zu bodies, got %zu", rigidBodies_.size(), state.bodies.size());
+
+    currentTime_         = state.currentTime;
+    currentTimeStep_     = state.currentTimeStep;
+    magneticField_.phase = state.fieldPhase;
+    gen_                 = state.gen;
+    normal_              = state.normal;
+
+    for (size_t i = 0; i < rigidBodies_.size(); ++i)
+    {
+        RigidBody& b = rigidBodies_[i];
+        const RigidBodyState& bs = state.bodies[i];
+        b.q     = bs.q;
+        b.r     = bs.r;
+        b.v     = bs.v;
+        b.omega = bs.omega;
+    }
+
+    positions_ = state.positions;
 }
 
 void Simulation::activateDump(const std::string& fname, long dumpEvery)
+{
+    _openDump(fname, dumpEvery, std::ios::out | std::ios::trunc);
+}
+
+void Simulation::deactivateDump()
+{
+    if (file_.is_open())
+        file_.close();
+
+    dumpFileName_.clear();
+}
+
+void Simulation::_openDump(const std::string& fname, long dumpEvery, std::ios::openmode mode)
 {
     MSODE_Expect(dumpEvery > 0, "expect positive dumpEvery");
     dumpEvery_ = dumpEvery;
+    dumpFileName_ = fname;
+
+    frameBuffer_.reset();
 
     if (file_.is_open())
         file_.close();
 
-    file_.open(fname);
+    file_.open(fname, mode);
     MSODE_Ensure(file_.is_open(), "could not open file for writing");
 }
 
-void Simulation::runForwardEuler(long nsteps, real dt)
+void Simulation::activateBufferedDump(long dumpEvery, long capacity, bool singlePrecision)
 {
-    MSODE_Expect(nsteps > 0, "expect positive number of steps");
-    MSODE_Expect(dt > 0._r, "expect positive time step");
+    MSODE_Expect(dumpEvery > 0, "expect positive dumpEvery");
+    MSODE_Expect(!checkpointWriter_, "the buffered dump can not be checkpointed");
+    dumpEvery_ = dumpEvery;
+    dumpFileName_.clear();
 
-    for (long step = 0; step < nsteps; ++step)
-        advanceForwardEuler(dt);
+    if (file_.is_open())
+        file_.close();
+
+    // time, omega, field direction, then orientation, position and angular velocity of each body
+    const int frameSize = 5 + 10 * static_cast<int>(rigidBodies_.size());
+    frame_.resize(frameSize);
+    frameBuffer_ = std::make_unique<FrameBuffer>(frameSize, capacity, singlePrecision);
 }
 
-void Simulation::runRK4(long nsteps, real dt)
+void Simulation::flushBufferedDump(const std::string& fname) const
 {
-    MSODE_Expect(nsteps > 0, "expect positive number of steps");
-    MSODE_Expect(dt > 0._r, "expect positive time step");
+    MSODE_Expect(frameBuffer_ != nullptr, "the buffered dump is not active");
 
-    for (long step = 0; step < nsteps; ++step)
-        advanceRK4(dt);
+    std::ofstream file(fname);
+    if (!file.is_open())
+        msode_die("Could not open the file '%s'", fname.c_str());
+
+    frameBuffer_->writeText(file);
 }
 
-void Simulation::advanceForwardEuler(real dt)
+void Simulation::activateCheckpoint(const std::string& fileName, double wallTimeInterval)
 {
-    if (file_.is_open() && currentTimeStep_ % dumpEvery_ == 0)
-        dump();
+    MSODE_Expect(wallTimeInterval >= 0.0, "expect non negative wall time interval, got %g", wallTimeInterval);
+    MSODE_Expect(!frameBuffer_, "the buffered dump can not be checkpointed");
 
-    _stepForwardEuler(dt);
+    checkpointWriter_ = std::make_unique<CheckpointWriter>(fileName);
+    checkpointInterval_ = std::chrono::duration<double>(wallTimeInterval);
+    lastCheckpoint_ = std::chrono::steady_clock::now();
+}
 
-    ++currentTimeStep_;
+void Simulation::writeCheckpoint(const std::string& fileName)
+{
+    Checkpoint checkpoint;
+    _fillCheckpoint(checkpoint);
+    msode::writeCheckpoint(fileName, checkpoint);
 }
 
-void Simulation::advanceRK4(real dt)
+void Simulation::restartFromCheckpoint(const std::string& fileName)
 {
-    if (file_.is_open() && currentTimeStep_ % dumpEvery_ == 0)
-        dump();
+    const Checkpoint checkpoint = readCheckpoint(fileName);
 
-    _stepRK4(dt);
+    if (checkpoint.observerStates.size() != observers_.size())
+        msode_die("The checkpoint '%s' holds the states of %zu observers, but %zu are attached",
+                  fileName.c_str(), checkpoint.observerStates.size(), observers_.size());
 
-    ++currentTimeStep_;
+    restore(checkpoint.state);
+
+    for (size_t i = 0; i < observers_.size(); ++i)
+    {
+        std::istringstream stream(checkpoint.observerStates[i]);
+        observers_[i].observer->loadState(stream);
+    }
+
+    if (checkpoint.dumpFileName.empty())
+        return;
+
+    const char *dumpFileName = checkpoint.dumpFileName.c_str();
+
+    {
+        std::ifstream dumpFile(checkpoint.dumpFileName, std::ios::binary | std::ios::ate);
+        if (!dumpFile.is_open())
+            msode_die("Could not open the dump file '%s' of the checkpoint", dumpFileName);
+
+        if (static_cast<long>(dumpFile.tellg()) < checkpoint.dumpSize)
+            msode_die("The dump file '%s' is shorter than when the checkpoint was taken", dumpFileName);
+    }
+
+    // discard what was dumped after the checkpoint; it will be dumped again
+    if (::truncate(dumpFileName, checkpoint.dumpSize) != 0)
+        msode_die("Could not truncate the dump file '%s'", dumpFileName);
+
+    _openDump(checkpoint.dumpFileName, checkpoint.dumpEvery, std::ios::app | std::ios::ate);
 }
 
-static inline std::tuple<real3, real3>
-computeVelocities(const RigidBody& b, real3 B,
-                  const BaseVelocityField *velocityField,
-                  real time)
+void Simulation::_fillCheckpoint(Checkpoint& checkpoint)
 {
-    const Quaternion q = b.q;
-    const Quaternion qInv = q.conjugate();
-
-    const real3 m      = qInv.rotate(b.magnMoment);
-    const real3 torque = cross(m, B);
-    constexpr real3 force {0.0_r, 0.0_r, 0.0_r};
+    MSODE_Expect(!frameBuffer_, "the buffered dump can not be checkpointed");
 
-    real3 v, omega;
-    std::tie(v, omega) = computeVelocities(b.propulsion,
-                                           q.rotate(force),
-                                           q.rotate(torque));
+    snapshot(checkpoint.state);
 
-    v     = qInv.rotate(v    );
-    omega = qInv.rotate(omega);
+    checkpoint.observerStates.clear();
+    for (const auto& entry : observers_)
+    {
+        std::ostringstream stream;
+        entry.observer->saveState(stream);
+        checkpoint.observerStates.push_back(stream.str());
+    }
 
-    v     +=         velocityField->getVelocity (b.r, time);
-    omega += 0.5_r * velocityField->getVorticity(b.r, time);
+    if (file_.is_open())
+    {
+        file_.flush();
+        checkpoint.dumpFileName = dumpFileName_;
+        checkpoint.dumpEvery    = dumpEvery_;
+        checkpoint.dumpSize     = static_cast<long>(file_.tellp());
+    }
+}
 
-    const auto T = velocityField->getDeformationRateTensor(b.r, time);
-    const real3 p = qInv.rotate({1.0_r, 0.0_r, 0.0_r});
-    const real L = (b.aspectRatio*b.aspectRatio - 1.0_r) / (b.aspectRatio*b.aspectRatio + 1.0_r);
-    omega += L * cross(p, multiply(T, p));
+void Simulation::addObserver(BaseObserver *observer, long observeEvery)
+{
+    MSODE_Expect(observer != nullptr, "expect a non null observer");
+    MSODE_Expect(observeEvery > 0, "expect positive observeEvery");
+    observers_.push_back({observer, observeEvery});
+}
 
-    return {v, omega};
+void Simulation::clearObservers()
+{
+    observers_.clear();
 }
 
-static inline Quaternion quaternionDerivative(Quaternion q, real3 omega)
+void Simulation::runForwardEuler(long nsteps, real dt)
 {
-    return 0.5_r * q * Quaternion::createPureVector(omega);
+    MSODE_Expect(nsteps > 0, "expect positive number of steps");
+    MSODE_Expect(dt > 0._r, "expect positive time step");
+
+    _run(*eulerStepper_, nsteps, dt);
 }
 
+void Simulation::runRK4(long nsteps, real dt)
+{
+    MSODE_Expect(nsteps > 0, "expect positive number of steps");
+    MSODE_Expect(dt > 0._r, "expect positive time step");
+
+    MSODE_Expect(kBT_ == 0, "SDE not implemented for RK4. Expect zero diffusion.");
 
-static inline void addThermalNoise(RigidBody& b,
-                                   real kBT,
-                                   real dt,
-                                   std::mt19937& gen,
-                                   std::normal_distribution<real>& normal)
+    _run(*rk4Stepper_, nsteps, dt);
+}
+
+template <class AdvanceTo>
+void Simulation::_advanceThroughEvents(real tEnd, const std::vector<real>& switchTimes, AdvanceTo advanceTo)
 {
-    if (kBT > 0)
+    MSODE_Expect(std::is_sorted(switchTimes.begin(), switchTimes.end()), "expect increasing switch times");
+
+    auto advanceUntil = [&](real t)
     {
-        const real3 etaF {normal(gen), normal(gen), normal(gen)};
-        const real3 etaT {normal(gen), normal(gen), normal(gen)};
+        const real duration = t - getCurrentTime();
 
-        const real two_kBT_dt = 2 * kBT / dt;
-        const auto A = b.propulsion.A;
-        const auto B = b.propulsion.B;
-        const auto C = b.propulsion.C;
+        if (duration <= 0._r)
+            return;
 
-        b.v.x     += std::sqrt(two_kBT_dt * A[0]) * etaF.x + std::sqrt(two_kBT_dt * B[0]) * etaT.x;
-        b.v.y     += std::sqrt(two_kBT_dt * A[1]) * etaF.y + std::sqrt(two_kBT_dt * B[1]) * etaT.y;
-        b.v.z     += std::sqrt(two_kBT_dt * A[2]) * etaF.z + std::sqrt(two_kBT_dt * B[2]) * etaT.z;
+        advanceTo(duration);
+        currentTime_ = t; // remove the round off errors accumulated over the interval
+    };
 
-        b.omega.x += std::sqrt(two_kBT_dt * B[0]) * etaF.x + std::sqrt(two_kBT_dt * C[0]) * etaT.x;
-        b.omega.y += std::sqrt(two_kBT_dt * B[1]) * etaF.y + std::sqrt(two_kBT_dt * C[1]) * etaT.y;
-        b.omega.z += std::sqrt(two_kBT_dt * B[2]) * etaF.z + std::sqrt(two_kBT_dt * C[2]) * etaT.z;
-    }
-}
+    auto it = std::upper_bound(switchTimes.begin(), switchTimes.end(), getCurrentTime());
+
+    for (; it != switchTimes.end() && *it < tEnd; ++it)
+        advanceUntil(*it);
 
+    advanceUntil(tEnd);
+}
 
-void Simulation::_stepForwardEuler(real dt)
+void Simulation::runForwardEulerUntil(real tEnd, real dtMax, const std::vector<real>& switchTimes)
 {
-    const real3 B = magneticField_(currentTime_);
+    MSODE_Expect(dtMax > 0._r, "expect positive time step");
 
-    for (auto& rigidBody : rigidBodies_)
+    _advanceThroughEvents(tEnd, switchTimes, [&](real duration)
     {
-        std::tie(rigidBody.v, rigidBody.omega) = computeVelocities(rigidBody, B,
-                                                                   velocityField_.get(),
-                                                                   currentTime_);
-        addThermalNoise(rigidBody, kBT_, dt, gen_, normal_);
+        const long nsteps = static_cast<long>(std::ceil(duration / dtMax));
+        _run(*eulerStepper_, nsteps, duration / nsteps);
+    });
+}
 
-        const Quaternion dq_dt = quaternionDerivative(rigidBody.q, rigidBody.omega);
+void Simulation::skipUntil(real tEnd, const std::vector<real>& switchTimes)
+{
+    _advanceThroughEvents(tEnd, switchTimes, [&](real duration)
+    {
+        constexpr real_acc twoPi = 2 * M_PI;
+        magneticField_.advance(getCurrentTime(), duration);
+        magneticField_.phase = std::fmod(magneticField_.phase, twoPi);
+        if (magneticField_.phase < 0) magneticField_.phase += twoPi;
+    });
+}
 
-        rigidBody.r += dt * rigidBody.v;
-        rigidBody.q += dt * dq_dt;
+void Simulation::advanceForwardEuler(real dt)
+{
+    _run(*eulerStepper_, 1, dt);
+}
 
-        rigidBody.q = rigidBody.q.normalized();
-    }
+void Simulation::advanceRK4(real dt)
+{
+    MSODE_Expect(kBT_ == 0, "SDE not implemented for RK4. Expect zero diffusion.");
 
-    magneticField_.advance(currentTime_, dt);
-    currentTime_ += dt;
+    _run(*rk4Stepper_, 1, dt);
 }
 
-void Simulation::_stepRK4(real dt)
+void Simulation::_run(const BaseStepper& stepper, long nsteps, real dt)
 {
-    const real dt_half = 0.5_r * dt;
+    // the steps are performed in chunks between two checkpoint, dump or observation events
+    while (nsteps > 0)
+    {
+        long chunk = nsteps;
 
-    const real3 B0 = magneticField_(currentTime_);
-    magneticField_.advance(currentTime_, dt_half);
+        // before the dump, so that a restarted run dumps the current step again
+        if (checkpointWriter_)
+        {
+            const auto now = std::chrono::steady_clock::now();
 
-    const real3 Bh = magneticField_(currentTime_ + dt_half); // B half
-    magneticField_.advance(currentTime_ + dt_half, dt_half);
+            if (now - lastCheckpoint_ >= checkpointInterval_)
+            {
+                Checkpoint checkpoint;
+                _fillCheckpoint(checkpoint);
+                checkpointWriter_->writeAsync(std::move(checkpoint));
+                lastCheckpoint_ = now;
+            }
 
-    const real3 B1 = magneticField_(currentTime_ + dt);
+            chunk = std::min(chunk, stepsPerCheckpointPoll);
+        }
 
-    for (auto& rigidBody : rigidBodies_)
-    {
-        MSODE_Ensure(kBT_ == 0,
-                     "SDE not implemented for RK4. Expect zero diffusion.");
-
-        real3 v1, v2, v3, v4;
-
-        // compute k1 = f(y0, t)
-        RigidBody bWork = rigidBody;
-        std::tie(v1, bWork.omega) = computeVelocities(bWork, B0,
-                                                      velocityField_.get(),
-                                                      currentTime_);
-        const auto dq_dt1 = quaternionDerivative(bWork.q, bWork.omega);
-
-        bWork.r = rigidBody.r + dt_half * v1;
-        bWork.q = rigidBody.q + dt_half * dq_dt1;
-        bWork.q = bWork.q.normalized();
-        bWork.v = v1;
-
-        // compute k2 = f(y0 + dt/2 * k1, t + dt/2)
-        std::tie(v2, bWork.omega) = computeVelocities(bWork, Bh,
-                                                      velocityField_.get(),
-                                                      currentTime_+dt_half);
-        const auto dq_dt2 = quaternionDerivative(bWork.q, bWork.omega);
-
-        bWork.r = rigidBody.r + dt_half * v2;
-        bWork.q = rigidBody.q + dt_half * dq_dt2;
-        bWork.q = bWork.q.normalized();
-        bWork.v = v2;
-
-        // compute k3 = f(y0 + dt/2 * k2, t + dt/2)
-        std::tie(v3, bWork.omega) = computeVelocities(bWork, Bh,
-                                                      velocityField_.get(),
-                                                      currentTime_+dt_half);
-        const auto dq_dt3 = quaternionDerivative(bWork.q, bWork.omega);
-
-        bWork.r = rigidBody.r + dt * v3;
-        bWork.q = rigidBody.q + dt * dq_dt3;
-        bWork.q = bWork.q.normalized();
-        bWork.v = v3;
-
-        // compute k4 = f(y0 + dt * k3, t + dt)
-        std::tie(v4, rigidBody.omega) = computeVelocities(bWork, B1,
-                                                          velocityField_.get(),
-                                                          currentTime_+dt);
-        const auto dq_dt4 = quaternionDerivative(rigidBody.q, rigidBody.omega);
-
-        // compute y1 = y0 + (k1/6 + k2/3 + k3/3 + k4/6) * dt
-        constexpr real one_third = 1.0_r / 3.0_r;
-        constexpr real one_sixth = 1.0_r / 6.0_r;
-
-        rigidBody.r += dt * (one_sixth * (v1     + v4    ) + one_third * (v2     + v3    ));
-        rigidBody.q += dt * (one_sixth * (dq_dt1 + dq_dt4) + one_third * (dq_dt2 + dq_dt3));
-        rigidBody.q = rigidBody.q.normalized();
-        rigidBody.v = v4;
-    }
+        if (file_.is_open() || frameBuffer_)
+        {
+            const long stepsSinceDump = currentTimeStep_ % dumpEvery_;
+
+            if (stepsSinceDump == 0)
+                dump();
+
+            chunk = std::min(chunk, dumpEvery_ - stepsSinceDump);
+        }
 
-    currentTime_ += dt;
+        for (const auto& entry : observers_)
+        {
+            const long stepsSinceObservation = currentTimeStep_ % entry.every;
+
+            if (stepsSinceObservation == 0)
+                entry.observer->observe(*this);
+
+            chunk = std::min(chunk, entry.every - stepsSinceObservation);
+        }
+
+        stepper.run(*this, chunk, dt);
+        nsteps -= chunk;
+    }
 }
 
 void Simulation::dump()
@@ -260,6 +377,27 @@ void Simulation::dump()
     const real omega = magneticField_.omega(currentTime_);
     const real3 dir  = magneticField_.rotatingDirection(currentTime_);
 
+    if (frameBuffer_)
+    {
+        MSODE_Expect(static_cast<int>(frame_.size()) == 5 + 10 * static_cast<int>(rigidBodies_.size()),
+                     "the number of bodies changed since activateBufferedDump()");
+
+        double *f = frame_.data();
+        *f++ = currentTime_;
+        *f++ = omega;
+        *f++ = dir.x; *f++ = dir.y; *f++ = dir.z;
+
+        for (const auto& b : rigidBodies_)
+        {
+            *f++ = b.q.w; *f++ = b.q.x; *f++ = b.q.y; *f++ = b.q.z;
+            *f++ = b.r.x;     *f++ = b.r.y;     *f++ = b.r.z;
+            *f++ = b.omega.x; *f++ = b.omega.y; *f++ = b.omega.z;
+        }
+
+        frameBuffer_->push(frame_.data());
+        return;
+    }
+
     file_ << currentTime_ << " " << omega << " "  << dir.x << " "  << dir.y << " "  << dir.z;
 
     for (const auto& rigidBody : rigidBodies_)
@@ -1,11 +1,14 @@
 // Copyright 2020 ETH Zurich. All Rights Reserved.
 #pragma once
 
+#include "frame_buffer.h"
+#include "observer.h"
 #include "quaternion.h"
 #include "types.h"
 #include "velocity_field/interface.h"
 
 #include <array>
+#include <chrono>
 #include <cmath>
 #include <fstream>
 #include <functional>
@@ -18,33 +21,67 @@
 namespace msode
 {
 
-struct PropulsionMatrix
+/// Diagonal propulsion matrix, generic over the scalar type (see Vector3)
+template <class T>
+struct PropulsionMatrixT
 {
-    using SubMatrix = std::array<real,3>;
+    using SubMatrix = std::array<T,3>;
     SubMatrix A, B, C;
 };
 
-struct RigidBody
+using PropulsionMatrix = PropulsionMatrixT<real>;
+
+/// Rigid body, generic over the scalar type (see Vector3) so that derivatives can be propagated through the dynamics
+template <class T>
+struct RigidBodyT
 {
-    Quaternion q;
-    real3 r, magnMoment;
-    PropulsionMatrix propulsion;
-    real aspectRatio {1.0_r};
+    QuaternionT<T> q;
+    Vector3<T> r, magnMoment;
+    PropulsionMatrixT<T> propulsion;
+    T aspectRatio {1.0_r};
 
-    real3 v {0._r, 0._r, 0._r}, omega {0._r, 0._r, 0._r};
+    Vector3<T> v {0._r, 0._r, 0._r}, omega {0._r, 0._r, 0._r};
 
     // assume m is along y
-    inline real stepOutFrequency(real magneticFieldMagnitude, int dir = 0) const
+    inline T stepOutFrequency(T magneticFieldMagnitude, int dir = 0) const
     {
-        MSODE_Expect(std::abs(magnMoment.x) < 1e-6_r && std::abs(magnMoment.z) < 1e-6_r, "Assume m along y");
+        using std::abs;
+        MSODE_Expect(abs(magnMoment.x) < 1e-6_r && abs(magnMoment.z) < 1e-6_r, "Assume m along y");
         MSODE_Expect(dir == 0 || dir == 2, "Can only compute step out frequency along x or z direction");
 
-        const real m = length(magnMoment);
-        const real C = propulsion.C[dir];
+        const T m = length(magnMoment);
+        const T C = propulsion.C[dir];
         return magneticFieldMagnitude * m * C;
     }
 };
 
+using RigidBody = RigidBodyT<real>;
+
+/** \brief Compute the magnetic field rotating in the plane normal to a given direction.
+    \param magnitude The magnitude of the field
+    \param phase The phase of the rotation
+    \param direction The rotation direction of the field; must be non zero
+    \return The field vector
+ */
+template <class T>
+inline Vector3<T> computeRotatingField(T magnitude, T phase, Vector3<T> direction)
+{
+    using std::cos;
+    using std::sin;
+
+    const Vector3<T> B {magnitude * cos(phase),
+                        magnitude * sin(phase),
+                        T(0)};
+
+    const Vector3<T> originalDirection {T(0), T(0), T(1)};
+
+    MSODE_Ensure(length(direction) > 0.0_r, "Rotating direction must be different than 0");
+
+    const auto q = QuaternionT<T>::createFromVectors(originalDirection, direction);
+
+    return q.rotate(B);
+}
+
 struct MagneticField
 {
     MagneticField(real magnitude_, std::function<real(real)> omega_, std::function<real3(real)> rotatingDirection_) :
@@ -57,33 +94,50 @@ struct MagneticField
     {
         phase += omega(t) * dt;
 
-        constexpr real twoPi = 2._r * M_PI;
+        constexpr real_acc twoPi = 2 * M_PI;
         if (phase >= twoPi) phase -= twoPi;
         if (phase < 0)      phase += twoPi;
     }
 
     real3 operator()(real t) const
     {
-        const real3 B {magnitude * std::cos(phase),
-                       magnitude * std::sin(phase),
-                       0.0_r};
-
-        constexpr real3 originalDirection {0.0_r, 0.0_r, 1.0_r};
-        const real3 currentDirection = rotatingDirection(t);
-
-        MSODE_Ensure(length(currentDirection) > 0.0_r, "Rotating direction must be different than 0");
-
-        const auto q = Quaternion::createFromVectors(originalDirection, currentDirection);
-
-        return q.rotate(B);
+        return computeRotatingField(magnitude, static_cast<real>(phase), rotatingDirection(t));
     }
 
-    real magnitude, phase {0};
+    real magnitude;
+    real_acc phase {0};
     std::function<real(real)> omega;
     std::function<real3(real)> rotatingDirection;
 };
 
 
+/// The part of a RigidBody that changes during a simulation
+struct RigidBodyState
+{
+    Quaternion q;
+    real3 r, v, omega;
+};
+
+/** The dynamic state of a Simulation: time, bodies kinematics, phase of the magnetic field and random number generator.
+    The immutable parts (properties of the bodies, field functions, velocity field) are not stored: they are shared
+    with the simulation that the state is restored to. See Simulation::snapshot() and Simulation::restore().
+ */
+struct SimulationState
+{
+    real_acc currentTime {0};
+    long currentTimeStep {0};
+    real_acc fieldPhase {0};
+    std::vector<RigidBodyState> bodies;
+    std::vector<real3_acc> positions; ///< positions of the bodies accumulated in real_acc precision
+    std::mt19937 gen;
+    std::normal_distribution<real> normal;
+};
+
+
+class BaseStepper;
+class CheckpointWriter;
+struct Checkpoint;
+
 class Simulation
 {
 public:
@@ -93,37 +147,155 @@ public:
     Simulation(std::vector<RigidBody> initialRBs, MagneticField initialMF, real kBT);
     Simulation(std::vector<RigidBody> initialRBs, MagneticField initialMF, real kBT,
                std::unique_ptr<BaseVelocityField> velocityField);
-    ~Simulation() = default;
+    ~Simulation();
 
     void reset(std::vector<RigidBody> initialRBs, MagneticField initialMF);
+
+    /** reset the time and the phase of the magnetic field, keeping the current bodies and field.
+        The bodies can be modified in place with getBodies(). Does not allocate memory.
+     */
+    void reset();
     void activateDump(const std::string& fname, long dumpEvery);
 
+    /// stop writing to the file opened by activateDump(), if any; the buffered dump is not affected
+    void deactivateDump();
+
+    /** \brief Keep the dumps in a ring buffer in memory instead of writing them to a file (see FrameBuffer).
+        \param dumpEvery The dump frequency, as in activateDump()
+        \param capacity The maximum number of frames kept; the oldest frames are dropped first
+        \param singlePrecision Store the frames in float32
+        The buffer is cleared at every reset() and written only on request with flushBufferedDump(), e.g. for the
+        runs that turn out to be interesting. Replaces the dump to a file; activateDump() replaces the buffered dump.
+        The buffered frames are not part of the checkpoints, hence the buffered dump can not be combined with them.
+     */
+    void activateBufferedDump(long dumpEvery, long capacity, bool singlePrecision = false);
+
+    /// write the buffered frames, oldest first, to \p fname in the format of activateDump()
+    void flushBufferedDump(const std::string& fname) const;
+
+    /// \return The buffer of the frames, or nullptr if the buffered dump is not active
+    const FrameBuffer* getFrameBuffer() const {return frameBuffer_.get();}
+
+    /** \brief Attach an in-situ analysis to the simulation.
+        \param observer The observer; must outlive the simulation, or be detached with clearObservers().
+        \param observeEvery The observer is called before every time step whose index is a multiple of \p observeEvery,
+               like the dumps (see activateDump()).
+        The observers are kept across resets and are not part of the snapshots. Their states are part of the checkpoints
+        (see restartFromCheckpoint()).
+     */
+    void addObserver(BaseObserver *observer, long observeEvery);
+
+    /// detach all observers
+    void clearObservers();
+
+    /// reset the state of the random number generator used for the thermal noise
+    void setNoiseSeed(unsigned long seed);
+
+    /** \brief Save the dynamic state of the simulation.
+        \param state Receives the state. Does not allocate memory if it already holds the same number of bodies.
+     */
+    void snapshot(SimulationState& state) const;
+
+    /** \brief Restore a state saved with snapshot().
+        \param state The state, saved from this simulation or from an equivalent one (same bodies properties,
+               magnetic field functions and velocity field), e.g. to fork a run into several branches.
+        The trajectory dump, if active, is not affected. Does not allocate memory.
+     */
+    void restore(const SimulationState& state);
+
+    /** \brief Periodically save a checkpoint of the simulation during the runs (see Checkpoint).
+        \param fileName The checkpoint file; it is replaced atomically at every checkpoint.
+        \param wallTimeInterval The wall clock time in seconds between two checkpoints.
+        The checkpoints are taken between time steps and written on a background thread.
+        The states of the observers are saved with the checkpoints. This method will fail if the buffered dump is active.
+     */
+    void activateCheckpoint(const std::string& fileName, double wallTimeInterval);
+
+    /// write a checkpoint of the current state to \p fileName; blocks until the file is written (see activateCheckpoint())
+    void writeCheckpoint(const std::string& fileName);
+
+    /** \brief Resume a simulation from a checkpoint.
+        \param fileName A checkpoint written by this simulation or by an equivalent one (see restore()).
+        If the dump was active when the checkpoint was taken, the dump file is truncated to its size at that time
+        and the dump continues at its end; in that case activateDump() must not be called.
+        The observers must be attached before the restart, in the same order and with the same parameters as when
+        the checkpoint was taken; their states are restored from the checkpoint.
+        The remaining number of steps of a run is its total number of steps minus getCurrentTimeStep().
+     */
+    void restartFromCheckpoint(const std::string& fileName);
+
     void runForwardEuler(long nsteps, real dt);
     void runRK4(long nsteps, real dt);
 
+    /** \brief Advance the simulation with forward Euler until time \p tEnd, with steps aligned on switching events.
+        \param tEnd The final time
+        \param dtMax The maximum time step
+        \param switchTimes Increasing times at which the controls change (e.g. FieldSchedule::getSwitchTimes()).
+
+        The interval between two consecutive events is split into equal steps no larger than \p dtMax,
+        so that no step straddles a switch. The simulation time is set exactly to each event once it is reached.
+     */
+    void runForwardEulerUntil(real tEnd, real dtMax, const std::vector<real>& switchTimes);
+
+    /** \brief Advance the time and the magnetic field until time \p tEnd without moving the bodies.
+        \param tEnd The final time
+        \param switchTimes Increasing times at which the controls change (e.g. FieldSchedule::getSwitchTimes()).
+
+        Used when the bodies are propagated externally (e.g. analytically) over that interval.
+        The phase of the field is integrated exactly if its frequency is constant between two events.
+     */
+    void skipUntil(real tEnd, const std::vector<real>& switchTimes);
+
     const std::vector<RigidBody>& getBodies() const {return rigidBodies_;}
     std::vector<RigidBody>& getBodies() {return rigidBodies_;}
 
     const MagneticField& getField() const {return magneticField_;}
-    real getCurrentTime() const {return currentTime_;}
+    const BaseVelocityField* getVelocityField() const {return velocityField_.get();}
+    real getCurrentTime() const {return static_cast<real>(currentTime_);}
+    long getCurrentTimeStep() const {return currentTimeStep_;} ///< number of time steps performed since the last reset
+    real getKBT() const {return kBT_;}
 
     void advanceForwardEuler(real dt);
     void advanceRK4(real dt);
     void dump();
 
 private:
-    void _stepForwardEuler(real dt);
-    void _stepRK4(real dt);
+    void _run(const BaseStepper& stepper, long nsteps, real dt);
+    void _openDump(const std::string& fname, long dumpEvery, std::ios::openmode mode);
+    void _fillCheckpoint(Checkpoint& checkpoint);
+
+    template <class AdvanceTo>
+    void _advanceThroughEvents(real tEnd, const std::vector<real>& switchTimes, AdvanceTo advanceTo);
+
+    template <class Scheme, class FieldT, class NoiseT>
+    friend class Stepper;
 
 private:
-    real currentTime_ {0.0_r};
+    real_acc currentTime_ {0};
     long currentTimeStep_ {0};
     std::vector<RigidBody> rigidBodies_;
+    std::vector<real3_acc> positions_; ///< positions of the bodies accumulated over the time steps, in real_acc precision
     MagneticField magneticField_;
     std::unique_ptr<BaseVelocityField> velocityField_;
+    std::unique_ptr<BaseStepper> eulerStepper_;
+    std::unique_ptr<BaseStepper> rk4Stepper_;
 
     long dumpEvery_ {0};
+    std::string dumpFileName_;
     std::ofstream file_ {};
+    std::unique_ptr<FrameBuffer> frameBuffer_;
+    std::vector<double> frame_; ///< work space for the frames of the buffered dump
+
+    std::unique_ptr<CheckpointWriter> checkpointWriter_;
+    std::chrono::duration<double> checkpointInterval_ {0.0};
+    std::chrono::steady_clock::time_point lastCheckpoint_;
+
+    struct ObserverEntry
+    {
+        BaseObserver *observer;
+        long every;
+    };
+    std::vector<ObserverEntry> observers_;
 
     real kBT_{0.0_r};
     std::mt19937 gen_{424242};
@@ -0,0 +1,224 @@
+// Copyright 2020 ETH Zurich. All Rights Reserved.
+#include "stepper.h"
+#include "dynamics.h"
+#include "math.h"
+#include "velocity_field/none.h"
+#include "velocity_field/shear.h"
+#include "velocity_field/taylor_green_vortex.h"
+
+#include <tuple>
+
+namespace msode
+{
+
+BaseStepper::~BaseStepper() = default;
+
+static inline void accumulate(real3_acc& acc, real3 dr)
+{
+    acc.x += dr.x;
+    acc.y += dr.y;
+    acc.z += dr.z;
+}
+
+static inline real3 toReal3(real3_acc a)
+{
+    return {static_cast<real>(a.x),
+            static_cast<real>(a.y),
+            static_cast<real>(a.z)};
+}
+
+static inline void addThermalNoise(noise::None,
+                                   RigidBody& /* b */,
+                                   real /* kBT */,
+                                   real /* dt */,
+                                   std::mt19937& /* gen */,
+                                   std::normal_distribution<real>& /* normal */)
+{}
+
+static inline void addThermalNoise(noise::Thermal,
+                                   RigidBody& b,
+                                   real kBT,
+                                   real dt,
+                                   std::mt19937& gen,
+                                   std::normal_distribution<real>& normal)
+{
+    const real3 etaF {normal(gen), normal(gen), normal(gen)};
+    const real3 etaT {normal(gen), normal(gen), normal(gen)};
+
+    const real two_kBT_dt = 2 * kBT / dt;
+    const auto A = b.propulsion.A;
+    const auto B = b.propulsion.B;
+    const auto C = b.propulsion.C;
+
+    b.v.x     += std::sqrt(two_kBT_dt * A[0]) * etaF.x + std::sqrt(two_kBT_dt * B[0]) * etaT.x;
+    b.v.y     += std::sqrt(two_kBT_dt * A[1]) * etaF.y + std::sqrt(two_kBT_dt * B[1]) * etaT.y;
+    b.v.z     += std::sqrt(two_kBT_dt * A[2]) * etaF.z + std::sqrt(two_kBT_dt * B[2]) * etaT.z;
+
+    b.omega.x += std::sqrt(two_kBT_dt * B[0]) * etaF.x + std::sqrt(two_kBT_dt * C[0]) * etaT.x;
+    b.omega.y += std::sqrt(two_kBT_dt * B[1]) * etaF.y + std::sqrt(two_kBT_dt * C[1]) * etaT.y;
+    b.omega.z += std::sqrt(two_kBT_dt * B[2]) * etaF.z + std::sqrt(two_kBT_dt * C[2]) * etaT.z;
+}
+
+
+template <class Scheme, class FieldT, class NoiseT>
+inline void Stepper<Scheme, FieldT, NoiseT>::_step(schemes::ForwardEuler, Simulation& sim, real dt) const
+{
+    const FieldT *velocityField = field_;
+    const real currentTime = static_cast<real>(sim.currentTime_);
+    const real3 B = sim.magneticField_(currentTime);
+
+    for (size_t i = 0; i < sim.rigidBodies_.size(); ++i)
+    {
+        auto& rigidBody = sim.rigidBodies_[i];
+        std::tie(rigidBody.v, rigidBody.omega) = computeVelocities(rigidBody, B,
+                                                                   velocityField,
+                                                                   currentTime);
+        addThermalNoise(NoiseT{}, rigidBody, sim.kBT_, dt, sim.gen_, sim.normal_);
+
+        const Quaternion dq_dt = quaternionDerivative(rigidBody.q, rigidBody.omega);
+
+        accumulate(sim.positions_[i], dt * rigidBody.v);
+        rigidBody.r = toReal3(sim.positions_[i]);
+        rigidBody.q += dt * dq_dt;
+
+        rigidBody.q = rigidBody.q.normalized();
+    }
+
+    sim.magneticField_.advance(currentTime, dt);
+    sim.currentTime_ += dt;
+}
+
+template <class Scheme, class FieldT, class NoiseT>
+inline void Stepper<Scheme, FieldT, NoiseT>::_step(schemes::RK4, Simulation& sim, real dt) const
+{
+    const FieldT *velocityField = field_;
+    const real currentTime = static_cast<real>(sim.currentTime_);
+    const real dt_half = 0.5_r * dt;
+
+    const real3 B0 = sim.magneticField_(currentTime);
+    sim.magneticField_.advance(currentTime, dt_half);
+
+    const real3 Bh = sim.magneticField_(currentTime + dt_half); // B half
+    sim.magneticField_.advance(currentTime + dt_half, dt_half);
+
+    const real3 B1 = sim.magneticField_(currentTime + dt);
+
+    for (size_t i = 0; i < sim.rigidBodies_.size(); ++i)
+    {
+        auto& rigidBody = sim.rigidBodies_[i];
+        real3 v1, v2, v3, v4;
+
+        // compute k1 = f(y0, t)
+        RigidBody bWork = rigidBody;
+        std::tie(v1, bWork.omega) = computeVelocities(bWork, B0,
+                                                      velocityField,
+                                                      currentTime);
+        const auto dq_dt1 = quaternionDerivative(bWork.q, bWork.omega);
+
+        bWork.r = rigidBody.r + dt_half * v1;
+        bWork.q = rigidBody.q + dt_half * dq_dt1;
+        bWork.q = bWork.q.normalized();
+        bWork.v = v1;
+
+        // compute k2 = f(y0 + dt/2 * k1, t + dt/2)
+        std::tie(v2, bWork.omega) = computeVelocities(bWork, Bh,
+                                                      velocityField,
+                                                      currentTime+dt_half);
+        const auto dq_dt2 = quaternionDerivative(bWork.q, bWork.omega);
+
+        bWork.r = rigidBody.r + dt_half * v2;
+        bWork.q = rigidBody.q + dt_half * dq_dt2;
+        bWork.q = bWork.q.normalized();
+        bWork.v = v2;
+
+        // compute k3 = f(y0 + dt/2 * k2, t + dt/2)
+        std::tie(v3, bWork.omega) = computeVelocities(bWork, Bh,
+                                                      velocityField,
+                                                      currentTime+dt_half);
+        const auto dq_dt3 = quaternionDerivative(bWork.q, bWork.omega);
+
+        bWork.r = rigidBody.r + dt * v3;
+        bWork.q = rigidBody.q + dt * dq_dt3;
+        bWork.q = bWork.q.normalized();
+        bWork.v = v3;
+
+        // compute k4 = f(y0 + dt * k3, t + dt)
+        std::tie(v4, rigidBody.omega) = computeVelocities(bWork, B1,
+                                                          velocityField,
+                                                          currentTime+dt);
+        const auto dq_dt4 = quaternionDerivative(rigidBody.q, rigidBody.omega);
+
+        // compute y1 = y0 + (k1/6 + k2/3 + k3/3 + k4/6) * dt
+        constexpr real one_third = 1.0_r / 3.0_r;
+        constexpr real one_sixth = 1.0_r / 6.0_r;
+
+        accumulate(sim.positions_[i], dt * (one_sixth * (v1     + v4    ) + one_third * (v2     + v3    )));
+        rigidBody.r = toReal3(sim.positions_[i]);
+        rigidBody.q += dt * (one_sixth * (dq_dt1 + dq_dt4) + one_third * (dq_dt2 + dq_dt3));
+        rigidBody.q = rigidBody.q.normalized();
+        rigidBody.v = v4;
+    }
+
+    sim.currentTime_ += dt;
+}
+
+template <class Scheme, class FieldT, class NoiseT>
+void Stepper<Scheme, FieldT, NoiseT>::run(Simulation& sim, long nsteps, real dt) const
+{
+    // the positions are accumulated in real_acc precision and rounded to real after each step.
+    // The accumulated values are kept in the simulation from one run to the next,
+    // unless the bodies have been moved in between.
+    // The time is accumulated in the simulation itself.
+    sim.positions_.resize(sim.rigidBodies_.size());
+    for (size_t i = 0; i < sim.positions_.size(); ++i)
+    {
+        const real3 r = sim.rigidBodies_[i].r;
+        const real3 rAcc = toReal3(sim.positions_[i]);
+
+        if (r.x != rAcc.x || r.y != rAcc.y || r.z != rAcc.z)
+            sim.positions_[i] = {r.x, r.y, r.z};
+    }
+
+    for (long i = 0; i < nsteps; ++i)
+    {
+        _step(Scheme{}, sim, dt);
+        ++sim.currentTimeStep_;
+    }
+}
+
+
+template <class Scheme, class NoiseT>
+static std::unique_ptr<BaseStepper> createStepper(const BaseVelocityField *velocityField)
+{
+    // VelocityFieldNone derives from VelocityFieldConstant: zero velocity, vorticity and deformation rate everywhere
+    if (dynamic_cast<const VelocityFieldNone*>(velocityField))
+        return std::make_unique<Stepper<Scheme, NoFlow, NoiseT>>(nullptr);
+
+    if (auto tgv = dynamic_cast<const VelocityFieldTaylorGreenVortex*>(velocityField))
+        return std::make_unique<Stepper<Scheme, VelocityFieldTaylorGreenVortex, NoiseT>>(tgv);
+
+    if (auto shear = dynamic_cast<const VelocityFieldShear*>(velocityField))
+        return std::make_unique<Stepper<Scheme, VelocityFieldShear, NoiseT>>(shear);
+
+    return std::make_unique<Stepper<Scheme, BaseVelocityField, NoiseT>>(velocityField);
+}
+
+std::unique_ptr<BaseStepper> createStepper(Simulation::ODEScheme scheme, const BaseVelocityField *velocityField, real kBT)
+{
+    switch (scheme)
+    {
+    case Simulation::ODEScheme::ForwardEuler:
+        if (kBT > 0)
+            return createStepper<schemes::ForwardEuler, noise::Thermal>(velocityField);
+        else
+            return createStepper<schemes::ForwardEuler, noise::None>(velocityField);
+
+    case Simulation::ODEScheme::RK4:
+        return createStepper<schemes::RK4, noise::None>(velocityField);
+    };
+
+    msode_die("Unknown ODE scheme");
+    return nullptr;
+}
+
+} // namespace msode
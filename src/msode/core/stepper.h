@@ -0,0 +1,78 @@
+// Copyright 2020 ETH Zurich. All Rights Reserved.
+#pragma once
+
+#include "dynamics.h"
+#include "simulation.h"
+
+#include <memory>
+#include <vector>
+
+namespace msode
+{
+
+/// Time integration schemes
+namespace schemes
+{
+struct ForwardEuler {};
+struct RK4 {};
+} // namespace schemes
+
+/// Thermal noise models
+namespace noise
+{
+struct None {};    ///< deterministic dynamics
+struct Thermal {}; ///< Brownian motion at temperature kBT > 0
+} // namespace noise
+
+/** Advances the state of a Simulation by a given number of time steps.
+    This is the type-erased interface of Stepper; the Simulation holds one stepper per integration scheme.
+ */
+class BaseStepper
+{
+public:
+    virtual ~BaseStepper();
+
+    /** \brief advance the simulation by \p nsteps steps of size \p dt.
+        Does not dump the state; the caller is responsible for splitting the run at the dump events.
+     */
+    virtual void run(Simulation& sim, long nsteps, real dt) const = 0;
+};
+
+/** Time stepping core specialized at compile time.
+    \tparam Scheme One of the types in the schemes namespace
+    \tparam FieldT The concrete type of the background flow, NoFlow, or BaseVelocityField for any flow (virtual calls)
+    \tparam NoiseT One of the types in the noise namespace
+
+    The whole loop over the time steps is compiled for the given combination,
+    so that no branch on the noise, no virtual call to a known flow and no scheme selection remain in the hot loop.
+ */
+template <class Scheme, class FieldT, class NoiseT>
+class Stepper : public BaseStepper
+{
+public:
+    explicit Stepper(const FieldT *field) :
+        field_(field)
+    {}
+
+    void run(Simulation& sim, long nsteps, real dt) const override;
+
+private:
+    void _step(schemes::ForwardEuler, Simulation& sim, real dt) const;
+    void _step(schemes::RK4, Simulation& sim, real dt) const;
+
+private:
+    const FieldT *field_;
+};
+
+/** \brief Create the Stepper specialized for the given scheme, flow and temperature.
+    \param scheme The time integration scheme
+    \param velocityField The background flow; must outlive the stepper
+    \param kBT The temperature; thermal noise is enabled if positive
+
+    Known flow types (no flow, Taylor-Green vortex, shear) are dispatched to devirtualized kernels;
+    other flows use the generic kernel.
+    The RK4 scheme does not support thermal noise; its stepper is always deterministic.
+ */
+std::unique_ptr<BaseStepper> createStepper(Simulation::ODEScheme scheme, const BaseVelocityField *velocityField, real kBT);
+
+} // namespace msode
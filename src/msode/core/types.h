@@ -6,9 +6,31 @@
 namespace msode
 {
 
+/** Floating point type of the state, the fields and the kernels.
+    Selected at configure time with MSODE_PRECISION:
+    - double: everything in double precision (default)
+    - single: everything in single precision
+    - mixed:  single precision state and kernels; positions and time are accumulated in double precision
+ */
+#if defined(MSODE_SINGLE_PRECISION) || defined(MSODE_MIXED_PRECISION)
+using real = float;
+#else
 using real = double;
+#endif
 
-struct real3 {real x, y, z;};
+/// 3D vector generic over the scalar type, e.g. to propagate derivatives with Dual numbers (see dual.h)
+template <class T>
+struct Vector3 {T x, y, z;};
+
+using real3 = Vector3<real>;
+
+/// Floating point type used to accumulate the positions and the time over many time steps
+#ifdef MSODE_MIXED_PRECISION
+using real_acc = double;
+#else
+using real_acc = real;
+#endif
+using real3_acc = Vector3<real_acc>;
 struct int3 {int x, y, z;};
 
 constexpr inline real3 make_real3(real a)
@@ -29,7 +51,8 @@ constexpr inline real operator "" _r (const long double a)
 }
 } // namespace literals
 
-inline std::ostream& operator<<(std::ostream& stream, const real3& v)
+template <class T>
+inline std::ostream& operator<<(std::ostream& stream, const Vector3<T>& v)
 {
     return stream << v.x << " " << v.y << " " << v.z;
 }
@@ -1,6 +1,8 @@
 // Copyright 2020 ETH Zurich. All Rights Reserved.
 #include "constant.h"
 
+#include <msode/core/math.h>
+
 namespace msode
 {
 
@@ -28,4 +30,9 @@ DeformationRateTensor VelocityFieldConstant::getDeformationRateTensor(real3 /* r
     return {0.0_r, 0.0_r, 0.0_r, 0.0_r, 0.0_r, 0.0_r};
 }
 
+real VelocityFieldConstant::getVelocityBound() const
+{
+    return length(vel_);
+}
+
 } // namespace msode
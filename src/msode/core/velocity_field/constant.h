@@ -17,6 +17,7 @@ public:
     real3 getVelocity(real3 r, real t) const override;
     real3 getVorticity(real3 r, real t) const override;
     DeformationRateTensor getDeformationRateTensor(real3 r, real t) const override;
+    real getVelocityBound() const override;
 
 private:
     const real3 vel_; ///< velocity everywhere in space and time
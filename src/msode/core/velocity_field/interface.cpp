@@ -4,14 +4,20 @@
 #include <msode/core/log.h>
 #include <msode/core/math.h>
 
-#include <vector>
 #include <fstream>
+#include <limits>
+#include <vector>
 
 namespace msode
 {
 
 BaseVelocityField::~BaseVelocityField() = default;
 
+real BaseVelocityField::getVelocityBound() const
+{
+    return std::numeric_limits<real>::infinity();
+}
+
 void BaseVelocityField::dumpToVtkUniformGrid(const std::string& fileName, int3 dimensions, real3 start, real3 size,
                                              real t, Filter filter) const
 {
@@ -11,15 +11,19 @@
 namespace msode
 {
 
-/// Symmetric matrix
-struct DeformationRateTensor
+/// Symmetric matrix, generic over the scalar type (see Vector3)
+template <class T>
+struct DeformationRateTensorT
 {
-    real xx, xy, xz, yy, yz, zz;
+    T xx, xy, xz, yy, yz, zz;
 };
 
+using DeformationRateTensor = DeformationRateTensorT<real>;
+
 using Filter = std::function<bool(real3)>;
 
-static inline real3 multiply(DeformationRateTensor T, real3 v)
+template <class Scalar>
+static inline Vector3<Scalar> multiply(const DeformationRateTensorT<Scalar>& T, const Vector3<Scalar>& v)
 {
     return {T.xx * v.x + T.xy * v.y + T.xz * v.z,
             T.xy * v.x + T.yy * v.y + T.yz * v.z,
@@ -52,6 +56,11 @@ public:
     */
     virtual DeformationRateTensor getDeformationRateTensor(real3 r, real t) const = 0;
 
+    /** \returns an upper bound of the magnitude of the velocity over the whole space and time.
+        The default implementation returns infinity, which is always valid.
+    */
+    virtual real getVelocityBound() const;
+
     /** dump the velocity and vorticity fields on a uniform grid to a vtk file called \p fileName.
         \param [in] fileName The destination file name.
         \param [in] dimensions Number of points per dimension
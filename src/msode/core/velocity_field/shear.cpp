@@ -13,19 +13,19 @@ std::unique_ptr<BaseVelocityField> VelocityFieldShear::clone() const
     return std::make_unique<VelocityFieldShear>(*this);
 }
 
-real3 VelocityFieldShear::getVelocity(real3 r, real /* t */) const
+real3 VelocityFieldShear::getVelocity(real3 r, real t) const
 {
-    return {r.y * G_, 0.0_r, 0.0_r};
+    return getVelocity<real>(r, t);
 }
 
-real3 VelocityFieldShear::getVorticity(real3 /* r */, real /* t */) const
+real3 VelocityFieldShear::getVorticity(real3 r, real t) const
 {
-    return {0.0_r, 0.0_r, G_};
+    return getVorticity<real>(r, t);
 }
 
-DeformationRateTensor VelocityFieldShear::getDeformationRateTensor(real3 /* r */, real /* t */) const
+DeformationRateTensor VelocityFieldShear::getDeformationRateTensor(real3 r, real t) const
 {
-    return {0.0_r, 0.5_r * G_, 0.0_r, 0.0_r, 0.0_r, 0.0_r};
+    return getDeformationRateTensor<real>(r, t);
 }
 
 } // namespace msode
@@ -7,7 +7,7 @@ namespace msode
 {
 
 /// shear rate along x, gradient along y: v(x,y,z) = (G * y, 0, 0)
-class VelocityFieldShear : public BaseVelocityField
+class VelocityFieldShear final : public BaseVelocityField
 {
 public:
     VelocityFieldShear(real G);
@@ -18,8 +18,32 @@ public:
     real3 getVorticity(real3 r, real t) const override;
     DeformationRateTensor getDeformationRateTensor(real3 r, real t) const override;
 
+    /// generic versions of the above, e.g. to propagate derivatives with Dual numbers
+    template <class T> Vector3<T> getVelocity(const Vector3<T>& r, real t) const;
+    template <class T> Vector3<T> getVorticity(const Vector3<T>& r, real t) const;
+    template <class T> DeformationRateTensorT<T> getDeformationRateTensor(const Vector3<T>& r, real t) const;
+
 private:
     const real G_; ///< velocity everywhere in space and time
 };
 
+template <class T>
+inline Vector3<T> VelocityFieldShear::getVelocity(const Vector3<T>& r, real /* t */) const
+{
+    return {r.y * G_, T(0), T(0)};
+}
+
+template <class T>
+inline Vector3<T> VelocityFieldShear::getVorticity(const Vector3<T>& /* r */, real /* t */) const
+{
+    return {T(0), T(0), T(G_)};
+}
+
+template <class T>
+inline DeformationRateTensorT<T> VelocityFieldShear::getDeformationRateTensor(const Vector3<T>& /* r */,
+                                                                              real /* t */) const
+{
+    return {T(0), T(0.5_r * G_), T(0), T(0), T(0), T(0)};
+}
+
 } // namespace msode
@@ -57,4 +57,14 @@ DeformationRateTensor VelocityFieldSum::getDeformationRateTensor(real3 r, real t
     return T;
 }
 
+real VelocityFieldSum::getVelocityBound() const
+{
+    real bound {0.0_r};
+
+    for (const auto& f : fields_)
+        bound += f->getVelocityBound();
+
+    return bound;
+}
+
 } // namespace msode
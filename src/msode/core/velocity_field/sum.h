@@ -20,6 +20,7 @@ public:
     real3 getVelocity(real3 r, real t) const override;
     real3 getVorticity(real3 r, real t) const override;
     DeformationRateTensor getDeformationRateTensor(real3 r, real t) const override;
+    real getVelocityBound() const override;
 
 private:
     std::vector<std::unique_ptr<BaseVelocityField>> fields_;
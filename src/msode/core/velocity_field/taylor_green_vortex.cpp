@@ -20,62 +20,26 @@ std::unique_ptr<BaseVelocityField> VelocityFieldTaylorGreenVortex::clone() const
     return std::make_unique<VelocityFieldTaylorGreenVortex>(*this);
 }
 
-real3 VelocityFieldTaylorGreenVortex::getVelocity(real3 r, real /* t */) const
+real3 VelocityFieldTaylorGreenVortex::getVelocity(real3 r, real t) const
 {
-    const real cx = std::cos(invPeriod_.x * r.x);
-    const real sx = std::sin(invPeriod_.x * r.x);
-
-    const real cy = std::cos(invPeriod_.y * r.y);
-    const real sy = std::sin(invPeriod_.y * r.y);
-
-    const real cz = std::cos(invPeriod_.z * r.z);
-    const real sz = std::sin(invPeriod_.z * r.z);
-
-    return {magnitude_.x * cx * sy * sz,
-            magnitude_.y * sx * cy * sz,
-            magnitude_.z * sx * sy * cz};
+    return getVelocity<real>(r, t);
 }
 
-real3 VelocityFieldTaylorGreenVortex::getVorticity(real3 r, real /* t */) const
+real3 VelocityFieldTaylorGreenVortex::getVorticity(real3 r, real t) const
 {
-    const real cx = std::cos(invPeriod_.x * r.x);
-    const real sx = std::sin(invPeriod_.x * r.x);
-
-    const real cy = std::cos(invPeriod_.y * r.y);
-    const real sy = std::sin(invPeriod_.y * r.y);
-
-    const real cz = std::cos(invPeriod_.z * r.z);
-    const real sz = std::sin(invPeriod_.z * r.z);
-
-    const real3 w = cross(invPeriod_, magnitude_);
-
-    return {sx * cy * cz * w.x,
-            cx * sy * cz * w.y,
-            cx * cy * sz * w.z};
+    return getVorticity<real>(r, t);
 }
 
-DeformationRateTensor VelocityFieldTaylorGreenVortex::getDeformationRateTensor(real3 r, real /* t */) const
+DeformationRateTensor VelocityFieldTaylorGreenVortex::getDeformationRateTensor(real3 r, real t) const
 {
-    const real cx = std::cos(invPeriod_.x * r.x);
-    const real sx = std::sin(invPeriod_.x * r.x);
-
-    const real cy = std::cos(invPeriod_.y * r.y);
-    const real sy = std::sin(invPeriod_.y * r.y);
-
-    const real cz = std::cos(invPeriod_.z * r.z);
-    const real sz = std::sin(invPeriod_.z * r.z);
-
-    DeformationRateTensor T;
-
-    T.xx = -magnitude_.x * invPeriod_.x * sx * sy * sz;
-    T.yy = -magnitude_.y * invPeriod_.y * sx * sy * sz;
-    T.zz = -magnitude_.z * invPeriod_.z * sx * sy * sz;
-
-    T.xy = 0.5_r * (magnitude_.x * invPeriod_.y + magnitude_.y * invPeriod_.x) * cx * cy * sz;
-    T.xz = 0.5_r * (magnitude_.x * invPeriod_.z + magnitude_.z * invPeriod_.x) * cx * sy * cz;
-    T.yz = 0.5_r * (magnitude_.y * invPeriod_.z + magnitude_.z * invPeriod_.y) * sx * cy * cz;
+    return getDeformationRateTensor<real>(r, t);
+}
 
-    return T;
+real VelocityFieldTaylorGreenVortex::getVelocityBound() const
+{
+    // each component is bounded by the magnitude along that direction
+    const real3 m {std::abs(magnitude_.x), std::abs(magnitude_.y), std::abs(magnitude_.z)};
+    return length(m);
 }
 
 } // namespace msode
@@ -3,11 +3,15 @@
 
 #include "interface.h"
 
+#include <msode/core/math.h>
+
+#include <cmath>
+
 namespace msode
 {
 
 /// Steady Taylor-green vortex flow, see initial conditions in https://en.wikipedia.org/wiki/Taylor%E2%80%93Green_vortex
-class VelocityFieldTaylorGreenVortex : public BaseVelocityField
+class VelocityFieldTaylorGreenVortex final : public BaseVelocityField
 {
 public:
     /** Construct a VelocityFieldTaylorGreenVortex.
@@ -24,10 +28,79 @@ public:
     real3 getVelocity(real3 r, real t) const override;
     real3 getVorticity(real3 r, real t) const override;
     DeformationRateTensor getDeformationRateTensor(real3 r, real t) const override;
+    real getVelocityBound() const override;
+
+    /// generic versions of the above, e.g. to propagate derivatives with Dual numbers
+    template <class T> Vector3<T> getVelocity(const Vector3<T>& r, real t) const;
+    template <class T> Vector3<T> getVorticity(const Vector3<T>& r, real t) const;
+    template <class T> DeformationRateTensorT<T> getDeformationRateTensor(const Vector3<T>& r, real t) const;
+
+private:
+    /// the sines and cosines of the phases along each direction at position r
+    template <class T>
+    struct Trigonometry
+    {
+        Trigonometry(const Vector3<T>& r, const real3& invPeriod)
+        {
+            using std::cos;
+            using std::sin;
+
+            cx = cos(invPeriod.x * r.x);
+            sx = sin(invPeriod.x * r.x);
+
+            cy = cos(invPeriod.y * r.y);
+            sy = sin(invPeriod.y * r.y);
+
+            cz = cos(invPeriod.z * r.z);
+            sz = sin(invPeriod.z * r.z);
+        }
+
+        T cx, sx, cy, sy, cz, sz;
+    };
 
 private:
     real3 magnitude_; ///< magnitudes along the 3 directions
     real3 invPeriod_; ///< inverse wave lengths along each dimension
 };
 
+template <class T>
+inline Vector3<T> VelocityFieldTaylorGreenVortex::getVelocity(const Vector3<T>& r, real /* t */) const
+{
+    const Trigonometry<T> tr(r, invPeriod_);
+
+    return {magnitude_.x * tr.cx * tr.sy * tr.sz,
+            magnitude_.y * tr.sx * tr.cy * tr.sz,
+            magnitude_.z * tr.sx * tr.sy * tr.cz};
+}
+
+template <class T>
+inline Vector3<T> VelocityFieldTaylorGreenVortex::getVorticity(const Vector3<T>& r, real /* t */) const
+{
+    const Trigonometry<T> tr(r, invPeriod_);
+    const real3 w = cross(invPeriod_, magnitude_);
+
+    return {tr.sx * tr.cy * tr.cz * w.x,
+            tr.cx * tr.sy * tr.cz * w.y,
+            tr.cx * tr.cy * tr.sz * w.z};
+}
+
+template <class T>
+inline DeformationRateTensorT<T> VelocityFieldTaylorGreenVortex::getDeformationRateTensor(const Vector3<T>& r,
+                                                                                          real /* t */) const
+{
+    const Trigonometry<T> tr(r, invPeriod_);
+
+    DeformationRateTensorT<T> D;
+
+    D.xx = -magnitude_.x * invPeriod_.x * tr.sx * tr.sy * tr.sz;
+    D.yy = -magnitude_.y * invPeriod_.y * tr.sx * tr.sy * tr.sz;
+    D.zz = -magnitude_.z * invPeriod_.z * tr.sx * tr.sy * tr.sz;
+
+    D.xy = 0.5_r * (magnitude_.x * invPeriod_.y + magnitude_.y * invPeriod_.x) * tr.cx * tr.cy * tr.sz;
+    D.xz = 0.5_r * (magnitude_.x * invPeriod_.z + magnitude_.z * invPeriod_.x) * tr.cx * tr.sy * tr.cz;
+    D.yz = 0.5_r * (magnitude_.y * invPeriod_.z + magnitude_.z * invPeriod_.y) * tr.sx * tr.cy * tr.cz;
+
+    return D;
+}
+
 } // namespace msode
@@ -0,0 +1,237 @@
+// Copyright 2020 ETH Zurich. All Rights Reserved.
+#include "controller.h"
+
+#include <msode/core/log.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <limits>
+#include <numeric>
+
+namespace msode {
+namespace mpc {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr real infinity = std::numeric_limits<real>::infinity();
+
+Controller::Controller(const rl::EpisodeRunner::EnvironmentFactory& createEnvironment, Params params, int numThreads) :
+    params_(params),
+    pool_(numThreads)
+{
+    MSODE_Expect(params_.horizon > 0, "expect a positive horizon, got %d", params_.horizon);
+    MSODE_Expect(params_.numCandidates > 0, "expect a positive number of candidates, got %d", params_.numCandidates);
+    MSODE_Expect(params_.numIterations > 0, "expect a positive number of iterations, got %d", params_.numIterations);
+    MSODE_Expect(params_.numElites > 0 && params_.numElites <= params_.numCandidates,
+                 "expect a number of elites in [1, %d], got %d", params_.numCandidates, params_.numElites);
+
+    for (int i = 0; i < pool_.getNumThreads(); ++i)
+    {
+        envs_.push_back(createEnvironment());
+        MSODE_Ensure(envs_.back() != nullptr, "the environment factory returned a null environment");
+        actions_.emplace_back(envs_.back()->numActions());
+    }
+
+    numActions_ = envs_[0]->numActions();
+    sequenceSize_ = params_.horizon * numActions_;
+    std::tie(lo_, hi_) = envs_[0]->getActionBounds();
+
+    mean_      .resize(sequenceSize_);
+    std_       .resize(sequenceSize_);
+    best_      .resize(sequenceSize_);
+    candidates_.resize(params_.numCandidates * sequenceSize_);
+    costs_     .resize(params_.numCandidates);
+    order_     .resize(params_.numCandidates);
+
+    reset(0);
+}
+
+int Controller::getNumThreads() const
+{
+    return pool_.getNumThreads();
+}
+
+void Controller::reset(long episodeId)
+{
+    std::seed_seq seq {params_.seed, episodeId};
+    gen_.seed(seq);
+    hasPlan_ = false;
+}
+
+const DecisionInfo& Controller::getLastDecisionInfo() const
+{
+    return info_;
+}
+
+void Controller::computeAction(const rl::MSodeEnvironment& env, std::vector<double>& action)
+{
+    MSODE_Expect(static_cast<int>(action.size()) == numActions_,
+                 "expect an action of size %d, got %zu", numActions_, action.size());
+
+    const auto start = Clock::now();
+    const bool hasBudget = params_.timeBudget > 0.0;
+    deadline_ = start + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(params_.timeBudget));
+
+    env.snapshot(state_);
+    noiseSeed_ = gen_();
+    info_ = DecisionInfo{};
+
+    _initializePlan();
+
+    for (int iteration = 0; iteration < params_.numIterations; ++iteration)
+    {
+        if (iteration > 0 && hasBudget && Clock::now() > deadline_)
+            break;
+
+        ++info_.numIterations;
+        _sampleCandidates();
+        _evaluateCandidates(iteration == 0);
+        _updateDistribution();
+    }
+
+    std::copy(best_.begin(), best_.begin() + numActions_, action.begin());
+    hasPlan_ = true;
+
+    info_.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    info_.bestCost = bestCost_;
+}
+
+void Controller::_initializePlan()
+{
+    // warm start: the plan of the previous decision, shifted by one action; the last action is repeated
+    if (hasPlan_)
+    {
+        std::copy(best_.begin() + numActions_, best_.end(), mean_.begin());
+        std::copy(best_.end() - numActions_, best_.end(), mean_.end() - numActions_);
+    }
+    else
+    {
+        for (int j = 0; j < sequenceSize_; ++j)
+        {
+            const int a = j % numActions_;
+            mean_[j] = 0.5 * (lo_[a] + hi_[a]);
+        }
+    }
+
+    for (int j = 0; j < sequenceSize_; ++j)
+    {
+        const int a = j % numActions_;
+        std_[j] = params_.initialStd * (hi_[a] - lo_[a]);
+    }
+
+    best_ = mean_;
+    bestCost_ = infinity;
+}
+
+void Controller::_sampleCandidates()
+{
+    std::normal_distribution<double> normal(0.0, 1.0);
+
+    // the first candidate is the mean of the distribution; in the first iteration, the warm start
+    std::copy(mean_.begin(), mean_.end(), candidates_.begin());
+
+    for (int c = 1; c < params_.numCandidates; ++c)
+    {
+        double *sequence = candidates_.data() + c * sequenceSize_;
+
+        for (int j = 0; j < sequenceSize_; ++j)
+        {
+            const int a = j % numActions_;
+            const double x = mean_[j] + std_[j] * normal(gen_);
+            sequence[j] = std::min(hi_[a], std::max(lo_[a], x));
+        }
+    }
+}
+
+void Controller::_evaluateCandidates(bool evaluateFirst)
+{
+    const bool hasBudget = params_.timeBudget > 0.0;
+    std::atomic<long> numRollouts {0};
+
+    pool_.run(params_.numCandidates, [&](long c, int workerId)
+    {
+        // anytime cutoff: skip the rollouts that start after the budget is exhausted
+        if (hasBudget && !(evaluateFirst && c == 0) && Clock::now() > deadline_)
+        {
+            costs_[c] = infinity;
+            return;
+        }
+
+        costs_[c] = _rollout(*envs_[workerId], candidates_.data() + c * sequenceSize_, actions_[workerId]);
+        ++numRollouts;
+    });
+
+    info_.numRollouts += numRollouts;
+}
+
+void Controller::_updateDistribution()
+{
+    std::iota(order_.begin(), order_.end(), 0);
+    std::stable_sort(order_.begin(), order_.end(), [this](int a, int b) {return costs_[a] < costs_[b];});
+
+    const int bestId = order_[0];
+
+    if (costs_[bestId] < bestCost_)
+    {
+        bestCost_ = costs_[bestId];
+        std::copy(candidates_.begin() + bestId * sequenceSize_,
+                  candidates_.begin() + (bestId + 1) * sequenceSize_,
+                  best_.begin());
+    }
+
+    int numElites {0};
+    while (numElites < params_.numElites && costs_[order_[numElites]] < infinity)
+        ++numElites;
+
+    if (numElites == 0)
+        return;
+
+    for (int j = 0; j < sequenceSize_; ++j)
+    {
+        double sum {0.0}, sumSq {0.0};
+
+        for (int e = 0; e < numElites; ++e)
+        {
+            const double x = candidates_[order_[e] * sequenceSize_ + j];
+            sum   += x;
+            sumSq += x * x;
+        }
+
+        const int a = j % numActions_;
+        const double mean = sum / numElites;
+        const double var = std::max(0.0, sumSq / numElites - mean * mean);
+
+        mean_[j] = mean;
+        std_[j]  = std::max(std::sqrt(var), static_cast<double>(params_.minStd * (hi_[a] - lo_[a])));
+    }
+}
+
+real Controller::_rollout(rl::MSodeEnvironment& env, const double *sequence, std::vector<double>& action) const
+{
+    using Status = rl::MSodeEnvironment::Status;
+
+    env.restore(state_);
+
+    // the rollouts must not know the future noise of the controlled environment;
+    // all candidates see the same noise, so that they are compared fairly
+    env.sim->setNoiseSeed(noiseSeed_);
+
+    real totalReward {0.0_r};
+
+    for (int k = 0; k < params_.horizon; ++k)
+    {
+        std::copy(sequence + k * numActions_, sequence + (k + 1) * numActions_, action.begin());
+
+        const Status status = env.advance(action);
+        totalReward += static_cast<real>(env.getReward());
+
+        if (status != Status::Running)
+            break;
+    }
+
+    return -totalReward;
+}
+
+} // namespace mpc
+} // namespace msode
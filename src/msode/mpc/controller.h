@@ -0,0 +1,112 @@
+// Copyright 2020 ETH Zurich. All Rights Reserved.
+#pragma once
+
+#include <msode/rl/environment.h>
+#include <msode/rl/episode_runner.h>
+#include <msode/utils/thread_pool.h>
+
+#include <chrono>
+#include <memory>
+#include <random>
+#include <vector>
+
+namespace msode {
+namespace mpc {
+
+/// Parameters of the receding horizon controller
+struct Params
+{
+    int horizon {4};          ///< number of actions of each candidate sequence
+    int numCandidates {32};   ///< number of candidate sequences evaluated per iteration
+    int numIterations {3};    ///< number of refinements of the sampling distribution per decision
+    int numElites {4};        ///< number of best candidates used to refine the sampling distribution
+    real initialStd {0.3_r};  ///< standard deviation of the samples at the first iteration, relative to the action range
+    real minStd {0.02_r};     ///< lower bound of the standard deviation of the samples, relative to the action range
+    double timeBudget {0.0};  ///< maximum wall-clock time per decision, in seconds; non positive values mean no limit
+    long seed {424242};       ///< seed of the sampling and of the thermal noise used in the rollouts
+};
+
+/// Summary of the last decision of the controller
+struct DecisionInfo
+{
+    long numRollouts {0};   ///< number of candidate sequences evaluated
+    int numIterations {0};  ///< number of iterations started before the time budget was exhausted
+    double seconds {0.0};   ///< wall-clock time spent in the decision
+    real bestCost {0.0_r};  ///< cost of the chosen sequence: minus the sum of the rewards over the horizon
+};
+
+/** A receding horizon (model predictive) controller for MSodeEnvironment.
+
+    At every decision, candidate sequences of horizon actions are evaluated by simulating them from the current state
+    of the environment (see MSodeEnvironment::snapshot()) on copies of the environment, one per worker thread.
+    The cost of a sequence is minus the sum of the rewards of the environment over the horizon; the rollouts therefore
+    account for the background flow and the thermal noise, unlike the analytic control.
+    The candidates are sampled from a gaussian distribution refined at every iteration from the best candidates
+    (cross entropy method). The distribution is centered at first on the best sequence of the previous decision,
+    shifted by one action. The first action of the best sequence found is applied.
+
+    The candidates of one iteration are evaluated in parallel as one batch. When a time budget is set, the iterations
+    stop once the budget is exhausted and the remaining rollouts are skipped; the sequence of the previous decision is
+    always evaluated, so that a valid action is always available.
+    Without time budget, the decisions are deterministic and independent of the number of threads.
+ */
+class Controller
+{
+public:
+    /** \brief Construct a Controller
+        \param createEnvironment Creates the environments used for the rollouts; must be equivalent to the controlled one.
+        \param params The parameters of the controller
+        \param numThreads The number of worker threads. Non positive values select the number of hardware threads.
+     */
+    Controller(const rl::EpisodeRunner::EnvironmentFactory& createEnvironment, Params params, int numThreads);
+
+    int getNumThreads() const;
+
+    /** \brief Prepare a new episode: forget the previous plan and reseed the random generators.
+        \param episodeId The id of the episode, used to seed the random generators
+     */
+    void reset(long episodeId);
+
+    /** \brief Compute the next action from the current state of \p env.
+        \param env The controlled environment
+        \param action Receives the action; has the size env.numActions().
+     */
+    void computeAction(const rl::MSodeEnvironment& env, std::vector<double>& action);
+
+    const DecisionInfo& getLastDecisionInfo() const;
+
+private:
+    void _initializePlan();
+    void _sampleCandidates();
+    void _evaluateCandidates(bool evaluateFirst);
+    void _updateDistribution();
+    real _rollout(rl::MSodeEnvironment& env, const double *sequence, std::vector<double>& action) const;
+
+private:
+    const Params params_;
+    utils::ThreadPool pool_;
+    std::vector<std::unique_ptr<rl::MSodeEnvironment>> envs_; ///< rollout environments, one per worker
+    std::vector<std::vector<double>> actions_;                ///< action buffers, one per worker
+
+    int numActions_;
+    int sequenceSize_;                     ///< horizon x numActions
+    std::vector<double> lo_, hi_;          ///< action bounds
+
+    rl::MSodeEnvironment::State state_;    ///< state of the controlled environment at the current decision
+    unsigned long noiseSeed_ {0};          ///< seed of the thermal noise in the rollouts of the current decision
+    std::mt19937 gen_;
+
+    std::vector<double> mean_, std_;       ///< sampling distribution of the sequences
+    std::vector<double> candidates_;       ///< numCandidates sequences
+    std::vector<real> costs_;              ///< cost of each candidate; infinite if skipped
+    std::vector<int> order_;               ///< candidates sorted by cost
+    std::vector<double> best_;             ///< best sequence found so far
+    real bestCost_;
+    bool hasPlan_ {false};                 ///< true if best_ holds the plan of the previous decision
+
+    std::chrono::steady_clock::time_point deadline_; ///< end of the time budget of the current decision
+    DecisionInfo info_;
+};
+
+} // namespace mpc
+} // namespace msode
@@ -1,18 +1,24 @@
 // Copyright 2020 ETH Zurich. All Rights Reserved.
 #include "environment.h"
 
+#include <msode/analytic_control/helpers.h>
+#include <msode/analytic_control/optimal_path.h>
+
 #include <iomanip>
+#include <limits>
 #include <sstream>
 
 namespace msode {
 namespace rl {
 
-Params::Params(TimeParams time_, RewardParams reward_, real fieldMagnitude_, real distanceThreshold_, real kBT_) :
+Params::Params(TimeParams time_, RewardParams reward_, real fieldMagnitude_, real distanceThreshold_, real kBT_,
+               TerminationParams termination_) :
     time(time_),
     reward(reward_),
     fieldMagnitude(fieldMagnitude_),
     distanceThreshold(distanceThreshold_),
-    kBT(kBT_)
+    kBT(kBT_),
+    termination(termination_)
 {}
 
 
@@ -31,6 +37,7 @@ MSodeEnvironment::MSodeEnvironment(const Params& params,
     posIc_(std::move(posIc)),
     targetDistance_(std::move(targetDistance)),
     rewardParams_(params.reward),
+    terminationParams_(params.termination),
     targetPositions_(initialRBs.size(), posIc_->target),
     dumpEvery_(params.time.dumpEvery)
 {
@@ -55,6 +62,28 @@ MSodeEnvironment::MSodeEnvironment(const Params& params,
 
     sim = std::make_unique<Simulation>(std::move(initialRBs), std::move(field),
                                        params.kBT, std::move(velocityField));
+    _computeMaxBodyVelocities();
+
+    if (terminationParams_.cutHopeless && terminationParams_.travelTimeBound)
+    {
+        const auto& bodies = sim->getBodies();
+        const size_t n = bodies.size();
+        const analytic_control::MatrixReal U = analytic_control::createVelocityMatrix(fieldMagnitude, bodies).inverse();
+
+        U_.resize(n * n);
+        modeTolerances_.resize(n);
+        A_.resize(n);
+
+        for (size_t i = 0; i < n; ++i)
+        {
+            // moving all bodies by at most distanceThreshold_ changes a_i by at most distanceThreshold_ * sum_j |U_ij|
+            modeTolerances_[i] = distanceThreshold_ * U.row(i).cwiseAbs().sum();
+
+            for (size_t j = 0; j < n; ++j)
+                U_[i * n + j] = U(i, j);
+        }
+    }
+
     _setDistances();
 }
 
@@ -70,48 +99,121 @@ ActionBounds MSodeEnvironment::getActionBounds() const
 
 void MSodeEnvironment::reset(std::mt19937& gen, long simId, bool successfulPreviousTry)
 {
-    MagneticField          field  = sim->getField();
-    std::vector<RigidBody> bodies = sim->getBodies();
-
-    field.phase = 0.0_r;
+    auto& bodies = sim->getBodies();
 
     posIc_->update(successfulPreviousTry);
-    const auto positions = posIc_->generateNewPositions(gen, bodies.size());
+    positionsBuffer_.resize(bodies.size());
+    posIc_->fillNewPositions(gen, positionsBuffer_);
 
     for (size_t i = 0; i < bodies.size(); ++i)
     {
-        bodies[i].r = positions[i];
+        bodies[i].r = positionsBuffer_[i];
         bodies[i].q = utils::generateUniformQuaternion(gen);
     }
 
-    sim->reset(std::move(bodies), std::move(field));
+    _startEpisode(simId);
+}
 
-    if (dumpEvery_ > 0)
+void MSodeEnvironment::reset(const std::vector<RigidBodyState>& initialBodies, long simId)
+{
+    auto& bodies = sim->getBodies();
+
+    MSODE_Expect(initialBodies.size() == bodies.size(),
+                 "expected %zu bodies, got %zu", bodies.size(), initialBodies.size());
+
+    for (size_t i = 0; i < bodies.size(); ++i)
     {
-        std::ostringstream ss;
-        ss << std::setw(6) << std::setfill('0') << simId;
-        const std::string outputFileName = "trajectories_" + ss.str() + ".dat";
-        sim->activateDump(outputFileName, dumpEvery_);
+        bodies[i].q     = initialBodies[i].q;
+        bodies[i].r     = initialBodies[i].r;
+        bodies[i].v     = initialBodies[i].v;
+        bodies[i].omega = initialBodies[i].omega;
     }
+
+    _startEpisode(simId);
+}
+
+void MSodeEnvironment::_startEpisode(long simId)
+{
+    // an episode interrupted by a reset is not passed to the predicate, but its requested dump is still written;
+    // this must happen before the reset of the simulation, which clears the buffer
+    if (dumpRequested_ && deferredDumpPredicate_ && simId_ != NO_DUMP)
+        sim->flushBufferedDump(_trajectoryFileName());
+
+    sim->reset();
+    magnFieldState->reset();
+    _invalidateCache();
+    hasSuccessTime_ = false;
+
+    simId_ = simId;
+    dumpRequested_ = false;
+
+    // the deferred dump buffer is cleared by the reset of the simulation
+    if (dumpEvery_ > 0 && !deferredDumpPredicate_)
+    {
+        if (simId_ == NO_DUMP)
+            sim->deactivateDump();
+        else
+            sim->activateDump(_trajectoryFileName(), dumpEvery_);
+    }
+
     _setDistances();
 }
 
+void MSodeEnvironment::_endEpisode(Status status)
+{
+    if (deferredDumpPredicate_ && simId_ != NO_DUMP &&
+        (dumpRequested_ || deferredDumpPredicate_(*this, status)))
+        sim->flushBufferedDump(_trajectoryFileName());
+
+    dumpRequested_ = false;
+}
+
+std::string MSodeEnvironment::_trajectoryFileName() const
+{
+    std::ostringstream ss;
+    ss << std::setw(6) << std::setfill('0') << simId_;
+    return "trajectories_" + ss.str() + ".dat";
+}
+
+void MSodeEnvironment::setDeferredDump(long capacity, bool singlePrecision, DumpPredicate predicate)
+{
+    MSODE_Expect(dumpEvery_ > 0, "the deferred dump needs a positive dumpEvery");
+    MSODE_Expect(static_cast<bool>(predicate), "expect a predicate");
+
+    deferredDumpPredicate_ = std::move(predicate);
+    sim->activateBufferedDump(dumpEvery_, capacity, singlePrecision);
+}
+
+void MSodeEnvironment::requestDump()
+{
+    dumpRequested_ = true;
+}
+
 void MSodeEnvironment::setPositions(const std::vector<real3>& positions)
 {
     auto& bodies = sim->getBodies();
 
     for (size_t i = 0; i < bodies.size(); ++i)
         bodies[i].r = positions[i];
+
+    _invalidateCache();
+    hasSuccessTime_ = false;
 }
 
 std::vector<real3> MSodeEnvironment::getPositions() const
 {
     std::vector<real3> positions;
+    getPositions(positions);
+    return positions;
+}
+
+void MSodeEnvironment::getPositions(std::vector<real3>& positions) const
+{
     const auto& bodies = sim->getBodies();
+    positions.resize(bodies.size());
 
-    for (const auto& b : bodies)
-        positions.push_back(b.r);
-    return positions;
+    for (size_t i = 0; i < bodies.size(); ++i)
+        positions[i] = bodies[i].r;
 }
 
 MSodeEnvironment::Status MSodeEnvironment::advance(const std::vector<double>& action)
@@ -119,22 +221,114 @@ MSodeEnvironment::Status MSodeEnvironment::advance(const std::vector<double>& ac
     magnFieldState->advance(sim->getCurrentTime());
     magnFieldState->setAction(action);
 
-    for (long step = 0; step < nstepsPerAction_; ++step)
+    Status status {Status::Running};
+    long nextDistanceCheck = _computeNumStepsWithoutSuccess();
+    hasSuccessTime_ = false;
+
+    long step {0}; // number of steps performed during this action
+
+    while (step < nstepsPerAction_)
     {
-        sim->advanceForwardEuler(dt_);
+        // advance without intermediate checks up to the next step that needs one
+        const long numSteps = std::min(nstepsPerAction_ - step,
+                                       std::min(std::max(1L, nextDistanceCheck - step + 1),
+                                                1 + _computeNumStepsBeforeMaxTime()));
+        sim->runForwardEuler(numSteps, dt_);
+        step += numSteps;
+
+        const long lastStep = step - 1;
+
+        if (sim->getCurrentTime() > tmax_)
+        {
+            status = Status::MaxTimeEllapsed;
+            break;
+        }
+
+        if (lastStep < nextDistanceCheck)
+        {
+            terminationStats_.numDistanceChecksSkipped += numSteps;
+            continue;
+        }
+
+        terminationStats_.numDistanceChecksSkipped += numSteps - 1;
+
+        if (_bodiesWithinDistanceToTargets())
+        {
+            status = Status::Success;
+            break;
+        }
+
+        nextDistanceCheck = lastStep + 1 + _computeNumStepsWithoutSuccess();
+    }
 
-        auto status = _getCurrentStatus();
-        if (status != Status::Running)
-            return status;
+    if (status == Status::Running && terminationParams_.cutHopeless)
+    {
+        const real remainingTime = getRemainingTimeBeforeCutting();
+
+        if (terminationParams_.cutoffFactor * _computeTimeToTargetsLowerBound() > remainingTime)
+        {
+            status = Status::MaxTimeEllapsed;
+            ++terminationStats_.numEpisodesCut;
+            terminationStats_.numStepsSaved += static_cast<long>(std::ceil(remainingTime / dt_));
+        }
     }
 
-    return Status::Running;
+    _invalidateCache();
+    cachedStatus_ = status;
+    statusStep_ = step_;
+
+    if (status == Status::Success && terminationParams_.exactCrossing)
+    {
+        successTime_ = _computeSuccessTime();
+        hasSuccessTime_ = true;
+    }
+
+    if (status != Status::Running)
+        _endEpisode(status);
+
+    return status;
+}
+
+const std::tuple<real3, real3, real3>& MSodeEnvironment::getFrameReference() const
+{
+    if (frameStep_ != step_)
+    {
+        cachedFrame_ = magnFieldState->getFrameReference();
+        frameStep_ = step_;
+    }
+    return cachedFrame_;
+}
+
+void MSodeEnvironment::snapshot(State& state) const
+{
+    sim->snapshot(state.sim);
+    magnFieldState->saveState(state.fieldFromAction);
+    state.status           = _getCurrentStatus();
+    state.previousDistance = previousDistance_;
+    state.hasSuccessTime   = hasSuccessTime_;
+    state.successTime      = successTime_;
+}
+
+void MSodeEnvironment::restore(const State& state)
+{
+    sim->restore(state.sim);
+    magnFieldState->loadState(state.fieldFromAction);
+    previousDistance_ = state.previousDistance;
+    hasSuccessTime_   = state.hasSuccessTime;
+    successTime_      = state.successTime;
+
+    _invalidateCache();
+    cachedStatus_ = state.status;
+    statusStep_ = step_;
 }
 
 const std::vector<double>& MSodeEnvironment::getState() const
 {
+    if (stateStep_ == step_)
+        return cachedState_;
+
     real3 n1, n2, n3;
-    std::tie(n1, n2, n3) = magnFieldState->getFrameReference();
+    std::tie(n1, n2, n3) = getFrameReference();
 
     const RotMatrix rot = [n1,n2,n3]()
     {
@@ -146,24 +340,26 @@ const std::vector<double>& MSodeEnvironment::getState() const
 
     const auto qRot = Quaternion::createFromMatrix(rot);
 
-    cachedState_.resize(0);
-
     const auto& bodies = sim->getBodies();
+    constexpr size_t nVarsPerBody = 7;
+    cachedState_.resize(nVarsPerBody * bodies.size());
 
     for (size_t i = 0; i < bodies.size(); ++i)
     {
         const real3 dr = bodies[i].r - targetPositions_[i];
-        cachedState_.push_back(dot(dr, n1));
-        cachedState_.push_back(dot(dr, n2));
-        cachedState_.push_back(dot(dr, n3));
-
         const auto q = bodies[i].q * qRot;
-        cachedState_.push_back(q.w);
-        cachedState_.push_back(q.x);
-        cachedState_.push_back(q.y);
-        cachedState_.push_back(q.z);
+        double *s = &cachedState_[nVarsPerBody * i];
+
+        s[0] = dot(dr, n1);
+        s[1] = dot(dr, n2);
+        s[2] = dot(dr, n3);
+        s[3] = q.w;
+        s[4] = q.x;
+        s[5] = q.y;
+        s[6] = q.z;
     }
 
+    stateStep_ = step_;
     return cachedState_;
 }
 
@@ -171,8 +367,7 @@ double MSodeEnvironment::getReward() const
 {
     real r {0.0_r};
     const auto status = _getCurrentStatus();
-    const auto& bodies = sim->getBodies();
-    const auto currentDistance = targetDistance_->compute(bodies);
+    const auto currentDistance = _getCurrentDistance();
 
     r += rewardParams_.distCoeff * (previousDistance_ - currentDistance);
     r -= rewardParams_.timeCoeff * dt_ * nstepsPerAction_;
@@ -202,6 +397,8 @@ const EnvPosIC* MSodeEnvironment::getEnvPosIC() const
 
 real MSodeEnvironment::getSimulationTime() const
 {
+    if (hasSuccessTime_)
+        return successTime_;
     return sim->getCurrentTime();
 }
 
@@ -210,10 +407,152 @@ real MSodeEnvironment::getRemainingTimeBeforeCutting() const
     return tmax_ - getSimulationTime();
 }
 
-void MSodeEnvironment::_setDistances()
+const TerminationStatistics& MSodeEnvironment::getTerminationStatistics() const
+{
+    return terminationStats_;
+}
+
+void MSodeEnvironment::_invalidateCache()
 {
+    ++step_;
+}
+
+void MSodeEnvironment::_computeMaxBodyVelocities()
+{
+    // the propulsion matrix relates the torque to the velocity: |v| <= max_i |B_i| |T|, with |T| <= |m| |B|
+    const real flowVelocity = sim->getVelocityField()->getVelocityBound();
+    const auto& bodies = sim->getBodies();
+
+    maxBodyVelocities_.resize(bodies.size());
+
+    for (size_t i = 0; i < bodies.size(); ++i)
+    {
+        const auto& B = bodies[i].propulsion.B;
+        const real maxB = std::max(std::abs(B[0]), std::max(std::abs(B[1]), std::abs(B[2])));
+        maxBodyVelocities_[i] = maxB * length(bodies[i].magnMoment) * fieldMagnitude + flowVelocity;
+    }
+}
+
+long MSodeEnvironment::_computeNumStepsWithoutSuccess() const
+{
+    // thermal noise is not bounded
+    if (!terminationParams_.skipDistanceChecks || sim->getKBT() > 0.0_r)
+        return 0;
+
+    // relative safety margin against round off errors
+    constexpr real safety = 1.0_r - 1e-6_r;
+
+    const auto& bodies = sim->getBodies();
+    real numSteps {0.0_r};
+
+    // the episode can not succeed as long as at least one body can not have reached its target
+    for (size_t i = 0; i < bodies.size(); ++i)
+    {
+        const real remainingDistance = length(bodies[i].r - targetPositions_[i]) - distanceThreshold_;
+
+        if (remainingDistance <= 0.0_r)
+            continue;
+
+        const real maxDisplacementPerStep = dt_ * maxBodyVelocities_[i];
+
+        if (maxDisplacementPerStep <= 0.0_r)
+            return nstepsPerAction_;
+
+        // after k steps, the body moved at most k * maxDisplacementPerStep
+        const real k = std::ceil(safety * remainingDistance / maxDisplacementPerStep) - 1.0_r;
+        numSteps = std::max(numSteps, k);
+    }
+
+    return static_cast<long>(std::min(numSteps, static_cast<real>(nstepsPerAction_)));
+}
+
+real MSodeEnvironment::_computeTimeToTargetsLowerBound() const
+{
+    // thermal noise is not bounded
+    if (sim->getKBT() > 0.0_r)
+        return 0.0_r;
+
+    const auto& bodies = sim->getBodies();
+    real bound {0.0_r};
+
+    for (size_t i = 0; i < bodies.size(); ++i)
+    {
+        const real remainingDistance = length(bodies[i].r - targetPositions_[i]) - distanceThreshold_;
+
+        if (remainingDistance <= 0.0_r)
+            continue;
+
+        if (maxBodyVelocities_[i] <= 0.0_r)
+            return std::numeric_limits<real>::infinity();
+
+        bound = std::max(bound, remainingDistance / maxBodyVelocities_[i]);
+    }
+
+    if (terminationParams_.travelTimeBound && sim->getVelocityField()->getVelocityBound() == 0.0_r)
+    {
+        // A = U * (positions relative to the targets), see analytic_control::computeA()
+        const size_t n = bodies.size();
+        for (size_t i = 0; i < n; ++i)
+        {
+            A_[i] = real3 {0.0_r, 0.0_r, 0.0_r};
+            for (size_t j = 0; j < n; ++j)
+                A_[i] += U_[i * n + j] * (bodies[j].r - targetPositions_[j]);
+        }
+
+        bound = std::max(bound, analytic_control::computeTravelTimeLowerBound(A_, modeTolerances_));
+    }
+
+    return bound;
+}
+
+long MSodeEnvironment::_computeNumStepsBeforeMaxTime() const
+{
+    const real remainingTime = tmax_ - sim->getCurrentTime();
+
+    if (remainingTime <= 0.0_r)
+        return 0;
+
+    // keep one step and a relative margin against the round off errors of the time accumulation
+    constexpr real safety = 1.0_r - 1e-6_r;
+    const real numSteps = std::floor(safety * remainingTime / dt_) - 1.0_r;
+
+    return static_cast<long>(std::max(0.0_r, std::min(numSteps, static_cast<real>(nstepsPerAction_))));
+}
+
+real MSodeEnvironment::_computeSuccessTime() const
+{
+    // the bodies moved along straight lines with velocity v during the last forward Euler step.
+    // find the first time at which every body is within the threshold distance of its target
+    const real tEnd = sim->getCurrentTime();
+    const real thresholdSq = distanceThreshold_ * distanceThreshold_;
     const auto& bodies = sim->getBodies();
-    previousDistance_ = targetDistance_->compute(bodies);
+
+    real s {0.0_r}; // time elapsed since the start of the step
+
+    for (size_t i = 0; i < bodies.size(); ++i)
+    {
+        const real3 v = bodies[i].v;
+        const real3 dr0 = bodies[i].r - dt_ * v - targetPositions_[i];
+
+        // solve |dr0 + s v|^2 = threshold^2
+        const real a = dot(v, v);
+        const real b = 2.0_r * dot(dr0, v);
+        const real c = dot(dr0, dr0) - thresholdSq;
+
+        if (c <= 0.0_r || a <= 0.0_r)
+            continue;
+
+        const real discriminant = std::max(0.0_r, b * b - 4.0_r * a * c);
+        const real si = (-b - std::sqrt(discriminant)) / (2.0_r * a);
+        s = std::max(s, std::min(si, dt_));
+    }
+
+    return tEnd - dt_ + s;
+}
+
+void MSodeEnvironment::_setDistances()
+{
+    previousDistance_ = _getCurrentDistance();
 }
 
 bool MSodeEnvironment::_bodiesWithinDistanceToTargets() const
@@ -229,7 +568,7 @@ bool MSodeEnvironment::_bodiesWithinDistanceToTargets() const
     return maxDistance < distanceThreshold_;
 }
 
-MSodeEnvironment::Status MSodeEnvironment::_getCurrentStatus() const
+MSodeEnvironment::Status MSodeEnvironment::_computeCurrentStatus() const
 {
     if (sim->getCurrentTime() > tmax_)
         return Status::MaxTimeEllapsed;
@@ -240,5 +579,25 @@ MSodeEnvironment::Status MSodeEnvironment::_getCurrentStatus() const
     return Status::Running;
 }
 
+MSodeEnvironment::Status MSodeEnvironment::_getCurrentStatus() const
+{
+    if (statusStep_ != step_)
+    {
+        cachedStatus_ = _computeCurrentStatus();
+        statusStep_ = step_;
+    }
+    return cachedStatus_;
+}
+
+real MSodeEnvironment::_getCurrentDistance() const
+{
+    if (distanceStep_ != step_)
+    {
+        cachedDistance_ = targetDistance_->compute(sim->getBodies());
+        distanceStep_ = step_;
+    }
+    return cachedDistance_;
+}
+
 } // namespace rl
 } // namespace msode
@@ -8,6 +8,7 @@
 #include <msode/core/simulation.h>
 #include <msode/utils/rnd.h>
 
+#include <functional>
 #include <memory>
 #include <random>
 
@@ -29,15 +30,45 @@ struct RewardParams
     real terminationBonus;
 };
 
+/// Controls how the end of an episode is detected
+struct TerminationParams
+{
+    /// skip the distance checks as long as the bodies can not have reached their targets, given their maximum velocity
+    bool skipDistanceChecks {true};
+    /// report the time at which the bodies reached their targets during the last time step, instead of the end of that step
+    bool exactCrossing {false};
+
+    /// end the episode with MaxTimeEllapsed as soon as a lower bound of the time needed to reach the targets
+    /// exceeds the remaining time
+    bool cutHopeless {false};
+    /** also use the travel time of the analytic control model as a lower bound.
+        This bound is only valid if the field rotates at frequencies where the bodies do not swim faster
+        than at the step out frequencies of the model. It is ignored in the presence of a flow or thermal noise.
+     */
+    bool travelTimeBound {false};
+    /// the episode is cut if cutoffFactor * lowerBound > remaining time. Values below 1 add a safety margin.
+    real cutoffFactor {1.0_r};
+};
+
+/// Counters of the work saved by the termination checks, accumulated over all episodes
+struct TerminationStatistics
+{
+    long numDistanceChecksSkipped {0}; ///< number of time steps after which the distance to the targets was not evaluated
+    long numEpisodesCut {0};           ///< number of episodes ended early because the targets could not be reached in time
+    long numStepsSaved {0};            ///< number of time steps that were not performed because of these early ends
+};
+
 struct Params
 {
-    Params(TimeParams time_, RewardParams reward_, real fieldMagnitude_, real distanceThreshold_, real kBT_);
+    Params(TimeParams time_, RewardParams reward_, real fieldMagnitude_, real distanceThreshold_, real kBT_,
+           TerminationParams termination_ = TerminationParams{});
 
     const TimeParams time;
     const RewardParams reward;
     const real fieldMagnitude;
     const real distanceThreshold;
     const real kBT;
+    const TerminationParams termination;
 };
 
 class MSodeEnvironment
@@ -46,6 +77,19 @@ public:
     enum class Status {Running, MaxTimeEllapsed, Success};
     enum {NO_DUMP = -1};
 
+    /** The dynamic state of an environment during an episode, see snapshot() and restore().
+        The immutable parts (bodies properties, velocity field, targets) are shared with the environment it is restored to.
+     */
+    struct State
+    {
+        SimulationState sim;
+        FieldFromActionState fieldFromAction;
+        Status status {Status::Running};
+        real previousDistance {0.0_r};
+        bool hasSuccessTime {false};
+        real successTime {0.0_r};
+    };
+
     MSodeEnvironment(const Params& params,
                      std::unique_ptr<EnvPosIC> posIc,
                      std::vector<RigidBody> initialRBs,
@@ -63,31 +107,91 @@ public:
     ActionBounds getActionBounds() const;
 
     /**
-       \param simId simulation id, used to create the trajectory file name. Not relevant if dumpEvery_ is zero
+       \param simId simulation id, used to create the trajectory file name. Not relevant if dumpEvery_ is zero.
+              NO_DUMP: the trajectory of this episode is not written, neither directly nor by the deferred dump.
      */
     void reset(std::mt19937& gen, long simId, bool successfulPreviousTry);
+
+    /** \brief Start an episode from given initial bodies instead of drawing them, e.g. to replay a recorded episode.
+        \param initialBodies The initial state of each body
+        \param simId simulation id, used to create the trajectory file name, or NO_DUMP (see the other reset())
+     */
+    void reset(const std::vector<RigidBodyState>& initialBodies, long simId);
     void setPositions(const std::vector<real3>& positions);
     std::vector<real3> getPositions() const;
+    /// Same as getPositions() but writes into a caller-owned buffer
+    void getPositions(std::vector<real3>& positions) const;
 
     Status advance(const std::vector<double>& action);
 
+    /// Decides at the end of an episode if its trajectory is written, see setDeferredDump()
+    using DumpPredicate = std::function<bool(const MSodeEnvironment& env, Status status)>;
+
+    /** \brief Keep the trajectory of each episode in memory and write it only if the episode turns out to be interesting.
+        \param capacity The number of frames kept per episode; the first frames of longer episodes are dropped
+        \param singlePrecision Store the frames in float32
+        \param predicate Called at the end of every episode with its final status; if it returns true, the trajectory
+               is written to the file that the direct dump would have used.
+        Replaces the direct dump of every episode. The frames are recorded every dumpEvery steps (see TimeParams).
+        An episode ends when advance() returns a status other than Running. An episode interrupted by a reset is not
+        passed to the predicate; its trajectory is written at that reset only if requestDump() was called.
+     */
+    void setDeferredDump(long capacity, bool singlePrecision, DumpPredicate predicate);
+
+    /// write the trajectory of the current episode at its end (or at the next reset) even if the predicate does not fire, e.g. after a rare event
+    void requestDump();
+
+    /** \brief Save the dynamic state of the current episode.
+        \param state Receives the state. Does not allocate memory once it has been used with this environment.
+     */
+    void snapshot(State& state) const;
+
+    /** \brief Restore a state saved with snapshot().
+        \param state The state, saved by this environment or by an equivalent one (e.g. created from the same config).
+        Used to fork an episode into several branches, e.g. for planning. Does not allocate memory.
+        The initial conditions generator, the termination statistics and the trajectory dump are not affected.
+     */
+    void restore(const State& state);
+
     const std::vector<double>& getState() const;
     double getReward() const;
 
+    /** \return The frame of reference of the current state, as given by the FieldFromAction object.
+        Computed at most once per action step.
+     */
+    const std::tuple<real3, real3, real3>& getFrameReference() const;
+
     const std::vector<RigidBody>& getBodies() const;
     const std::vector<real3>& getTargetPositions() const;
     const EnvPosIC* getEnvPosIC() const;
 
+    /** \return The current simulation time.
+        If the exact crossing option is enabled and the episode ended successfully, this is the time at which the
+        bodies reached their targets.
+     */
     real getSimulationTime() const;
 
     /** \return The time remaining before cutting the episode. */
     real getRemainingTimeBeforeCutting() const;
 
+    const TerminationStatistics& getTerminationStatistics() const;
+
 
 private:
+    void _startEpisode(long simId);
+    void _endEpisode(Status status);
+    std::string _trajectoryFileName() const;
+    void _invalidateCache();
+    void _computeMaxBodyVelocities();
+    long _computeNumStepsWithoutSuccess() const;
+    long _computeNumStepsBeforeMaxTime() const;
+    real _computeSuccessTime() const;
+    real _computeTimeToTargetsLowerBound() const;
     void _setDistances();
     bool _bodiesWithinDistanceToTargets() const;
+    Status _computeCurrentStatus() const;
     Status _getCurrentStatus() const;
+    real _getCurrentDistance() const;
 
 public:
     std::unique_ptr<Simulation> sim;
@@ -102,12 +206,35 @@ private:
     std::unique_ptr<EnvPosIC> posIc_;
     std::unique_ptr<TargetDistance> targetDistance_;
     const RewardParams rewardParams_;
+    const TerminationParams terminationParams_;
+    std::vector<real> maxBodyVelocities_; ///< upper bounds of the velocity magnitude of each body
+    bool hasSuccessTime_ {false};
+    real successTime_ {0.0_r};
+    std::vector<real> U_;                 ///< inverse of the velocity matrix (row major); used for the travel time lower bound
+    std::vector<real> modeTolerances_;    ///< travel time that can be saved along each mode thanks to the target radius
+    mutable std::vector<real3> A_;        ///< work space for the travel time lower bound
+    TerminationStatistics terminationStats_;
 
     std::vector<real3> targetPositions_;
+    std::vector<real3> positionsBuffer_; ///< work space for the initial positions
     mutable real previousDistance_;
-    mutable std::vector<real> cachedState_;
+
+    // quantities derived from the current state of the simulation.
+    // Each of them is valid if its step equals step_, which changes every time the bodies are modified.
+    long step_ {0};
+    mutable long frameStep_ {-1};
+    mutable long stateStep_ {-1};
+    mutable long statusStep_ {-1};
+    mutable long distanceStep_ {-1};
+    mutable std::tuple<real3, real3, real3> cachedFrame_;
+    mutable std::vector<double> cachedState_;
+    mutable Status cachedStatus_ {Status::Running};
+    mutable real cachedDistance_ {0.0_r};
 
     const long dumpEvery_;
+    long simId_ {0};
+    DumpPredicate deferredDumpPredicate_;
+    bool dumpRequested_ {false};
 };
 
 } // namespace rl
@@ -0,0 +1,197 @@
+// Copyright 2020 ETH Zurich. All Rights Reserved.
+#include "episode_log.h"
+
+#include <msode/core/binary_io.h>
+#include <msode/core/log.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+namespace msode {
+namespace rl {
+
+static constexpr char episodeLogMagic[8] = {'M', 'S', 'O', 'D', 'E', 'L', 'O', 'G'};
+static constexpr std::uint32_t episodeLogVersion = 1;
+
+static void getBodiesState(const MSodeEnvironment& env, std::vector<RigidBodyState>& states)
+{
+    const auto& bodies = env.getBodies();
+    states.resize(bodies.size());
+
+    for (size_t i = 0; i < bodies.size(); ++i)
+    {
+        const RigidBody& b = bodies[i];
+        states[i] = RigidBodyState{b.q, b.r, b.v, b.omega};
+    }
+}
+
+long EpisodeRecord::getNumActions() const
+{
+    return actionSize > 0 ? static_cast<long>(actions.size()) / actionSize : 0;
+}
+
+
+EpisodeLogWriter::EpisodeLogWriter(const std::string& fileName) :
+    fileName_(fileName),
+    file_(fileName, std::ios::binary | std::ios::app | std::ios::ate)
+{
+    if (!file_.is_open())
+        msode_die("Could not open the file '%s'", fileName.c_str());
+
+    if (file_.tellp() == 0)
+    {
+        file_.write(episodeLogMagic, sizeof(episodeLogMagic));
+        binary_io::write(file_, episodeLogVersion);
+        binary_io::write(file_, static_cast<std::uint32_t>(sizeof(real)));
+    }
+}
+
+void EpisodeLogWriter::beginEpisode(long episodeId, unsigned long noiseSeed, const MSodeEnvironment& env)
+{
+    record_.episodeId = episodeId;
+    record_.noiseSeed = noiseSeed;
+    record_.actionSize = env.numActions();
+    record_.actions.clear();
+    record_.status = MSodeEnvironment::Status::Running;
+    getBodiesState(env, record_.initialBodies);
+}
+
+void EpisodeLogWriter::recordAction(const std::vector<double>& action)
+{
+    MSODE_Expect(static_cast<int>(action.size()) == record_.actionSize,
+                 "expected an action of size %d, got %zu", record_.actionSize, action.size());
+    record_.actions.insert(record_.actions.end(), action.begin(), action.end());
+}
+
+void EpisodeLogWriter::endEpisode(const MSodeEnvironment& env, MSodeEnvironment::Status status)
+{
+    record_.status = status;
+    record_.time = env.getSimulationTime();
+    getBodiesState(env, record_.finalBodies);
+
+    binary_io::write(file_, static_cast<std::int64_t>(record_.episodeId));
+    binary_io::write(file_, static_cast<std::uint64_t>(record_.noiseSeed));
+    binary_io::write(file_, record_.initialBodies);
+    binary_io::write(file_, static_cast<std::int32_t>(record_.actionSize));
+    binary_io::write(file_, record_.actions);
+    binary_io::write(file_, static_cast<std::int32_t>(record_.status));
+    binary_io::write(file_, record_.time);
+    binary_io::write(file_, record_.finalBodies);
+
+    // keep the log complete if the run is interrupted
+    file_.flush();
+    if (!file_)
+        msode_die("Error while writing the file '%s'", fileName_.c_str());
+}
+
+
+std::vector<EpisodeRecord> readEpisodeLog(const std::string& fileName)
+{
+    std::ifstream stream(fileName, std::ios::binary);
+    if (!stream.is_open())
+        msode_die("Could not open the file '%s'", fileName.c_str());
+
+    char magic[sizeof(episodeLogMagic)];
+    std::uint32_t version {0}, realSize {0};
+
+    stream.read(magic, sizeof(magic));
+    binary_io::read(stream, version);
+    binary_io::read(stream, realSize);
+
+    if (!stream || std::memcmp(magic, episodeLogMagic, sizeof(magic)) != 0)
+        msode_die("'%s' is not an episode log", fileName.c_str());
+
+    if (version != episodeLogVersion)
+        msode_die("'%s': unsupported episode log version %u (expected %u)",
+                  fileName.c_str(), version, episodeLogVersion);
+
+    if (realSize != sizeof(real))
+        msode_die("'%s' was written with another floating point precision", fileName.c_str());
+
+    std::vector<EpisodeRecord> records;
+
+    while (stream.peek() != std::ifstream::traits_type::eof())
+    {
+        EpisodeRecord record;
+        std::int64_t episodeId {0};
+        std::uint64_t noiseSeed {0};
+        std::int32_t actionSize {0}, status {0};
+
+        binary_io::read(stream, episodeId);
+        binary_io::read(stream, noiseSeed);
+        binary_io::read(stream, record.initialBodies);
+        binary_io::read(stream, actionSize);
+        binary_io::read(stream, record.actions);
+        binary_io::read(stream, status);
+        binary_io::read(stream, record.time);
+        binary_io::read(stream, record.finalBodies);
+
+        if (!stream)
+            msode_die("The episode log '%s' is truncated after %zu episodes", fileName.c_str(), records.size());
+
+        record.episodeId = episodeId;
+        record.noiseSeed = noiseSeed;
+        record.actionSize = actionSize;
+        record.status = static_cast<MSodeEnvironment::Status>(status);
+
+        records.push_back(std::move(record));
+    }
+
+    return records;
+}
+
+MSodeEnvironment::Status replayEpisode(MSodeEnvironment& env, const EpisodeRecord& record,
+                                       const std::string& dumpFileName, long dumpEvery)
+{
+    using Status = MSodeEnvironment::Status;
+
+    MSODE_Expect(record.actionSize == env.numActions(),
+                 "the episode was recorded with %d actions, the environment has %d",
+                 record.actionSize, env.numActions());
+
+    // same sequence as during the recording: reset, seed the noise, then the actions.
+    // The environment must not write the trajectory of the episode: it would overwrite the one of the original run.
+    env.reset(record.initialBodies, MSodeEnvironment::NO_DUMP);
+    env.sim->setNoiseSeed(record.noiseSeed);
+
+    if (!dumpFileName.empty())
+        env.sim->activateDump(dumpFileName, dumpEvery);
+
+    std::vector<double> action(record.actionSize);
+    Status status {Status::Running};
+
+    for (long i = 0; i < record.getNumActions() && status == Status::Running; ++i)
+    {
+        std::copy(record.actions.begin() +  i      * record.actionSize,
+                  record.actions.begin() + (i + 1) * record.actionSize,
+                  action.begin());
+        status = env.advance(action);
+    }
+
+    return status;
+}
+
+static inline bool bitwiseEqual(const RigidBodyState& a, const RigidBodyState& b)
+{
+    auto eq = [](const auto& x, const auto& y) {return std::memcmp(&x, &y, sizeof(x)) == 0;};
+    return eq(a.q, b.q) && eq(a.r, b.r) && eq(a.v, b.v) && eq(a.omega, b.omega);
+}
+
+bool matchesFinalState(const MSodeEnvironment& env, const EpisodeRecord& record)
+{
+    std::vector<RigidBodyState> bodies;
+    getBodiesState(env, bodies);
+
+    if (bodies.size() != record.finalBodies.size())
+        return false;
+
+    for (size_t i = 0; i < bodies.size(); ++i)
+        if (!bitwiseEqual(bodies[i], record.finalBodies[i]))
+            return false;
+
+    return true;
+}
+
+} // namespace rl
+} // namespace msode
@@ -0,0 +1,81 @@
+// Copyright 2020 ETH Zurich. All Rights Reserved.
+#pragma once
+
+#include "environment.h"
+
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace msode {
+namespace rl {
+
+/** Compact record of an episode, enough to re-simulate it exactly with replayEpisode().
+    Much lighter than a trajectory dump: it holds the initial state of the bodies, the seed of the thermal noise and
+    the sequence of actions. The final state of the bodies is kept to check that the replays are exact.
+ */
+struct EpisodeRecord
+{
+    long episodeId {0};
+    unsigned long noiseSeed {0};                ///< the seed passed to Simulation::setNoiseSeed() at the start
+    std::vector<RigidBodyState> initialBodies;
+    int actionSize {0};
+    std::vector<double> actions;                ///< the actions in the order they were applied (numActions x actionSize)
+    MSodeEnvironment::Status status {MSodeEnvironment::Status::Running};
+    real time {0.0_r};                          ///< simulation time at the end of the episode
+    std::vector<RigidBodyState> finalBodies;
+
+    long getNumActions() const;
+};
+
+/** Append EpisodeRecord objects to a binary log file while the episodes are running.
+    The episode must be seeded explicitly with Simulation::setNoiseSeed() after the reset of the environment,
+    so that the thermal noise does not depend on the previous episodes.
+ */
+class EpisodeLogWriter
+{
+public:
+    /// \param fileName The log file; the records are appended to it if it exists
+    explicit EpisodeLogWriter(const std::string& fileName);
+
+    /** \brief Start recording an episode.
+        \param episodeId The id of the episode
+        \param noiseSeed The seed of the thermal noise of the episode
+        \param env The environment, after its reset and the seeding of its noise
+     */
+    void beginEpisode(long episodeId, unsigned long noiseSeed, const MSodeEnvironment& env);
+
+    /// record the next action applied to the environment
+    void recordAction(const std::vector<double>& action);
+
+    /// append the current episode to the file; \p env and \p status are those at the end of the episode
+    void endEpisode(const MSodeEnvironment& env, MSodeEnvironment::Status status);
+
+private:
+    std::string fileName_;
+    std::ofstream file_;
+    EpisodeRecord record_;
+};
+
+/** \brief Read a log written by EpisodeLogWriter.
+    This method will fail if the file can not be read or was written with another precision.
+ */
+std::vector<EpisodeRecord> readEpisodeLog(const std::string& fileName);
+
+/** \brief Re-simulate a recorded episode.
+    \param env An environment equivalent to the one that ran the episode (e.g. created from the same config)
+    \param record The episode to replay
+    \param dumpFileName If not empty, the trajectory is dumped to that file. The environment itself does not dump
+           the replayed episode, see MSodeEnvironment::NO_DUMP. The replay dump replaces the buffered frames of
+           MSodeEnvironment::setDeferredDump(), if any.
+    \param dumpEvery The dump frequency, in time steps; used only if \p dumpFileName is not empty
+    \return The status at the end of the replay; \p env is left at the end of the episode.
+ */
+MSodeEnvironment::Status replayEpisode(MSodeEnvironment& env, const EpisodeRecord& record,
+                                       const std::string& dumpFileName = "", long dumpEvery = 1);
+
+/// \return true if the bodies of \p env are bitwise identical to the final bodies of \p record
+bool matchesFinalState(const MSodeEnvironment& env, const EpisodeRecord& record);
+
+} // namespace rl
+} // namespace msode
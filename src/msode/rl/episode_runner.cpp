@@ -0,0 +1,267 @@
+// Copyright 2020 ETH Zurich. All Rights Reserved.
+#include "episode_runner.h"
+
+#include <msode/core/log.h>
+#include <msode/core/math.h>
+
+#include <algorithm>
+#include <atomic>
+#include <random>
+
+namespace msode {
+namespace rl {
+
+EpisodeRunner::EpisodeRunner(const EnvironmentFactory& createEnvironment, int numThreads, long seed) :
+    pool_(numThreads),
+    seed_(seed)
+{
+    const int n = pool_.getNumThreads();
+
+    for (int i = 0; i < n; ++i)
+    {
+        envs_.push_back(createEnvironment());
+        MSODE_Ensure(envs_.back() != nullptr, "the environment factory returned a null environment");
+    }
+
+    actions_.resize(n);
+}
+
+int EpisodeRunner::getNumThreads() const
+{
+    return pool_.getNumThreads();
+}
+
+const MSodeEnvironment* EpisodeRunner::getEnvironment(int workerId) const
+{
+    MSODE_Expect(workerId >= 0 && workerId < getNumThreads(), "wrong worker id %d", workerId);
+    return envs_[workerId].get();
+}
+
+std::vector<EpisodeResult> EpisodeRunner::run(long numEpisodes, const Policy& policy, long firstEpisodeId)
+{
+    MSODE_Expect(numEpisodes >= 0, "expect non negative number of episodes, got %ld", numEpisodes);
+
+    std::vector<EpisodeResult> results(numEpisodes);
+
+    pool_.run(numEpisodes, [&](long taskId, int workerId)
+    {
+        results[taskId] = runEpisode(*envs_[workerId], seed_, firstEpisodeId + taskId, workerId,
+                                     policy, actions_[workerId]);
+    });
+
+    return results;
+}
+
+static real computeMaxDistance(const MSodeEnvironment& env)
+{
+    const auto& bodies  = env.getBodies();
+    const auto& targets = env.getTargetPositions();
+
+    real maxDistance {0.0_r};
+    for (size_t i = 0; i < bodies.size(); ++i)
+        maxDistance = std::max(maxDistance, length(bodies[i].r - targets[i]));
+
+    return maxDistance;
+}
+
+/// reset \p env for the given episode and initialize its result
+static void startEpisode(MSodeEnvironment& env, long seed, long episodeId, EpisodeResult& result)
+{
+    std::seed_seq seq {seed, episodeId};
+    std::mt19937 gen(seq);
+
+    // always behave as if the previous try was successful, so that the initial conditions
+    // do not depend on the episodes previously run by this environment
+    const bool successfulPreviousTry {true};
+    env.reset(gen, episodeId, successfulPreviousTry);
+    env.sim->setNoiseSeed(gen());
+
+    result = EpisodeResult{};
+    result.episodeId = episodeId;
+    result.initialMaxDistance = computeMaxDistance(env);
+}
+
+static void finishEpisode(const MSodeEnvironment& env, MSodeEnvironment::Status status,
+                          long numActions, EpisodeResult& result)
+{
+    result.status = status;
+    result.time = env.getSimulationTime();
+    result.numActions = numActions;
+    result.finalMaxDistance = computeMaxDistance(env);
+}
+
+EpisodeResult runEpisode(MSodeEnvironment& env, long seed, long episodeId, int workerId,
+                         const EpisodeRunner::Policy& policy, std::vector<double>& action)
+{
+    using Status = MSodeEnvironment::Status;
+
+    EpisodeResult result;
+    startEpisode(env, seed, episodeId, result);
+
+    action.resize(env.numActions());
+
+    EpisodeContext context {episodeId, 0, workerId};
+    Status status {Status::Running};
+
+    while (status == Status::Running)
+    {
+        policy(context, env, env.getState(), action);
+
+        status = env.advance(action);
+        result.totalReward += env.getReward();
+        ++context.actionId;
+    }
+
+    finishEpisode(env, status, context.actionId, result);
+
+    return result;
+}
+
+
+BatchEpisodeRunner::BatchEpisodeRunner(const EnvironmentFactory& createEnvironment, int numEnvironments,
+                                       int numThreads, long seed) :
+    pool_(numThreads),
+    seed_(seed)
+{
+    MSODE_Expect(numEnvironments > 0, "expect a positive number of environments, got %d", numEnvironments);
+
+    for (int i = 0; i < numEnvironments; ++i)
+    {
+        envs_.push_back(createEnvironment());
+        MSODE_Ensure(envs_.back() != nullptr, "the environment factory returned a null environment");
+        actions_.emplace_back(envs_.back()->numActions());
+    }
+
+    const int numChunks = std::min(numEnvironments, pool_.getNumThreads());
+    chunks_.resize(numChunks);
+
+    for (int c = 0; c < numChunks; ++c)
+    {
+        chunks_[c].begin = static_cast<int>(static_cast<long>(c)     * numEnvironments / numChunks);
+        chunks_[c].end   = static_cast<int>(static_cast<long>(c + 1) * numEnvironments / numChunks);
+    }
+}
+
+int BatchEpisodeRunner::getNumThreads() const
+{
+    return pool_.getNumThreads();
+}
+
+int BatchEpisodeRunner::getNumEnvironments() const
+{
+    return static_cast<int>(envs_.size());
+}
+
+const MSodeEnvironment* BatchEpisodeRunner::getEnvironment(int envId) const
+{
+    MSODE_Expect(envId >= 0 && envId < getNumEnvironments(), "wrong environment id %d", envId);
+    return envs_[envId].get();
+}
+
+std::vector<EpisodeResult> BatchEpisodeRunner::run(long numEpisodes, const BatchPolicy& policy, long firstEpisodeId,
+                                                   const EpisodeStartCallback& onEpisodeStart)
+{
+    using Status = MSodeEnvironment::Status;
+
+    MSODE_Expect(numEpisodes >= 0, "expect non negative number of episodes, got %ld", numEpisodes);
+
+    const int numEnvs = getNumEnvironments();
+    const int numActions = envs_[0]->numActions();
+
+    std::vector<EpisodeResult> results(numEpisodes);
+    std::vector<long> episodeIndices(numEnvs, -1); // index of the running episode in results; -1 if none
+    std::atomic<long> nextEpisode {0};
+
+    // start the next episode on environment e; returns false if all episodes were started
+    auto startNextEpisode = [&](int e)
+    {
+        const long index = nextEpisode++;
+
+        if (index >= numEpisodes)
+        {
+            episodeIndices[e] = -1;
+            return false;
+        }
+
+        episodeIndices[e] = index;
+        startEpisode(*envs_[e], seed_, firstEpisodeId + index, results[index]);
+
+        if (onEpisodeStart)
+            onEpisodeStart(firstEpisodeId + index, *envs_[e]);
+
+        return true;
+    };
+
+    pool_.run(numEnvs, [&](long e, int)
+    {
+        startNextEpisode(static_cast<int>(e));
+    });
+
+    std::atomic<bool> anyRunning {numEpisodes > 0};
+
+    while (anyRunning)
+    {
+        anyRunning = false;
+
+        pool_.run(static_cast<long>(chunks_.size()), [&](long chunkId, int workerId)
+        {
+            Chunk& chunk = chunks_[chunkId];
+            chunk.running.clear();
+            chunk.states.clear();
+
+            for (int e = chunk.begin; e < chunk.end; ++e)
+            {
+                if (episodeIndices[e] < 0)
+                    continue;
+
+                const auto& state = envs_[e]->getState();
+                chunk.running.push_back(e);
+                chunk.states.insert(chunk.states.end(), state.begin(), state.end());
+            }
+
+            const long n = static_cast<long>(chunk.running.size());
+
+            if (n == 0)
+                return;
+
+            chunk.actions.resize(n * numActions);
+            policy(workerId, n, chunk.states.data(), chunk.actions.data());
+
+            bool chunkRunning {false};
+
+            for (long k = 0; k < n; ++k)
+            {
+                const int e = chunk.running[k];
+                MSodeEnvironment& env = *envs_[e];
+                EpisodeResult& result = results[episodeIndices[e]];
+                std::vector<double>& action = actions_[e];
+
+                std::copy(chunk.actions.begin() + k * numActions,
+                          chunk.actions.begin() + (k + 1) * numActions,
+                          action.begin());
+
+                const Status status = env.advance(action);
+                result.totalReward += env.getReward();
+                ++result.numActions;
+
+                if (status != Status::Running)
+                {
+                    finishEpisode(env, status, result.numActions, result);
+                    chunkRunning |= startNextEpisode(e);
+                }
+                else
+                {
+                    chunkRunning = true;
+                }
+            }
+
+            if (chunkRunning)
+                anyRunning = true;
+        });
+    }
+
+    return results;
+}
+
+} // namespace rl
+} // namespace msode
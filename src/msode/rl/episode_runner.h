@@ -0,0 +1,169 @@
+// Copyright 2020 ETH Zurich. All Rights Reserved.
+#pragma once
+
+#include "environment.h"
+
+#include <msode/utils/thread_pool.h>
+
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace msode {
+namespace rl {
+
+/// Summary of one episode run by the EpisodeRunner
+struct EpisodeResult
+{
+    long episodeId {0};
+    MSodeEnvironment::Status status {MSodeEnvironment::Status::Running};
+    real time {0.0_r};               ///< simulation time at the end of the episode
+    long numActions {0};             ///< number of actions performed during the episode
+    real totalReward {0.0_r};        ///< sum of all rewards received during the episode
+    real initialMaxDistance {0.0_r}; ///< largest distance from a body to its target at the start of the episode
+    real finalMaxDistance {0.0_r};   ///< largest distance from a body to its target at the end of the episode
+};
+
+/// Information passed to the policy together with the environment
+struct EpisodeContext
+{
+    long episodeId; ///< the episode being run
+    long actionId;  ///< index of the requested action within the episode; 0 for the first action
+    int workerId;   ///< the worker running the episode, in [0, numThreads)
+};
+
+/** Run many independent episodes in parallel on a work stealing thread pool.
+
+    Each worker thread owns one MSodeEnvironment.
+    Episodes are scheduled dynamically, so that workers that finish short episodes take over the
+    remaining work of the others.
+    Every episode draws its initial conditions and thermal noise from a random generator seeded by
+    the episode id only. The results are therefore independent of the number of threads and of the
+    scheduling, as long as the policy is a deterministic function of its inputs.
+
+    \note Initial conditions that follow a curriculum depend on the history of the environment.
+          These are not reproducible across different numbers of threads.
+ */
+class EpisodeRunner
+{
+public:
+    using EnvironmentFactory = std::function<std::unique_ptr<MSodeEnvironment>()>;
+
+    /** A policy writes the next action for the given environment in \p action.
+        \p action has the size MSodeEnvironment::numActions().
+        Must be thread safe; the workerId in the context can be used to index per-thread data.
+    */
+    using Policy = std::function<void(const EpisodeContext& context,
+                                      const MSodeEnvironment& env,
+                                      const std::vector<double>& state,
+                                      std::vector<double>& action)>;
+
+    /** \brief Construct an EpisodeRunner
+        \param createEnvironment Creates one environment per worker. All environments must be equivalent.
+        \param numThreads The number of worker threads. Non positive values select the number of hardware threads.
+        \param seed Base seed of the per-episode random generators.
+     */
+    EpisodeRunner(const EnvironmentFactory& createEnvironment, int numThreads, long seed = 424242);
+
+    int getNumThreads() const;
+
+    /** \brief Run the episodes firstEpisodeId, ..., firstEpisodeId + numEpisodes - 1.
+        \param numEpisodes The number of episodes to run
+        \param policy The decision rule
+        \param firstEpisodeId Id of the first episode; used to seed the episodes and to name the trajectory files
+        \return The results ordered by episode id
+     */
+    std::vector<EpisodeResult> run(long numEpisodes, const Policy& policy, long firstEpisodeId = 0);
+
+    /// \return The environment owned by the given worker
+    const MSodeEnvironment* getEnvironment(int workerId) const;
+
+private:
+    utils::ThreadPool pool_;
+    std::vector<std::unique_ptr<MSodeEnvironment>> envs_;       ///< one per worker
+    std::vector<std::vector<double>> actions_;                  ///< action buffers, one per worker
+    const long seed_;
+};
+
+/** \brief Run one full episode on the given environment.
+    The episode is seeded as in EpisodeRunner: the result depends only on \p seed, \p episodeId and the policy.
+    \param env The environment; it is reset at the start of the episode
+    \param seed Base seed of the per-episode random generators
+    \param episodeId Id of the episode
+    \param workerId Passed to the policy in the EpisodeContext
+    \param policy The decision rule
+    \param action Buffer for the actions, resized to env.numActions(); does not allocate once it has the correct size
+    \return The summary of the episode
+ */
+EpisodeResult runEpisode(MSodeEnvironment& env, long seed, long episodeId, int workerId,
+                         const EpisodeRunner::Policy& policy, std::vector<double>& action);
+
+
+/** Run many independent episodes on a batch of environments advanced in lock step, so that the policy is
+    evaluated on many states at once (e.g. a neural network, see MLP).
+
+    The environments are split in one contiguous chunk per worker thread. At every wave, each worker gathers the
+    states of its running environments, evaluates the policy on all of them at once and advances them by one action.
+    An environment that finishes its episode starts immediately the next episode that was not started yet.
+    As in EpisodeRunner, every episode is seeded by its id only: for deterministic policies, the results do not
+    depend on the number of environments and threads, and are the same as with an EpisodeRunner with the same seed.
+ */
+class BatchEpisodeRunner
+{
+public:
+    using EnvironmentFactory = EpisodeRunner::EnvironmentFactory;
+
+    /** A batch policy writes the actions of \p n environments.
+        \p states has n x (size of the state) values and \p actions has n x MSodeEnvironment::numActions() values,
+        both stored environment major.
+        Called concurrently by the workers on different environments; the workerId, in [0, numThreads), can be used
+        to index per-thread data.
+    */
+    using BatchPolicy = std::function<void(int workerId, long n, const double *states, double *actions)>;
+
+    /// Called after the environment of an episode was reset; called concurrently by the workers.
+    using EpisodeStartCallback = std::function<void(long episodeId, const MSodeEnvironment& env)>;
+
+    /** \brief Construct a BatchEpisodeRunner
+        \param createEnvironment Creates the environments. All environments must be equivalent.
+        \param numEnvironments The number of environments advanced in lock step.
+        \param numThreads The number of worker threads. Non positive values select the number of hardware threads.
+        \param seed Base seed of the per-episode random generators.
+     */
+    BatchEpisodeRunner(const EnvironmentFactory& createEnvironment, int numEnvironments, int numThreads, long seed = 424242);
+
+    int getNumThreads() const;
+    int getNumEnvironments() const;
+
+    /// \return The environment with the given index, in [0, getNumEnvironments())
+    const MSodeEnvironment* getEnvironment(int envId) const;
+
+    /** \brief Run the episodes firstEpisodeId, ..., firstEpisodeId + numEpisodes - 1.
+        \param numEpisodes The number of episodes to run
+        \param policy The decision rule
+        \param firstEpisodeId Id of the first episode; used to seed the episodes and to name the trajectory files
+        \param onEpisodeStart If set, called at the start of every episode
+        \return The results ordered by episode id
+     */
+    std::vector<EpisodeResult> run(long numEpisodes, const BatchPolicy& policy, long firstEpisodeId = 0,
+                                   const EpisodeStartCallback& onEpisodeStart = nullptr);
+
+private:
+    /// Work space of one chunk of environments
+    struct Chunk
+    {
+        int begin, end;                ///< range of environments
+        std::vector<int> running;      ///< the environments of the chunk that run an episode
+        std::vector<double> states;    ///< states of the running environments
+        std::vector<double> actions;   ///< actions of the running environments
+    };
+
+    utils::ThreadPool pool_;
+    std::vector<std::unique_ptr<MSodeEnvironment>> envs_;
+    std::vector<std::vector<double>> actions_;   ///< action buffers, one per environment
+    std::vector<Chunk> chunks_;
+    const long seed_;
+};
+
+} // namespace rl
+} // namespace msode
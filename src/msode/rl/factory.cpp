@@ -9,6 +9,8 @@
 #include <msode/rl/pos_ic/factory.h>
 #include <msode/rl/target_distances/factory.h>
 
+#include <limits>
+
 namespace msode {
 namespace rl {
 namespace factory {
@@ -55,6 +57,35 @@ estimateMaxDistanceAndTravelTime(const std::vector<RigidBody>& bodies,
     return {maxDistance, maxTravelTime};
 }
 
+static TerminationParams createTerminationParams(const Config& config)
+{
+    TerminationParams params;
+
+    if (!config.contains("termination"))
+        return params;
+
+    const auto& conf = config.at("termination");
+
+    if (conf.contains("skipDistanceChecks"))
+        params.skipDistanceChecks = conf.at("skipDistanceChecks").get<bool>();
+
+    if (conf.contains("exactCrossing"))
+        params.exactCrossing = conf.at("exactCrossing").get<bool>();
+
+    if (conf.contains("cutHopeless"))
+        params.cutHopeless = conf.at("cutHopeless").get<bool>();
+
+    if (conf.contains("travelTimeBound"))
+        params.travelTimeBound = conf.at("travelTimeBound").get<bool>();
+
+    if (conf.contains("cutoffFactor"))
+        params.cutoffFactor = conf.at("cutoffFactor").get<real>();
+
+    MSODE_Expect(params.cutoffFactor > 0.0_r, "cutoffFactor must be positive, got %g", params.cutoffFactor);
+
+    return params;
+}
+
 static Params createParams(const std::vector<RigidBody>& bodies, const EnvPosIC *posIc, const TargetDistance *targetDist, const Config& config)
 {
     const real distanceThreshold = config.at("targetRadius").get<real>();
@@ -83,6 +114,7 @@ static Params createParams(const std::vector<RigidBody>& bodies, const EnvPosIC
 
     const TimeParams timeParams {dt, tmax, nstepsPerAction, dumpEvery};
     const RewardParams rewardParams {distCoeffReward, timeCoeffReward, terminationBonus};
+    const TerminationParams terminationParams = createTerminationParams(config);
 
     fprintf(stderr,
             "----------------------------------------------------------\n"
@@ -95,14 +127,45 @@ static Params createParams(const std::vector<RigidBody>& bodies, const EnvPosIC
             "dt action        %g\n"
             "steps per action %ld\n"
             "kBT              %g\n"
+            "skip dist checks %d\n"
+            "exact crossing   %d\n"
+            "cut hopeless     %d (travel time bound: %d, factor: %g)\n"
             "----------------------------------------------------------\n",
             tmax, maxDistance, distCoeffReward, timeCoeffReward, terminationBonus,
-            dt, dtAction, nstepsPerAction, kBT);
+            dt, dtAction, nstepsPerAction, kBT,
+            terminationParams.skipDistanceChecks, terminationParams.exactCrossing,
+            terminationParams.cutHopeless, terminationParams.travelTimeBound, terminationParams.cutoffFactor);
 
-    const Params params(timeParams, rewardParams, fieldMagnitude, distanceThreshold, kBT);
+    const Params params(timeParams, rewardParams, fieldMagnitude, distanceThreshold, kBT, terminationParams);
     return params;
 }
 
+/** Optional config entry "deferredDump": {"capacity": frames, "float32": bool, "minTime": time}.
+    The trajectories are kept in memory and written only for the failed episodes and those lasting longer than minTime.
+ */
+static void setDeferredDump(MSodeEnvironment& env, const Config& config)
+{
+    if (!config.contains("deferredDump"))
+        return;
+
+    const auto& conf = config.at("deferredDump");
+
+    const long capacity = conf.at("capacity").get<long>();
+
+    bool singlePrecision {false};
+    if (conf.contains("float32"))
+        singlePrecision = conf.at("float32").get<bool>();
+
+    real minTime = std::numeric_limits<real>::infinity();
+    if (conf.contains("minTime"))
+        minTime = conf.at("minTime").get<real>();
+
+    env.setDeferredDump(capacity, singlePrecision, [minTime](const MSodeEnvironment& e, MSodeEnvironment::Status status)
+    {
+        return status != MSodeEnvironment::Status::Success || e.getSimulationTime() > minTime;
+    });
+}
+
 std::unique_ptr<MSodeEnvironment> createEnvironment(const Config& rootConfig, ConfPointer confPointer)
 {
     auto config = rootConfig.at(confPointer);
@@ -115,7 +178,9 @@ std::unique_ptr<MSodeEnvironment> createEnvironment(const Config& rootConfig, Co
 
     auto params = createParams(bodies, posIc.get(), targetDistance.get(), config);
 
-    return std::make_unique<MSodeEnvironment>(params, std::move(posIc), std::move(bodies), std::move(fieldAction), std::move(velField), std::move(targetDistance));
+    auto env = std::make_unique<MSodeEnvironment>(params, std::move(posIc), std::move(bodies), std::move(fieldAction), std::move(velField), std::move(targetDistance));
+    setDeferredDump(*env, config);
+    return env;
 }
 
 } // namespace factory
@@ -54,6 +54,31 @@ void FieldFromActionChange::advance(real t)
     lastAxis_ = normalized(lastAxis_);
 }
 
+void FieldFromActionChange::reset()
+{
+    lastOmega_ = 0.0_r;
+    lastAxis_ = ex;
+    lastActionTime_ = 0.0_r;
+    dOmega_ = 0.0_r;
+    dAxis_ = real3{0.0_r, 0.0_r, 0.0_r};
+}
+
+void FieldFromActionChange::saveState(FieldFromActionState& state) const
+{
+    state.values = {lastOmega_, lastAxis_.x, lastAxis_.y, lastAxis_.z, lastActionTime_,
+                    dOmega_, dAxis_.x, dAxis_.y, dAxis_.z};
+}
+
+void FieldFromActionChange::loadState(const FieldFromActionState& state)
+{
+    const auto& v = state.values;
+    lastOmega_      = v[0];
+    lastAxis_       = real3{v[1], v[2], v[3]};
+    lastActionTime_ = v[4];
+    dOmega_         = v[5];
+    dAxis_          = real3{v[6], v[7], v[8]};
+}
+
 real FieldFromActionChange::getOmega(real t) const
 {
     return lastOmega_ + _omegaActionChange(t);
@@ -20,6 +20,10 @@ public:
     void setAction(const std::vector<double>& action) override;
 
     void advance(real t) override;
+    void reset() override;
+
+    void saveState(FieldFromActionState& state) const override;
+    void loadState(const FieldFromActionState& state) override;
 
     real getOmega(real t) const override;
     real3 getAxis(real t) const override;
@@ -45,5 +45,16 @@ void FieldFromActionDirect::setAction(const std::vector<double>& action)
     axis_ = normalized(axis_);
 }
 
+void FieldFromActionDirect::saveState(FieldFromActionState& state) const
+{
+    state.values = {omega_, axis_.x, axis_.y, axis_.z};
+}
+
+void FieldFromActionDirect::loadState(const FieldFromActionState& state)
+{
+    omega_ = state.values[0];
+    axis_  = real3{state.values[1], state.values[2], state.values[3]};
+}
+
 } // namespace rl
 } // namespace msode
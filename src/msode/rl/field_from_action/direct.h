@@ -18,6 +18,9 @@ public:
     std::tuple<real3, real3, real3> getFrameReference() const override;
 
     void setAction(const std::vector<double>& action) override;
+
+    void saveState(FieldFromActionState& state) const override;
+    void loadState(const FieldFromActionState& state) override;
     real getOmega(real) const override  {return omega_;}
     real3 getAxis(real) const override  {return axis_;}
 
@@ -36,12 +36,25 @@ void FieldFromActionDirect3::setAction(const std::vector<double>& action)
     MSODE_Expect(static_cast<int>(action.size()) == 3, "expect action of size 3");
     constexpr real tolerance = 1e-6_r;
 
-    real3 a {action[1], action[2], action[3]};
+    const real3 a {static_cast<real>(action[1]),
+                   static_cast<real>(action[2]),
+                   static_cast<real>(action[3])};
 
     omega_ = length(a);
 
     axis_ = omega_ < tolerance ? ex : normalized(a);
 }
 
+void FieldFromActionDirect3::saveState(FieldFromActionState& state) const
+{
+    state.values = {omega_, axis_.x, axis_.y, axis_.z};
+}
+
+void FieldFromActionDirect3::loadState(const FieldFromActionState& state)
+{
+    omega_ = state.values[0];
+    axis_  = real3{state.values[1], state.values[2], state.values[3]};
+}
+
 } // namespace rl
 } // namespace msode
@@ -3,6 +3,7 @@
 
 #include <msode/core/types.h>
 
+#include <array>
 #include <tuple>
 #include <vector>
 
@@ -13,6 +14,15 @@ class MSodeEnvironment;
 
 using ActionBounds = std::tuple<std::vector<double>, std::vector<double>>;
 
+/** The dynamic state of a FieldFromAction (e.g. the current action).
+    Stored in a fixed number of values, so that it can be copied without allocation.
+ */
+struct FieldFromActionState
+{
+    static constexpr int maxSize = 12;
+    std::array<real, maxSize> values;
+};
+
 class FieldFromAction
 {
 public:
@@ -27,6 +37,14 @@ public:
     virtual void setAction(const std::vector<double>& action) = 0;
     virtual void advance(real) {}
 
+    /// restore the initial state; called at the beginning of every episode
+    virtual void reset() {}
+
+    /// store the dynamic state in \p state
+    virtual void saveState(FieldFromActionState& state) const = 0;
+    /// restore a state stored with saveState() by an object of the same type
+    virtual void loadState(const FieldFromActionState& state) = 0;
+
     virtual real getOmega(real t) const = 0;
     virtual real3 getAxis(real t) const = 0;
 
@@ -85,11 +85,22 @@ void FieldFromActionFromLocalFrame::setAction(const std::vector<double>& action)
     omega_ = std::min(maxOmega_, std::max(minOmega_, static_cast<real>(action[0])));
 
     real3 n1, n2, n3;
-    std::tie(n1, n2, n3) = getFrameReference();
+    std::tie(n1, n2, n3) = env_->getFrameReference();
 
     axis_ = a.x * n1 + a.y * n2 + a.z * n3;
     axis_ = normalized(axis_);
 }
 
+void FieldFromActionFromLocalFrame::saveState(FieldFromActionState& state) const
+{
+    state.values = {omega_, axis_.x, axis_.y, axis_.z};
+}
+
+void FieldFromActionFromLocalFrame::loadState(const FieldFromActionState& state)
+{
+    omega_ = state.values[0];
+    axis_  = real3{state.values[1], state.values[2], state.values[3]};
+}
+
 } // namespace rl
 } // namespace msode
@@ -55,5 +55,16 @@ void FieldFromActionFromTargets::setAction(const std::vector<double>& action)
     axis_ = normalized(axis_);
 }
 
+void FieldFromActionFromTargets::saveState(FieldFromActionState& state) const
+{
+    state.values = {omega_, axis_.x, axis_.y, axis_.z};
+}
+
+void FieldFromActionFromTargets::loadState(const FieldFromActionState& state)
+{
+    omega_ = state.values[0];
+    axis_  = real3{state.values[1], state.values[2], state.values[3]};
+}
+
 } // namespace rl
 } // namespace msode
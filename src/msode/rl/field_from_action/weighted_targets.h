@@ -19,6 +19,9 @@ public:
 
     void setAction(const std::vector<double>& action) override;
 
+    void saveState(FieldFromActionState& state) const override;
+    void loadState(const FieldFromActionState& state) override;
+
     real getOmega(real) const override  {return omega_;}
     real3 getAxis(real) const override  {return axis_;}
 
@@ -0,0 +1,165 @@
+// Copyright 2020 ETH Zurich. All Rights Reserved.
+#include "analytic_control.h"
+
+#include <msode/analytic_control/optimal_path.h>
+#include <msode/core/log.h>
+#include <msode/rl/environment.h>
+#include <msode/rl/field_from_action/direct.h>
+#include <msode/utils/mean_vel.h>
+
+#include <cmath>
+#include <limits>
+
+namespace msode {
+namespace rl {
+
+PolicyAnalyticControl::PolicyAnalyticControl(real omegaFactor) :
+    omegaFactor_(omegaFactor)
+{
+    MSODE_Expect(omegaFactor_ > 0.0_r && omegaFactor_ <= 1.0_r, "omegaFactor must be in (0, 1], got %g", omegaFactor_);
+}
+
+std::unique_ptr<Policy> PolicyAnalyticControl::clone() const
+{
+    return std::make_unique<PolicyAnalyticControl>(*this);
+}
+
+void PolicyAnalyticControl::reset(const MSodeEnvironment& env, long /* episodeId */)
+{
+    if (dynamic_cast<const FieldFromActionDirect*>(env.magnFieldState.get()) == nullptr)
+        msode_die("The analytic control policy requires the 'Direct' field from action");
+
+    const auto& bodies = env.getBodies();
+
+    if (!_isVelocityMatrixUpToDate(env.fieldMagnitude, bodies))
+        _computeVelocityMatrix(env.fieldMagnitude, bodies);
+
+    _setRelativePositions(env);
+    previous_ = Choice{0, 0, 0};
+
+    const auto A = analytic_control::computeA(U_, dr_);
+    const Quaternion q = analytic_control::findBestPathLBFGS(A);
+
+    dirs_ = {{q.rotate(real3{1.0_r, 0.0_r, 0.0_r}),
+              q.rotate(real3{0.0_r, 1.0_r, 0.0_r}),
+              q.rotate(real3{0.0_r, 0.0_r, 1.0_r})}};
+}
+
+void PolicyAnalyticControl::computeAction(const MSodeEnvironment& env,
+                                          const std::vector<double>& /* state */,
+                                          std::vector<double>& action)
+{
+    MSODE_Expect(action.size() == 4, "expect an action of size 4, got %zu", action.size());
+
+    _setRelativePositions(env);
+
+    // keep driving the same pair until its remaining time changes sign, as the segments of the analytic control
+    const bool continuePrevious = previous_.sign != 0 &&
+        previous_.sign * _computeBeta(previous_.dir, previous_.body) > 0.0_r;
+
+    Choice choice = previous_;
+
+    if (!continuePrevious)
+    {
+        const int n = static_cast<int>(dr_.size());
+        real bestBeta {0.0_r};
+
+        for (int k = 0; k < 3; ++k)
+        {
+            for (int i = 0; i < n; ++i)
+            {
+                const real beta = _computeBeta(k, i);
+
+                if (std::abs(beta) > std::abs(bestBeta))
+                {
+                    bestBeta = beta;
+                    choice = {k, i, bestBeta > 0.0_r ? 1 : -1};
+                }
+            }
+        }
+    }
+
+    // align the bodies with a new axis at low frequency before driving them close to their step out frequency
+    const bool reorient = !continuePrevious;
+    previous_ = choice;
+
+    // rotating at -omega around dir is the same as rotating at +omega around -dir
+    const real3 axis = static_cast<real>(choice.sign) * dirs_[choice.dir];
+
+    action[0] = reorient ? omegaReorient_ : omegas_[choice.body];
+    action[1] = axis.x;
+    action[2] = axis.y;
+    action[3] = axis.z;
+}
+
+real PolicyAnalyticControl::_computeBeta(int dir, int body) const
+{
+    real beta {0.0_r};
+    for (size_t j = 0; j < dr_.size(); ++j)
+        beta += U_(body, j) * dot(dr_[j], dirs_[dir]);
+    return beta;
+}
+
+static bool sameProperties(const RigidBody& a, const RigidBody& b)
+{
+    return a.magnMoment.x == b.magnMoment.x &&
+        a.magnMoment.y == b.magnMoment.y &&
+        a.magnMoment.z == b.magnMoment.z &&
+        a.propulsion.A == b.propulsion.A &&
+        a.propulsion.B == b.propulsion.B &&
+        a.propulsion.C == b.propulsion.C;
+}
+
+bool PolicyAnalyticControl::_isVelocityMatrixUpToDate(real magneticFieldMagnitude, const std::vector<RigidBody>& bodies) const
+{
+    if (cachedBodies_.empty() ||
+        cachedFieldMagnitude_ != magneticFieldMagnitude ||
+        cachedBodies_.size() != bodies.size())
+        return false;
+
+    for (size_t i = 0; i < bodies.size(); ++i)
+        if (!sameProperties(cachedBodies_[i], bodies[i]))
+            return false;
+
+    return true;
+}
+
+void PolicyAnalyticControl::_computeVelocityMatrix(real magneticFieldMagnitude, const std::vector<RigidBody>& bodies)
+{
+    // same as analytic_control::createVelocityMatrix() at the reduced frequencies
+    constexpr long nIntegration = 10000;
+    const size_t n = bodies.size();
+
+    omegas_ = analytic_control::computeStepOutFrequencies(magneticFieldMagnitude, bodies);
+    for (auto& omega : omegas_)
+        omega *= omegaFactor_;
+
+    analytic_control::MatrixReal V(n, n);
+
+    for (size_t i = 0; i < n; ++i)
+        for (size_t j = 0; j < n; ++j)
+            V(i, j) = utils::computeMeanVelocityAnalytical(bodies[i], magneticFieldMagnitude, omegas_[j], nIntegration);
+
+    U_ = V.inverse();
+
+    omegaReorient_ = std::numeric_limits<real>::max();
+    for (const auto& b : bodies)
+        omegaReorient_ = std::min(omegaReorient_, 0.5_r * b.stepOutFrequency(magneticFieldMagnitude));
+
+    cachedFieldMagnitude_ = magneticFieldMagnitude;
+    cachedBodies_ = bodies;
+}
+
+void PolicyAnalyticControl::_setRelativePositions(const MSodeEnvironment& env)
+{
+    const auto& bodies  = env.getBodies();
+    const auto& targets = env.getTargetPositions();
+
+    dr_.resize(bodies.size());
+
+    for (size_t i = 0; i < bodies.size(); ++i)
+        dr_[i] = bodies[i].r - targets[i];
+}
+
+} // namespace rl
+} // namespace msode
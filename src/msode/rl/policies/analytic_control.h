@@ -0,0 +1,72 @@
+// Copyright 2020 ETH Zurich. All Rights Reserved.
+#pragma once
+
+#include "interface.h"
+
+#include <msode/analytic_control/helpers.h>
+
+#include <array>
+
+namespace msode {
+namespace rl {
+
+/** A feedback policy derived from the analytic control strategy.
+
+    At the beginning of each episode, the three swimming directions of the optimal path are computed from the
+    initial positions of the bodies relative to their targets (see analytic_control::findBestPathLBFGS()).
+    At every action, the field rotates around one of these directions at a fraction of the step out frequency of
+    one body. The (direction, body) pair is kept as long as its remaining time beta (see
+    analytic_control::simulateOptimalPath()), evaluated from the current positions, keeps its sign; the pair with
+    the largest |beta| is then chosen.
+    Whenever the pair changes, the field first rotates around the new axis for one action at half the lowest
+    step out frequency, as in the reorientation windows of the analytic control: close to their step out frequency,
+    bodies that are not aligned with the rotation axis may tumble without swimming.
+
+    The velocity matrix is recomputed at reset whenever the field magnitude or the magnetic moments and propulsion
+    matrices of the bodies differ from the ones it was computed with.
+
+    Requires the "Direct" FieldFromAction (action = omega, axis).
+ */
+class PolicyAnalyticControl : public Policy
+{
+public:
+    /** \brief Construct a PolicyAnalyticControl
+        \param omegaFactor The fraction of the step out frequencies used to drive the bodies, in (0, 1].
+               Values below 1 keep the bodies away from the marginally stable synchronous motion at the step out frequency.
+     */
+    PolicyAnalyticControl(real omegaFactor = 0.99_r);
+
+    std::unique_ptr<Policy> clone() const override;
+
+    void reset(const MSodeEnvironment& env, long episodeId) override;
+    void computeAction(const MSodeEnvironment& env,
+                       const std::vector<double>& state,
+                       std::vector<double>& action) override;
+
+private:
+    /// A propulsion segment: rotation around sign * dirs_[dir] at omegas_[body]
+    struct Choice
+    {
+        int dir, body;
+        int sign; ///< +1 or -1; 0 if no segment was chosen yet in the episode
+    };
+
+    bool _isVelocityMatrixUpToDate(real magneticFieldMagnitude, const std::vector<RigidBody>& bodies) const;
+    void _computeVelocityMatrix(real magneticFieldMagnitude, const std::vector<RigidBody>& bodies);
+    void _setRelativePositions(const MSodeEnvironment& env);
+    real _computeBeta(int dir, int body) const;
+
+private:
+    const real omegaFactor_;
+    analytic_control::MatrixReal U_; ///< inverse of the velocity matrix at the frequencies omegas_
+    real cachedFieldMagnitude_ {0.0_r};  ///< field magnitude used to compute U_
+    std::vector<RigidBody> cachedBodies_; ///< bodies used to compute U_; only their magnetic moments and propulsion matter
+    std::vector<real> omegas_;       ///< driving frequencies: the step out frequencies of the bodies times omegaFactor_
+    real omegaReorient_;             ///< frequency used to align the bodies with a new axis
+    std::array<real3, 3> dirs_;      ///< swimming directions of the current episode
+    Choice previous_;                ///< the segment chosen at the previous action
+    std::vector<real3> dr_;          ///< work space: positions relative to the targets
+};
+
+} // namespace rl
+} // namespace msode
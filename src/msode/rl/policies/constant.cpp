@@ -0,0 +1,33 @@
+// Copyright 2020 ETH Zurich. All Rights Reserved.
+#include "constant.h"
+
+#include <msode/core/log.h>
+#include <msode/rl/environment.h>
+
+namespace msode {
+namespace rl {
+
+PolicyConstant::PolicyConstant(std::vector<double> action) :
+    action_(std::move(action))
+{}
+
+std::unique_ptr<Policy> PolicyConstant::clone() const
+{
+    return std::make_unique<PolicyConstant>(*this);
+}
+
+void PolicyConstant::reset(const MSodeEnvironment& env, long /* episodeId */)
+{
+    MSODE_Expect(static_cast<int>(action_.size()) == env.numActions(),
+                 "expect an action of size %d, got %zu", env.numActions(), action_.size());
+}
+
+void PolicyConstant::computeAction(const MSodeEnvironment& /* env */,
+                                   const std::vector<double>& /* state */,
+                                   std::vector<double>& action)
+{
+    action = action_;
+}
+
+} // namespace rl
+} // namespace msode
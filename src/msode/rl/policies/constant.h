@@ -0,0 +1,27 @@
+// Copyright 2020 ETH Zurich. All Rights Reserved.
+#pragma once
+
+#include "interface.h"
+
+namespace msode {
+namespace rl {
+
+/// Always perform the same action
+class PolicyConstant : public Policy
+{
+public:
+    PolicyConstant(std::vector<double> action);
+
+    std::unique_ptr<Policy> clone() const override;
+
+    void reset(const MSodeEnvironment& env, long episodeId) override;
+    void computeAction(const MSodeEnvironment& env,
+                       const std::vector<double>& state,
+                       std::vector<double>& action) override;
+
+private:
+    const std::vector<double> action_;
+};
+
+} // namespace rl
+} // namespace msode
@@ -0,0 +1,49 @@
+// Copyright 2020 ETH Zurich. All Rights Reserved.
+#include "factory.h"
+
+#include "analytic_control.h"
+#include "constant.h"
+#include "mlp.h"
+#include "random.h"
+
+#include <msode/core/log.h>
+
+namespace msode {
+namespace rl {
+namespace factory {
+
+std::unique_ptr<Policy> createPolicy(const Config& config)
+{
+    std::unique_ptr<Policy> policy;
+
+    const auto type = config.at("__type").get<std::string>();
+
+    if (type == "Random")
+    {
+        const long seed = config.contains("seed") ? config.at("seed").get<long>() : 4242L;
+        policy = std::make_unique<PolicyRandom>(seed);
+    }
+    else if (type == "Constant")
+    {
+        policy = std::make_unique<PolicyConstant>(config.at("action").get<std::vector<double>>());
+    }
+    else if (type == "AnalyticControl")
+    {
+        const real omegaFactor = config.contains("omegaFactor") ? config.at("omegaFactor").get<real>() : 0.99_r;
+        policy = std::make_unique<PolicyAnalyticControl>(omegaFactor);
+    }
+    else if (type == "MLP")
+    {
+        policy = std::make_unique<PolicyMLP>(readMLPFromFile(config.at("file").get<std::string>()));
+    }
+    else
+    {
+        msode_die("Could not generate a Policy object from type '%s'",
+                  type.c_str());
+    }
+    return policy;
+}
+
+} // namespace factory
+} // namespace rl
+} // namespace msode
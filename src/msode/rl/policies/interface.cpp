@@ -0,0 +1,39 @@
+// Copyright 2020 ETH Zurich. All Rights Reserved.
+#include "interface.h"
+
+#include <msode/core/log.h>
+
+namespace msode {
+namespace rl {
+
+Policy::Policy() = default;
+Policy::~Policy() = default;
+
+void Policy::reset(const MSodeEnvironment& /* env */, long /* episodeId */)
+{}
+
+EpisodeRunner::Policy createRunnerPolicy(const Policy& policy, int numWorkers)
+{
+    MSODE_Expect(numWorkers > 0, "expect a positive number of workers, got %d", numWorkers);
+
+    auto policies = std::make_shared<std::vector<std::unique_ptr<Policy>>>();
+
+    for (int i = 0; i < numWorkers; ++i)
+        policies->push_back(policy.clone());
+
+    return [policies](const EpisodeContext& context,
+                      const MSodeEnvironment& env,
+                      const std::vector<double>& state,
+                      std::vector<double>& action)
+    {
+        Policy& p = *(*policies)[context.workerId];
+
+        if (context.actionId == 0)
+            p.reset(env, context.episodeId);
+
+        p.computeAction(env, state, action);
+    };
+}
+
+} // namespace rl
+} // namespace msode
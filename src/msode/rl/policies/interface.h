@@ -0,0 +1,49 @@
+// Copyright 2020 ETH Zurich. All Rights Reserved.
+#pragma once
+
+#include <msode/rl/episode_runner.h>
+
+#include <memory>
+#include <vector>
+
+namespace msode {
+namespace rl {
+
+class MSodeEnvironment;
+
+/** A decision rule that maps the state of an environment to an action.
+    Used to drive environments without an external learning framework (benchmarks, evaluation).
+ */
+class Policy
+{
+public:
+    Policy();
+    virtual ~Policy();
+
+    /// \return a copy of the object, with the correct type
+    virtual std::unique_ptr<Policy> clone() const = 0;
+
+    /** \brief Prepare a new episode; called after the environment was reset and before the first action.
+        \param env The environment
+        \param episodeId Id of the episode; stochastic policies use it to seed their random generator.
+     */
+    virtual void reset(const MSodeEnvironment& env, long episodeId);
+
+    /** \brief Compute the next action
+        \param env The environment
+        \param state The current state, as given by env.getState()
+        \param action Receives the action; has the size env.numActions().
+     */
+    virtual void computeAction(const MSodeEnvironment& env,
+                               const std::vector<double>& state,
+                               std::vector<double>& action) = 0;
+};
+
+/** \brief Wrap a policy to drive an EpisodeRunner.
+    \param policy The policy; it is copied once per worker, so that it does not need to be thread safe.
+    \param numWorkers The number of worker threads of the EpisodeRunner
+ */
+EpisodeRunner::Policy createRunnerPolicy(const Policy& policy, int numWorkers);
+
+} // namespace rl
+} // namespace msode
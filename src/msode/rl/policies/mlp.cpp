@@ -0,0 +1,227 @@
+// Copyright 2020 ETH Zurich. All Rights Reserved.
+#include "mlp.h"
+
+#include <msode/core/log.h>
+#include <msode/rl/environment.h>
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+
+namespace msode {
+namespace rl {
+
+static void checkSize(long size, long expected, const char *name)
+{
+    MSODE_Expect(size == expected, "expected %ld values for '%s', got %ld", expected, name, size);
+}
+
+MLP::MLP(std::vector<Layer> layers,
+         RowVector inputShift,  RowVector inputScale,
+         RowVector outputShift, RowVector outputScale) :
+    layers_(std::move(layers)),
+    inputShift_(std::move(inputShift)),
+    inputScale_(std::move(inputScale)),
+    outputShift_(std::move(outputShift)),
+    outputScale_(std::move(outputScale))
+{
+    MSODE_Expect(!layers_.empty(), "expected at least one layer");
+
+    for (size_t l = 0; l < layers_.size(); ++l)
+    {
+        const Layer& layer = layers_[l];
+        checkSize(layer.biases.size(), layer.weights.cols(), "biases");
+
+        if (l > 0)
+            MSODE_Expect(layer.weights.rows() == layers_[l-1].weights.cols(),
+                         "layer %zu has %ld inputs but the previous layer has %ld outputs",
+                         l, static_cast<long>(layer.weights.rows()), static_cast<long>(layers_[l-1].weights.cols()));
+    }
+
+    checkSize(inputShift_.size(),  getNumInputs(),  "inputShift");
+    checkSize(inputScale_.size(),  getNumInputs(),  "inputScale");
+    checkSize(outputShift_.size(), getNumOutputs(), "outputShift");
+    checkSize(outputScale_.size(), getNumOutputs(), "outputScale");
+}
+
+int MLP::getNumInputs() const
+{
+    return static_cast<int>(layers_.front().weights.rows());
+}
+
+int MLP::getNumOutputs() const
+{
+    return static_cast<int>(layers_.back().weights.cols());
+}
+
+template <class Activations>
+static void applyActivation(MLP::Activation activation, Activations y)
+{
+    switch (activation)
+    {
+    case MLP::Activation::Linear:
+        break;
+    case MLP::Activation::SoftSign:
+        y = y / (1.0_r + y.abs());
+        break;
+    case MLP::Activation::Tanh:
+        y = y.tanh();
+        break;
+    case MLP::Activation::ReLU:
+        y = y.max(0.0_r);
+        break;
+    };
+}
+
+void MLP::forward(long batchSize, const double *inputs, double *outputs, Workspace& work) const
+{
+    using InputMatrix = Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>;
+
+    // large enough for the matrix products to be efficient, small enough for the activations to stay in cache
+    constexpr long blockSize = 256;
+
+    long maxWidth = getNumInputs();
+    for (const auto& layer : layers_)
+        maxWidth = std::max(maxWidth, static_cast<long>(layer.weights.cols()));
+
+    const long workRows = std::min(blockSize, batchSize);
+    if (work.a.rows() < workRows || work.a.cols() < maxWidth)
+    {
+        work.a.resize(workRows, maxWidth);
+        work.b.resize(workRows, maxWidth);
+    }
+
+    const int ni = getNumInputs();
+    const int no = getNumOutputs();
+
+    for (long start = 0; start < batchSize; start += blockSize)
+    {
+        const long n = std::min(blockSize, batchSize - start);
+        const Eigen::Map<const InputMatrix> in(inputs + start * ni, n, ni);
+        Eigen::Map<InputMatrix> out(outputs + start * no, n, no);
+
+        work.a.topLeftCorner(n, ni) = ((in.cast<real>().rowwise() - inputShift_).array().rowwise()
+                                       * inputScale_.array()).matrix();
+
+        Matrix *x = &work.a;
+        Matrix *y = &work.b;
+
+        for (const auto& layer : layers_)
+        {
+            const long lni = layer.weights.rows();
+            const long lno = layer.weights.cols();
+
+            auto yBlock = y->topLeftCorner(n, lno);
+            yBlock.noalias() = x->topLeftCorner(n, lni) * layer.weights;
+            yBlock.rowwise() += layer.biases;
+            applyActivation(layer.activation, yBlock.array());
+
+            std::swap(x, y);
+        }
+
+        out = ((x->topLeftCorner(n, no).array().rowwise() * outputScale_.array()).rowwise()
+               + outputShift_.array()).matrix().cast<double>();
+    }
+}
+
+
+static MLP::Activation parseActivation(const std::string& name)
+{
+    if (name == "Linear")   return MLP::Activation::Linear;
+    if (name == "SoftSign") return MLP::Activation::SoftSign;
+    if (name == "Tanh")     return MLP::Activation::Tanh;
+    if (name == "ReLU")     return MLP::Activation::ReLU;
+
+    msode_die("Unknown activation '%s'", name.c_str());
+    return MLP::Activation::Linear;
+}
+
+static MLP::RowVector readOptionalVector(const Config& config, const char *key, int n, real defaultValue)
+{
+    if (!config.contains(key))
+        return MLP::RowVector::Constant(n, defaultValue);
+
+    const auto values = config.at(key).get<std::vector<real>>();
+    return Eigen::Map<const MLP::RowVector>(values.data(), static_cast<long>(values.size()));
+}
+
+MLP readMLPFromConfig(const Config& config)
+{
+    std::vector<MLP::Layer> layers;
+
+    for (const auto& layerConfig : config.at("layers"))
+    {
+        const auto rows   = layerConfig.at("weights").get<std::vector<std::vector<real>>>();
+        const auto biases = layerConfig.at("biases").get<std::vector<real>>();
+
+        const int numOutputs = static_cast<int>(rows.size());
+        const int numInputs  = rows.empty() ? 0 : static_cast<int>(rows[0].size());
+
+        MLP::Layer layer;
+        layer.biases     = Eigen::Map<const MLP::RowVector>(biases.data(), static_cast<long>(biases.size()));
+        layer.activation = parseActivation(layerConfig.at("activation").get<std::string>());
+        layer.weights.resize(numInputs, numOutputs);
+
+        // one row per output in the file, one column per output in the layer
+        for (int o = 0; o < numOutputs; ++o)
+        {
+            checkSize(static_cast<long>(rows[o].size()), numInputs, "weights row");
+
+            for (int i = 0; i < numInputs; ++i)
+                layer.weights(i, o) = rows[o][i];
+        }
+
+        layers.push_back(std::move(layer));
+    }
+
+    MSODE_Expect(!layers.empty(), "expected at least one layer");
+
+    const int ni = static_cast<int>(layers.front().weights.rows());
+    const int no = static_cast<int>(layers.back().weights.cols());
+
+    return MLP(std::move(layers),
+               readOptionalVector(config, "inputShift",  ni, 0.0_r),
+               readOptionalVector(config, "inputScale",  ni, 1.0_r),
+               readOptionalVector(config, "outputShift", no, 0.0_r),
+               readOptionalVector(config, "outputScale", no, 1.0_r));
+}
+
+MLP readMLPFromFile(const std::string& fileName)
+{
+    std::ifstream file(fileName);
+
+    if (!file.is_open())
+        msode_die("Could not open the file '%s'", fileName.c_str());
+
+    return readMLPFromConfig(json::parse(file));
+}
+
+
+PolicyMLP::PolicyMLP(MLP mlp) :
+    mlp_(std::move(mlp))
+{}
+
+std::unique_ptr<Policy> PolicyMLP::clone() const
+{
+    return std::make_unique<PolicyMLP>(*this);
+}
+
+void PolicyMLP::reset(const MSodeEnvironment& env, long /* episodeId */)
+{
+    MSODE_Expect(mlp_.getNumInputs() == static_cast<int>(env.getState().size()),
+                 "the network has %d inputs but the state has %zu variables",
+                 mlp_.getNumInputs(), env.getState().size());
+    MSODE_Expect(mlp_.getNumOutputs() == env.numActions(),
+                 "the network has %d outputs but the environment has %d actions",
+                 mlp_.getNumOutputs(), env.numActions());
+}
+
+void PolicyMLP::computeAction(const MSodeEnvironment& /* env */,
+                              const std::vector<double>& state,
+                              std::vector<double>& action)
+{
+    mlp_.forward(1, state.data(), action.data(), work_);
+}
+
+} // namespace rl
+} // namespace msode
@@ -0,0 +1,108 @@
+// Copyright 2020 ETH Zurich. All Rights Reserved.
+#pragma once
+
+#include "interface.h"
+
+#include <msode/core/config.h>
+
+#include <Eigen/Core>
+
+#include <string>
+#include <vector>
+
+namespace msode {
+namespace rl {
+
+/** A fully connected feed forward network, evaluated on batches of inputs.
+
+    The inputs are normalized as (x - inputShift) * inputScale, and the outputs of the last layer are mapped to
+    outputShift + outputScale * y.
+    A batch is evaluated with one matrix-matrix product per layer (activations of the samples times the weights),
+    so that Eigen blocks and vectorizes the computation. Large batches go through the whole network by blocks of
+    samples, which bounds the size of the work space.
+ */
+class MLP
+{
+public:
+    enum class Activation {Linear, SoftSign, Tanh, ReLU};
+
+    using Matrix    = Eigen::Matrix<real, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>;
+    using RowVector = Eigen::Matrix<real, 1, Eigen::Dynamic>;
+
+    struct Layer
+    {
+        Matrix weights;    ///< numInputs x numOutputs
+        RowVector biases;  ///< numOutputs
+        Activation activation;
+    };
+
+    /// Buffers used by the forward pass; one per thread
+    struct Workspace
+    {
+        Matrix a, b; ///< activations of a block of samples, one sample per row
+    };
+
+    MLP(std::vector<Layer> layers,
+        RowVector inputShift,  RowVector inputScale,
+        RowVector outputShift, RowVector outputScale);
+
+    int getNumInputs()  const;
+    int getNumOutputs() const;
+
+    /** \brief Evaluate the network on a batch of inputs.
+        \param batchSize The number of samples
+        \param inputs batchSize x getNumInputs() values, sample major
+        \param outputs Receives batchSize x getNumOutputs() values, sample major
+        \param work Work space; does not allocate after the first call
+     */
+    void forward(long batchSize, const double *inputs, double *outputs, Workspace& work) const;
+
+private:
+    std::vector<Layer> layers_;
+    RowVector inputShift_, inputScale_;
+    RowVector outputShift_, outputScale_;
+};
+
+/** \brief Read a network from its json description.
+
+    The format is
+    \code
+    {
+        "inputShift":  [...], "inputScale":  [...],   (optional, default 0 and 1)
+        "outputShift": [...], "outputScale": [...],   (optional, default 0 and 1)
+        "layers": [
+            {"weights": [[...], ...], "biases": [...], "activation": "SoftSign"},
+            ...
+        ]
+    }
+    \endcode
+    where "weights" has one row per output of the layer and "activation" is one of Linear, SoftSign, Tanh and ReLU.
+ */
+MLP readMLPFromConfig(const Config& config);
+
+/// Same as readMLPFromConfig() from a json file.
+MLP readMLPFromFile(const std::string& fileName);
+
+
+/** Compute the actions with an MLP that maps the state of the environment to the action.
+    Typically the mean of a policy trained with smarties, exported with readMLPFromConfig() format.
+ */
+class PolicyMLP : public Policy
+{
+public:
+    PolicyMLP(MLP mlp);
+
+    std::unique_ptr<Policy> clone() const override;
+
+    void reset(const MSodeEnvironment& env, long episodeId) override;
+    void computeAction(const MSodeEnvironment& env,
+                       const std::vector<double>& state,
+                       std::vector<double>& action) override;
+
+private:
+    MLP mlp_;
+    MLP::Workspace work_;
+};
+
+} // namespace rl
+} // namespace msode
@@ -0,0 +1,41 @@
+// Copyright 2020 ETH Zurich. All Rights Reserved.
+#include "random.h"
+
+#include <msode/core/log.h>
+#include <msode/rl/environment.h>
+
+namespace msode {
+namespace rl {
+
+PolicyRandom::PolicyRandom(long seed) :
+    seed_(seed)
+{}
+
+std::unique_ptr<Policy> PolicyRandom::clone() const
+{
+    return std::make_unique<PolicyRandom>(*this);
+}
+
+void PolicyRandom::reset(const MSodeEnvironment& env, long episodeId)
+{
+    std::seed_seq seq {seed_, episodeId};
+    gen_.seed(seq);
+    std::tie(lo_, hi_) = env.getActionBounds();
+}
+
+void PolicyRandom::computeAction(const MSodeEnvironment& /* env */,
+                                 const std::vector<double>& /* state */,
+                                 std::vector<double>& action)
+{
+    MSODE_Expect(action.size() == lo_.size(), "expect an action of size %zu, got %zu (was reset() called?)",
+                 lo_.size(), action.size());
+
+    for (size_t i = 0; i < action.size(); ++i)
+    {
+        std::uniform_real_distribution<double> distr(lo_[i], hi_[i]);
+        action[i] = distr(gen_);
+    }
+}
+
+} // namespace rl
+} // namespace msode
@@ -0,0 +1,34 @@
+// Copyright 2020 ETH Zurich. All Rights Reserved.
+#pragma once
+
+#include "interface.h"
+
+#include <random>
+
+namespace msode {
+namespace rl {
+
+/** Draw every action uniformly within the action bounds of the environment.
+    The random generator is reseeded at every episode, so that an episode only depends on its id.
+ */
+class PolicyRandom : public Policy
+{
+public:
+    PolicyRandom(long seed);
+
+    std::unique_ptr<Policy> clone() const override;
+
+    void reset(const MSodeEnvironment& env, long episodeId) override;
+    void computeAction(const MSodeEnvironment& env,
+                       const std::vector<double>& state,
+                       std::vector<double>& action) override;
+
+private:
+    const long seed_;
+    std::mt19937 gen_;
+    std::vector<double> lo_; ///< lower action bounds
+    std::vector<double> hi_; ///< upper action bounds
+};
+
+} // namespace rl
+} // namespace msode
@@ -21,9 +21,10 @@ std::unique_ptr<EnvPosIC> EnvPosICBall::clone() const
 real3 EnvPosICBall::getLowestPosition()  const {return {-radius_, -radius_, -radius_};}
 real3 EnvPosICBall::getHighestPosition() const {return {+radius_, +radius_, +radius_};}
 
-std::vector<real3> EnvPosICBall::generateNewPositions(std::mt19937& gen, int n)
+void EnvPosICBall::fillNewPositions(std::mt19937& gen, std::vector<real3>& positions)
 {
-    return generateUniformPositions(gen, n);
+    for (auto& p : positions)
+        p = utils::generateUniformPositionBall(gen, radius_);
 }
 
 std::vector<real3> EnvPosICBall::generateUniformPositions(std::mt19937& gen, int n) const
@@ -35,12 +35,10 @@ void EnvPosICBallGrowing::update(bool successfulTry)
     }
 }
 
-std::vector<real3> EnvPosICBallGrowing::generateNewPositions(std::mt19937& gen, int n)
+void EnvPosICBallGrowing::fillNewPositions(std::mt19937& gen, std::vector<real3>& positions)
 {
-    std::vector<real3> positions(n);
     for (auto& p : positions)
         p = utils::generateUniformPositionShell(gen, targetRadius_, currentRadius_);
-    return positions;
 }
 
 } // namespace rl
@@ -14,7 +14,7 @@ public:
     std::unique_ptr<EnvPosIC> clone() const override;
 
     void update(bool successfulTry) override;
-    std::vector<real3> generateNewPositions(std::mt19937& gen, int n) override;
+    void fillNewPositions(std::mt19937& gen, std::vector<real3>& positions) override;
 
     real getCurrentRadius() const {return currentRadius_;}
 
@@ -20,13 +20,14 @@ std::unique_ptr<EnvPosIC> EnvPosICBallLine::clone() const
     return std::make_unique<EnvPosICBallLine>(*this);
 }
 
-std::vector<real3> EnvPosICBallLine::generateNewPositions(std::mt19937& gen, int n)
+void EnvPosICBallLine::fillNewPositions(std::mt19937& gen, std::vector<real3>& positions)
 {
     std::uniform_real_distribution<real> U(0.0_r, 1.0_r);
 
     if (U(gen) < probLine_)
-        return _generateLines(gen, n);
-    return generateUniformPositions(gen, n);
+        _generateLines(gen, positions);
+    else
+        EnvPosICBall::fillNewPositions(gen, positions);
 }
 
 
@@ -41,18 +42,14 @@ static inline real3 makeRandomUnitVector(std::mt19937& gen)
              std::cos(phi)};
 }
 
-std::vector<real3> EnvPosICBallLine::_generateLines(std::mt19937& gen, int n) const
+void EnvPosICBallLine::_generateLines(std::mt19937& gen, std::vector<real3>& positions) const
 {
-    std::vector<real3> positions(n);
-
     std::uniform_real_distribution<real> Udistance(-radius_, radius_);
 
     const real3 direction = makeRandomUnitVector(gen);
 
     for (auto& p : positions)
         p = Udistance(gen) * direction;
-
-    return positions;
 }
 
 } // namespace rl
@@ -13,10 +13,10 @@ public:
 
     std::unique_ptr<EnvPosIC> clone() const override;
 
-    std::vector<real3> generateNewPositions(std::mt19937& gen, int n) override;
+    void fillNewPositions(std::mt19937& gen, std::vector<real3>& positions) override;
 
 private:
-    std::vector<real3> _generateLines(std::mt19937& gen, int n) const;
+    void _generateLines(std::mt19937& gen, std::vector<real3>& positions) const;
 
 protected:
     const real probLine_; ///< the probability to select all swimmers on a random line
@@ -4,6 +4,8 @@
 #include <msode/core/math.h>
 #include <msode/utils/rnd.h>
 
+#include <algorithm>
+
 namespace msode {
 namespace rl {
 
@@ -46,8 +48,9 @@ void EnvPosICBallRandomWalk::update(bool successfulTry)
     }
 }
 
-std::vector<real3> EnvPosICBallRandomWalk::generateNewPositions(std::mt19937& gen, int n)
+void EnvPosICBallRandomWalk::fillNewPositions(std::mt19937& gen, std::vector<real3>& positions)
 {
+    const int n = positions.size();
     _setPositionsIfNotUnitialized(gen, n);
 
     if (needUpdate_)
@@ -56,7 +59,7 @@ std::vector<real3> EnvPosICBallRandomWalk::generateNewPositions(std::mt19937& ge
             previousPositions_[i] = _generateOnePositionMC(gen, previousPositions_[i]);
     }
 
-    return previousPositions_;
+    std::copy(previousPositions_.begin(), previousPositions_.end(), positions.begin());
 }
 
 void EnvPosICBallRandomWalk::_setPositionsIfNotUnitialized(std::mt19937& gen, int n)
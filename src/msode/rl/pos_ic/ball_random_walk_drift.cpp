@@ -4,6 +4,8 @@
 #include <msode/core/math.h>
 #include <msode/utils/rnd.h>
 
+#include <algorithm>
+
 namespace msode {
 namespace rl {
 
@@ -26,8 +28,9 @@ std::unique_ptr<EnvPosIC> EnvPosICBallRandomWalkDrift::clone() const
     return std::make_unique<EnvPosICBallRandomWalkDrift>(*this);
 }
 
-std::vector<real3> EnvPosICBallRandomWalkDrift::generateNewPositions(std::mt19937& gen, int n)
+void EnvPosICBallRandomWalkDrift::fillNewPositions(std::mt19937& gen, std::vector<real3>& positions)
 {
+    const int n = positions.size();
     _setPositionsIfNotUnitialized(gen, n);
 
     if (needUpdate_)
@@ -36,7 +39,7 @@ std::vector<real3> EnvPosICBallRandomWalkDrift::generateNewPositions(std::mt1993
             previousPositions_[i] = _generateOnePositionMC(gen, _applyInverseDrift(previousPositions_[i]));
     }
 
-    return previousPositions_;
+    std::copy(previousPositions_.begin(), previousPositions_.end(), positions.begin());
 }
 
 real3 EnvPosICBallRandomWalkDrift::_applyInverseDrift(real3 r) const
@@ -24,7 +24,7 @@ public:
 
     std::unique_ptr<EnvPosIC> clone() const override;
 
-    std::vector<real3> generateNewPositions(std::mt19937& gen, int n) override;
+    void fillNewPositions(std::mt19937& gen, std::vector<real3>& positions) override;
 
 private:
     real3 _applyInverseDrift(real3 r) const;
@@ -20,9 +20,10 @@ std::unique_ptr<EnvPosIC> EnvPosICBox::clone() const
 real3 EnvPosICBox::getLowestPosition()  const {return domain_.lo;}
 real3 EnvPosICBox::getHighestPosition() const {return domain_.hi;}
 
-std::vector<real3> EnvPosICBox::generateNewPositions(std::mt19937& gen, int n)
+void EnvPosICBox::fillNewPositions(std::mt19937& gen, std::vector<real3>& positions)
 {
-    return generateUniformPositions(gen, n);
+    for (auto& p : positions)
+        p = utils::generateUniformPositionBox(gen, domain_.lo, domain_.hi);
 }
 
 std::vector<real3> EnvPosICBox::generateUniformPositions(std::mt19937& gen, int n) const
@@ -3,6 +3,8 @@
 
 #include <msode/core/math.h>
 
+#include <algorithm>
+
 namespace msode {
 namespace rl {
 
@@ -41,13 +43,13 @@ real3 EnvPosICConst::getHighestPosition() const
     return rmax;
 }
 
-std::vector<real3> EnvPosICConst::generateNewPositions(std::mt19937& /* gen */, int n)
+void EnvPosICConst::fillNewPositions(std::mt19937& /* gen */, std::vector<real3>& positions)
 {
-    MSODE_Expect(n == static_cast<int>(positions_.size()),
-                 "incompatible number of positions (required %d, have %zu",
-                 n, positions_.size());
+    MSODE_Expect(positions.size() == positions_.size(),
+                 "incompatible number of positions (required %zu, have %zu",
+                 positions.size(), positions_.size());
 
-    return positions_;
+    std::copy(positions_.begin(), positions_.end(), positions.begin());
 }
 
 std::vector<real3> EnvPosICConst::generateUniformPositions(std::mt19937& /* gen */, int n) const
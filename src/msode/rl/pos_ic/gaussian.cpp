@@ -54,9 +54,14 @@ real3 EnvPosICGaussian::getHighestPosition() const
     return rmax;
 }
 
-std::vector<real3> EnvPosICGaussian::generateNewPositions(std::mt19937& gen, int n)
+void EnvPosICGaussian::fillNewPositions(std::mt19937& gen, std::vector<real3>& positions)
 {
-    return generateUniformPositions(gen, n);
+    MSODE_Expect(positions.size() == positions_.size(),
+                 "incompatible number of positions (required %zu, have %zu",
+                 positions.size(), positions_.size());
+
+    for (size_t i = 0; i < positions.size(); ++i)
+        positions[i] = positions_[i] + _randomDisplacement(gen);
 }
 
 std::vector<real3> EnvPosICGaussian::generateUniformPositions(std::mt19937& gen, int n) const
@@ -21,7 +21,7 @@ public:
     real3 getLowestPosition()  const override;
     real3 getHighestPosition() const override;
 
-    std::vector<real3> generateNewPositions(std::mt19937& gen, int n) override;
+    void fillNewPositions(std::mt19937& gen, std::vector<real3>& positions) override;
     std::vector<real3> generateUniformPositions(std::mt19937& gen, int n) const override;
 
 private:
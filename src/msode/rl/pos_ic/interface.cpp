@@ -13,5 +13,12 @@ EnvPosIC::~EnvPosIC() = default;
 void EnvPosIC::update(bool /* successfulTry */)
 {}
 
+std::vector<real3> EnvPosIC::generateNewPositions(std::mt19937& gen, int n)
+{
+    std::vector<real3> positions(n);
+    fillNewPositions(gen, positions);
+    return positions;
+}
+
 } // namespace rl
 } // namespace msode
@@ -34,7 +34,16 @@ public:
         \param n Number of positions to generate; must be alwasy the same between two calls
         \return \p n positions in the space
      */
-    virtual std::vector<real3> generateNewPositions(std::mt19937& gen, int n) = 0;
+    std::vector<real3> generateNewPositions(std::mt19937& gen, int n);
+
+    /** \brief generate new positions in the current space into a caller-owned buffer
+        \param gen rng
+        \param positions Overwritten with the new positions. Its size is the number of positions to generate;
+                         must be always the same between two calls.
+
+        Same as generateNewPositions() but does not allocate memory.
+     */
+    virtual void fillNewPositions(std::mt19937& gen, std::vector<real3>& positions) = 0;
 
     /** \brief generate positions uniformly in the whole spanned space
         \param gen rng
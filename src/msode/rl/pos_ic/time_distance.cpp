@@ -1,6 +1,8 @@
 // Copyright 2020 ETH Zurich. All Rights Reserved.
 #include "time_distance.h"
 
+#include <algorithm>
+
 namespace msode {
 namespace rl {
 
@@ -48,11 +50,16 @@ static int randomSign(std::mt19937& gen)
     return 2 * x - 1;
 }
 
-static std::vector<real> genPositions1D(std::mt19937& gen, real travelTime, const msode::analytic_control::MatrixReal& V)
+/** Generate one component of the positions of all bodies with the given travel time along that direction.
+    \param betas Work space; does not allocate once it has the correct size
+    \param component The component of the positions to set, e.g. &real3::x
+ */
+static void genPositions1D(std::mt19937& gen, real travelTime, const msode::analytic_control::MatrixReal& V,
+                           std::vector<real>& betas, std::vector<real3>& positions, real real3::*component)
 {
     std::exponential_distribution<real> d(1.0_r);
     const int n = V.cols();
-    std::vector<real> betas(n), x(n, 0.0_r);
+    betas.resize(n);
 
     real betas1 {0.0_r};
 
@@ -66,24 +73,29 @@ static std::vector<real> genPositions1D(std::mt19937& gen, real travelTime, cons
         b *= travelTime / betas1;
 
     for (int i = 0; i < n; ++i)
+    {
+        real x {0.0_r};
         for (int j = 0; j < n; ++j)
-            x[i] += V(i,j) * betas[j];
-
-    return x;
+            x += V(i,j) * betas[j];
+        positions[i].*component = x;
+    }
 }
 
-std::vector<real3> EnvPosICTimeDistance::generateNewPositions(std::mt19937& gen, int n)
+void EnvPosICTimeDistance::fillNewPositions(std::mt19937& gen, std::vector<real3>& positions)
 {
-    return _generatePositions(gen, n, travelTime_);
+    _generatePositions(gen, travelTime_, positions);
 }
 
 std::vector<real3> EnvPosICTimeDistance::generateUniformPositions(std::mt19937& gen, int n) const
 {
-    return _generatePositions(gen, n, travelTime_);
+    std::vector<real3> positions(n);
+    _generatePositions(gen, travelTime_, positions);
+    return positions;
 }
 
-std::vector<real3> EnvPosICTimeDistance::_generatePositions(std::mt19937& gen, int n, real travelTime) const
+void EnvPosICTimeDistance::_generatePositions(std::mt19937& gen, real travelTime, std::vector<real3>& positions) const
 {
+    const int n = static_cast<int>(positions.size());
     MSODE_Expect(n == V_.cols(), "Mismatch in velocity matrix dimensions. Got n=%d instead of %ld.", n, V_.cols());
 
     if (ball_)
@@ -93,18 +105,10 @@ std::vector<real3> EnvPosICTimeDistance::_generatePositions(std::mt19937& gen, i
     }
 
     const real3 T = generateTravelTimes(gen, travelTime);
-    std::vector<real3> positions(n);
-
-    const auto x = genPositions1D(gen, T.x, V_);
-    const auto y = genPositions1D(gen, T.y, V_);
-    const auto z = genPositions1D(gen, T.z, V_);
-
-    for (size_t i = 0; i < static_cast<size_t>(n); ++i)
-    {
-        positions[i] = make_real3(x[i], y[i], z[i]);
-    }
 
-    return positions;
+    genPositions1D(gen, T.x, V_, betas_, positions, &real3::x);
+    genPositions1D(gen, T.y, V_, betas_, positions, &real3::y);
+    genPositions1D(gen, T.z, V_, betas_, positions, &real3::z);
 }
 
 } // namespace rl
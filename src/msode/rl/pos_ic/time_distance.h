@@ -20,16 +20,18 @@ public:
     real3 getLowestPosition()  const override;
     real3 getHighestPosition() const override;
 
-    std::vector<real3> generateNewPositions(std::mt19937& gen, int n) override;
+    void fillNewPositions(std::mt19937& gen, std::vector<real3>& positions) override;
     std::vector<real3> generateUniformPositions(std::mt19937& gen, int n) const override;
 
 protected:
-    std::vector<real3> _generatePositions(std::mt19937& gen, int n, real travelTime) const;
+    /// fill \p positions with new positions at the given travel time; does not allocate
+    void _generatePositions(std::mt19937& gen, real travelTime, std::vector<real3>& positions) const;
 
 protected:
     bool ball_; ///< if true, will generate random travel times up to travelTime_; otherwise will be exactly travelTime_.
     real travelTime_;
     msode::analytic_control::MatrixReal V_; ///< velocity matrix
+    mutable std::vector<real> betas_;       ///< work space of _generatePositions()
 };
 
 } // namespace rl
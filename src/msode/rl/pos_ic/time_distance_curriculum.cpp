@@ -44,7 +44,9 @@ void EnvPosICTimeDistanceCurriculum::update(bool successfulTry)
 
 std::vector<real3> EnvPosICTimeDistanceCurriculum::generateUniformPositions(std::mt19937& gen, int n) const
 {
-    return _generatePositions(gen, n, maxTravelTime_);
+    std::vector<real3> positions(n);
+    _generatePositions(gen, maxTravelTime_, positions);
+    return positions;
 }
 
 } // namespace rl
@@ -0,0 +1,118 @@
+// Copyright 2020 ETH Zurich. All Rights Reserved.
+#include "sweep.h"
+#include "factory.h"
+
+#include <msode/analytic_control/apply_strategy.h>
+#include <msode/analytic_control/helpers.h>
+#include <msode/core/factory.h>
+#include <msode/core/velocity_field/factory.h>
+#include <msode/utils/thread_pool.h>
+
+#include <memory>
+
+namespace msode {
+namespace rl {
+
+static std::vector<real3> extractPositions(const std::vector<RigidBody>& bodies)
+{
+    std::vector<real3> positions;
+    positions.reserve(bodies.size());
+
+    for (const auto& b : bodies)
+        positions.push_back(b.r);
+
+    return positions;
+}
+
+std::vector<SweepResult> runSweep(const Config& baseConfig, const ParameterGrid& grid, long numEpisodes,
+                                  const Policy& policy, bool runAC, int numThreads, long seed)
+{
+    const long numVariants = grid.getNumVariants();
+
+    std::vector<Config> configs;
+    configs.reserve(numVariants);
+
+    for (long variantId = 0; variantId < numVariants; ++variantId)
+    {
+        configs.push_back(grid.createVariant(baseConfig, variantId));
+        configs.back()["dumpEvery"] = 0;
+    }
+
+    utils::ThreadPool pool(numThreads);
+    const int nthreads = pool.getNumThreads();
+
+    // velocity matrices used by the analytic control, one per variant
+    std::vector<analytic_control::MatrixReal> Us(numVariants);
+
+    if (runAC)
+    {
+        pool.run(numVariants, [&](long variantId, int)
+        {
+            const Config& config = configs[variantId];
+            const auto bodies = msode::factory::readBodiesArray(config.at("bodies"));
+            const auto V = analytic_control::createVelocityMatrix(config.at("fieldMagnitude").get<real>(), bodies);
+            Us[variantId] = V.inverse();
+        });
+    }
+
+    // the environments and policies are created on demand, one per worker and variant
+    std::vector<std::vector<std::unique_ptr<MSodeEnvironment>>> envs(nthreads);
+    std::vector<std::vector<std::unique_ptr<Policy>>> policies(nthreads);
+
+    for (int i = 0; i < nthreads; ++i)
+    {
+        envs[i].resize(numVariants);
+        policies[i].resize(numVariants);
+    }
+
+    std::vector<std::vector<double>> actions(nthreads);
+    std::vector<std::vector<RigidBody>> initialBodies(nthreads);
+
+    std::vector<SweepResult> results(numVariants * numEpisodes);
+
+    // tasks are numbered variant major: each worker starts with a contiguous range and reuses its environments
+    pool.run(numVariants * numEpisodes, [&](long taskId, int workerId)
+    {
+        const long variantId = taskId / numEpisodes;
+        const long episodeId = taskId % numEpisodes;
+        const Config& config = configs[variantId];
+
+        auto& env = envs[workerId][variantId];
+        if (!env)
+            env = factory::createEnvironment(config, ConfPointer(""));
+
+        auto& variantPolicy = policies[workerId][variantId];
+        if (!variantPolicy)
+            variantPolicy = policy.clone();
+
+        // keep the initial conditions of the episode for the analytic control
+        auto episodePolicy = [&](const EpisodeContext& context, const MSodeEnvironment& e,
+                                 const std::vector<double>& state, std::vector<double>& action)
+        {
+            if (context.actionId == 0)
+            {
+                initialBodies[workerId] = e.getBodies();
+                variantPolicy->reset(e, context.episodeId);
+            }
+            variantPolicy->computeAction(e, state, action);
+        };
+
+        SweepResult& r = results[taskId];
+        r.rl = runEpisode(*env, seed, episodeId, workerId, episodePolicy, actions[workerId]);
+
+        if (runAC)
+        {
+            const auto& bodies = initialBodies[workerId];
+            auto velocityField = msode::factory::createVelocityField(config, ConfPointer("/velocityField"));
+            const int noDump = 0;
+            r.timeAC = analytic_control::simulateOptimalPath(config.at("fieldMagnitude").get<real>(), bodies,
+                                                             extractPositions(bodies), std::move(velocityField),
+                                                             Us[variantId], "", noDump);
+        }
+    });
+
+    return results;
+}
+
+} // namespace rl
+} // namespace msode
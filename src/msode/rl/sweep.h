@@ -0,0 +1,44 @@
+// Copyright 2020 ETH Zurich. All Rights Reserved.
+#pragma once
+
+#include "episode_runner.h"
+#include "policies/interface.h"
+
+#include <msode/core/config.h>
+#include <msode/core/parameter_grid.h>
+
+#include <vector>
+
+namespace msode {
+namespace rl {
+
+/// Result of one (variant, episode) task of a sweep
+struct SweepResult
+{
+    EpisodeResult rl;
+    real timeAC {0.0_r}; ///< travel time of the analytic control from the same initial conditions; 0 if not computed
+};
+
+/** \brief Evaluate a policy on a grid of variants of an environment config.
+
+    The variants are built in memory and all (variant x episode) tasks are scheduled on a single thread pool.
+    Each worker creates its environments and its copies of the policy on demand, one per variant, so that no state
+    computed by the policy at reset (e.g. the velocity matrix of PolicyAnalyticControl) leaks across variants.
+    Episodes are seeded as in EpisodeRunner: for deterministic policies, the results are the same as running every
+    variant separately, independently of the number of threads.
+    No trajectories are written.
+
+    \param baseConfig The environment config (see factory::createEnvironment())
+    \param grid The parameters to vary
+    \param numEpisodes The number of episodes per variant
+    \param policy The decision rule; copied with Policy::clone()
+    \param runAC If true, also compute the travel time of the analytic control from the initial conditions of each episode
+    \param numThreads The number of worker threads. Non positive values select the number of hardware threads.
+    \param seed Base seed of the per-episode random generators
+    \return The results, variant major: the result of episode e of variant v is at index v * numEpisodes + e
+ */
+std::vector<SweepResult> runSweep(const Config& baseConfig, const ParameterGrid& grid, long numEpisodes,
+                                  const Policy& policy, bool runAC, int numThreads, long seed);
+
+} // namespace rl
+} // namespace msode
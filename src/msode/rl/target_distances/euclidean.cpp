@@ -8,7 +8,7 @@ real TargetDistanceEuclidean::compute(const std::vector<RigidBody>& bodies) cons
 {
     real d {0.0_r};
 
-    for (auto b : bodies)
+    for (const auto& b : bodies)
         d += dot(b.r, b.r);
 
     return std::sqrt(d);
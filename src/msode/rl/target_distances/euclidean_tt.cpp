@@ -10,16 +10,6 @@ TargetDistanceEuclideanTT::TargetDistanceEuclideanTT(real magneticFieldMagnitude
     magneticFieldMagnitude_(magneticFieldMagnitude)
 {}
 
-static inline std::vector<real3> getPositions(const std::vector<RigidBody>& bodies)
-{
-    std::vector<real3> positions;
-    for (auto b : bodies)
-        positions.push_back(b.r);
-    return positions;
-}
-
-
-
 real TargetDistanceEuclideanTT::compute(const std::vector<RigidBody>& bodies) const
 {
     if (!initialized_)
@@ -29,11 +19,12 @@ real TargetDistanceEuclideanTT::compute(const std::vector<RigidBody>& bodies) co
         initialized_ = true;
     }
 
-    const auto A = msode::analytic_control::computeA(U_, getPositions(bodies));
+    getPositions(bodies, positions_);
+    msode::analytic_control::computeA(U_, positions_, A_);
 
     real sum {0.0_r};
 
-    for (auto a : A)
+    for (const auto& a : A_)
         sum += dot(a, a);
 
     return std::sqrt(sum);
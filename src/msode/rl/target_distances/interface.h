@@ -24,5 +24,14 @@ public:
     virtual real compute(const std::vector<RigidBody>& bodies) const = 0;
 };
 
+/// copy the positions of the bodies into \p positions; does not allocate if its capacity is large enough.
+inline void getPositions(const std::vector<RigidBody>& bodies, std::vector<real3>& positions)
+{
+    positions.resize(bodies.size());
+
+    for (size_t i = 0; i < bodies.size(); ++i)
+        positions[i] = bodies[i].r;
+}
+
 } // namespace rl
 } // namespace msode
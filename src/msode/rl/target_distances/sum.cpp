@@ -8,7 +8,7 @@ real TargetDistanceSum::compute(const std::vector<RigidBody>& bodies) const
 {
     real d {0.0_r};
 
-    for (auto b : bodies)
+    for (const auto& b : bodies)
         d += length(b.r);
 
     return d;
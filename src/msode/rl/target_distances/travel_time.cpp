@@ -10,14 +10,6 @@ TargetDistanceTravelTime::TargetDistanceTravelTime(real magneticFieldMagnitude)
     magneticFieldMagnitude_(magneticFieldMagnitude)
 {}
 
-static inline std::vector<real3> getPositions(const std::vector<RigidBody>& bodies)
-{
-    std::vector<real3> positions;
-    for (auto b : bodies)
-        positions.push_back(b.r);
-    return positions;
-}
-
 real TargetDistanceTravelTime::compute(const std::vector<RigidBody>& bodies) const
 {
     if (!initialized_)
@@ -27,9 +19,10 @@ real TargetDistanceTravelTime::compute(const std::vector<RigidBody>& bodies) con
         initialized_ = true;
     }
 
-    const auto A = analytic_control::computeA(U_, getPositions(bodies));
-    const auto q = analytic_control::findBestPathCMAES(A);
-    const real travelTime = analytic_control::computeTravelTime(A, q);
+    getPositions(bodies, positions_);
+    analytic_control::computeA(U_, positions_, A_);
+    const auto q = analytic_control::findBestPathCMAES(A_);
+    const real travelTime = analytic_control::computeTravelTime(A_, q);
 
     return travelTime;
 }
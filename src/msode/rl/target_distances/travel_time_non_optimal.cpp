@@ -10,14 +10,6 @@ TargetDistanceTravelTimeNonOptimal::TargetDistanceTravelTimeNonOptimal(real magn
     magneticFieldMagnitude_(magneticFieldMagnitude)
 {}
 
-static inline std::vector<real3> getPositions(const std::vector<RigidBody>& bodies)
-{
-    std::vector<real3> positions;
-    for (auto b : bodies)
-        positions.push_back(b.r);
-    return positions;
-}
-
 real TargetDistanceTravelTimeNonOptimal::compute(const std::vector<RigidBody>& bodies) const
 {
     if (!initialized_)
@@ -27,8 +19,9 @@ real TargetDistanceTravelTimeNonOptimal::compute(const std::vector<RigidBody>& b
         initialized_ = true;
     }
 
-    auto A = msode::analytic_control::computeA(U_, getPositions(bodies));
-    const real travelTime = msode::analytic_control::computeTravelTime(A, q_);
+    getPositions(bodies, positions_);
+    msode::analytic_control::computeA(U_, positions_, A_);
+    const real travelTime = msode::analytic_control::computeTravelTime(A_, q_);
     return travelTime;
 }
 
@@ -24,6 +24,8 @@ private:
 
     mutable bool initialized_ {false};
     mutable msode::analytic_control::MatrixReal U_; ///< inverse of the velocity matrix
+    mutable std::vector<real3> positions_; ///< work space: positions of the bodies
+    mutable std::vector<real3> A_;         ///< work space: see analytic_control::computeA()
     Quaternion q_{Quaternion::createIdentity()}; ///< orientation used to compute the travel time
 };
 
@@ -11,14 +11,6 @@ TargetDistanceTravelTimeOrdered::TargetDistanceTravelTimeOrdered(real magneticFi
     scales_(scales)
 {}
 
-static inline std::vector<real3> getPositions(const std::vector<RigidBody>& bodies)
-{
-    std::vector<real3> positions;
-    for (auto b : bodies)
-        positions.push_back(b.r);
-    return positions;
-}
-
 real TargetDistanceTravelTimeOrdered::compute(const std::vector<RigidBody>& bodies) const
 {
     if (!initialized_)
@@ -28,10 +20,11 @@ real TargetDistanceTravelTimeOrdered::compute(const std::vector<RigidBody>& bodi
         initialized_ = true;
     }
 
-    auto A = msode::analytic_control::computeA(U_, getPositions(bodies));
+    getPositions(bodies, positions_);
+    msode::analytic_control::computeA(U_, positions_, A_);
 
     real tt {0.0_r};
-    for (const auto& a : A)
+    for (const auto& a : A_)
     {
         tt +=
             scales_.x * std::abs(a.x) +
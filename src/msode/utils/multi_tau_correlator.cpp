@@ -0,0 +1,163 @@
+// Copyright 2020 ETH Zurich. All Rights Reserved.
+#include "multi_tau_correlator.h"
+
+#include <msode/core/binary_io.h>
+#include <msode/core/log.h>
+#include <msode/core/math.h>
+
+#include <algorithm>
+
+namespace msode {
+namespace utils {
+
+MultiTauCorrelator::MultiTauCorrelator(Kind kind, int numLevels, int pointsPerLevel, int averaging) :
+    kind_(kind),
+    numLevels_(numLevels),
+    p_(pointsPerLevel),
+    m_(averaging)
+{
+    MSODE_Expect(numLevels_ > 0, "expect a positive number of levels, got %d", numLevels_);
+    MSODE_Expect(m_ > 1, "expect an averaging of at least 2, got %d", m_);
+    MSODE_Expect(p_ > 0 && p_ % m_ == 0,
+                 "expect a number of points per level multiple of the averaging %d, got %d", m_, p_);
+
+    const Vector zero {0.0, 0.0, 0.0};
+    history_       .assign(numLevels_ * p_, zero);
+    numInserted_   .assign(numLevels_, 0);
+    accumulators_  .assign(numLevels_, zero);
+    numAccumulated_.assign(numLevels_, 0);
+    sums_          .assign(numLevels_ * p_, 0.0);
+    counts_        .assign(numLevels_ * p_, 0);
+}
+
+void MultiTauCorrelator::add(Vector x)
+{
+    ++count_;
+    _add(x, 0);
+}
+
+long MultiTauCorrelator::getCount() const
+{
+    return count_;
+}
+
+void MultiTauCorrelator::_add(const Vector& x, int level)
+{
+    Vector *history = history_.data() + level * p_;
+    double *sums = sums_.data() + level * p_;
+    long *counts = counts_.data() + level * p_;
+
+    std::copy_backward(history, history + p_ - 1, history + p_);
+    history[0] = x;
+    ++numInserted_[level];
+
+    // the lags below p/m are already covered by the finer level
+    const int jStart = level == 0 ? 0 : p_ / m_;
+    const int jEnd = static_cast<int>(std::min(static_cast<long>(p_), numInserted_[level]));
+
+    for (int j = jStart; j < jEnd; ++j)
+    {
+        const Vector& xOld = history[j];
+
+        if (kind_ == Kind::Correlation)
+        {
+            sums[j] += dot(x, xOld);
+        }
+        else
+        {
+            const Vector dx = x - xOld;
+            sums[j] += dot(dx, dx);
+        }
+        ++counts[j];
+    }
+
+    if (level + 1 < numLevels_)
+    {
+        accumulators_[level] += x;
+
+        if (++numAccumulated_[level] == m_)
+        {
+            const Vector mean = (1.0 / m_) * accumulators_[level];
+            accumulators_[level] = {0.0, 0.0, 0.0};
+            numAccumulated_[level] = 0;
+            _add(mean, level + 1);
+        }
+    }
+}
+
+std::vector<long> MultiTauCorrelator::getLags() const
+{
+    std::vector<long> lags;
+    long stride = 1;
+
+    for (int level = 0; level < numLevels_; ++level, stride *= m_)
+    {
+        const int jStart = level == 0 ? 0 : p_ / m_;
+
+        for (int j = jStart; j < p_; ++j)
+            if (counts_[level * p_ + j] > 0)
+                lags.push_back(j * stride);
+    }
+    return lags;
+}
+
+std::vector<double> MultiTauCorrelator::getValues() const
+{
+    std::vector<double> values;
+
+    for (int level = 0; level < numLevels_; ++level)
+    {
+        const int jStart = level == 0 ? 0 : p_ / m_;
+
+        for (int j = jStart; j < p_; ++j)
+        {
+            const long n = counts_[level * p_ + j];
+            if (n > 0)
+                values.push_back(sums_[level * p_ + j] / n);
+        }
+    }
+    return values;
+}
+
+void MultiTauCorrelator::saveState(std::ostream& stream) const
+{
+    binary_io::write(stream, static_cast<int>(kind_));
+    binary_io::write(stream, numLevels_);
+    binary_io::write(stream, p_);
+    binary_io::write(stream, m_);
+
+    binary_io::write(stream, count_);
+    binary_io::write(stream, history_);
+    binary_io::write(stream, numInserted_);
+    binary_io::write(stream, accumulators_);
+    binary_io::write(stream, numAccumulated_);
+    binary_io::write(stream, sums_);
+    binary_io::write(stream, counts_);
+}
+
+void MultiTauCorrelator::loadState(std::istream& stream)
+{
+    int kind {0}, numLevels {0}, p {0}, m {0};
+    binary_io::read(stream, kind);
+    binary_io::read(stream, numLevels);
+    binary_io::read(stream, p);
+    binary_io::read(stream, m);
+
+    if (!stream || kind != static_cast<int>(kind_) || numLevels != numLevels_ || p != p_ || m != m_)
+        msode_die("The state does not match the parameters of the correlator");
+
+    binary_io::read(stream, count_);
+    const bool sameSizes =
+        binary_io::readSameSize(stream, history_) &&
+        binary_io::readSameSize(stream, numInserted_) &&
+        binary_io::readSameSize(stream, accumulators_) &&
+        binary_io::readSameSize(stream, numAccumulated_) &&
+        binary_io::readSameSize(stream, sums_) &&
+        binary_io::readSameSize(stream, counts_);
+
+    if (!sameSizes || !stream)
+        msode_die("Could not read the state of the correlator");
+}
+
+} // namespace utils
+} // namespace msode
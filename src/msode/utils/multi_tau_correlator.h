@@ -0,0 +1,79 @@
+// Copyright 2020 ETH Zurich. All Rights Reserved.
+#pragma once
+
+#include <msode/core/types.h>
+
+#include <istream>
+#include <ostream>
+#include <vector>
+
+namespace msode {
+namespace utils {
+
+/** Streaming time correlation of a vector signal sampled at regular intervals (multi-tau correlator,
+    Ramirez et al., J. Chem. Phys. 133, 154103, 2010).
+
+    The lags are spaced linearly within each level and geometrically across levels: level 0 holds the lags
+    0, 1, ..., p-1 samples; level l > 0 holds the lags j * m^l for j = p/m, ..., p-1, computed from the signal averaged
+    over blocks of m^l samples. The memory and the cost per sample are independent of the length of the signal,
+    and the longest lag grows exponentially with the number of levels.
+ */
+class MultiTauCorrelator
+{
+public:
+    using Vector = Vector3<double>;
+
+    enum class Kind
+    {
+        Correlation,            ///< < x(t) . x(t+tau) >
+        MeanSquaredDisplacement ///< < |x(t+tau) - x(t)|^2 >
+    };
+
+    /** \brief Construct a MultiTauCorrelator
+        \param kind The correlation to compute
+        \param numLevels The number of levels
+        \param pointsPerLevel The number of lags p per level; must be a multiple of \p averaging
+        \param averaging The number of samples m averaged from one level to the next
+     */
+    MultiTauCorrelator(Kind kind, int numLevels = 16, int pointsPerLevel = 16, int averaging = 2);
+
+    /// add the next sample of the signal; does not allocate memory
+    void add(Vector x);
+
+    /// \return The number of samples added so far
+    long getCount() const;
+
+    /// \return The lags, in number of samples, at which the correlation has been estimated so far, in increasing order
+    std::vector<long> getLags() const;
+
+    /// \return The estimates of the correlation at the lags returned by getLags()
+    std::vector<double> getValues() const;
+
+    /// write the internal state in binary (see BaseObserver::saveState())
+    void saveState(std::ostream& stream) const;
+
+    /** \brief Restore a state written by saveState().
+        This method will fail if the state was written by a correlator with other parameters. Does not allocate memory.
+     */
+    void loadState(std::istream& stream);
+
+private:
+    void _add(const Vector& x, int level);
+
+private:
+    const Kind kind_;
+    const int numLevels_;
+    const int p_;
+    const int m_;
+
+    long count_ {0};
+    std::vector<Vector> history_;      ///< the last p samples of each level, most recent first (numLevels x p)
+    std::vector<long> numInserted_;    ///< number of samples inserted in each level
+    std::vector<Vector> accumulators_; ///< sum of the samples waiting to be averaged into the next level
+    std::vector<int> numAccumulated_;
+    std::vector<double> sums_;         ///< sum of the products for each lag (numLevels x p)
+    std::vector<long> counts_;         ///< number of products for each lag (numLevels x p)
+};
+
+} // namespace utils
+} // namespace msode
@@ -0,0 +1,323 @@
+// Copyright 2020 ETH Zurich. All Rights Reserved.
+#include "observers.h"
+
+#include <msode/core/binary_io.h>
+#include <msode/core/dynamics.h>
+#include <msode/core/log.h>
+#include <msode/core/math.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace msode {
+namespace utils {
+
+namespace quantities {
+
+/** The observers are called before the step: RigidBody::v still holds the velocity of the previous step (or of the
+    last RK4 stage). Evaluate the velocity of the current state instead.
+ */
+static inline real3 currentVelocity(const Simulation& sim, int bodyId)
+{
+    const real t = sim.getCurrentTime();
+    real3 v, omega;
+    std::tie(v, omega) = computeVelocities(sim.getBodies()[bodyId], sim.getField()(t), sim.getVelocityField(), t);
+    return v;
+}
+
+ScalarQuantity speed()
+{
+    return [](const Simulation& sim, int bodyId)
+    {
+        return length(currentVelocity(sim, bodyId));
+    };
+}
+
+ScalarQuantity velocityAlong(real3 direction)
+{
+    const real3 u = normalized(direction);
+    return [u](const Simulation& sim, int bodyId)
+    {
+        return dot(u, currentVelocity(sim, bodyId));
+    };
+}
+
+ScalarQuantity distanceTo(std::vector<real3> targets)
+{
+    return [targets = std::move(targets)](const Simulation& sim, int bodyId)
+    {
+        MSODE_Expect(bodyId < static_cast<int>(targets.size()), "no target for body %d", bodyId);
+        return length(sim.getBodies()[bodyId].r - targets[bodyId]);
+    };
+}
+
+} // namespace quantities
+
+static inline void checkNumBodies(const Simulation& sim, int numBodies)
+{
+    MSODE_Expect(static_cast<int>(sim.getBodies().size()) == numBodies,
+                 "the observer expects %d bodies, got %zu", numBodies, sim.getBodies().size());
+}
+
+static inline void checkStateLoaded(bool success, const std::istream& stream, const char *observerName)
+{
+    if (!success || !stream)
+        msode_die("The state does not match this %s (other parameters or truncated state)", observerName);
+}
+
+
+ObserverStatistics::ObserverStatistics(ScalarQuantity quantity, int numBodies) :
+    quantity_(std::move(quantity)),
+    stats_(numBodies),
+    min_(numBodies, std::numeric_limits<real>::infinity()),
+    max_(numBodies, -std::numeric_limits<real>::infinity())
+{}
+
+void ObserverStatistics::observe(const Simulation& sim)
+{
+    checkNumBodies(sim, static_cast<int>(stats_.size()));
+
+    for (size_t i = 0; i < stats_.size(); ++i)
+    {
+        const real x = quantity_(sim, static_cast<int>(i));
+        stats_[i].add(x);
+        min_[i] = std::min(min_[i], x);
+        max_[i] = std::max(max_[i], x);
+    }
+}
+
+void ObserverStatistics::write(std::ostream& stream) const
+{
+    stream << "# bodyId count mean variance min max\n";
+
+    for (size_t i = 0; i < stats_.size(); ++i)
+    {
+        stream << i << ' '
+               << stats_[i].getCount() << ' '
+               << stats_[i].getMean() << ' '
+               << stats_[i].getVariance() << ' '
+               << min_[i] << ' '
+               << max_[i] << '\n';
+    }
+}
+
+void ObserverStatistics::saveState(std::ostream& stream) const
+{
+    binary_io::write(stream, stats_);
+    binary_io::write(stream, min_);
+    binary_io::write(stream, max_);
+}
+
+void ObserverStatistics::loadState(std::istream& stream)
+{
+    const bool success =
+        binary_io::readSameSize(stream, stats_) &&
+        binary_io::readSameSize(stream, min_) &&
+        binary_io::readSameSize(stream, max_);
+
+    checkStateLoaded(success, stream, "ObserverStatistics");
+}
+
+const RunningStats& ObserverStatistics::getStats(int bodyId) const
+{
+    return stats_[bodyId];
+}
+
+real ObserverStatistics::getMin(int bodyId) const
+{
+    return min_[bodyId];
+}
+
+real ObserverStatistics::getMax(int bodyId) const
+{
+    return max_[bodyId];
+}
+
+
+ObserverHistogram::ObserverHistogram(ScalarQuantity quantity, int numBodies, real lo, real hi, int numBins) :
+    quantity_(std::move(quantity)),
+    numBodies_(numBodies),
+    lo_(lo),
+    hi_(hi),
+    numBins_(numBins),
+    counts_(numBodies * numBins, 0),
+    outOfRange_(numBodies, 0)
+{
+    MSODE_Expect(hi_ > lo_, "expect an interval of positive length, got [%g, %g]", lo_, hi_);
+    MSODE_Expect(numBins_ > 0, "expect a positive number of bins, got %d", numBins_);
+}
+
+void ObserverHistogram::observe(const Simulation& sim)
+{
+    checkNumBodies(sim, numBodies_);
+    const real invBinSize = numBins_ / (hi_ - lo_);
+
+    for (int i = 0; i < numBodies_; ++i)
+    {
+        const real x = quantity_(sim, i);
+        const int binId = static_cast<int>(std::floor((x - lo_) * invBinSize));
+
+        if (x >= lo_ && binId >= 0 && binId < numBins_)
+            ++counts_[i * numBins_ + binId];
+        else
+            ++outOfRange_[i];
+    }
+}
+
+void ObserverHistogram::write(std::ostream& stream) const
+{
+    const real binSize = (hi_ - lo_) / numBins_;
+
+    stream << "# out of range:";
+    for (auto n : outOfRange_)
+        stream << ' ' << n;
+    stream << '\n';
+
+    stream << "# binCenter counts\n";
+    for (int binId = 0; binId < numBins_; ++binId)
+    {
+        stream << lo_ + (binId + 0.5_r) * binSize;
+        for (int i = 0; i < numBodies_; ++i)
+            stream << ' ' << counts_[i * numBins_ + binId];
+        stream << '\n';
+    }
+}
+
+void ObserverHistogram::saveState(std::ostream& stream) const
+{
+    binary_io::write(stream, lo_);
+    binary_io::write(stream, hi_);
+    binary_io::write(stream, counts_);
+    binary_io::write(stream, outOfRange_);
+}
+
+void ObserverHistogram::loadState(std::istream& stream)
+{
+    real lo {0.0_r}, hi {0.0_r};
+    binary_io::read(stream, lo);
+    binary_io::read(stream, hi);
+
+    const bool success =
+        lo == lo_ && hi == hi_ &&
+        binary_io::readSameSize(stream, counts_) &&
+        binary_io::readSameSize(stream, outOfRange_);
+
+    checkStateLoaded(success, stream, "ObserverHistogram");
+}
+
+long ObserverHistogram::getCount(int bodyId, int binId) const
+{
+    return counts_[bodyId * numBins_ + binId];
+}
+
+long ObserverHistogram::getOutOfRangeCount(int bodyId) const
+{
+    return outOfRange_[bodyId];
+}
+
+
+static inline MultiTauCorrelator::Kind toCorrelatorKind(ObserverCorrelation::Signal signal)
+{
+    switch (signal)
+    {
+    case ObserverCorrelation::Signal::MeanSquaredDisplacement:
+        return MultiTauCorrelator::Kind::MeanSquaredDisplacement;
+    case ObserverCorrelation::Signal::OrientationAutocorrelation:
+        return MultiTauCorrelator::Kind::Correlation;
+    };
+    msode_die("Unknown signal");
+    return MultiTauCorrelator::Kind::Correlation;
+}
+
+ObserverCorrelation::ObserverCorrelation(Signal signal, int numBodies, int numLevels, int pointsPerLevel, int averaging) :
+    signal_(signal),
+    correlators_(numBodies, MultiTauCorrelator(toCorrelatorKind(signal), numLevels, pointsPerLevel, averaging))
+{}
+
+void ObserverCorrelation::observe(const Simulation& sim)
+{
+    checkNumBodies(sim, static_cast<int>(correlators_.size()));
+
+    const long count = correlators_.empty() ? 0 : correlators_[0].getCount();
+    if (count == 0)
+        firstTime_ = sim.getCurrentTime();
+    else if (count == 1)
+        samplingInterval_ = sim.getCurrentTime() - firstTime_;
+
+    const auto& bodies = sim.getBodies();
+
+    for (size_t i = 0; i < correlators_.size(); ++i)
+    {
+        real3 x;
+
+        if (signal_ == Signal::MeanSquaredDisplacement)
+            x = bodies[i].r;
+        else // direction of the main axis, as in the coupling with the flow
+            x = bodies[i].q.conjugate().rotate({1.0_r, 0.0_r, 0.0_r});
+
+        correlators_[i].add({x.x, x.y, x.z});
+    }
+}
+
+void ObserverCorrelation::write(std::ostream& stream) const
+{
+    if (correlators_.empty())
+        return;
+
+    const auto lags = correlators_[0].getLags();
+    std::vector<std::vector<double>> values;
+    for (const auto& c : correlators_)
+        values.push_back(c.getValues());
+
+    stream << "# lagTime values\n";
+    for (size_t k = 0; k < lags.size(); ++k)
+    {
+        stream << lags[k] * samplingInterval_;
+        for (const auto& v : values)
+            stream << ' ' << v[k];
+        stream << '\n';
+    }
+}
+
+void ObserverCorrelation::saveState(std::ostream& stream) const
+{
+    binary_io::write(stream, static_cast<int>(signal_));
+    binary_io::write(stream, firstTime_);
+    binary_io::write(stream, samplingInterval_);
+    binary_io::write(stream, static_cast<int>(correlators_.size()));
+
+    for (const auto& c : correlators_)
+        c.saveState(stream);
+}
+
+void ObserverCorrelation::loadState(std::istream& stream)
+{
+    int signal {0}, numBodies {0};
+    binary_io::read(stream, signal);
+    binary_io::read(stream, firstTime_);
+    binary_io::read(stream, samplingInterval_);
+    binary_io::read(stream, numBodies);
+
+    const bool success =
+        signal == static_cast<int>(signal_) &&
+        numBodies == static_cast<int>(correlators_.size());
+
+    checkStateLoaded(success, stream, "ObserverCorrelation");
+
+    for (auto& c : correlators_)
+        c.loadState(stream);
+}
+
+const MultiTauCorrelator& ObserverCorrelation::getCorrelator(int bodyId) const
+{
+    return correlators_[bodyId];
+}
+
+real ObserverCorrelation::getSamplingInterval() const
+{
+    return samplingInterval_;
+}
+
+} // namespace utils
+} // namespace msode
@@ -0,0 +1,139 @@
+// Copyright 2020 ETH Zurich. All Rights Reserved.
+#pragma once
+
+#include "multi_tau_correlator.h"
+#include "running_stats.h"
+
+#include <msode/core/observer.h>
+#include <msode/core/simulation.h>
+
+#include <functional>
+#include <vector>
+
+namespace msode {
+namespace utils {
+
+/** Built-in observers of a Simulation (see BaseObserver and Simulation::addObserver()).
+    Each observer reduces a quantity of every body separately; the results are written with one column per body.
+ */
+
+/// A scalar quantity of the body \p bodyId of a simulation
+using ScalarQuantity = std::function<real(const Simulation& sim, int bodyId)>;
+
+namespace quantities {
+
+/// the norm of the velocity of the body at the time of the observation, without thermal noise
+ScalarQuantity speed();
+
+/// the projection of the velocity of the body (see speed()) on \p direction, e.g. the mean velocity along the field axis
+ScalarQuantity velocityAlong(real3 direction);
+
+/// the distance between the body and its target in \p targets
+ScalarQuantity distanceTo(std::vector<real3> targets);
+
+} // namespace quantities
+
+
+/** Mean, variance, minimum and maximum of a scalar quantity over the observations (Welford's algorithm).
+    Output: one line per body: bodyId count mean variance min max
+ */
+class ObserverStatistics : public BaseObserver
+{
+public:
+    /** \brief Construct an ObserverStatistics
+        \param quantity The quantity to reduce
+        \param numBodies The number of bodies of the observed simulation
+     */
+    ObserverStatistics(ScalarQuantity quantity, int numBodies);
+
+    void observe(const Simulation& sim) override;
+    void write(std::ostream& stream) const override;
+    void saveState(std::ostream& stream) const override;
+    void loadState(std::istream& stream) override;
+
+    const RunningStats& getStats(int bodyId) const;
+    real getMin(int bodyId) const;
+    real getMax(int bodyId) const;
+
+private:
+    ScalarQuantity quantity_;
+    std::vector<RunningStats> stats_;
+    std::vector<real> min_, max_;
+};
+
+
+/** Histogram of a scalar quantity over the observations, with uniform bins.
+    Output: one line per bin: binCenter count_0 count_1 ...; the samples out of range are counted separately.
+ */
+class ObserverHistogram : public BaseObserver
+{
+public:
+    /** \brief Construct an ObserverHistogram
+        \param quantity The quantity to reduce
+        \param numBodies The number of bodies of the observed simulation
+        \param lo The lower bound of the first bin
+        \param hi The upper bound of the last bin; must be larger than \p lo
+        \param numBins The number of bins
+     */
+    ObserverHistogram(ScalarQuantity quantity, int numBodies, real lo, real hi, int numBins);
+
+    void observe(const Simulation& sim) override;
+    void write(std::ostream& stream) const override;
+    void saveState(std::ostream& stream) const override;
+    void loadState(std::istream& stream) override;
+
+    /// \return the number of samples of the body \p bodyId in the bin \p binId
+    long getCount(int bodyId, int binId) const;
+
+    /// \return the number of samples of the body \p bodyId outside of [lo, hi)
+    long getOutOfRangeCount(int bodyId) const;
+
+private:
+    ScalarQuantity quantity_;
+    const int numBodies_;
+    const real lo_, hi_;
+    const int numBins_;
+    std::vector<long> counts_;         ///< numBodies x numBins
+    std::vector<long> outOfRange_;     ///< per body
+};
+
+
+/** Time correlation of the trajectory of the bodies, estimated on the fly with a MultiTauCorrelator.
+    The observations must be equally spaced in time.
+    Output: one line per lag: lagTime value_0 value_1 ...
+ */
+class ObserverCorrelation : public BaseObserver
+{
+public:
+    enum class Signal
+    {
+        MeanSquaredDisplacement,   ///< < |r(t+tau) - r(t)|^2 > of the position r
+        OrientationAutocorrelation ///< < p(t) . p(t+tau) > of the direction p of the main axis of the body
+    };
+
+    /** \brief Construct an ObserverCorrelation
+        \param signal The correlation to estimate
+        \param numBodies The number of bodies of the observed simulation
+        \param numLevels, pointsPerLevel, averaging The parameters of the correlator, see MultiTauCorrelator
+     */
+    ObserverCorrelation(Signal signal, int numBodies, int numLevels = 16, int pointsPerLevel = 16, int averaging = 2);
+
+    void observe(const Simulation& sim) override;
+    void write(std::ostream& stream) const override;
+    void saveState(std::ostream& stream) const override;
+    void loadState(std::istream& stream) override;
+
+    const MultiTauCorrelator& getCorrelator(int bodyId) const;
+
+    /// \return the time between two observations; 0 if there were less than two observations
+    real getSamplingInterval() const;
+
+private:
+    const Signal signal_;
+    std::vector<MultiTauCorrelator> correlators_;
+    real firstTime_ {0.0_r};
+    real samplingInterval_ {0.0_r};
+};
+
+} // namespace utils
+} // namespace msode
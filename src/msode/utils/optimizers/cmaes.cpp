@@ -4,6 +4,7 @@
 #include <msode/core/log.h>
 
 #include <limits>
+#include <type_traits>
 
 namespace msode {
 namespace utils {
@@ -14,7 +15,9 @@ static inline real safeSqrt(real x)
     return std::sqrt(x);
 }
 
-CMAES::CMAES(const Function& function, int lambda, Vector mean, real sigma, long seed) :
+template <int Dim>
+CMAES<Dim>::CMAES(const Function& function, int lambda, Vector mean, real sigma, long seed,
+                  EigenSolver eigenSolver) :
     function_(function),
     gen_(seed),
     lambda_(lambda),
@@ -23,8 +26,14 @@ CMAES::CMAES(const Function& function, int lambda, Vector mean, real sigma, long
     xmean_(mean),
     C_     (Matrix::Identity(mean.rows(), mean.rows())),
     pC_    (Vector::Zero(mean.rows())),
-    pSigma_(Vector::Zero(mean.rows()))
+    pSigma_(Vector::Zero(mean.rows())),
+    eigenSolver_(eigenSolver)
 {
+    // the closed form solution is not accurate enough in single precision
+    constexpr bool closedFormAvailable = (Dim == 2 || Dim == 3) && std::is_same<real, double>::value;
+    MSODE_Expect(eigenSolver_ == EigenSolver::Iterative || closedFormAvailable,
+                 "The closed form eigen decomposition needs a fixed dimension 2 or 3 in double precision");
+
     n_ = mean.rows();
 
     weights_.resize(mu_);
@@ -69,7 +78,8 @@ CMAES::CMAES(const Function& function, int lambda, Vector mean, real sigma, long
 }
 
 
-CMAES::Info CMAES::runMinimization(real absoluteThreshold, int maxGeneration, bool verbose)
+template <int Dim>
+typename CMAES<Dim>::Info CMAES<Dim>::runMinimization(real absoluteThreshold, int maxGeneration, bool verbose)
 {
     Info info;
     info.status = Status::Ok;
@@ -111,10 +121,14 @@ CMAES::Info CMAES::runMinimization(real absoluteThreshold, int maxGeneration, bo
     return info;
 }
 
-CMAES::Status CMAES::_runGeneration()
+template <int Dim>
+typename CMAES<Dim>::Status CMAES<Dim>::_runGeneration()
 {
     // eigen decomposition C = (B D) (D B)'
-    CDecomposition_.compute(C_);
+    if (eigenSolver_ == EigenSolver::ClosedForm)
+        CDecomposition_.computeDirect(C_);
+    else
+        CDecomposition_.compute(C_);
     const Matrix B = CDecomposition_.eigenvectors();
     Vector D = CDecomposition_.eigenvalues();
 
@@ -183,7 +197,8 @@ CMAES::Status CMAES::_runGeneration()
 }
 
 
-CMAES::Vector CMAES::_generateNormalDistrVector()
+template <int Dim>
+typename CMAES<Dim>::Vector CMAES<Dim>::_generateNormalDistrVector()
 {
     Vector z = Vector::Zero(n_);
 
@@ -194,13 +209,16 @@ CMAES::Vector CMAES::_generateNormalDistrVector()
 }
 
 
-void CMAES::_computeOrdering(const std::vector<real>& values)
+template <int Dim>
+void CMAES<Dim>::_computeOrdering(const std::vector<real>& values)
 {
     std::iota(order_.begin(), order_.end(), 0);
     std::sort(order_.begin(), order_.end(),
               [&](int a, int b) { return values[a] < values[b]; } );
 }
 
+template class CMAES<Eigen::Dynamic>;
+template class CMAES<3>;
 
 } // namespace utils
 } // namespace msode
@@ -6,6 +6,7 @@
 
 #include <Eigen/Core>
 #include <Eigen/Eigenvalues>
+#include <Eigen/StdVector>
 #include <functional>
 #include <random>
 #include <tuple>
@@ -16,17 +17,28 @@ namespace utils {
 
 /** Simple (mu lambda) CMA-ES for minimization
    See https://arxiv.org/pdf/1604.00772.pdf p.36
+   \tparam Dim The problem dimension if known at compile time, Eigen::Dynamic otherwise.
+                With a fixed dimension all vectors and matrices live on the stack.
  */
+template <int Dim = Eigen::Dynamic>
 class CMAES
 {
 public:
-    using Vector = Eigen::Matrix<real, Eigen::Dynamic, 1>;
-    using Matrix = Eigen::Matrix<real, Eigen::Dynamic, Eigen::Dynamic>;
+    EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+
+    using Vector = Eigen::Matrix<real, Dim, 1>;
+    using Matrix = Eigen::Matrix<real, Dim, Dim>;
 
     using Function = std::function<real(const Vector&)>;
 
     enum class Status {Ok, BadEigenValue};
 
+    /** The method used to decompose the covariance matrix at every generation.
+        \c ClosedForm is only available for Dim = 2 or 3 in double precision; it is faster but does not
+        give the same eigen vectors as \c Iterative to round-off, hence the optimization follows a different path.
+     */
+    enum class EigenSolver {Iterative, ClosedForm};
+
     /// information returned by the optimization
     struct Info
     {
@@ -42,8 +54,10 @@ public:
         \param mean the initial mean
         \param sigma The initial standard deviation
         \param long seed random seed
+        \param eigenSolver The method used to decompose the covariance matrix (see EigenSolver)
      */
-    CMAES(const Function& function, int lambda, Vector mean, real sigma, long seed);
+    CMAES(const Function& function, int lambda, Vector mean, real sigma, long seed,
+          EigenSolver eigenSolver = EigenSolver::Iterative);
 
     /** \brief Run the minimization
         \param absoluteThreshold The minimization will stop if two consecutive best values are separated only by this threshold
@@ -92,12 +106,15 @@ private:
 
     std::vector<real> weights_; ///< normalize recombination weights array
 
+    EigenSolver eigenSolver_; ///< method used to decompose C
     Eigen::SelfAdjointEigenSolver<Matrix> CDecomposition_; ///< helper class to compute eigen decomposition of C
 
     std::vector<int> order_;   ///< ordering of the best candidates (best has index order_[0])
-    std::vector<Vector> xs_;   ///< list of samples for new candidates (in evaluation space)
-    std::vector<Vector> ys_;   ///< (list of samples minus the current mean) / sigma
-    std::vector<Vector> zs_;   ///< normally distributed vectors used to generate current samples
+    using VectorList = std::vector<Vector, Eigen::aligned_allocator<Vector>>;
+
+    VectorList xs_;   ///< list of samples for new candidates (in evaluation space)
+    VectorList ys_;   ///< (list of samples minus the current mean) / sigma
+    VectorList zs_;   ///< normally distributed vectors used to generate current samples
     std::vector<real> functionValues_; ///< function values evaluated at the current samples
 
     real bestEverValue_; ///< minimal function value ever encountered
@@ -107,5 +124,8 @@ private:
     real previousBestValue_; ///< best value in the previous generation
 };
 
+extern template class CMAES<Eigen::Dynamic>;
+extern template class CMAES<3>;
+
 } // namespace utils
 } // namespace msode
@@ -0,0 +1,168 @@
+// Copyright 2020 ETH Zurich. All Rights Reserved.
+#pragma once
+
+#include <msode/core/log.h>
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace msode {
+namespace utils {
+
+/** A pool of background threads that executes jobs asynchronously, with results delivered in submission order.
+
+    Jobs are submitted without blocking; the workers execute them in any order. The completed results go to a
+    completion queue from which they can be popped only in the order of submission. This lets a producer
+    keep working while the jobs complete, and still write the results deterministically.
+ */
+template <class Result>
+class OrderedAsyncPool
+{
+public:
+    using Job = std::function<Result()>;
+
+    /** \brief Construct an OrderedAsyncPool
+        \param numThreads The number of worker threads. Non positive values select the number of hardware threads.
+     */
+    explicit OrderedAsyncPool(int numThreads)
+    {
+        if (numThreads <= 0)
+            numThreads = std::max(1u, std::thread::hardware_concurrency());
+
+        for (int i = 0; i < numThreads; ++i)
+            threads_.emplace_back([this]() {_workerLoop();});
+    }
+
+    /// Wait for all submitted jobs to complete; their results that were not popped are discarded.
+    ~OrderedAsyncPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+        jobCv_.notify_all();
+
+        for (auto& t : threads_)
+            t.join();
+    }
+
+    OrderedAsyncPool(const OrderedAsyncPool&) = delete;
+    OrderedAsyncPool& operator=(const OrderedAsyncPool&) = delete;
+
+    OrderedAsyncPool(OrderedAsyncPool&&) = delete;
+    OrderedAsyncPool& operator=(OrderedAsyncPool&&) = delete;
+
+    /// \return The number of worker threads
+    int getNumThreads() const
+    {
+        return static_cast<int>(threads_.size());
+    }
+
+    /** \brief Submit a job; does not wait for its execution.
+        \param job The function to execute; must be thread safe.
+        \return The submission index of the job, starting at 0.
+     */
+    long submit(Job job)
+    {
+        long id;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            id = numSubmitted_++;
+            jobs_.push_back({id, std::move(job)});
+        }
+        jobCv_.notify_one();
+        return id;
+    }
+
+    /// \return The number of submitted jobs whose result was not popped yet
+    long getNumPending() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return numSubmitted_ - numPopped_;
+    }
+
+    /** \brief Pop the result of the oldest job not popped yet, if it is completed.
+        \param result Receives the result on success
+        \return \c false if that job is not completed (or if there is none); does not block.
+     */
+    bool tryPop(Result& result)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return _popNext(result);
+    }
+
+    /** \brief Pop the result of the oldest job not popped yet, waiting for its completion.
+        \param result Receives the result
+        \note There must be at least one pending job.
+     */
+    void pop(Result& result)
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        MSODE_Expect(numSubmitted_ > numPopped_, "No pending job");
+
+        doneCv_.wait(lock, [this]() {return completed_.count(numPopped_) > 0;});
+        _popNext(result);
+    }
+
+private:
+    /// requires the mutex
+    bool _popNext(Result& result)
+    {
+        auto it = completed_.find(numPopped_);
+
+        if (it == completed_.end())
+            return false;
+
+        result = std::move(it->second);
+        completed_.erase(it);
+        ++numPopped_;
+        return true;
+    }
+
+    void _workerLoop()
+    {
+        while (true)
+        {
+            std::pair<long, Job> job;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                jobCv_.wait(lock, [this]() {return stop_ || !jobs_.empty();});
+
+                if (jobs_.empty())
+                    return; // stop_ is set and all jobs are done
+
+                job = std::move(jobs_.front());
+                jobs_.pop_front();
+            }
+
+            Result result = job.second();
+
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                completed_.emplace(job.first, std::move(result));
+            }
+            doneCv_.notify_all();
+        }
+    }
+
+private:
+    std::vector<std::thread> threads_;
+
+    mutable std::mutex mutex_;           ///< protects the members below
+    std::condition_variable jobCv_;      ///< signals the workers that a job is available
+    std::condition_variable doneCv_;     ///< signals pop() that a job is completed
+    std::deque<std::pair<long, Job>> jobs_;
+    std::map<long, Result> completed_;   ///< the completion queue, indexed by submission order
+    long numSubmitted_ {0};
+    long numPopped_ {0};
+    bool stop_ {false};
+};
+
+} // namespace utils
+} // namespace msode
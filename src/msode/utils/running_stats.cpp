@@ -0,0 +1,44 @@
+// Copyright 2020 ETH Zurich. All Rights Reserved.
+
+#include "running_stats.h"
+
+#include <cmath>
+
+namespace msode {
+namespace utils {
+
+void RunningStats::add(double x)
+{
+    ++count_;
+    const double delta = x - mean_;
+    mean_ += delta / count_;
+    m2_ += delta * (x - mean_);
+}
+
+long RunningStats::getCount() const
+{
+    return count_;
+}
+
+double RunningStats::getMean() const
+{
+    return mean_;
+}
+
+double RunningStats::getVariance() const
+{
+    return count_ > 1 ? m2_ / (count_ - 1) : 0.0;
+}
+
+double RunningStats::getStandardError() const
+{
+    return count_ > 1 ? std::sqrt(getVariance() / count_) : 0.0;
+}
+
+double RunningStats::getConfidenceHalfWidth(double z) const
+{
+    return z * getStandardError();
+}
+
+} // namespace utils
+} // namespace msode
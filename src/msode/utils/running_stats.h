@@ -0,0 +1,44 @@
+// Copyright 2020 ETH Zurich. All Rights Reserved.
+#pragma once
+
+namespace msode {
+namespace utils {
+
+/** Streaming mean and variance of a sequence of samples (Welford's algorithm).
+
+    The samples are not stored; the estimates are numerically stable even when the
+    mean is large compared to the standard deviation.
+ */
+class RunningStats
+{
+public:
+    RunningStats() = default;
+
+    /// add the sample \p x to the statistics
+    void add(double x);
+
+    /// \return The number of samples added so far
+    long getCount() const;
+
+    /// \return The mean of the samples; 0 if there are none
+    double getMean() const;
+
+    /// \return The unbiased sample variance; 0 if there are less than 2 samples
+    double getVariance() const;
+
+    /// \return The standard error of the mean; 0 if there are less than 2 samples
+    double getStandardError() const;
+
+    /** \return The half width of the confidence interval of the mean, in the normal approximation.
+        \param z The quantile of the standard normal distribution, e.g. 1.96 for a 95% confidence interval.
+     */
+    double getConfidenceHalfWidth(double z = 1.96) const;
+
+private:
+    long count_ {0};
+    double mean_ {0.0};
+    double m2_ {0.0}; ///< sum of the squared deviations from the current mean
+};
+
+} // namespace utils
+} // namespace msode
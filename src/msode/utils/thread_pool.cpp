@@ -0,0 +1,170 @@
+// Copyright 2020 ETH Zurich. All Rights Reserved.
+#include "thread_pool.h"
+
+#include <msode/core/log.h>
+
+namespace msode {
+namespace utils {
+
+ThreadPool::ThreadPool(int numThreads)
+{
+    if (numThreads <= 0)
+        numThreads = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+
+    for (int i = 0; i < numThreads; ++i)
+        ranges_.push_back(std::make_unique<TaskRange>());
+
+    for (int i = 0; i < numThreads; ++i)
+        threads_.emplace_back(&ThreadPool::_workerLoop, this, i);
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    startCv_.notify_all();
+
+    for (auto& t : threads_)
+        t.join();
+}
+
+int ThreadPool::getNumThreads() const
+{
+    return static_cast<int>(threads_.size());
+}
+
+void ThreadPool::run(long numTasks, const Task& task)
+{
+    MSODE_Expect(numTasks >= 0, "expect non negative number of tasks, got %ld", numTasks);
+
+    if (numTasks == 0)
+        return;
+
+    const long numWorkers = getNumThreads();
+    const long chunk      = numTasks / numWorkers;
+    const long remainder  = numTasks % numWorkers;
+
+    std::unique_lock<std::mutex> lock(mutex_);
+
+    long begin {0};
+    for (long i = 0; i < numWorkers; ++i)
+    {
+        const long end = begin + chunk + (i < remainder ? 1 : 0);
+        std::lock_guard<std::mutex> rangeLock(ranges_[i]->mutex);
+        ranges_[i]->begin = begin;
+        ranges_[i]->end   = end;
+        begin = end;
+    }
+
+    currentTask_ = &task;
+    numBusyWorkers_ = numWorkers;
+    ++generation_;
+
+    startCv_.notify_all();
+    doneCv_.wait(lock, [this]() {return numBusyWorkers_ == 0;});
+
+    currentTask_ = nullptr;
+}
+
+void ThreadPool::_workerLoop(int workerId)
+{
+    long lastGeneration {0};
+
+    while (true)
+    {
+        const Task *task {nullptr};
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            startCv_.wait(lock, [&]() {return stop_ || generation_ != lastGeneration;});
+
+            if (stop_)
+                return;
+
+            lastGeneration = generation_;
+            task = currentTask_;
+        }
+
+        while (true)
+        {
+            long taskId;
+            if (_popTask(workerId, taskId))
+                (*task)(taskId, workerId);
+            else if (!_stealTasks(workerId))
+                break;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (--numBusyWorkers_ == 0)
+                doneCv_.notify_all();
+        }
+    }
+}
+
+bool ThreadPool::_popTask(int workerId, long& taskId)
+{
+    TaskRange& range = *ranges_[workerId];
+    std::lock_guard<std::mutex> lock(range.mutex);
+
+    if (range.begin >= range.end)
+        return false;
+
+    taskId = range.begin++;
+    return true;
+}
+
+bool ThreadPool::_stealTasks(int workerId)
+{
+    const int numWorkers = getNumThreads();
+
+    // find the worker with the largest amount of remaining work
+    int victim {-1};
+    long maxRemaining {0};
+
+    for (int i = 0; i < numWorkers; ++i)
+    {
+        if (i == workerId)
+            continue;
+
+        TaskRange& range = *ranges_[i];
+        std::lock_guard<std::mutex> lock(range.mutex);
+        const long remaining = range.end - range.begin;
+
+        if (remaining > maxRemaining)
+        {
+            maxRemaining = remaining;
+            victim = i;
+        }
+    }
+
+    if (victim < 0)
+        return false;
+
+    long stolenBegin, stolenEnd;
+    {
+        TaskRange& range = *ranges_[victim];
+        std::lock_guard<std::mutex> lock(range.mutex);
+        const long remaining = range.end - range.begin;
+
+        // the victim may have progressed in the meantime; the caller will try again
+        if (remaining <= 0)
+            return true;
+
+        const long numStolen = std::max(1L, remaining / 2);
+        stolenEnd   = range.end;
+        stolenBegin = range.end - numStolen;
+        range.end   = stolenBegin;
+    }
+
+    TaskRange& range = *ranges_[workerId];
+    std::lock_guard<std::mutex> lock(range.mutex);
+    range.begin = stolenBegin;
+    range.end   = stolenEnd;
+
+    return true;
+}
+
+} // namespace utils
+} // namespace msode
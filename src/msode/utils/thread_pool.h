@@ -0,0 +1,76 @@
+// Copyright 2020 ETH Zurich. All Rights Reserved.
+#pragma once
+
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace msode {
+namespace utils {
+
+/** A pool of persistent worker threads that executes independent tasks with work stealing.
+
+    Tasks are identified by their index in [0, numTasks).
+    Each worker starts with a contiguous range of tasks that it processes from the front.
+    A worker that runs out of tasks steals the back half of the largest remaining range of the other workers.
+    This keeps all workers busy when the cost of the tasks is heterogeneous and unknown in advance.
+ */
+class ThreadPool
+{
+public:
+    /// A task takes the task index and the id of the worker that executes it (in [0, getNumThreads()))
+    using Task = std::function<void(long taskId, int workerId)>;
+
+    /** \brief Construct a ThreadPool
+        \param numThreads The number of worker threads. Non positive values select the number of hardware threads.
+     */
+    explicit ThreadPool(int numThreads);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    ThreadPool(ThreadPool&&) = delete;
+    ThreadPool& operator=(ThreadPool&&) = delete;
+
+    /// \return The number of worker threads
+    int getNumThreads() const;
+
+    /** \brief Execute the tasks 0, ..., numTasks-1 and return once all of them are completed.
+        \param numTasks The number of tasks to execute
+        \param task The function to execute for each task; must be thread safe.
+        \note Must not be called concurrently from different threads or from within a task.
+     */
+    void run(long numTasks, const Task& task);
+
+private:
+    /// The tasks [begin, end) that are owned by one worker.
+    struct TaskRange
+    {
+        std::mutex mutex;
+        long begin {0};
+        long end {0};
+    };
+
+    void _workerLoop(int workerId);
+    bool _popTask(int workerId, long& taskId);
+    bool _stealTasks(int workerId);
+
+private:
+    std::vector<std::unique_ptr<TaskRange>> ranges_; ///< one range per worker
+    std::vector<std::thread> threads_;
+
+    std::mutex mutex_;                ///< protects the members below
+    std::condition_variable startCv_; ///< signals the workers that new tasks are available
+    std::condition_variable doneCv_;  ///< signals the caller of run() that all workers are done
+    const Task *currentTask_ {nullptr};
+    long generation_ {0};             ///< incremented at every call of run()
+    int numBusyWorkers_ {0};
+    bool stop_ {false};
+};
+
+} // namespace utils
+} // namespace msode
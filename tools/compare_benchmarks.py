@@ -0,0 +1,65 @@
+#! /usr/bin/env python3
+
+# Compare two json outputs of msode_bench and flag the regressions.
+# A benchmark is flagged if its time per call grew by more than the threshold, or by more than the
+# measured noise (spread of the repetitions of both runs) if that is larger.
+# The exit code is 1 if there is at least one regression.
+
+import argparse
+import json
+import sys
+
+parser = argparse.ArgumentParser()
+parser.add_argument('baseline', type=str, help='json output of msode_bench used as reference.')
+parser.add_argument('candidate', type=str, help='json output of msode_bench to compare.')
+parser.add_argument('--threshold', type=float, default=0.05, help="Relative slowdown considered as a regression.")
+parser.add_argument('--noise-factor', type=float, default=1.0, help="Multiplier of the measured spread added to the noise level.")
+parser.add_argument('--all', action='store_true', default=False, help="Print all benchmarks, not only the changes.")
+args = parser.parse_args()
+
+def load(fname):
+    with open(fname) as f:
+        data = json.load(f)
+    results = {}
+    for b in data['benchmarks']:
+        params = " ".join(f"{k}={v}" for k, v in sorted(b['params'].items()))
+        results[(b['name'], params)] = b
+    return data['context'], results
+
+base_context, base = load(args.baseline)
+cand_context, cand = load(args.candidate)
+
+if base_context.get('precision') != cand_context.get('precision'):
+    print(f"warning: comparing different precisions ({base_context.get('precision')} and {cand_context.get('precision')})",
+          file=sys.stderr)
+
+regressions = []
+improvements = []
+
+print(f"{'benchmark':<45} {'params':<22} {'base ns/item':>14} {'new ns/item':>14} {'change':>8}")
+
+for key in sorted(base.keys() & cand.keys()):
+    b, c = base[key], cand[key]
+    ratio = c['ns_per_call'] / b['ns_per_call']
+    noise = max(args.threshold, args.noise_factor * (b['rel_spread'] + c['rel_spread']))
+
+    status = ""
+    if ratio > 1 + noise:
+        status = "REGRESSION"
+        regressions.append(key)
+    elif ratio < 1 / (1 + noise):
+        status = "improved"
+        improvements.append(key)
+
+    if status or args.all:
+        name, params = key
+        print(f"{name:<45} {params:<22} {b['ns_per_item']:>14.3f} {c['ns_per_item']:>14.3f} {100*(ratio-1):>+7.1f}% {status}")
+
+for key in sorted(base.keys() - cand.keys()):
+    print(f"missing in candidate: {key[0]} {key[1]}")
+for key in sorted(cand.keys() - base.keys()):
+    print(f"new in candidate: {key[0]} {key[1]}")
+
+print(f"{len(regressions)} regressions, {len(improvements)} improvements, {len(base.keys() & cand.keys())} compared")
+
+sys.exit(1 if regressions else 0)
@@ -1,13 +1,35 @@
 #pragma once
 
 #include <msode/core/simulation.h>
+#include <msode/core/velocity_field/none.h>
+#include <msode/rl/environment.h>
+#include <msode/rl/field_from_action/direct.h>
+#include <msode/rl/field_from_action/local_frame.h>
+#include <msode/rl/pos_ic/ball.h>
+#include <msode/rl/target_distances/square.h>
 
+#include <algorithm>
+#include <memory>
 #include <random>
+#include <type_traits>
+#include <vector>
 
 namespace helpers
 {
 using namespace msode;
 
+/// true if the library is compiled with single precision kernels (single and mixed precision builds)
+constexpr bool singlePrecision = std::is_same<real, float>::value;
+
+/** \brief Select a test parameter (e.g. a tolerance) according to the precision of the library.
+    \param valueDouble The value used in double precision builds
+    \param valueSingle The value used in single and mixed precision builds
+ */
+constexpr real byPrecision(real valueDouble, real valueSingle)
+{
+    return singlePrecision ? valueSingle : valueDouble;
+}
+
 static inline PropulsionMatrix generateRandomPropulsion(std::mt19937& gen)
 {
     std::uniform_real_distribution<real> unif(0.8, 1.2);
@@ -33,4 +55,68 @@ inline RigidBody generateRandomBody(std::mt19937& gen)
     return {q, r, m, propulsion, 1.0};
 }
 
+/// Parameters of createTestEnvironment()
+struct TestEnvironmentParams
+{
+    std::vector<RigidBody> bodies;
+    real magneticFieldMagnitude {1.0_r};
+    real distanceThreshold {2.0_r};
+    real domainRadius {50.0_r}; ///< radius of the ball of initial positions; not used if posIC is set
+    real kBT {0.0_r};
+    real tmax {500.0_r};
+    long dumpEvery {0};
+
+    real stepsPerPeriod {50.0_r};  ///< number of time steps per rotation at the largest step out frequency
+    real periodsPerAction {1.0_r}; ///< duration of an action, in rotations at the smallest perpendicular step out frequency
+    long nstepsPerAction {0};      ///< if positive, replaces periodsPerAction
+
+    rl::RewardParams rewards {1.0_r, 0.0_r, 0.0_r};
+    rl::TerminationParams termination;
+
+    bool localFrameActions {false}; ///< FieldFromActionFromLocalFrame if true, FieldFromActionDirect otherwise
+    std::unique_ptr<rl::EnvPosIC> posIC;                ///< if not set, uniform in a ball of radius domainRadius
+    std::unique_ptr<rl::TargetDistance> targetDistance; ///< if not set, TargetDistanceSquare
+};
+
+/** \brief Create an environment without flow for the tests.
+    The time step, the action duration and the range of the action frequencies are chosen from the step out
+    frequencies of the bodies.
+ */
+inline std::unique_ptr<rl::MSodeEnvironment> createTestEnvironment(TestEnvironmentParams p)
+{
+    real omegaC {0.0_r};
+    real omegaCperp {1e9_r};
+
+    for (const auto& b : p.bodies)
+    {
+        omegaC     = std::max(omegaC,     b.stepOutFrequency(p.magneticFieldMagnitude));
+        omegaCperp = std::min(omegaCperp, b.stepOutFrequency(p.magneticFieldMagnitude, 2));
+    }
+
+    const real orientScale = 2.0_r * M_PI / omegaCperp;
+
+    rl::TimeParams tParams;
+    tParams.dt              = 2.0_r * M_PI / omegaC / p.stepsPerPeriod;
+    tParams.tmax            = p.tmax;
+    tParams.nstepsPerAction = p.nstepsPerAction > 0 ? p.nstepsPerAction : p.periodsPerAction * orientScale / tParams.dt;
+    tParams.dumpEvery       = p.dumpEvery;
+
+    rl::Params params(tParams, p.rewards, p.magneticFieldMagnitude, p.distanceThreshold, p.kBT, p.termination);
+
+    std::unique_ptr<rl::FieldFromAction> actionField;
+    if (p.localFrameActions)
+        actionField = std::make_unique<rl::FieldFromActionFromLocalFrame>(0.0_r, 2.0_r * omegaC);
+    else
+        actionField = std::make_unique<rl::FieldFromActionDirect>(0.0_r, 2.0_r * omegaC);
+
+    if (!p.posIC)
+        p.posIC = std::make_unique<rl::EnvPosICBall>(p.domainRadius);
+
+    if (!p.targetDistance)
+        p.targetDistance = std::make_unique<rl::TargetDistanceSquare>();
+
+    return std::make_unique<rl::MSodeEnvironment>(params, std::move(p.posIC), p.bodies, std::move(actionField),
+                                                  std::make_unique<VelocityFieldNone>(), std::move(p.targetDistance));
+}
+
 } // namespace helpers
@@ -0,0 +1,100 @@
+#include "helpers.h"
+
+#include <msode/analytic_control/apply_strategy.h>
+#include <msode/analytic_control/helpers.h>
+#include <msode/core/velocity_field/constant.h>
+#include <msode/core/velocity_field/none.h>
+
+#include <gtest/gtest.h>
+#include <vector>
+
+using namespace msode;
+
+constexpr real magneticFieldMagnitude {1.0_r};
+
+static std::vector<RigidBody> generateRandomBodies(int n, std::mt19937& gen)
+{
+    std::vector<RigidBody> bodies;
+    bodies.reserve(n);
+
+    for (int i = 0; i < n; ++i)
+        bodies.push_back(helpers::generateRandomBody(gen));
+
+    return bodies;
+}
+
+static real maxDistance(const std::vector<real3>& positions)
+{
+    real d {0.0_r};
+    for (auto r : positions)
+        d = std::max(d, length(r));
+    return d;
+}
+
+GTEST_TEST( AC_HYBRID, reaches_targets )
+{
+    std::mt19937 gen {4242};
+    const int n = 3;
+    const auto bodies = generateRandomBodies(n, gen);
+    const auto V = analytic_control::createVelocityMatrix(magneticFieldMagnitude, bodies);
+    const analytic_control::MatrixReal U = V.inverse();
+
+    const real L = 20.0_r;
+    const real3 boxLo {-L, -L, -L};
+    const real3 boxHi {+L, +L, +L};
+
+    for (long seed = 0; seed < 5; ++seed)
+    {
+        const auto positions = analytic_control::generateRandomPositionsBox(n, boxLo, boxHi, seed);
+        const real tRequired = analytic_control::computeRequiredTime(magneticFieldMagnitude, bodies, positions, U, true);
+
+        const auto result = analytic_control::executeOptimalPathHybrid(magneticFieldMagnitude, bodies, positions,
+                                                                       std::make_unique<VelocityFieldNone>(), U, 0);
+
+        ASSERT_EQ(result.requiredTime, tRequired);
+        ASSERT_NEAR(result.time, tRequired, helpers::byPrecision(1e-6_r, 1e-3_r) * tRequired);
+
+        // only the reorientation windows displace the bodies away from the plan
+        ASSERT_LT(maxDistance(result.finalPositions), 0.1_r * maxDistance(positions));
+    }
+}
+
+GTEST_TEST( AC_HYBRID, uniform_flow_drift )
+{
+    std::mt19937 gen {4242};
+    const int n = 2;
+    const auto bodies = generateRandomBodies(n, gen);
+    const auto V = analytic_control::createVelocityMatrix(magneticFieldMagnitude, bodies);
+    const analytic_control::MatrixReal U = V.inverse();
+
+    const real3 boxLo {-10.0_r, -10.0_r, -10.0_r};
+    const real3 boxHi {+10.0_r, +10.0_r, +10.0_r};
+    const auto positions = analytic_control::generateRandomPositionsBox(n, boxLo, boxHi);
+
+    const real3 drift {0.01_r, -0.02_r, 0.005_r};
+    const int numQuadraturePoints = 4;
+
+    const auto ref  = analytic_control::executeOptimalPathHybrid(magneticFieldMagnitude, bodies, positions,
+                                                                 std::make_unique<VelocityFieldNone>(), U,
+                                                                 numQuadraturePoints);
+    const auto flow = analytic_control::executeOptimalPathHybrid(magneticFieldMagnitude, bodies, positions,
+                                                                 std::make_unique<VelocityFieldConstant>(drift), U,
+                                                                 numQuadraturePoints);
+
+    // a uniform flow only advects the bodies
+    const real tol = helpers::byPrecision(1e-6_r, 1e-3_r) * ref.time;
+
+    for (int i = 0; i < n; ++i)
+    {
+        const real3 expected = ref.finalPositions[i] + ref.time * drift;
+        ASSERT_NEAR(flow.finalPositions[i].x, expected.x, tol);
+        ASSERT_NEAR(flow.finalPositions[i].y, expected.y, tol);
+        ASSERT_NEAR(flow.finalPositions[i].z, expected.z, tol);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
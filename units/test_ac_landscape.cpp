@@ -0,0 +1,156 @@
+#include "helpers.h"
+
+#include <msode/analytic_control/landscape.h>
+#include <msode/analytic_control/optimal_path.h>
+
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+using namespace msode;
+
+static std::vector<real3> generateRandomA(int n, std::mt19937& gen)
+{
+    std::uniform_real_distribution<real> dstr(-1.0_r, 1.0_r);
+    std::vector<real3> A(n);
+    for (auto& a : A)
+        a = {dstr(gen), dstr(gen), dstr(gen)};
+    return A;
+}
+
+GTEST_TEST( AC_LANDSCAPE, batched_travel_times )
+{
+    std::mt19937 gen {4242};
+    std::uniform_real_distribution<real> angle(0.0_r, 2 * M_PI);
+    const int n = 5;
+    const auto A = generateRandomA(n, gen);
+
+    std::vector<Quaternion> qs;
+    for (int i = 0; i < 100; ++i)
+        qs.push_back(analytic_control::quaternionFromLandscapeAngles(angle(gen), 0.5_r * angle(gen), angle(gen)));
+
+    std::vector<real> times;
+    std::vector<uint64_t> signs;
+    analytic_control::computeTravelTimes(A, qs, times, &signs);
+
+    ASSERT_EQ(times.size(), qs.size());
+    ASSERT_EQ(signs.size(), qs.size() * analytic_control::getNumSignWords(n));
+
+    for (size_t s = 0; s < qs.size(); ++s)
+    {
+        const real tRef = analytic_control::computeTravelTime(A, qs[s]);
+        ASSERT_NEAR(times[s], tRef, helpers::byPrecision(1e-12_r, 1e-5_r) * tRef);
+
+        const real3 d1 = qs[s].rotate({1.0_r, 0.0_r, 0.0_r});
+        const uint64_t expectedBit = dot(A[0], d1) >= 0.0_r;
+        ASSERT_EQ(signs[s] & 1, expectedBit);
+    }
+}
+
+GTEST_TEST( AC_LANDSCAPE, coarse_points_are_exact )
+{
+    std::mt19937 gen {4242};
+    const auto A = generateRandomA(3, gen);
+    utils::ThreadPool pool(2);
+
+    const int coarseRes = 16;
+    const int refinement = 3;
+    const auto grid = analytic_control::computeLandscape(A, coarseRes, refinement, pool);
+
+    ASSERT_EQ(grid.ntheta, 2 * coarseRes * refinement);
+    ASSERT_EQ(grid.nphi,       coarseRes * refinement);
+    ASSERT_EQ(grid.npsi,       coarseRes * refinement);
+    ASSERT_LT(grid.numEvaluations, static_cast<long>(grid.values.size()));
+
+    // the points of the coarse grid are always exact
+    for (int ips = 0; ips < grid.npsi; ips += refinement)
+        for (int iph = 0; iph < grid.nphi; iph += refinement)
+            for (int ith = 0; ith < grid.ntheta; ith += refinement)
+            {
+                const auto q = analytic_control::quaternionFromLandscapeAngles(ith * grid.dtheta, iph * grid.dphi, ips * grid.dpsi);
+                const real tRef = analytic_control::computeTravelTime(A, q);
+                ASSERT_NEAR(grid.values[grid.index(ith, iph, ips)], tRef, helpers::byPrecision(1e-10_r, 1e-4_r) * tRef);
+            }
+}
+
+GTEST_TEST( AC_LANDSCAPE, interpolated_points_match_brute_force )
+{
+    std::mt19937 gen {4242};
+    const auto A = generateRandomA(3, gen);
+    utils::ThreadPool pool(2);
+
+    const int coarseRes = 16;
+    const int refinement = 3;
+    const auto grid = analytic_control::computeLandscape(A, coarseRes, refinement, pool);
+
+    // brute force: evaluate the travel time exactly at every point of the fine grid
+    std::vector<Quaternion> qs;
+    for (int ips = 0; ips < grid.npsi; ++ips)
+        for (int iph = 0; iph < grid.nphi; ++iph)
+            for (int ith = 0; ith < grid.ntheta; ++ith)
+                qs.push_back(analytic_control::quaternionFromLandscapeAngles(ith * grid.dtheta, iph * grid.dphi, ips * grid.dpsi));
+
+    std::vector<real> tRef;
+    analytic_control::computeTravelTimes(A, qs, tRef);
+    ASSERT_EQ(tRef.size(), grid.values.size());
+
+    // the points evaluated exactly match up to round off; the others are interpolated trilinearly from the coarse grid.
+    // The travel time is smooth in the interpolated cells, with an O(h^2) error: at this coarse resolution
+    // (h = pi / 16) it stays below 5% pointwise and 2% on average
+    const real exactTolerance        = helpers::byPrecision(1e-10_r, 1e-4_r);
+    const real interpolatedTolerance = 0.05_r;
+    const real meanTolerance         = 0.02_r;
+
+    long numInterpolated {0};
+    real sumErrors {0.0_r};
+
+    for (size_t i = 0; i < tRef.size(); ++i)
+    {
+        const real relError = std::abs(grid.values[i] - tRef[i]) / tRef[i];
+        ASSERT_LT(relError, interpolatedTolerance);
+
+        if (relError > exactTolerance)
+        {
+            ++numInterpolated;
+            sumErrors += relError;
+        }
+    }
+
+    const long numNotEvaluated = static_cast<long>(grid.values.size()) - grid.numEvaluations;
+    ASSERT_GT(numInterpolated, 0);
+    ASSERT_LE(numInterpolated, numNotEvaluated);
+    ASSERT_LT(sumErrors / numInterpolated, meanTolerance);
+
+    // the cells around the coarse minima are evaluated exactly, so the global minimum is not interpolated
+    const real minGrid = *std::min_element(grid.values.begin(), grid.values.end());
+    const real minRef  = *std::min_element(tRef.begin(), tRef.end());
+    ASSERT_NEAR(minGrid, minRef, exactTolerance * minRef);
+}
+
+GTEST_TEST( AC_LANDSCAPE, minima )
+{
+    // a single body: the travel time is minimal when A is aligned with one of the rotated axes, where it equals |A|
+    const std::vector<real3> A {{0.3_r, -0.4_r, 1.2_r}};
+    utils::ThreadPool pool(2);
+
+    const auto grid = analytic_control::computeLandscape(A, 16, 4, pool);
+    const auto minima = analytic_control::findLocalMinima(grid);
+
+    ASSERT_FALSE(minima.empty());
+    ASSERT_NEAR(minima.front().travelTime, length(A[0]), 0.01_r * length(A[0]));
+
+    real totalBasins {0.0_r};
+    for (const auto& m : minima)
+    {
+        ASSERT_GE(m.travelTime, length(A[0]) * (1.0_r - 1e-6_r));
+        totalBasins += m.basinFraction;
+    }
+    ASSERT_NEAR(totalBasins, 1.0_r, 1e-6_r);
+}
+
+int main(int argc, char **argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
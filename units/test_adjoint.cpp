@@ -0,0 +1,198 @@
+#include "helpers.h"
+
+#include <msode/adjoint/gradient.h>
+#include <msode/core/dual.h>
+#include <msode/core/velocity_field/shear.h>
+#include <msode/core/velocity_field/taylor_green_vortex.h>
+
+#include <gtest/gtest.h>
+#include <random>
+
+using namespace msode;
+
+constexpr real magneticFieldMagnitude = 1.0_r;
+
+static adjoint::Problem createProblem(Simulation::ODEScheme scheme, const BaseVelocityField *velocityField,
+                                      int numBodies)
+{
+    std::mt19937 gen(4242);
+    adjoint::Problem problem;
+
+    for (int i = 0; i < numBodies; ++i)
+    {
+        RigidBody body = helpers::generateRandomBody(gen);
+        body.q = Quaternion::createFromRotation(0.3_r + i, {1.0_r, 0.5_r, -0.2_r * i});
+        body.r = {1.0_r * i, -0.5_r, 0.2_r};
+        body.aspectRatio = 2.0_r;
+        problem.bodies.push_back(body);
+        problem.targets.push_back({2.0_r, 1.0_r + i, -1.0_r});
+    }
+
+    problem.magneticFieldMagnitude = magneticFieldMagnitude;
+    problem.dt = 0.01_r;
+    problem.nstepsPerControl = 20;
+    problem.scheme = scheme;
+    problem.velocityField = velocityField;
+    return problem;
+}
+
+static std::vector<adjoint::Control> createControls(int numControls)
+{
+    std::vector<adjoint::Control> controls;
+    for (int k = 0; k < numControls; ++k)
+        controls.push_back({2.0_r + 0.5_r * k, {0.3_r * k, 1.0_r, 0.5_r}});
+    return controls;
+}
+
+static void checkGradientAgainstFiniteDifferences(Simulation::ODEScheme scheme, const BaseVelocityField *flow)
+{
+    const auto problem = createProblem(scheme, flow, 2);
+    const auto controls = createControls(5);
+
+    const auto g = adjoint::computeGradient(problem, controls, 7);
+    ASSERT_EQ(g.cost, adjoint::computeCost(problem, controls));
+
+    constexpr real h   = helpers::byPrecision(1e-6_r, 1e-2_r);
+    constexpr real tol = helpers::byPrecision(1e-5_r, 5e-2_r);
+
+    auto centeredDifference = [&](auto perturb)
+    {
+        auto problemP = problem, problemM = problem;
+        auto controlsP = controls, controlsM = controls;
+        perturb(problemP, controlsP, +h);
+        perturb(problemM, controlsM, -h);
+        return (adjoint::computeCost(problemP, controlsP) - adjoint::computeCost(problemM, controlsM)) / (2 * h);
+    };
+
+    for (size_t k = 0; k < controls.size(); ++k)
+    {
+        const real dOmega = centeredDifference([k](adjoint::Problem&, std::vector<adjoint::Control>& c, real eps)
+        {
+            c[k].omega += eps;
+        });
+        const real dAxisX = centeredDifference([k](adjoint::Problem&, std::vector<adjoint::Control>& c, real eps)
+        {
+            c[k].axis.x += eps;
+        });
+        const real dAxisY = centeredDifference([k](adjoint::Problem&, std::vector<adjoint::Control>& c, real eps)
+        {
+            c[k].axis.y += eps;
+        });
+        const real dAxisZ = centeredDifference([k](adjoint::Problem&, std::vector<adjoint::Control>& c, real eps)
+        {
+            c[k].axis.z += eps;
+        });
+
+        ASSERT_NEAR(g.controls[k].omega,  dOmega, tol);
+        ASSERT_NEAR(g.controls[k].axis.x, dAxisX, tol);
+        ASSERT_NEAR(g.controls[k].axis.y, dAxisY, tol);
+        ASSERT_NEAR(g.controls[k].axis.z, dAxisZ, tol);
+    }
+
+    for (size_t i = 0; i < problem.bodies.size(); ++i)
+    {
+        const real dC0 = centeredDifference([i](adjoint::Problem& p, std::vector<adjoint::Control>&, real eps)
+        {
+            p.bodies[i].propulsion.C[0] += eps;
+        });
+        const real dA1 = centeredDifference([i](adjoint::Problem& p, std::vector<adjoint::Control>&, real eps)
+        {
+            p.bodies[i].propulsion.A[1] += eps;
+        });
+        const real dB2 = centeredDifference([i](adjoint::Problem& p, std::vector<adjoint::Control>&, real eps)
+        {
+            p.bodies[i].propulsion.B[2] += eps;
+        });
+        const real dmy = centeredDifference([i](adjoint::Problem& p, std::vector<adjoint::Control>&, real eps)
+        {
+            p.bodies[i].magnMoment.y += eps;
+        });
+
+        ASSERT_NEAR(g.bodies[i].propulsion.C[0], dC0, tol);
+        ASSERT_NEAR(g.bodies[i].propulsion.A[1], dA1, tol);
+        ASSERT_NEAR(g.bodies[i].propulsion.B[2], dB2, tol);
+        ASSERT_NEAR(g.bodies[i].magnMoment.y,    dmy, tol);
+    }
+}
+
+GTEST_TEST( ADJOINT, dual_numbers_differentiate_quaternion_rotations )
+{
+    using D = Dual<1>;
+    const real angle = 0.7_r;
+    const real3 axis {0.2_r, -1.0_r, 0.4_r};
+    const real3 v {1.0_r, 2.0_r, 3.0_r};
+
+    const auto q = QuaternionT<D>::createFromRotation(D::createVariable(angle, 0), {D(axis.x), D(axis.y), D(axis.z)});
+    const Vector3<D> w = q.rotate({D(v.x), D(v.y), D(v.z)});
+
+    // derivative of the rotation with respect to its angle: cross product with the unit axis
+    const real3 expected = cross(normalized(axis), Quaternion::createFromRotation(angle, axis).rotate(v));
+
+    constexpr real tol = helpers::byPrecision(1e-12_r, 1e-5_r);
+    ASSERT_NEAR(w.x.d[0], expected.x, tol);
+    ASSERT_NEAR(w.y.d[0], expected.y, tol);
+    ASSERT_NEAR(w.z.d[0], expected.z, tol);
+}
+
+GTEST_TEST( ADJOINT, cost_matches_simulation )
+{
+    const auto problem = createProblem(Simulation::ODEScheme::ForwardEuler, nullptr, 1);
+    const auto controls = createControls(1);
+    const long nsteps = problem.nstepsPerControl;
+
+    const real omega = controls[0].omega;
+    const real3 axis = normalized(controls[0].axis);
+    MagneticField field(magneticFieldMagnitude, [omega](real) {return omega;}, [axis](real) {return axis;});
+
+    Simulation sim(problem.bodies, field, 0.0_r);
+    sim.runForwardEuler(nsteps, problem.dt);
+
+    const real3 dr = sim.getBodies()[0].r - problem.targets[0];
+    ASSERT_NEAR(adjoint::computeCost(problem, controls), 0.5_r * dot(dr, dr), helpers::byPrecision(1e-12_r, 1e-5_r));
+}
+
+GTEST_TEST( ADJOINT, gradient_matches_finite_differences_forward_euler )
+{
+    const VelocityFieldTaylorGreenVortex flow({0.5_r, 0.5_r, -1.0_r}, {0.5_r, 0.5_r, 0.5_r});
+    checkGradientAgainstFiniteDifferences(Simulation::ODEScheme::ForwardEuler, &flow);
+}
+
+GTEST_TEST( ADJOINT, gradient_matches_finite_differences_rk4 )
+{
+    const VelocityFieldTaylorGreenVortex flow({0.5_r, 0.5_r, -1.0_r}, {0.5_r, 0.5_r, 0.5_r});
+    checkGradientAgainstFiniteDifferences(Simulation::ODEScheme::RK4, &flow);
+}
+
+GTEST_TEST( ADJOINT, gradient_matches_finite_differences_shear )
+{
+    const VelocityFieldShear flow(0.7_r);
+    checkGradientAgainstFiniteDifferences(Simulation::ODEScheme::RK4, &flow);
+}
+
+GTEST_TEST( ADJOINT, gradient_matches_finite_differences_no_flow )
+{
+    checkGradientAgainstFiniteDifferences(Simulation::ODEScheme::ForwardEuler, nullptr);
+}
+
+GTEST_TEST( ADJOINT, gradient_independent_of_checkpoints )
+{
+    const auto problem = createProblem(Simulation::ODEScheme::RK4, nullptr, 3);
+    const auto controls = createControls(4);
+
+    const auto g1 = adjoint::computeGradient(problem, controls, 1);
+    const auto g2 = adjoint::computeGradient(problem, controls);
+
+    for (size_t k = 0; k < controls.size(); ++k)
+    {
+        ASSERT_EQ(g1.controls[k].omega,  g2.controls[k].omega);
+        ASSERT_EQ(g1.controls[k].axis.x, g2.controls[k].axis.x);
+        ASSERT_EQ(g1.controls[k].axis.y, g2.controls[k].axis.y);
+        ASSERT_EQ(g1.controls[k].axis.z, g2.controls[k].axis.z);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -2,6 +2,9 @@
 
 #include <msode/core/simulation.h>
 #include <msode/core/velocity_field/constant.h>
+#include <msode/core/velocity_field/none.h>
+#include <msode/core/velocity_field/sum.h>
+#include <msode/core/velocity_field/taylor_green_vortex.h>
 
 #include <gtest/gtest.h>
 #include <random>
@@ -43,6 +46,80 @@ GTEST_TEST( ADVECTION, constant )
     ASSERT_NEAR(rEnd.z, tEnd * vel.z, eps);
 }
 
+// runs the same simulation with two velocity fields which are equal but dispatched to different time steppers
+static void checkSameTrajectories(std::unique_ptr<BaseVelocityField> specialized,
+                                  std::unique_ptr<BaseVelocityField> generic,
+                                  bool useRK4)
+{
+    const real kBT{0.0_r};
+    std::mt19937 gen{424242L};
+    const std::vector<RigidBody> bodies = {helpers::generateRandomBody(gen),
+                                           helpers::generateRandomBody(gen)};
+
+    MagneticField magneticField(1.0_r,
+                                [](real){return 2.0_r;},
+                                [](real){return real3 {0.0_r, 0.0_r, 1.0_r};});
+
+    Simulation simSpecialized(bodies, magneticField, kBT, std::move(specialized));
+    Simulation simGeneric    (bodies, magneticField, kBT, std::move(generic));
+
+    const long nsteps = 1000;
+    const real dt {1e-2_r};
+
+    if (useRK4)
+    {
+        simSpecialized.runRK4(nsteps, dt);
+        simGeneric    .runRK4(nsteps, dt);
+    }
+    else
+    {
+        simSpecialized.runForwardEuler(nsteps, dt);
+        simGeneric    .runForwardEuler(nsteps, dt);
+    }
+
+    constexpr real eps {1e-10_r};
+
+    for (size_t i = 0; i < bodies.size(); ++i)
+    {
+        const auto& bs = simSpecialized.getBodies()[i];
+        const auto& bg = simGeneric    .getBodies()[i];
+        ASSERT_NEAR(bs.r.x, bg.r.x, eps);
+        ASSERT_NEAR(bs.r.y, bg.r.y, eps);
+        ASSERT_NEAR(bs.r.z, bg.r.z, eps);
+        ASSERT_NEAR(bs.q.w, bg.q.w, eps);
+        ASSERT_NEAR(bs.q.x, bg.q.x, eps);
+        ASSERT_NEAR(bs.q.y, bg.q.y, eps);
+        ASSERT_NEAR(bs.q.z, bg.q.z, eps);
+    }
+}
+
+static std::unique_ptr<BaseVelocityField> createSumWithZero(std::unique_ptr<BaseVelocityField> field)
+{
+    std::vector<std::unique_ptr<BaseVelocityField>> fields;
+    fields.push_back(std::move(field));
+    fields.push_back(std::make_unique<VelocityFieldConstant>(real3{0.0_r, 0.0_r, 0.0_r}));
+    return std::make_unique<VelocityFieldSum>(std::move(fields));
+}
+
+GTEST_TEST( ADVECTION, specialized_stepper_no_flow )
+{
+    for (bool useRK4 : {false, true})
+        checkSameTrajectories(std::make_unique<VelocityFieldNone>(),
+                              createSumWithZero(std::make_unique<VelocityFieldNone>()),
+                              useRK4);
+}
+
+GTEST_TEST( ADVECTION, specialized_stepper_taylor_green_vortex )
+{
+    const real3 magnitude {1.0_r, 0.5_r, -2.0_r};
+    const real3 invPeriod {0.1_r, 0.2_r, 0.1_r};
+
+    for (bool useRK4 : {false, true})
+        checkSameTrajectories(std::make_unique<VelocityFieldTaylorGreenVortex>(magnitude, invPeriod),
+                              createSumWithZero(std::make_unique<VelocityFieldTaylorGreenVortex>(magnitude, invPeriod)),
+                              useRK4);
+}
+
 int main(int argc, char **argv)
 {
     ::testing::InitGoogleTest(&argc, argv);
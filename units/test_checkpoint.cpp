@@ -0,0 +1,143 @@
+#include "helpers.h"
+
+#include <msode/core/checkpoint.h>
+
+#include <gtest/gtest.h>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <thread>
+
+using namespace msode;
+
+static std::unique_ptr<Simulation> createSimulation()
+{
+    std::mt19937 gen(4242);
+    const std::vector<RigidBody> bodies {helpers::generateRandomBody(gen),
+                                         helpers::generateRandomBody(gen)};
+
+    const real omega = 0.5_r * bodies[0].stepOutFrequency(1.0_r);
+
+    MagneticField magneticField(1.0_r,
+                                [omega](real t) {return omega * (1.0_r + 0.1_r * std::sin(t));},
+                                [](real t) {return normalized(real3 {1.0_r, std::cos(t), 0.0_r});});
+
+    const real kBT = 0.1_r;
+    return std::make_unique<Simulation>(bodies, magneticField, kBT);
+}
+
+static std::string readFile(const std::string& fileName)
+{
+    std::ifstream f(fileName, std::ios::binary);
+    std::stringstream ss;
+    ss << f.rdbuf();
+    return ss.str();
+}
+
+static bool bitwiseEqual(const real3& a, const real3& b)
+{
+    return std::memcmp(&a, &b, sizeof(a)) == 0;
+}
+
+GTEST_TEST( CHECKPOINT, restarted_run_is_bit_identical )
+{
+    const real dt = 1e-2_r;
+    const long nsteps = 2000;
+    const long nstepsBeforeCheckpoint = 1234;
+    const long dumpEvery = 10;
+
+    auto reference = createSimulation();
+    reference->activateDump("checkpoint_reference.dat", dumpEvery);
+    reference->runForwardEuler(nsteps, dt);
+    reference.reset(); // flush the dump
+
+    {
+        auto interrupted = createSimulation();
+        interrupted->activateDump("checkpoint_restarted.dat", dumpEvery);
+        interrupted->runForwardEuler(nstepsBeforeCheckpoint, dt);
+        interrupted->writeCheckpoint("checkpoint.bin");
+        // progress lost at the interruption
+        interrupted->runForwardEuler(321, dt);
+    }
+
+    auto restarted = createSimulation();
+    restarted->restartFromCheckpoint("checkpoint.bin");
+    ASSERT_EQ(restarted->getCurrentTimeStep(), nstepsBeforeCheckpoint);
+    restarted->runForwardEuler(nsteps - restarted->getCurrentTimeStep(), dt);
+
+    auto expected = createSimulation();
+    expected->runForwardEuler(nsteps, dt);
+
+    ASSERT_EQ(restarted->getCurrentTime(), expected->getCurrentTime());
+    ASSERT_EQ(restarted->getField().phase, expected->getField().phase);
+
+    for (size_t i = 0; i < expected->getBodies().size(); ++i)
+    {
+        const auto& a = restarted->getBodies()[i];
+        const auto& b = expected->getBodies()[i];
+        ASSERT_TRUE(bitwiseEqual(a.r, b.r));
+        ASSERT_TRUE(bitwiseEqual(a.v, b.v));
+        ASSERT_TRUE(bitwiseEqual(a.omega, b.omega));
+        ASSERT_EQ(a.q.w, b.q.w);
+        ASSERT_EQ(a.q.x, b.q.x);
+        ASSERT_EQ(a.q.y, b.q.y);
+        ASSERT_EQ(a.q.z, b.q.z);
+    }
+
+    restarted.reset(); // flush the dump
+    ASSERT_EQ(readFile("checkpoint_restarted.dat"), readFile("checkpoint_reference.dat"));
+}
+
+GTEST_TEST( CHECKPOINT, periodic_checkpoints_are_written_in_the_background )
+{
+    const real dt = 1e-2_r;
+    const long nsteps = 5000;
+
+    auto sim = createSimulation();
+    sim->activateCheckpoint("checkpoint_periodic.bin", 0.0);
+    sim->runForwardEuler(nsteps, dt);
+    sim.reset(); // wait for the last write
+
+    const Checkpoint checkpoint = readCheckpoint("checkpoint_periodic.bin");
+    ASSERT_GT(checkpoint.state.currentTimeStep, 0);
+    ASSERT_LT(checkpoint.state.currentTimeStep, nsteps);
+    ASSERT_TRUE(checkpoint.dumpFileName.empty());
+    ASSERT_EQ(checkpoint.state.bodies.size(), 2u);
+
+    // resuming from the last checkpoint gives the same final state as the uninterrupted run
+    auto restarted = createSimulation();
+    restarted->restartFromCheckpoint("checkpoint_periodic.bin");
+    restarted->runForwardEuler(nsteps - restarted->getCurrentTimeStep(), dt);
+
+    auto expected = createSimulation();
+    expected->runForwardEuler(nsteps, dt);
+
+    for (size_t i = 0; i < expected->getBodies().size(); ++i)
+        ASSERT_TRUE(bitwiseEqual(restarted->getBodies()[i].r, expected->getBodies()[i].r));
+}
+
+GTEST_TEST( CHECKPOINT, failed_background_write_is_reported_by_wait )
+{
+    auto sim = createSimulation();
+    Checkpoint checkpoint;
+    sim->snapshot(checkpoint.state);
+
+    // the writing thread must not exit the program: the failure is raised on the calling thread
+    ASSERT_EXIT(
+    {
+        CheckpointWriter writer("no_such_directory/checkpoint.bin");
+        writer.writeAsync(checkpoint);
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        fprintf(stderr, "still running\n");
+        writer.wait();
+    }, ::testing::ExitedWithCode(1), "still running.*Could not open the file 'no_such_directory/checkpoint.bin.tmp'");
+}
+
+int main(int argc, char **argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,101 @@
+#include "helpers.h"
+
+#include <msode/core/field_schedule.h>
+#include <msode/core/simulation.h>
+
+#include <gtest/gtest.h>
+#include <cmath>
+
+using namespace msode;
+
+constexpr real3 ex {1.0_r, 0.0_r, 0.0_r};
+constexpr real3 ey {0.0_r, 1.0_r, 0.0_r};
+constexpr real3 ez {0.0_r, 0.0_r, 1.0_r};
+
+GTEST_TEST( FIELD_SCHEDULE, lookup )
+{
+    FieldSchedule schedule;
+    schedule.addSegment(1.0_r,  2.0_r, ex);
+    schedule.addSegment(0.0_r,  5.0_r, ey); // ignored
+    schedule.addSegment(0.5_r, -3.0_r, ey);
+    schedule.addSegment(2.0_r,  1.0_r, ez);
+
+    ASSERT_EQ(schedule.getNumSegments(), 3);
+    ASSERT_EQ(schedule.getEndTime(), 3.5_r);
+
+    const auto& switchTimes = schedule.getSwitchTimes();
+    ASSERT_EQ(switchTimes.size(), 3u);
+    ASSERT_EQ(switchTimes[0], 1.0_r);
+    ASSERT_EQ(switchTimes[1], 1.5_r);
+    ASSERT_EQ(switchTimes[2], 3.5_r);
+
+    ASSERT_EQ(schedule.getOmega(0.0_r),  2.0_r);
+    ASSERT_EQ(schedule.getOmega(0.99_r), 2.0_r);
+    ASSERT_EQ(schedule.getOmega(1.0_r), -3.0_r); // segments start at their switch time
+    ASSERT_EQ(schedule.getOmega(1.2_r), -3.0_r);
+    ASSERT_EQ(schedule.getOmega(3.0_r),  1.0_r);
+    ASSERT_EQ(schedule.getOmega(4.0_r),  0.0_r);
+
+    ASSERT_EQ(schedule.getDirection(0.5_r).x, 1.0_r);
+    ASSERT_EQ(schedule.getDirection(1.2_r).y, 1.0_r);
+    ASSERT_EQ(schedule.getDirection(3.0_r).z, 1.0_r);
+    ASSERT_EQ(schedule.getDirection(5.0_r).z, 1.0_r);
+}
+
+GTEST_TEST( FIELD_SCHEDULE, steps_aligned_on_switches )
+{
+    std::mt19937 gen {4242};
+    const std::vector<RigidBody> bodies {helpers::generateRandomBody(gen)};
+
+    // durations are not multiples of the time step
+    FieldSchedule schedule;
+    schedule.addSegment(0.37_r,  2.0_r, ez);
+    schedule.addSegment(0.21_r, -1.0_r, ez);
+    schedule.addSegment(0.53_r,  3.0_r, ez);
+
+    Simulation sim(bodies, schedule.createMagneticField(1.0_r), 0.0_r);
+
+    const real dt = 0.05_r;
+    const real tEnd = schedule.getEndTime();
+    sim.runForwardEulerUntil(tEnd, dt, schedule.getSwitchTimes());
+
+    ASSERT_EQ(sim.getCurrentTime(), tEnd);
+
+    // the phase is the exact integral of the piecewise constant frequency only if no step straddles a switch
+    const real expectedPhase = 0.37_r * 2.0_r - 0.21_r * 1.0_r + 0.53_r * 3.0_r;
+    ASSERT_NEAR(sim.getField().phase, expectedPhase, helpers::byPrecision(1e-12_r, 1e-5_r));
+}
+
+GTEST_TEST( FIELD_SCHEDULE, run_until_intermediate_times )
+{
+    std::mt19937 gen {4242};
+    const std::vector<RigidBody> bodies {helpers::generateRandomBody(gen)};
+
+    FieldSchedule schedule;
+    schedule.addSegment(1.0_r, 2.0_r, ez);
+    schedule.addSegment(1.0_r, 1.0_r, ex);
+
+    Simulation simA(bodies, schedule.createMagneticField(1.0_r), 0.0_r);
+    Simulation simB(bodies, schedule.createMagneticField(1.0_r), 0.0_r);
+
+    const real dt = 0.01_r;
+    simA.runForwardEulerUntil(2.0_r, dt, schedule.getSwitchTimes());
+
+    simB.runForwardEulerUntil(0.5_r, dt, schedule.getSwitchTimes());
+    ASSERT_EQ(simB.getCurrentTime(), 0.5_r);
+    simB.runForwardEulerUntil(2.0_r, dt, schedule.getSwitchTimes());
+
+    const real tol = helpers::byPrecision(1e-6_r, 1e-3_r);
+    const real3 rA = simA.getBodies()[0].r;
+    const real3 rB = simB.getBodies()[0].r;
+
+    ASSERT_NEAR(rA.x, rB.x, tol);
+    ASSERT_NEAR(rA.y, rB.y, tol);
+    ASSERT_NEAR(rA.z, rB.z, tol);
+}
+
+int main(int argc, char **argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
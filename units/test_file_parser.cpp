@@ -32,18 +32,18 @@ GTEST_TEST( FILE_PARSER, types )
     FileParser fp(filename);
     ASSERT_EQ(fp.getStr("str"), "hello");
 
-    ASSERT_EQ(fp.getReal3("real3").x, 1.1);
-    ASSERT_EQ(fp.getReal3("real3").y, 2.2);
-    ASSERT_EQ(fp.getReal3("real3").z, 3.3);
-
-    ASSERT_EQ(fp.getQuaternion("quaternion").w,  1.1);
-    ASSERT_EQ(fp.getQuaternion("quaternion").x, -2.2);
-    ASSERT_EQ(fp.getQuaternion("quaternion").y,  3.3);
-    ASSERT_EQ(fp.getQuaternion("quaternion").z, -4.4);
-
-    ASSERT_EQ(fp.getSubMatrix("subm")[0],  1.1);
-    ASSERT_EQ(fp.getSubMatrix("subm")[1], -2.2);
-    ASSERT_EQ(fp.getSubMatrix("subm")[2],  3.3);
+    ASSERT_EQ(fp.getReal3("real3").x, 1.1_r);
+    ASSERT_EQ(fp.getReal3("real3").y, 2.2_r);
+    ASSERT_EQ(fp.getReal3("real3").z, 3.3_r);
+
+    ASSERT_EQ(fp.getQuaternion("quaternion").w,  1.1_r);
+    ASSERT_EQ(fp.getQuaternion("quaternion").x, -2.2_r);
+    ASSERT_EQ(fp.getQuaternion("quaternion").y,  3.3_r);
+    ASSERT_EQ(fp.getQuaternion("quaternion").z, -4.4_r);
+
+    ASSERT_EQ(fp.getSubMatrix("subm")[0],  1.1_r);
+    ASSERT_EQ(fp.getSubMatrix("subm")[1], -2.2_r);
+    ASSERT_EQ(fp.getSubMatrix("subm")[2],  3.3_r);
 }
 
 static std::map<std::string, std::string> createLargeData(int nentries)
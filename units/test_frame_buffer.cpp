@@ -0,0 +1,107 @@
+#include "helpers.h"
+
+#include <msode/core/frame_buffer.h>
+
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <sstream>
+
+using namespace msode;
+
+GTEST_TEST( FRAME_BUFFER, keeps_the_last_frames_in_order )
+{
+    const int frameSize = 3;
+    const long capacity = 4;
+
+    for (bool singlePrecision : {false, true})
+    {
+        FrameBuffer buffer(frameSize, capacity, singlePrecision);
+
+        for (int i = 0; i < 10; ++i)
+        {
+            const double frame[frameSize] = {1.0 * i, 0.5 * i, -1.0 * i};
+            buffer.push(frame);
+
+            ASSERT_EQ(buffer.size(), std::min(static_cast<long>(i + 1), capacity));
+            ASSERT_EQ(buffer.getNumPushed(), i + 1);
+        }
+
+        for (long frameId = 0; frameId < capacity; ++frameId)
+        {
+            const double i = 10 - capacity + frameId;
+            ASSERT_EQ(buffer.get(frameId, 0), i);
+            ASSERT_EQ(buffer.get(frameId, 1), 0.5 * i);
+            ASSERT_EQ(buffer.get(frameId, 2), -i);
+        }
+
+        buffer.clear();
+        ASSERT_EQ(buffer.size(), 0);
+    }
+}
+
+static std::unique_ptr<Simulation> createSimulation()
+{
+    std::mt19937 gen(4242);
+    const std::vector<RigidBody> bodies {helpers::generateRandomBody(gen),
+                                         helpers::generateRandomBody(gen)};
+
+    const real omega = 0.5_r * bodies[0].stepOutFrequency(1.0_r);
+
+    MagneticField magneticField(1.0_r,
+                                [omega](real) {return omega;},
+                                [](real t) {return normalized(real3 {1.0_r, std::cos(t), 0.0_r});});
+
+    return std::make_unique<Simulation>(bodies, magneticField, 0.0_r);
+}
+
+static std::vector<std::string> readLines(const std::string& fileName)
+{
+    std::ifstream f(fileName);
+    std::vector<std::string> lines;
+    std::string line;
+    while (std::getline(f, line))
+        lines.push_back(line);
+    return lines;
+}
+
+GTEST_TEST( FRAME_BUFFER, flushed_dump_matches_direct_dump )
+{
+    const real dt = 1e-2_r;
+    const long nsteps = 1000;
+    const long dumpEvery = 7;
+    const long capacity = 50;
+
+    auto direct = createSimulation();
+    direct->activateDump("frames_direct.dat", dumpEvery);
+    direct->runForwardEuler(nsteps, dt);
+    direct.reset(); // flush the dump
+
+    auto buffered = createSimulation();
+    buffered->activateBufferedDump(dumpEvery, capacity);
+    buffered->runForwardEuler(nsteps, dt);
+    buffered->flushBufferedDump("frames_buffered.dat");
+
+    const auto expected = readLines("frames_direct.dat");
+    const auto lines = readLines("frames_buffered.dat");
+
+    ASSERT_EQ(buffered->getFrameBuffer()->getNumPushed(), static_cast<long>(expected.size()));
+    ASSERT_EQ(static_cast<long>(lines.size()), capacity);
+
+    // the buffer holds the last frames of the run
+    for (long i = 0; i < capacity; ++i)
+        ASSERT_EQ(lines[i], expected[expected.size() - capacity + i]);
+
+    buffered->reset();
+    ASSERT_EQ(buffered->getFrameBuffer()->size(), 0);
+
+    std::remove("frames_direct.dat");
+    std::remove("frames_buffered.dat");
+}
+
+int main(int argc, char **argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
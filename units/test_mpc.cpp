@@ -0,0 +1,111 @@
+#include "helpers.h"
+
+#include <msode/mpc/controller.h>
+
+#include <gtest/gtest.h>
+#include <memory>
+
+using namespace msode;
+
+constexpr real distanceThreshold = 2.0_r;
+
+static std::unique_ptr<rl::MSodeEnvironment> createTestEnv()
+{
+    std::mt19937 gen(4242);
+
+    helpers::TestEnvironmentParams p;
+    p.bodies            = {helpers::generateRandomBody(gen)};
+    p.distanceThreshold = distanceThreshold;
+    p.domainRadius      = 20.0_r;
+    p.tmax              = 1000.0_r;
+
+    return helpers::createTestEnvironment(std::move(p));
+}
+
+static mpc::Params createTestParams()
+{
+    mpc::Params params;
+    params.horizon       = 3;
+    params.numCandidates = 16;
+    params.numIterations = 2;
+    params.numElites     = 4;
+    return params;
+}
+
+static std::vector<std::vector<double>> computeFirstActions(int numThreads, int numActions)
+{
+    auto env = createTestEnv();
+    std::mt19937 gen(42);
+    env->reset(gen, rl::MSodeEnvironment::NO_DUMP, true);
+
+    mpc::Controller controller(createTestEnv, createTestParams(), numThreads);
+    controller.reset(0);
+
+    std::vector<std::vector<double>> actions;
+    std::vector<double> action(env->numActions());
+
+    for (int i = 0; i < numActions; ++i)
+    {
+        controller.computeAction(*env, action);
+        env->advance(action);
+        actions.push_back(action);
+    }
+    return actions;
+}
+
+GTEST_TEST( MPC, reaches_target )
+{
+    auto env = createTestEnv();
+    mpc::Controller controller(createTestEnv, createTestParams(), 2);
+
+    auto policy = [&controller](const rl::EpisodeContext& context, const rl::MSodeEnvironment& e,
+                                const std::vector<double>&, std::vector<double>& action)
+    {
+        if (context.actionId == 0)
+            controller.reset(context.episodeId);
+        controller.computeAction(e, action);
+    };
+
+    std::vector<double> action;
+    const long seed = 1234;
+
+    for (long episodeId = 0; episodeId < 2; ++episodeId)
+    {
+        const auto result = rl::runEpisode(*env, seed, episodeId, 0, policy, action);
+        ASSERT_EQ(result.status, rl::MSodeEnvironment::Status::Success);
+        ASSERT_LT(result.finalMaxDistance, distanceThreshold);
+    }
+}
+
+GTEST_TEST( MPC, decisions_independent_of_num_threads )
+{
+    const int numActions = 3;
+    ASSERT_EQ(computeFirstActions(1, numActions), computeFirstActions(3, numActions));
+}
+
+GTEST_TEST( MPC, time_budget_keeps_warm_start )
+{
+    auto env = createTestEnv();
+    std::mt19937 gen(42);
+    env->reset(gen, rl::MSodeEnvironment::NO_DUMP, true);
+
+    mpc::Params params = createTestParams();
+    params.timeBudget = 1e-9; // exhausted before the first rollout
+
+    mpc::Controller controller(createTestEnv, params, 2);
+    controller.reset(0);
+
+    std::vector<double> action(env->numActions());
+    controller.computeAction(*env, action);
+
+    const auto& info = controller.getLastDecisionInfo();
+    ASSERT_EQ(info.numIterations, 1);
+    ASSERT_EQ(info.numRollouts, 1);
+    ASSERT_TRUE(std::isfinite(info.bestCost));
+}
+
+int main(int argc, char **argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
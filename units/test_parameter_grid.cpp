@@ -0,0 +1,80 @@
+#include <msode/core/parameter_grid.h>
+
+#include <gtest/gtest.h>
+
+using namespace msode;
+
+static Config createBaseConfig()
+{
+    return Config::parse(R"({
+        "kBT": 0.0,
+        "velocityField": {"__type": "FieldTaylorGreenVortex", "magnitude": [1.0, 1.0, -2.0], "invPeriod": [0.5, 0.5, 0.5]}
+    })");
+}
+
+GTEST_TEST( PARAMETER_GRID, variants_enumerate_cartesian_product )
+{
+    const ParameterGrid grid(Config::parse(R"({
+        "parameters": [
+            {"pointer": "/kBT", "values": [0.0, 0.1]},
+            {"pointer": "/velocityField/magnitude", "factors": [0.0, 1.0, 2.0]}
+        ]
+    })"));
+
+    ASSERT_EQ(grid.getNumVariants(), 6);
+
+    const Config base = createBaseConfig();
+
+    for (long variantId = 0; variantId < grid.getNumVariants(); ++variantId)
+    {
+        const auto indices = grid.getValueIndices(variantId);
+        ASSERT_EQ(indices.size(), 2u);
+        ASSERT_EQ(indices[0], variantId / 3);
+        ASSERT_EQ(indices[1], variantId % 3);
+
+        const Config variant = grid.createVariant(base, variantId);
+        const real kBT = indices[0] == 0 ? 0.0_r : 0.1_r;
+        const real factor = indices[1];
+
+        ASSERT_EQ(variant.at("kBT").get<real>(), kBT);
+
+        const auto magnitude = variant.at("velocityField").at("magnitude").get<std::vector<real>>();
+        ASSERT_EQ(magnitude[0],  1.0_r * factor);
+        ASSERT_EQ(magnitude[1],  1.0_r * factor);
+        ASSERT_EQ(magnitude[2], -2.0_r * factor);
+
+        // the other entries are untouched
+        ASSERT_EQ(variant.at("velocityField").at("invPeriod"), base.at("velocityField").at("invPeriod"));
+    }
+}
+
+GTEST_TEST( PARAMETER_GRID, values_replace_whole_objects_and_add_missing_entries )
+{
+    const ParameterGrid grid(Config::parse(R"({
+        "parameters": [
+            {"pointer": "/velocityField", "values": [{"__type": "None"}]},
+            {"pointer": "/dumpEvery", "values": [0]}
+        ]
+    })"));
+
+    ASSERT_EQ(grid.getNumVariants(), 1);
+
+    const Config variant = grid.createVariant(createBaseConfig(), 0);
+
+    ASSERT_EQ(variant.at("velocityField"), Config::parse(R"({"__type": "None"})"));
+    ASSERT_EQ(variant.at("dumpEvery").get<int>(), 0);
+}
+
+GTEST_TEST( PARAMETER_GRID, no_parameters_gives_the_base_config )
+{
+    const ParameterGrid grid(Config::parse(R"({"parameters": []})"));
+
+    ASSERT_EQ(grid.getNumVariants(), 1);
+    ASSERT_EQ(grid.createVariant(createBaseConfig(), 0), createBaseConfig());
+}
+
+int main(int argc, char **argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,164 @@
+#include "helpers.h"
+
+#include <msode/analytic_control/helpers.h>
+#include <msode/rl/environment.h>
+#include <msode/rl/pos_ic/time_distance.h>
+#include <msode/rl/target_distances/euclidean_tt.h>
+#include <msode/rl/target_distances/square.h>
+
+#include <gtest/gtest.h>
+#include <atomic>
+#include <cstdlib>
+#include <memory>
+#include <new>
+
+// counting allocator hook: every global allocation increments the counter
+static std::atomic<long> numAllocations {0};
+
+void* operator new(std::size_t size)
+{
+    ++numAllocations;
+    if (void *ptr = std::malloc(size))
+        return ptr;
+    throw std::bad_alloc();
+}
+
+void operator delete(void *ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete(void *ptr, std::size_t) noexcept
+{
+    std::free(ptr);
+}
+
+using namespace msode;
+using namespace msode::rl;
+
+constexpr real magneticFieldMagnitude = 1.0_r;
+constexpr real domainRadius           = 50.0_r;
+
+static std::unique_ptr<MSodeEnvironment> createTestEnv(std::mt19937& gen, std::unique_ptr<TargetDistance> targetDistance,
+                                                       bool travelTimeIC = false)
+{
+    helpers::TestEnvironmentParams params;
+    params.bodies = {helpers::generateRandomBody(gen),
+                     helpers::generateRandomBody(gen)};
+
+    params.domainRadius    = domainRadius;
+    params.tmax            = 200.0_r;
+    params.stepsPerPeriod  = 20.0_r;
+    params.nstepsPerAction = 100;
+    params.rewards         = {1.0_r, 0.1_r, 1.0_r};
+
+    params.termination.cutHopeless = true;
+    params.termination.travelTimeBound = true;
+    params.termination.cutoffFactor = 0.1_r; // evaluate the bounds but rarely cut the episodes
+
+    params.localFrameActions = true;
+    params.targetDistance = std::move(targetDistance);
+
+    if (travelTimeIC)
+    {
+        const bool ball = true;
+        const real travelTime = 20.0_r;
+        params.posIC = std::make_unique<EnvPosICTimeDistance>(ball, travelTime,
+                                                              analytic_control::createVelocityMatrix(magneticFieldMagnitude, params.bodies));
+    }
+
+    return helpers::createTestEnvironment(std::move(params));
+}
+
+static void runEpisode(MSodeEnvironment& env, std::mt19937& gen, std::vector<double>& action)
+{
+    const real omega = 0.8_r * env.getBodies()[0].stepOutFrequency(magneticFieldMagnitude);
+
+    env.reset(gen, MSodeEnvironment::NO_DUMP, true);
+
+    auto status = MSodeEnvironment::Status::Running;
+
+    while (status == MSodeEnvironment::Status::Running)
+    {
+        const auto& state = env.getState();
+        action[0] = omega;
+        action[1] = state[0];
+        action[2] = state[1];
+        action[3] = state[2];
+
+        status = env.advance(action);
+        env.getReward();
+    }
+}
+
+static long countAllocationsPerEpisodes(std::unique_ptr<TargetDistance> targetDistance, bool travelTimeIC = false)
+{
+    std::mt19937 gen(4242);
+    auto env = createTestEnv(gen, std::move(targetDistance), travelTimeIC);
+    std::vector<double> action(env->numActions());
+
+    // warm up: buffers reach their final size during the first episode
+    runEpisode(*env, gen, action);
+
+    const long numAllocationsStart = numAllocations.load();
+
+    for (int i = 0; i < 5; ++i)
+        runEpisode(*env, gen, action);
+
+    return numAllocations.load() - numAllocationsStart;
+}
+
+GTEST_TEST( RL_ALLOCATIONS, counter_works )
+{
+    const long start = numAllocations.load();
+    auto p = std::make_unique<int>(3);
+    ASSERT_GT(numAllocations.load(), start);
+}
+
+GTEST_TEST( RL_ALLOCATIONS, steady_state_episodes_do_not_allocate )
+{
+    ASSERT_EQ(countAllocationsPerEpisodes(std::make_unique<TargetDistanceSquare>()), 0);
+}
+
+GTEST_TEST( RL_ALLOCATIONS, steady_state_episodes_do_not_allocate_travel_time_distance )
+{
+    ASSERT_EQ(countAllocationsPerEpisodes(std::make_unique<TargetDistanceEuclideanTT>(magneticFieldMagnitude)), 0);
+}
+
+GTEST_TEST( RL_ALLOCATIONS, steady_state_episodes_do_not_allocate_travel_time_ic )
+{
+    const bool travelTimeIC = true;
+    ASSERT_EQ(countAllocationsPerEpisodes(std::make_unique<TargetDistanceSquare>(), travelTimeIC), 0);
+}
+
+GTEST_TEST( RL_ALLOCATIONS, snapshot_and_restore_do_not_allocate )
+{
+    std::mt19937 gen(4242);
+    auto env = createTestEnv(gen, std::make_unique<TargetDistanceSquare>());
+    const std::vector<double> action {1.0, 1.0, 0.0, 0.0};
+
+    env->reset(gen, MSodeEnvironment::NO_DUMP, true);
+
+    // warm up: the state and the buffers of the environment reach their final size
+    MSodeEnvironment::State state;
+    env->snapshot(state);
+    env->advance(action);
+    env->restore(state);
+
+    const long numAllocationsStart = numAllocations.load();
+
+    for (int i = 0; i < 5; ++i)
+    {
+        env->snapshot(state);
+        env->advance(action);
+        env->restore(state);
+    }
+
+    ASSERT_EQ(numAllocations.load() - numAllocationsStart, 0);
+}
+
+int main(int argc, char **argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
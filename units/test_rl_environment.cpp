@@ -1,57 +1,40 @@
 #include "helpers.h"
 
-#include <msode/core/velocity_field/none.h>
 #include <msode/rl/environment.h>
+#include <msode/rl/episode_log.h>
+#include <msode/rl/episode_runner.h>
 #include <msode/rl/factory.h>
 #include <msode/rl/field_from_action/factory.h>
-#include <msode/rl/field_from_action/direct.h>
 #include <msode/rl/pos_ic/ball.h>
 #include <msode/rl/pos_ic/factory.h>
-#include <msode/rl/target_distances/square.h>
 
 #include <gtest/gtest.h>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
 #include <memory>
+#include <sstream>
 
 using namespace msode;
 using namespace msode::rl;
 
 constexpr real magneticFieldMagnitude = 1.0_r;
-constexpr real distanceThreshold      = 2.0_r;
 constexpr real domainRadius           = 50.0_r;
 constexpr real kBT                    = 0.0_r;
 
-static std::unique_ptr<MSodeEnvironment> createTestEnv(std::mt19937& gen)
+static std::unique_ptr<MSodeEnvironment> createTestEnv(std::mt19937& gen, real tmax = 500.0_r,
+                                                      TerminationParams termination = TerminationParams{},
+                                                      real temperature = kBT, long dumpEvery = 0)
 {
-    const RigidBody body = helpers::generateRandomBody(gen);
-
-    const real omegaC     = body.stepOutFrequency(magneticFieldMagnitude);
-    const real omegaCperp = body.stepOutFrequency(magneticFieldMagnitude, 2);
-
-    const real orientScale = 2.0_r * M_PI / omegaCperp;
-
-    TimeParams tParams;
-    RewardParams rParams;
-
-    tParams.dt              = 2.0_r * M_PI / omegaC / 50;
-    tParams.tmax            = 500.0_r;
-    tParams.nstepsPerAction = 10.0_r * orientScale / tParams.dt;
-    tParams.dumpEvery       = 0;
-
-    rParams.timeCoeff        = 0.0_r;
-    rParams.terminationBonus = 0.0_r;
-
-    Params params(tParams, rParams, magneticFieldMagnitude, distanceThreshold, kBT);
-
-    auto posIc = std::make_unique<EnvPosICBall>(domainRadius);
-    std::vector<RigidBody> initialBodies = {body};
-    auto actionField = std::make_unique<FieldFromActionDirect>(0.0_r, 2.0_r * omegaC);
-    auto velField = std::make_unique<VelocityFieldNone>();
-    auto targetDistance = std::make_unique<TargetDistanceSquare>();
-
-    return std::make_unique<MSodeEnvironment>(params,
-                                              std::move(posIc), initialBodies,
-                                              std::move(actionField), std::move(velField),
-                                              std::move(targetDistance));
+    helpers::TestEnvironmentParams params;
+    params.bodies           = {helpers::generateRandomBody(gen)};
+    params.domainRadius     = domainRadius;
+    params.kBT              = temperature;
+    params.tmax             = tmax;
+    params.dumpEvery        = dumpEvery;
+    params.periodsPerAction = 10.0_r;
+    params.termination      = termination;
+    return helpers::createTestEnvironment(std::move(params));
 }
 
 GTEST_TEST( RL_ENVIRONMENT, reward_positive_towards_target )
@@ -81,6 +64,117 @@ GTEST_TEST( RL_ENVIRONMENT, reward_positive_towards_target )
     }
 }
 
+static std::vector<double> actionTowardsTarget(const MSodeEnvironment& env)
+{
+    const RigidBody& body = env.getBodies()[0];
+    const real omega = 0.8_r * body.stepOutFrequency(magneticFieldMagnitude);
+    const real3 r = normalized(body.r);
+    return {omega, r.x, r.y, r.z};
+}
+
+GTEST_TEST( RL_ENVIRONMENT, skipping_distance_checks_does_not_change_episodes )
+{
+    TerminationParams checkAlways, checkWhenReachable;
+    checkAlways.skipDistanceChecks = false;
+    checkWhenReachable.skipDistanceChecks = true;
+
+    std::mt19937 genEnvA(4242), genEnvB(4242);
+    auto envA = createTestEnv(genEnvA, 500.0_r, checkAlways);
+    auto envB = createTestEnv(genEnvB, 500.0_r, checkWhenReachable);
+
+    for (long episode = 0; episode < 5; ++episode)
+    {
+        std::mt19937 genA(episode), genB(episode);
+        envA->reset(genA, MSodeEnvironment::NO_DUMP, true);
+        envB->reset(genB, MSodeEnvironment::NO_DUMP, true);
+
+        auto statusA = MSodeEnvironment::Status::Running;
+        auto statusB = MSodeEnvironment::Status::Running;
+
+        while (statusA == MSodeEnvironment::Status::Running)
+        {
+            statusA = envA->advance(actionTowardsTarget(*envA));
+            statusB = envB->advance(actionTowardsTarget(*envB));
+            ASSERT_EQ(statusA, statusB);
+            ASSERT_EQ(envA->getSimulationTime(), envB->getSimulationTime());
+            ASSERT_EQ(envA->getReward(), envB->getReward());
+        }
+    }
+}
+
+GTEST_TEST( RL_ENVIRONMENT, exact_crossing_time_within_last_step )
+{
+    TerminationParams exact;
+    exact.exactCrossing = true;
+
+    std::mt19937 gen(4242);
+    auto env = createTestEnv(gen, 500.0_r, exact);
+
+    int numSuccesses {0};
+
+    for (long episode = 0; episode < 5; ++episode)
+    {
+        std::mt19937 genEpisode(episode);
+        env->reset(genEpisode, MSodeEnvironment::NO_DUMP, true);
+
+        auto status = MSodeEnvironment::Status::Running;
+        while (status == MSodeEnvironment::Status::Running)
+            status = env->advance(actionTowardsTarget(*env));
+
+        if (status != MSodeEnvironment::Status::Success)
+            continue;
+
+        ++numSuccesses;
+        const real tEnd = env->sim->getCurrentTime();
+        const real tCrossing = env->getSimulationTime();
+        ASSERT_LE(tCrossing, tEnd);
+        ASSERT_GE(tCrossing, tEnd - 2.0_r * M_PI / env->getBodies()[0].stepOutFrequency(magneticFieldMagnitude) / 50);
+    }
+
+    ASSERT_GT(numSuccesses, 0);
+}
+
+GTEST_TEST( RL_ENVIRONMENT, hopeless_episodes_are_cut_early )
+{
+    TerminationParams noCut, cut;
+    cut.cutHopeless = true;
+    cut.travelTimeBound = true;
+
+    // short episodes so that many of them can not succeed
+    const real tmax = 30.0_r;
+    std::mt19937 genEnvA(4242), genEnvB(4242);
+    auto envA = createTestEnv(genEnvA, tmax, noCut);
+    auto envB = createTestEnv(genEnvB, tmax, cut);
+
+    for (long episode = 0; episode < 20; ++episode)
+    {
+        std::mt19937 genA(episode), genB(episode);
+        envA->reset(genA, MSodeEnvironment::NO_DUMP, true);
+        envB->reset(genB, MSodeEnvironment::NO_DUMP, true);
+
+        auto statusA = MSodeEnvironment::Status::Running;
+        auto statusB = MSodeEnvironment::Status::Running;
+
+        while (statusA == MSodeEnvironment::Status::Running)
+            statusA = envA->advance(actionTowardsTarget(*envA));
+
+        while (statusB == MSodeEnvironment::Status::Running)
+            statusB = envB->advance(actionTowardsTarget(*envB));
+
+        // the bounds must never cut an episode that would succeed
+        ASSERT_EQ(statusA, statusB);
+        ASSERT_LE(envB->getSimulationTime(), envA->getSimulationTime());
+
+        if (statusA == MSodeEnvironment::Status::Success)
+            ASSERT_EQ(envA->getSimulationTime(), envB->getSimulationTime());
+    }
+
+    const auto& stats = envB->getTerminationStatistics();
+    ASSERT_GT(stats.numEpisodesCut, 0);
+    ASSERT_GT(stats.numStepsSaved, 0);
+    ASSERT_EQ(envA->getTerminationStatistics().numEpisodesCut, 0);
+}
+
 GTEST_TEST( RL_ENVIRONMENT, factory )
 {
     const Config config = json::parse(R"(
@@ -133,6 +227,437 @@ GTEST_TEST( RL_ENVIRONMENT, factory )
     ASSERT_NE(dynamic_cast<const EnvPosICBall*>(space), nullptr);
 }
 
+GTEST_TEST( RL_ENVIRONMENT, episode_runner_independent_of_num_threads )
+{
+    auto createEnv = []()
+    {
+        std::mt19937 gen(4242);
+        return createTestEnv(gen, 100.0_r);
+    };
+
+    auto policy = [](const EpisodeContext&, const MSodeEnvironment& env,
+                     const std::vector<double>&, std::vector<double>& action)
+    {
+        const RigidBody& body = env.getBodies()[0];
+        const real omega = 0.8_r * body.stepOutFrequency(magneticFieldMagnitude);
+        const real3 r = normalized(body.r);
+        action = {omega, r.x, r.y, r.z};
+    };
+
+    const long numEpisodes = 8;
+
+    EpisodeRunner serialRunner(createEnv, 1);
+    EpisodeRunner parallelRunner(createEnv, 3);
+
+    const auto serialResults   = serialRunner  .run(numEpisodes, policy);
+    const auto parallelResults = parallelRunner.run(numEpisodes, policy);
+
+    ASSERT_EQ(serialResults.size(), static_cast<size_t>(numEpisodes));
+    ASSERT_EQ(parallelResults.size(), static_cast<size_t>(numEpisodes));
+
+    for (long i = 0; i < numEpisodes; ++i)
+    {
+        const auto& a = serialResults[i];
+        const auto& b = parallelResults[i];
+        ASSERT_EQ(a.episodeId, i);
+        ASSERT_EQ(b.episodeId, i);
+        ASSERT_NE(a.status, MSodeEnvironment::Status::Running);
+        ASSERT_EQ(a.status, b.status);
+        ASSERT_EQ(a.numActions, b.numActions);
+        ASSERT_EQ(a.time, b.time);
+        ASSERT_EQ(a.totalReward, b.totalReward);
+        ASSERT_EQ(a.initialMaxDistance, b.initialMaxDistance);
+        ASSERT_EQ(a.finalMaxDistance, b.finalMaxDistance);
+    }
+}
+
+GTEST_TEST( RL_ENVIRONMENT, batch_runner_matches_episode_runner )
+{
+    auto createEnv = []()
+    {
+        std::mt19937 gen(4242);
+        return createTestEnv(gen, 100.0_r);
+    };
+
+    auto policy = [](const EpisodeContext&, const MSodeEnvironment& env,
+                     const std::vector<double>&, std::vector<double>& action)
+    {
+        action = actionTowardsTarget(env);
+    };
+
+    const real omega = 0.8_r * createEnv()->getBodies()[0].stepOutFrequency(magneticFieldMagnitude);
+
+    // the same decision rule, from the state only: the state starts with the position relative to the target
+    auto batchPolicy = [omega](int, long n, const double *states, double *actions)
+    {
+        for (long i = 0; i < n; ++i)
+        {
+            const double *s = states + 7 * i;
+            double *a = actions + 4 * i;
+            const real3 r = normalized(real3{static_cast<real>(s[0]), static_cast<real>(s[1]), static_cast<real>(s[2])});
+            a[0] = omega;
+            a[1] = r.x;
+            a[2] = r.y;
+            a[3] = r.z;
+        }
+    };
+
+    const long numEpisodes = 7;
+
+    EpisodeRunner reference(createEnv, 1);
+    const auto expected = reference.run(numEpisodes, policy);
+
+    for (int numEnvs : {1, 3})
+    {
+        BatchEpisodeRunner runner(createEnv, numEnvs, 2);
+        std::vector<long> started(numEpisodes, 0);
+
+        const auto results = runner.run(numEpisodes, batchPolicy, 0,
+                                        [&started](long episodeId, const MSodeEnvironment&) {++started[episodeId];});
+
+        ASSERT_EQ(results.size(), static_cast<size_t>(numEpisodes));
+
+        for (long i = 0; i < numEpisodes; ++i)
+        {
+            const auto& a = expected[i];
+            const auto& b = results[i];
+            ASSERT_EQ(started[i], 1);
+            ASSERT_EQ(b.episodeId, i);
+            ASSERT_EQ(a.status, b.status);
+            ASSERT_EQ(a.numActions, b.numActions);
+            ASSERT_EQ(a.time, b.time);
+            ASSERT_EQ(a.totalReward, b.totalReward);
+            ASSERT_EQ(a.initialMaxDistance, b.initialMaxDistance);
+            ASSERT_EQ(a.finalMaxDistance, b.finalMaxDistance);
+        }
+    }
+}
+
+GTEST_TEST( RL_ENVIRONMENT, restored_snapshot_reproduces_the_episode )
+{
+    using Status = MSodeEnvironment::Status;
+
+    const real temperature = 1e-3_r; // the thermal noise is part of the state
+    std::mt19937 genEnvA(4242), genEnvB(4242);
+    auto envA = createTestEnv(genEnvA, 500.0_r, TerminationParams{}, temperature);
+    auto envB = createTestEnv(genEnvB, 500.0_r, TerminationParams{}, temperature);
+
+    std::mt19937 genA(1), genB(2);
+    envA->reset(genA, MSodeEnvironment::NO_DUMP, true);
+    envB->reset(genB, MSodeEnvironment::NO_DUMP, true);
+
+    // a sub-optimal action, so that the episode lasts long enough
+    auto action = [](const MSodeEnvironment& env)
+    {
+        auto a = actionTowardsTarget(env);
+        a[1] += 0.5;
+        return a;
+    };
+
+    envA->advance(action(*envA));
+
+    MSodeEnvironment::State snapshot;
+    envA->snapshot(snapshot);
+
+    struct Step
+    {
+        Status status;
+        real time, reward;
+        std::vector<double> state;
+    };
+
+    auto runBranch = [&](MSodeEnvironment& env)
+    {
+        std::vector<Step> steps;
+        for (int i = 0; i < 3; ++i)
+        {
+            const Status status = env.advance(action(env));
+            steps.push_back({status, env.getSimulationTime(), static_cast<real>(env.getReward()), env.getState()});
+        }
+        return steps;
+    };
+
+    const auto expected = runBranch(*envA);
+
+    envA->restore(snapshot);
+    const auto replayed = runBranch(*envA);
+
+    envB->restore(snapshot);
+    const auto forked = runBranch(*envB);
+
+    for (const auto& steps : {replayed, forked})
+    {
+        for (size_t i = 0; i < expected.size(); ++i)
+        {
+            ASSERT_EQ(steps[i].status, expected[i].status);
+            ASSERT_EQ(steps[i].time,   expected[i].time);
+            ASSERT_EQ(steps[i].reward, expected[i].reward);
+            ASSERT_EQ(steps[i].state,  expected[i].state);
+        }
+    }
+}
+
+static std::string readFile(const std::string& fileName)
+{
+    std::ifstream f(fileName, std::ios::binary);
+    std::stringstream ss;
+    ss << f.rdbuf();
+    return ss.str();
+}
+
+static std::string trajectoryFileName(long simId)
+{
+    std::ostringstream ss;
+    ss << "trajectories_" << std::setw(6) << std::setfill('0') << simId << ".dat";
+    return ss.str();
+}
+
+static std::string recordedDumpName(long episodeId)
+{
+    return "episode_recorded_" + std::to_string(episodeId) + ".dat";
+}
+
+GTEST_TEST( RL_ENVIRONMENT, replayed_episodes_are_bitwise_identical )
+{
+    const real temperature = 0.05_r;
+    const real tmax = 100.0_r;
+    const long numEpisodes = 4;
+    const long dumpEvery = 3;
+    const std::string logFileName = "episodes_test.log";
+    std::remove(logFileName.c_str());
+
+    std::mt19937 genEnvA(4242), genEnvB(4242);
+    auto envA = createTestEnv(genEnvA, tmax, TerminationParams{}, temperature);
+    // the replay must not touch the trajectories of the original run, even if the environment dumps its episodes
+    auto envB = createTestEnv(genEnvB, tmax, TerminationParams{}, temperature, dumpEvery);
+
+    // record consecutive episodes as during training, with perturbed actions
+    {
+        EpisodeLogWriter log(logFileName);
+        std::mt19937 gen(1234);
+        std::normal_distribution<double> perturbation(0.0, 0.1);
+
+        for (long episodeId = 0; episodeId < numEpisodes; ++episodeId)
+        {
+            envA->reset(gen, MSodeEnvironment::NO_DUMP, true);
+            const unsigned long noiseSeed = gen();
+            envA->sim->setNoiseSeed(noiseSeed);
+            envA->sim->activateDump(recordedDumpName(episodeId), dumpEvery);
+            log.beginEpisode(episodeId, noiseSeed, *envA);
+
+            auto status = MSodeEnvironment::Status::Running;
+            while (status == MSodeEnvironment::Status::Running)
+            {
+                auto action = actionTowardsTarget(*envA);
+                for (auto& a : action)
+                    a += perturbation(gen);
+
+                log.recordAction(action);
+                status = envA->advance(action);
+            }
+            log.endEpisode(*envA, status);
+        }
+    }
+    envA.reset(); // flush the last dump
+
+    const auto records = readEpisodeLog(logFileName);
+    ASSERT_EQ(static_cast<long>(records.size()), numEpisodes);
+
+    // replay in another order, on another environment
+    for (long i = numEpisodes - 1; i >= 0; --i)
+    {
+        const auto& record = records[i];
+        ASSERT_EQ(record.episodeId, i);
+        ASSERT_GT(record.getNumActions(), 0);
+
+        const std::string originalTrajectory = "trajectory of the original run\n";
+        std::ofstream(trajectoryFileName(i)) << originalTrajectory;
+
+        const std::string replayName = "episode_replayed_" + std::to_string(i) + ".dat";
+        const auto status = replayEpisode(*envB, record, replayName, dumpEvery);
+        envB->sim->deactivateDump(); // close and flush the replay dump
+
+        ASSERT_EQ(status, record.status);
+        ASSERT_EQ(envB->getSimulationTime(), record.time);
+        ASSERT_TRUE(matchesFinalState(*envB, record));
+        ASSERT_EQ(readFile(replayName), readFile(recordedDumpName(i)));
+        ASSERT_EQ(readFile(trajectoryFileName(i)), originalTrajectory);
+
+        std::remove(trajectoryFileName(i).c_str());
+        std::remove(replayName.c_str());
+        std::remove(recordedDumpName(i).c_str());
+    }
+    std::remove(logFileName.c_str());
+}
+
+static long fileSize(const std::string& fileName)
+{
+    std::ifstream f(fileName, std::ios::binary | std::ios::ate);
+    return f.good() ? static_cast<long>(f.tellg()) : -1;
+}
+
+GTEST_TEST( RL_ENVIRONMENT, no_dump_episodes_write_no_trajectory )
+{
+    std::mt19937 gen(4242);
+    const real tmax = 20.0_r;
+    const long dumpEvery = 5;
+    auto env = createTestEnv(gen, tmax, TerminationParams{}, kBT, dumpEvery);
+
+    auto runEpisode = [&](long simId)
+    {
+        std::mt19937 genEpisode(4242);
+        env->reset(genEpisode, simId, true);
+        auto status = MSodeEnvironment::Status::Running;
+        while (status == MSodeEnvironment::Status::Running)
+            status = env->advance(actionTowardsTarget(*env));
+    };
+
+    const long simId {990010};
+    const std::string dumpName = trajectoryFileName(simId);
+    const std::string noDumpName = trajectoryFileName(MSodeEnvironment::NO_DUMP);
+    std::remove(noDumpName.c_str());
+
+    // the trajectory of the previous episode is closed and no file is created for the others
+    runEpisode(simId);
+    runEpisode(MSodeEnvironment::NO_DUMP);
+    const long size = fileSize(dumpName);
+    ASSERT_GT(size, 0);
+
+    runEpisode(MSodeEnvironment::NO_DUMP);
+    ASSERT_EQ(fileSize(dumpName), size);
+    ASSERT_EQ(fileSize(noDumpName), -1);
+
+    std::remove(dumpName.c_str());
+}
+
+GTEST_TEST( RL_ENVIRONMENT, deferred_dump_writes_only_selected_episodes )
+{
+    std::mt19937 gen(4242);
+    const real tmax = 20.0_r;
+    const long dumpEvery = 5;
+    const long capacity = 100;
+    auto env = createTestEnv(gen, tmax, TerminationParams{}, kBT, dumpEvery);
+
+    bool selectEpisode {false};
+    env->setDeferredDump(capacity, true, [&selectEpisode](const MSodeEnvironment&, MSodeEnvironment::Status)
+    {
+        return selectEpisode;
+    });
+
+    auto runEpisode = [&](long simId)
+    {
+        std::mt19937 genEpisode(simId);
+        env->reset(genEpisode, simId, true);
+        auto status = MSodeEnvironment::Status::Running;
+        while (status == MSodeEnvironment::Status::Running)
+            status = env->advance(actionTowardsTarget(*env));
+    };
+
+    auto fileExists = [](long simId)
+    {
+        return std::ifstream(trajectoryFileName(simId)).good();
+    };
+
+    const long idSkipped {990001}, idSelected {990002}, idRequested {990003}, idInterrupted {990004};
+    const std::vector<long> ids {idSkipped, idSelected, idRequested, idInterrupted};
+
+    for (long simId : ids)
+        std::remove(trajectoryFileName(simId).c_str());
+
+    runEpisode(idSkipped);
+    ASSERT_FALSE(fileExists(idSkipped));
+    ASSERT_GT(env->sim->getFrameBuffer()->getNumPushed(), 0);
+
+    selectEpisode = true;
+    runEpisode(idSelected);
+    ASSERT_TRUE(fileExists(idSelected));
+
+    // the buffer is cleared between episodes: the file holds only the frames of the selected episode
+    const long numFrames = env->sim->getFrameBuffer()->size();
+    std::ifstream file(trajectoryFileName(idSelected));
+    long numLines {0};
+    for (std::string line; std::getline(file, line);)
+        ++numLines;
+    ASSERT_EQ(numLines, numFrames);
+    ASSERT_LE(numFrames, capacity);
+
+    selectEpisode = false;
+    {
+        std::mt19937 genEpisode(idRequested);
+        env->reset(genEpisode, idRequested, true);
+        env->requestDump();
+        auto status = MSodeEnvironment::Status::Running;
+        while (status == MSodeEnvironment::Status::Running)
+            status = env->advance(actionTowardsTarget(*env));
+        ASSERT_TRUE(fileExists(idRequested));
+    }
+
+    // a requested dump of an episode interrupted by a reset is written at that reset
+    {
+        std::mt19937 genEpisode(idInterrupted);
+        env->reset(genEpisode, idInterrupted, true);
+        env->requestDump();
+
+        runEpisode(idSkipped);
+        ASSERT_TRUE(fileExists(idInterrupted));
+        ASSERT_FALSE(fileExists(idSkipped));
+    }
+
+    for (long simId : ids)
+        std::remove(trajectoryFileName(simId).c_str());
+}
+
+GTEST_TEST( RL_ENVIRONMENT, replay_on_environment_with_deferred_dump )
+{
+    const real tmax = 20.0_r;
+    const long dumpEvery = 5;
+    const long episodeId = 990020;
+    const std::string logFileName = "episodes_deferred_test.log";
+    const std::string recordedName = recordedDumpName(episodeId);
+    const std::string replayName = "episode_replayed_deferred.dat";
+    std::remove(logFileName.c_str());
+
+    std::mt19937 genEnvA(4242), genEnvB(4242);
+    auto envA = createTestEnv(genEnvA, tmax);
+    auto envB = createTestEnv(genEnvB, tmax, TerminationParams{}, kBT, dumpEvery);
+
+    // every episode is selected, as the failed and long ones in a run
+    envB->setDeferredDump(100, false, [](const MSodeEnvironment&, MSodeEnvironment::Status) {return true;});
+
+    {
+        EpisodeLogWriter log(logFileName);
+        std::mt19937 gen(1234);
+        envA->reset(gen, MSodeEnvironment::NO_DUMP, true);
+        envA->sim->activateDump(recordedName, dumpEvery);
+        log.beginEpisode(episodeId, 0, *envA);
+
+        auto status = MSodeEnvironment::Status::Running;
+        while (status == MSodeEnvironment::Status::Running)
+        {
+            const auto action = actionTowardsTarget(*envA);
+            log.recordAction(action);
+            status = envA->advance(action);
+        }
+        log.endEpisode(*envA, status);
+        envA->sim->deactivateDump();
+    }
+
+    const auto records = readEpisodeLog(logFileName);
+    ASSERT_EQ(records.size(), 1ul);
+
+    std::remove(trajectoryFileName(episodeId).c_str());
+    const auto status = replayEpisode(*envB, records[0], replayName, dumpEvery);
+    envB->sim->deactivateDump();
+
+    ASSERT_EQ(status, records[0].status);
+    ASSERT_TRUE(matchesFinalState(*envB, records[0]));
+    ASSERT_EQ(readFile(replayName), readFile(recordedName));
+    ASSERT_FALSE(std::ifstream(trajectoryFileName(episodeId)).good());
+
+    std::remove(logFileName.c_str());
+    std::remove(recordedName.c_str());
+    std::remove(replayName.c_str());
+}
 
 int main(int argc, char **argv)
 {
@@ -0,0 +1,270 @@
+#include "helpers.h"
+
+#include <msode/rl/environment.h>
+#include <msode/rl/episode_runner.h>
+#include <msode/rl/policies/factory.h>
+#include <msode/rl/policies/mlp.h>
+
+#include <gtest/gtest.h>
+#include <memory>
+
+using namespace msode;
+using namespace msode::rl;
+
+constexpr real magneticFieldMagnitude = 1.0_r;
+constexpr real distanceThreshold      = 2.0_r;
+
+static std::unique_ptr<MSodeEnvironment> createTestEnv(int numBodies, real tmax = 1000.0_r,
+                                                       real fieldMagnitude = magneticFieldMagnitude)
+{
+    std::mt19937 gen(4242);
+    std::vector<RigidBody> bodies;
+
+    // the analytic control needs well separated step out frequencies
+    auto separated = [&bodies](const RigidBody& b)
+    {
+        const real omega = b.stepOutFrequency(magneticFieldMagnitude);
+        for (const auto& other : bodies)
+            if (std::abs(omega - other.stepOutFrequency(magneticFieldMagnitude)) < 0.2_r * omega)
+                return false;
+        return true;
+    };
+
+    while (static_cast<int>(bodies.size()) < numBodies)
+    {
+        const RigidBody b = helpers::generateRandomBody(gen);
+        if (separated(b))
+            bodies.push_back(b);
+    }
+
+    helpers::TestEnvironmentParams p;
+    p.bodies                 = bodies;
+    p.magneticFieldMagnitude = fieldMagnitude;
+    p.distanceThreshold      = distanceThreshold;
+    p.tmax                   = tmax;
+
+    return helpers::createTestEnvironment(std::move(p));
+}
+
+GTEST_TEST( RL_POLICIES, random_within_bounds_and_reproducible )
+{
+    auto env = createTestEnv(1);
+    std::mt19937 gen(42);
+    env->reset(gen, MSodeEnvironment::NO_DUMP, true);
+
+    auto policy = factory::createPolicy({{"__type", "Random"}, {"seed", 12345}});
+    auto copy = policy->clone();
+
+    std::vector<double> lo, hi;
+    std::tie(lo, hi) = env->getActionBounds();
+    std::vector<double> a(env->numActions()), b(env->numActions());
+
+    policy->reset(*env, 7);
+    copy  ->reset(*env, 7);
+
+    for (int i = 0; i < 100; ++i)
+    {
+        policy->computeAction(*env, env->getState(), a);
+        copy  ->computeAction(*env, env->getState(), b);
+
+        ASSERT_EQ(a, b);
+
+        for (size_t j = 0; j < a.size(); ++j)
+        {
+            ASSERT_GE(a[j], lo[j]);
+            ASSERT_LE(a[j], hi[j]);
+        }
+    }
+
+    // another episode gives other actions
+    copy->reset(*env, 8);
+    copy->computeAction(*env, env->getState(), b);
+    ASSERT_NE(a, b);
+}
+
+GTEST_TEST( RL_POLICIES, constant )
+{
+    auto env = createTestEnv(1);
+    std::mt19937 gen(42);
+    env->reset(gen, MSodeEnvironment::NO_DUMP, true);
+
+    const std::vector<double> expected {1.0, 0.0, 1.0, 0.0};
+    auto policy = factory::createPolicy({{"__type", "Constant"}, {"action", expected}});
+
+    std::vector<double> action(env->numActions());
+    policy->reset(*env, 0);
+    policy->computeAction(*env, env->getState(), action);
+
+    ASSERT_EQ(action, expected);
+}
+
+GTEST_TEST( RL_POLICIES, analytic_control_reaches_targets )
+{
+    for (int numBodies : {1, 2})
+    {
+        const int numThreads = 2;
+        EpisodeRunner runner([numBodies]() {return createTestEnv(numBodies);}, numThreads);
+
+        auto policy = factory::createPolicy({{"__type", "AnalyticControl"}});
+        const auto results = runner.run(4, createRunnerPolicy(*policy, numThreads));
+
+        for (const auto& r : results)
+        {
+            ASSERT_EQ(r.status, MSodeEnvironment::Status::Success);
+            ASSERT_LT(r.finalMaxDistance, distanceThreshold);
+        }
+    }
+}
+
+GTEST_TEST( RL_POLICIES, analytic_control_follows_environment_changes )
+{
+    const int numBodies = 2;
+    const real tmax = 1000.0_r;
+    auto envA = createTestEnv(numBodies, tmax, 1.0_r);
+    auto envB = createTestEnv(numBodies, tmax, 2.0_r);
+
+    auto reused = factory::createPolicy({{"__type", "AnalyticControl"}});
+    auto fresh  = factory::createPolicy({{"__type", "AnalyticControl"}});
+
+    std::mt19937 genA(42), genB(42);
+    envA->reset(genA, MSodeEnvironment::NO_DUMP, true);
+    envB->reset(genB, MSodeEnvironment::NO_DUMP, true);
+
+    reused->reset(*envA, 0);
+    reused->reset(*envB, 1);
+    fresh->reset(*envB, 1);
+
+    std::vector<double> actionReused(envB->numActions()), actionFresh(envB->numActions());
+
+    for (int i = 0; i < 5; ++i)
+    {
+        reused->computeAction(*envB, envB->getState(), actionReused);
+        fresh ->computeAction(*envB, envB->getState(), actionFresh);
+        ASSERT_EQ(actionReused, actionFresh);
+        envB->advance(actionFresh);
+    }
+}
+
+static Config createRandomMLPConfig(const std::vector<int>& sizes, std::mt19937& gen)
+{
+    std::uniform_real_distribution<real> distr(-1.0_r, 1.0_r);
+    const char *activations[] = {"SoftSign", "Tanh", "ReLU", "Linear"};
+
+    Config config;
+    config["layers"] = Config::array();
+
+    for (size_t l = 0; l + 1 < sizes.size(); ++l)
+    {
+        std::vector<std::vector<real>> weights(sizes[l+1], std::vector<real>(sizes[l]));
+        std::vector<real> biases(sizes[l+1]);
+
+        for (auto& row : weights)
+            for (auto& w : row)
+                w = distr(gen);
+        for (auto& b : biases)
+            b = distr(gen);
+
+        config["layers"].push_back({{"weights", weights}, {"biases", biases}, {"activation", activations[l % 4]}});
+    }
+
+    std::vector<real> inputShift(sizes.front()), inputScale(sizes.front(), 0.5_r);
+    std::vector<real> outputScale(sizes.back(), 2.0_r);
+    for (auto& x : inputShift)
+        x = distr(gen);
+
+    config["inputShift"]  = inputShift;
+    config["inputScale"]  = inputScale;
+    config["outputScale"] = outputScale;
+    return config;
+}
+
+/// straightforward evaluation of a single sample
+static std::vector<double> referenceForward(const Config& config, std::vector<double> x)
+{
+    const auto shift = config.at("inputShift").get<std::vector<double>>();
+    const auto scale = config.at("inputScale").get<std::vector<double>>();
+
+    for (size_t i = 0; i < x.size(); ++i)
+        x[i] = (x[i] - shift[i]) * scale[i];
+
+    for (const auto& layer : config.at("layers"))
+    {
+        const auto W = layer.at("weights").get<std::vector<std::vector<double>>>();
+        const auto b = layer.at("biases").get<std::vector<double>>();
+        const auto activation = layer.at("activation").get<std::string>();
+
+        std::vector<double> y(b);
+        for (size_t o = 0; o < y.size(); ++o)
+        {
+            for (size_t i = 0; i < x.size(); ++i)
+                y[o] += W[o][i] * x[i];
+
+            if      (activation == "SoftSign") y[o] = y[o] / (1.0 + std::abs(y[o]));
+            else if (activation == "Tanh")     y[o] = std::tanh(y[o]);
+            else if (activation == "ReLU")     y[o] = std::max(y[o], 0.0);
+        }
+        x = y;
+    }
+
+    for (auto& v : x)
+        v *= 2.0;
+    return x;
+}
+
+GTEST_TEST( RL_POLICIES, mlp_batched_forward )
+{
+    std::mt19937 gen(4242);
+    const std::vector<int> sizes {7, 33, 16, 5, 4};
+    const Config config = createRandomMLPConfig(sizes, gen);
+    const MLP mlp = readMLPFromConfig(config);
+
+    ASSERT_EQ(mlp.getNumInputs(), 7);
+    ASSERT_EQ(mlp.getNumOutputs(), 4);
+
+    std::uniform_real_distribution<double> distr(-10.0, 10.0);
+    MLP::Workspace work;
+
+    // covers single samples, partial blocks and several blocks of samples
+    for (long batchSize : {1, 3, 4, 9, 300, 700})
+    {
+        std::vector<double> inputs(batchSize * 7), outputs(batchSize * 4);
+        for (auto& x : inputs)
+            x = distr(gen);
+
+        mlp.forward(batchSize, inputs.data(), outputs.data(), work);
+
+        for (long s = 0; s < batchSize; ++s)
+        {
+            const std::vector<double> x(inputs.begin() + 7 * s, inputs.begin() + 7 * (s + 1));
+            const auto expected = referenceForward(config, x);
+
+            for (int o = 0; o < 4; ++o)
+                ASSERT_NEAR(outputs[4 * s + o], expected[o], helpers::byPrecision(1e-10_r, 1e-4_r));
+        }
+    }
+}
+
+GTEST_TEST( RL_POLICIES, mlp_policy )
+{
+    auto env = createTestEnv(1);
+    std::mt19937 gen(42);
+    env->reset(gen, MSodeEnvironment::NO_DUMP, true);
+
+    const Config config = createRandomMLPConfig({7, 16, 4}, gen);
+    PolicyMLP policy(readMLPFromConfig(config));
+
+    std::vector<double> action(env->numActions());
+    policy.reset(*env, 0);
+    policy.computeAction(*env, env->getState(), action);
+
+    const auto expected = referenceForward(config, env->getState());
+
+    for (int i = 0; i < 4; ++i)
+        ASSERT_NEAR(action[i], expected[i], helpers::byPrecision(1e-10_r, 1e-4_r));
+}
+
+int main(int argc, char **argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
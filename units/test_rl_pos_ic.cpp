@@ -1,3 +1,5 @@
+#include "helpers.h"
+
 #include <msode/analytic_control/optimal_path.h>
 #include <msode/core/math.h>
 #include <msode/core/velocity_field/constant.h>
@@ -113,7 +115,7 @@ GTEST_TEST( RL_POS_IC, ball_random_walk_drift_correct_drift )
 
     for (size_t i = 0; i < initPos.size(); ++i)
     {
-        constexpr real tol = 1e-6_r;
+        constexpr real tol = helpers::byPrecision(1e-6_r, 1e-4_r);
 
         const real3 refDrift = -driftTime * vel;
         const real3 drift = nextPos[i] - initPos[i];
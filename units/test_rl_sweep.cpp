@@ -0,0 +1,110 @@
+#include <msode/rl/factory.h>
+#include <msode/rl/policies/factory.h>
+#include <msode/rl/sweep.h>
+
+#include <gtest/gtest.h>
+
+using namespace msode;
+using namespace msode::rl;
+
+static const Config baseConfig = json::parse(R"(
+{
+    "bodies" : [
+        {
+            "moment" : [0.0, 10.000000, 0.0],
+            "quaternion" : [0.0, 1.0, 0.0, 0.0],
+            "position" : [0.0, 0.0, 0.0],
+            "propulsion" : {
+                "A" : [0.246391, 0.200475, 0.199631],
+                "B" : [0.100000, 0.000000, 0.000000],
+                "C" : [6.983636, 1.153988, 1.218122]
+            },
+            "aspectRatio": 1.0
+        }
+    ],
+    "posIc" : {
+        "__type" : "Ball",
+        "radius" : 20.0
+    },
+    "fieldAction" : {
+        "__type" : "Direct",
+        "minOmega" : 0.0,
+        "maxOmega" : 120.0
+    },
+    "fieldMagnitude" : 1.0,
+    "targetRadius"   : 2.0,
+    "velocityField" : {
+        "__type" : "None"
+    },
+    "targetDistance" : {
+        "__type" : "Square"
+    },
+    "reward" :
+    {
+        "bonus" : 1.0,
+        "distCoeff" : 1.0,
+        "timeCoeff" : 0.5
+    },
+    "dtAction" : 1.0,
+    "dumpEvery" : 0
+}
+)");
+
+GTEST_TEST( RL_SWEEP, same_as_separate_variants )
+{
+    const ParameterGrid grid(json::parse(R"(
+    {"parameters": [{"pointer": "/fieldMagnitude", "factors": [0.5, 1.0, 2.0]}]}
+    )"));
+
+    const long numEpisodes = 3;
+    const long seed = 12345;
+    const bool runAC = false;
+
+    // the analytic control policy depends on the field magnitude through its velocity matrix
+    const auto policy = factory::createPolicy({{"__type", "AnalyticControl"}});
+
+    // reference: every variant on its own environment, with its own policy
+    std::vector<EpisodeResult> expected;
+
+    for (long variantId = 0; variantId < grid.getNumVariants(); ++variantId)
+    {
+        auto env = factory::createEnvironment(grid.createVariant(baseConfig, variantId), ConfPointer(""));
+        auto variantPolicy = policy->clone();
+        std::vector<double> action;
+
+        auto episodePolicy = [&](const EpisodeContext& context, const MSodeEnvironment& e,
+                                 const std::vector<double>& state, std::vector<double>& a)
+        {
+            if (context.actionId == 0)
+                variantPolicy->reset(e, context.episodeId);
+            variantPolicy->computeAction(e, state, a);
+        };
+
+        for (long episodeId = 0; episodeId < numEpisodes; ++episodeId)
+            expected.push_back(runEpisode(*env, seed, episodeId, 0, episodePolicy, action));
+    }
+
+    for (int numThreads : {1, 2})
+    {
+        const auto results = runSweep(baseConfig, grid, numEpisodes, *policy, runAC, numThreads, seed);
+
+        ASSERT_EQ(results.size(), expected.size());
+
+        for (size_t i = 0; i < results.size(); ++i)
+        {
+            const auto& a = results[i].rl;
+            const auto& b = expected[i];
+            ASSERT_EQ(a.episodeId,   b.episodeId);
+            ASSERT_EQ(a.status,      b.status);
+            ASSERT_EQ(a.numActions,  b.numActions);
+            ASSERT_EQ(a.time,        b.time);
+            ASSERT_EQ(a.totalReward, b.totalReward);
+        }
+    }
+}
+
+int main(int argc, char **argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
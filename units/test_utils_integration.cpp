@@ -1,3 +1,5 @@
+#include "helpers.h"
+
 #include <msode/utils/integrator.h>
 
 #include <gtest/gtest.h>
@@ -11,7 +13,7 @@ GTEST_TEST( Integrator, linear_polynomial )
     auto f = [](real x) {return 2.0_r * x + 5.0_r;};
     const real Iexact = 28.0_r;
     const real Itrap  = msode::utils::integrateTrapez(f, -1.0_r, 3.0_r, 1000);
-    ASSERT_FLOAT_EQ(Itrap, Iexact);
+    ASSERT_NEAR(Itrap, Iexact, helpers::byPrecision(1e-10_r, 1e-4_r));
 }
 
 GTEST_TEST( Integrator, quadratic_polynomial )
@@ -30,7 +32,7 @@ GTEST_TEST( Integrator, non_linear )
     auto fIndefinitIntegral = [](real x) {return 0.5_r * std::exp(x) * ((x - 1.0_r) * std::sin(x) + x * std::cos(x));};
     const real Iexact = fIndefinitIntegral(b) - fIndefinitIntegral(a);
     const real Itrap  = msode::utils::integrateTrapez(f, a, b, 10000);
-    ASSERT_NEAR(Itrap, Iexact, 1e-4_r);
+    ASSERT_NEAR(Itrap, Iexact, helpers::byPrecision(1e-4_r, 1e-3_r));
 }
 
 int main(int argc, char **argv)
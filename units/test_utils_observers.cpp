@@ -0,0 +1,262 @@
+#include "helpers.h"
+
+#include <msode/utils/observers.h>
+
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <memory>
+#include <random>
+#include <sstream>
+
+using namespace msode;
+using namespace msode::utils;
+
+GTEST_TEST( OBSERVERS, correlator_matches_direct_computation_at_short_lags )
+{
+    const int p = 16;
+    const int n = 1000;
+
+    std::mt19937 gen(4242);
+    std::normal_distribution<double> normal(0.0, 1.0);
+
+    std::vector<MultiTauCorrelator::Vector> signal(n);
+    for (auto& x : signal)
+        x = {normal(gen), normal(gen), normal(gen)};
+
+    MultiTauCorrelator correlator(MultiTauCorrelator::Kind::Correlation, 4, p, 2);
+    for (const auto& x : signal)
+        correlator.add(x);
+
+    const auto lags = correlator.getLags();
+    const auto values = correlator.getValues();
+    ASSERT_EQ(lags.size(), values.size());
+
+    for (int lag = 0; lag < p; ++lag)
+    {
+        double expected {0.0};
+        for (int i = lag; i < n; ++i)
+            expected += dot(signal[i], signal[i - lag]);
+        expected /= (n - lag);
+
+        ASSERT_EQ(lags[lag], lag);
+        ASSERT_NEAR(values[lag], expected, 1e-12);
+    }
+}
+
+GTEST_TEST( OBSERVERS, correlator_msd_of_ballistic_motion_is_exact_at_all_lags )
+{
+    const MultiTauCorrelator::Vector v {1.0, -2.0, 0.5};
+    MultiTauCorrelator correlator(MultiTauCorrelator::Kind::MeanSquaredDisplacement, 8, 8, 2);
+
+    for (int i = 0; i < 5000; ++i)
+        correlator.add(static_cast<double>(i) * v);
+
+    const auto lags = correlator.getLags();
+    const auto values = correlator.getValues();
+
+    ASSERT_GT(lags.back(), 500);
+
+    for (size_t k = 0; k < lags.size(); ++k)
+    {
+        const double tau = lags[k];
+        ASSERT_NEAR(values[k], tau * tau * dot(v, v), 1e-9 * (1.0 + tau * tau));
+        if (k > 0)
+            ASSERT_GT(lags[k], lags[k-1]);
+    }
+}
+
+static std::unique_ptr<Simulation> createSimulation(real kBT, real magneticFieldMagnitude, int numBodies)
+{
+    std::mt19937 gen(4242);
+    std::vector<RigidBody> bodies;
+    for (int i = 0; i < numBodies; ++i)
+        bodies.push_back(helpers::generateRandomBody(gen));
+
+    const real omega = 0.5_r * bodies[0].stepOutFrequency(1.0_r);
+
+    MagneticField magneticField(magneticFieldMagnitude,
+                                [omega](real) {return omega;},
+                                [](real) {return real3 {1.0_r, 0.0_r, 0.0_r};});
+
+    return std::make_unique<Simulation>(bodies, magneticField, kBT);
+}
+
+GTEST_TEST( OBSERVERS, statistics_and_histogram_match_direct_computation )
+{
+    const int numBodies = 2;
+    const long nsteps = 1000;
+    const long every = 7;
+    const real dt = 1e-2_r;
+    const real lo = 0.0_r, hi = 1.0_r;
+    const int numBins = 10;
+
+    auto sim = createSimulation(0.0_r, 1.0_r, numBodies);
+    auto reference = createSimulation(0.0_r, 1.0_r, numBodies);
+
+    const auto quantity = quantities::velocityAlong({1.0_r, 0.0_r, 0.0_r});
+    ObserverStatistics statistics(quantity, numBodies);
+    ObserverHistogram histogram(quantity, numBodies, lo, hi, numBins);
+
+    sim->addObserver(&statistics, every);
+    sim->addObserver(&histogram, 1);
+    sim->runForwardEuler(nsteps, dt);
+
+    std::vector<RunningStats> expectedStats(numBodies);
+    std::vector<long> expectedCounts(numBodies * numBins, 0);
+
+    for (long step = 0; step < nsteps; ++step)
+    {
+        for (int i = 0; i < numBodies; ++i)
+        {
+            const real x = quantity(*reference, i);
+            if (step % every == 0)
+                expectedStats[i].add(x);
+
+            const int binId = static_cast<int>(std::floor((x - lo) / (hi - lo) * numBins));
+            if (binId >= 0 && binId < numBins)
+                ++expectedCounts[i * numBins + binId];
+        }
+        reference->advanceForwardEuler(dt);
+    }
+
+    for (int i = 0; i < numBodies; ++i)
+    {
+        ASSERT_EQ(statistics.getStats(i).getCount(), (nsteps + every - 1) / every);
+        ASSERT_NEAR(statistics.getStats(i).getMean(),     expectedStats[i].getMean(),     1e-6);
+        ASSERT_NEAR(statistics.getStats(i).getVariance(), expectedStats[i].getVariance(), 1e-6);
+        ASSERT_LE(statistics.getMin(i), statistics.getStats(i).getMean());
+        ASSERT_GE(statistics.getMax(i), statistics.getStats(i).getMean());
+
+        long total = histogram.getOutOfRangeCount(i);
+        for (int binId = 0; binId < numBins; ++binId)
+        {
+            ASSERT_EQ(histogram.getCount(i, binId), expectedCounts[i * numBins + binId]);
+            total += histogram.getCount(i, binId);
+        }
+        ASSERT_EQ(total, nsteps);
+    }
+}
+
+GTEST_TEST( OBSERVERS, mean_velocity_matches_displacement )
+{
+    const int numBodies = 2;
+    const long nsteps = 2000;
+    const real dt = 1e-2_r;
+    const real3 direction {1.0_r, 0.0_r, 0.0_r};
+
+    auto sim = createSimulation(0.0_r, 1.0_r, numBodies);
+    std::vector<real3> r0;
+    for (const auto& b : sim->getBodies())
+        r0.push_back(b.r);
+
+    ObserverStatistics velocity(quantities::velocityAlong(direction), numBodies);
+    ObserverStatistics speed(quantities::speed(), numBodies);
+    sim->addObserver(&velocity, 1);
+    sim->addObserver(&speed, 1);
+    sim->runForwardEuler(nsteps, dt);
+
+    // forward Euler: the displacement is the sum of the velocities at the start of each step
+    for (int i = 0; i < numBodies; ++i)
+    {
+        const real expected = dot(direction, sim->getBodies()[i].r - r0[i]) / (nsteps * dt);
+        ASSERT_EQ(velocity.getStats(i).getCount(), nsteps);
+        ASSERT_NEAR(velocity.getStats(i).getMean(), expected, helpers::byPrecision(1e-9, 1e-4) * std::abs(expected));
+        ASSERT_GT(speed.getMin(i), 0.0_r);
+    }
+}
+
+GTEST_TEST( OBSERVERS, msd_under_thermal_noise_matches_diffusion_coefficient )
+{
+    const real kBT = 0.5_r;
+    const real dt = 0.1_r;
+    const long nsteps = 200000;
+
+    auto sim = createSimulation(kBT, 0.0_r, 1);
+    ObserverCorrelation msd(ObserverCorrelation::Signal::MeanSquaredDisplacement, 1);
+
+    sim->addObserver(&msd, 1);
+    sim->runForwardEuler(nsteps, dt);
+
+    ASSERT_NEAR(msd.getSamplingInterval(), dt, 1e-6_r);
+
+    // the thermal velocity of each component has the variance 2 kBT (A_ii + B_ii) / dt
+    const auto& P = sim->getBodies()[0].propulsion;
+    real sumDiffusion {0.0_r};
+    for (int d = 0; d < 3; ++d)
+        sumDiffusion += kBT * (P.A[d] + P.B[d]);
+
+    const auto lags = msd.getCorrelator(0).getLags();
+    const auto values = msd.getCorrelator(0).getValues();
+
+    for (size_t k = 1; k < 16; ++k)
+    {
+        const real tau = lags[k] * dt;
+        ASSERT_NEAR(values[k] / (2 * sumDiffusion * tau), 1.0, 0.05);
+    }
+}
+
+/// one observer of each kind, attached to a simulation
+struct AttachedObservers
+{
+    AttachedObservers(Simulation& sim, int numBodies) :
+        statistics(quantities::speed(), numBodies),
+        histogram(quantities::velocityAlong({1.0_r, 0.0_r, 0.0_r}), numBodies, -1.0_r, 1.0_r, 16),
+        msd(ObserverCorrelation::Signal::MeanSquaredDisplacement, numBodies, 8, 8, 2)
+    {
+        sim.addObserver(&statistics, 3);
+        sim.addObserver(&histogram, 1);
+        sim.addObserver(&msd, 5);
+    }
+
+    std::string results() const
+    {
+        std::ostringstream ss;
+        statistics.write(ss);
+        histogram.write(ss);
+        msd.write(ss);
+        return ss.str();
+    }
+
+    ObserverStatistics statistics;
+    ObserverHistogram histogram;
+    ObserverCorrelation msd;
+};
+
+GTEST_TEST( OBSERVERS, checkpoint_restores_the_observers )
+{
+    const int numBodies = 2;
+    const real kBT = 0.1_r;
+    const real dt = 1e-2_r;
+    const long nsteps = 3000;
+    const long nstepsBeforeCheckpoint = 1234;
+    const std::string checkpointFileName = "observers_checkpoint.bin";
+
+    {
+        auto interrupted = createSimulation(kBT, 1.0_r, numBodies);
+        AttachedObservers observers(*interrupted, numBodies);
+        interrupted->runForwardEuler(nstepsBeforeCheckpoint, dt);
+        interrupted->writeCheckpoint(checkpointFileName);
+        // progress lost at the interruption
+        interrupted->runForwardEuler(321, dt);
+    }
+
+    auto restarted = createSimulation(kBT, 1.0_r, numBodies);
+    AttachedObservers restartedObservers(*restarted, numBodies);
+    restarted->restartFromCheckpoint(checkpointFileName);
+    restarted->runForwardEuler(nsteps - restarted->getCurrentTimeStep(), dt);
+
+    auto expected = createSimulation(kBT, 1.0_r, numBodies);
+    AttachedObservers expectedObservers(*expected, numBodies);
+    expected->runForwardEuler(nsteps, dt);
+
+    ASSERT_EQ(restartedObservers.statistics.getStats(0).getCount(), expectedObservers.statistics.getStats(0).getCount());
+    ASSERT_EQ(restartedObservers.results(), expectedObservers.results());
+
+    std::remove(checkpointFileName.c_str());
+}
+
+int main(int argc, char **argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
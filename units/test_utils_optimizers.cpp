@@ -1,3 +1,5 @@
+#include "helpers.h"
+
 #include <msode/utils/optimizers/line_search.h>
 #include <msode/utils/optimizers/gradient_descent.h>
 #include <msode/utils/optimizers/cmaes.h>
@@ -10,11 +12,13 @@ using namespace msode;
 GTEST_TEST( OPTIMIZERS, lineSearch )
 {
     constexpr real tol = 1e-5_r;
+    // the minimum of a smooth function can not be located more accurately than sqrt(epsilon)
+    constexpr real checkTol = helpers::byPrecision(tol, 1e-3_r);
 
     {
         auto f1 = [](real x) { return std::cos(2 * M_PI * x); };
 
-        ASSERT_NEAR(utils::lineSearchGoldenSection(f1, 1.0_r, tol), 0.5_r, tol);
+        ASSERT_NEAR(utils::lineSearchGoldenSection(f1, 1.0_r, tol), 0.5_r, checkTol);
     }
 
     {
@@ -23,7 +27,7 @@ GTEST_TEST( OPTIMIZERS, lineSearch )
         const real c = -0.3_r;
         auto f2 = [a, b, c](real x) {return c + x * (b + x * a); };
         
-        ASSERT_NEAR(utils::lineSearchGoldenSection(f2, -b/a + 3.435_r, tol), -0.5_r * b / a, tol);
+        ASSERT_NEAR(utils::lineSearchGoldenSection(f2, -b/a + 3.435_r, tol), -0.5_r * b / a, checkTol);
     }
 }
 
@@ -53,10 +57,10 @@ GTEST_TEST( OPTIMIZERS, cma )
     constexpr real tol = 1e-5_r;
 
     {
-        auto f = [](const CMAES::Vector& x) { return std::pow(x(0) - 1.0_r, 2) + std::pow(x(1) + 2.0_r, 2) + std::pow(x(2) - 1.5_r, 2); };
+        auto f = [](const CMAES<>::Vector& x) { return std::pow(x(0) - 1.0_r, 2) + std::pow(x(1) + 2.0_r, 2) + std::pow(x(2) - 1.5_r, 2); };
 
         real lambda = 8;
-        CMAES optimizer(f, lambda, CMAES::Vector::Zero(3), 1.0, 4242);
+        CMAES<> optimizer(f, lambda, CMAES<>::Vector::Zero(3), 1.0, 4242);
 
         auto info = optimizer.runMinimization(1e-7_r, 100, false);
 
@@ -69,6 +73,53 @@ GTEST_TEST( OPTIMIZERS, cma )
     }
 }
 
+GTEST_TEST( OPTIMIZERS, cmaFixedDimension )
+{
+    using namespace utils;
+
+    auto f = [](auto x) { return std::pow(x(0) - 1.0_r, 2) + std::pow(x(1) + 2.0_r, 2) + std::pow(x(2) - 1.5_r, 2); };
+    const int lambda = 8;
+    const long seed = 4242;
+
+    CMAES<> optimizerDynamic(f, lambda, CMAES<>::Vector::Zero(3), 1.0, seed);
+    CMAES<3> optimizerFixed (f, lambda, CMAES<3>::Vector::Zero(), 1.0, seed);
+
+    const auto infoDynamic = optimizerDynamic.runMinimization(1e-7_r, 100, false);
+    const auto infoFixed   = optimizerFixed  .runMinimization(1e-7_r, 100, false);
+
+    // same algorithm, only the storage differs: the two runs follow the same path up to round-off
+    constexpr real roundOffTol = helpers::byPrecision(1e-10_r, 1e-4_r);
+
+    if (!helpers::singlePrecision)
+        ASSERT_EQ(infoFixed.numGenerations, infoDynamic.numGenerations);
+    ASSERT_NEAR(infoFixed.fval, infoDynamic.fval, roundOffTol);
+    for (int i = 0; i < 3; ++i)
+        ASSERT_NEAR(infoFixed.x(i), infoDynamic.x(i), roundOffTol);
+}
+
+GTEST_TEST( OPTIMIZERS, cmaClosedFormEigenSolver )
+{
+    using namespace utils;
+
+    auto f = [](auto x) { return std::pow(x(0) - 1.0_r, 2) + std::pow(x(1) + 2.0_r, 2) + std::pow(x(2) - 1.5_r, 2); };
+    const int lambda = 8;
+    const long seed = 4242;
+
+    if (helpers::singlePrecision)
+        GTEST_SKIP() << "the closed form eigen decomposition is only available in double precision";
+
+    CMAES<3> optimizer(f, lambda, CMAES<3>::Vector::Zero(), 1.0, seed, CMAES<3>::EigenSolver::ClosedForm);
+    const auto info = optimizer.runMinimization(1e-7_r, 100, false);
+
+    // the closed form eigen decomposition follows a different path but must reach the same minimum
+    constexpr real tol = 1e-3_r;
+
+    ASSERT_NEAR(info.fval, 0.0_r, tol);
+    ASSERT_NEAR(info.x(0),  1.0_r, tol);
+    ASSERT_NEAR(info.x(1), -2.0_r, tol);
+    ASSERT_NEAR(info.x(2),  1.5_r, tol);
+}
+
 int main(int argc, char **argv)
 {
     ::testing::InitGoogleTest(&argc, argv);
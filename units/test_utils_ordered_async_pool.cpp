@@ -0,0 +1,62 @@
+#include <msode/utils/ordered_async_pool.h>
+
+#include <gtest/gtest.h>
+#include <chrono>
+#include <thread>
+
+using namespace msode;
+
+GTEST_TEST( ORDERED_ASYNC_POOL, results_in_submission_order )
+{
+    for (int numThreads : {1, 3})
+    {
+        utils::OrderedAsyncPool<long> pool(numThreads);
+        ASSERT_EQ(pool.getNumThreads(), numThreads);
+
+        const long numJobs = 20;
+        for (long i = 0; i < numJobs; ++i)
+        {
+            // the first jobs are the slowest so that they complete last
+            const long id = pool.submit([i]()
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds(2 * (numJobs - i)));
+                return i * i;
+            });
+            ASSERT_EQ(id, i);
+        }
+
+        for (long i = 0; i < numJobs; ++i)
+        {
+            long result;
+            pool.pop(result);
+            ASSERT_EQ(result, i * i);
+        }
+        ASSERT_EQ(pool.getNumPending(), 0);
+    }
+}
+
+GTEST_TEST( ORDERED_ASYNC_POOL, try_pop_does_not_block )
+{
+    utils::OrderedAsyncPool<int> pool(1);
+
+    int result {-1};
+    ASSERT_FALSE(pool.tryPop(result));
+
+    std::mutex blocker;
+    blocker.lock();
+
+    pool.submit([&]() {std::lock_guard<std::mutex> lock(blocker); return 42;});
+    ASSERT_FALSE(pool.tryPop(result));
+    ASSERT_EQ(pool.getNumPending(), 1);
+
+    blocker.unlock();
+    pool.pop(result);
+    ASSERT_EQ(result, 42);
+    ASSERT_FALSE(pool.tryPop(result));
+}
+
+int main(int argc, char **argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
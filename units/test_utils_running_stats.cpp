@@ -0,0 +1,53 @@
+#include <msode/utils/running_stats.h>
+
+#include <gtest/gtest.h>
+#include <cmath>
+#include <random>
+#include <vector>
+
+using namespace msode;
+
+GTEST_TEST( RUNNING_STATS, empty )
+{
+    utils::RunningStats stats;
+    ASSERT_EQ(stats.getCount(), 0);
+    ASSERT_EQ(stats.getMean(), 0.0);
+    ASSERT_EQ(stats.getVariance(), 0.0);
+    ASSERT_EQ(stats.getConfidenceHalfWidth(), 0.0);
+}
+
+GTEST_TEST( RUNNING_STATS, matches_two_pass )
+{
+    std::mt19937 gen {4242};
+    std::normal_distribution<double> normal(1e6, 3.0); // large mean: the naive sum of squares loses all digits
+
+    std::vector<double> samples(1000);
+    utils::RunningStats stats;
+
+    for (auto& x : samples)
+    {
+        x = normal(gen);
+        stats.add(x);
+    }
+
+    double mean {0.0};
+    for (auto x : samples)
+        mean += x;
+    mean /= samples.size();
+
+    double var {0.0};
+    for (auto x : samples)
+        var += (x - mean) * (x - mean);
+    var /= samples.size() - 1;
+
+    ASSERT_EQ(stats.getCount(), static_cast<long>(samples.size()));
+    ASSERT_NEAR(stats.getMean(), mean, 1e-9 * mean);
+    ASSERT_NEAR(stats.getVariance(), var, 1e-6 * var);
+    ASSERT_NEAR(stats.getConfidenceHalfWidth(2.0), 2.0 * std::sqrt(var / samples.size()), 1e-6);
+}
+
+int main(int argc, char **argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,69 @@
+#include <msode/utils/thread_pool.h>
+
+#include <gtest/gtest.h>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+using namespace msode;
+
+GTEST_TEST( THREAD_POOL, all_tasks_run_exactly_once )
+{
+    for (int numThreads : {1, 2, 3, 8})
+    {
+        utils::ThreadPool pool(numThreads);
+        ASSERT_EQ(pool.getNumThreads(), numThreads);
+
+        for (long numTasks : {0L, 1L, 5L, 1000L})
+        {
+            std::vector<std::atomic<int>> counts(numTasks);
+            for (auto& c : counts)
+                c = 0;
+
+            pool.run(numTasks, [&](long taskId, int workerId)
+            {
+                ASSERT_GE(workerId, 0);
+                ASSERT_LT(workerId, numThreads);
+                ++counts[taskId];
+            });
+
+            for (const auto& c : counts)
+                ASSERT_EQ(c.load(), 1);
+        }
+    }
+}
+
+GTEST_TEST( THREAD_POOL, heterogeneous_tasks_are_balanced )
+{
+    const int numThreads = 4;
+    const long numTasks = 64;
+
+    utils::ThreadPool pool(numThreads);
+    std::vector<std::atomic<int>> tasksPerWorker(numThreads);
+    for (auto& c : tasksPerWorker)
+        c = 0;
+
+    // all the expensive tasks are given initially to the first worker
+    pool.run(numTasks, [&](long taskId, int workerId)
+    {
+        if (taskId < numTasks / numThreads)
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        ++tasksPerWorker[workerId];
+    });
+
+    int total {0};
+    for (const auto& c : tasksPerWorker)
+        total += c.load();
+
+    ASSERT_EQ(total, numTasks);
+
+    // the first worker must have been helped by the other ones
+    ASSERT_LT(tasksPerWorker[0].load(), numTasks / numThreads);
+}
+
+int main(int argc, char **argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -1,3 +1,5 @@
+#include "helpers.h"
+
 #include <msode/core/simulation.h>
 #include <msode/core/velocity_field/constant.h>
 #include <msode/core/velocity_field/none.h>
@@ -16,8 +18,8 @@ constexpr real3 ez {0.0_r, 0.0_r, 1.0_r};
 template<class VelocityField>
 static void checkDivergenceFree(const VelocityField& velocityField, real3 r)
 {
-    constexpr real tol = 1e-6_r;
-    constexpr real h = 1e-6_r;
+    constexpr real tol = helpers::byPrecision(1e-6_r, 1e-3_r);
+    constexpr real h   = helpers::byPrecision(1e-6_r, 1e-2_r);
     constexpr real invTwoH = 0.5_r / h;
     constexpr real t = 0.0_r;
 
@@ -56,8 +58,8 @@ static void checkDivergenceFree(const VelocityField& velocityField, int nsamples
 template<class VelocityField>
 static void checkVorticity(const VelocityField& velocityField, real3 r)
 {
-    constexpr real tol = 1e-6_r;
-    constexpr real h = 1e-6_r;
+    constexpr real tol = helpers::byPrecision(1e-6_r, 1e-3_r);
+    constexpr real h   = helpers::byPrecision(1e-6_r, 1e-2_r);
     constexpr real invTwoH = 0.5_r / h;
     constexpr real t = 0.0_r;
 
@@ -166,6 +168,37 @@ GTEST_TEST( VELOCITY_FIELD, sum_constants )
     ASSERT_NEAR(v.z, v0.z + v1.z, tol);
 }
 
+template<class VelocityField>
+static void checkVelocityBound(const VelocityField& velocityField, int nsamples = 1000, long seed = 424242L)
+{
+    constexpr real L = 10.0_r;
+    std::mt19937 gen(seed);
+    std::uniform_real_distribution<real> distr(-L, L);
+
+    const real bound = velocityField.getVelocityBound();
+
+    for (int i = 0; i < nsamples; ++i)
+    {
+        const real3 r {distr(gen), distr(gen), distr(gen)};
+        const real t = distr(gen);
+        ASSERT_LE(length(velocityField.getVelocity(r, t)), bound);
+    }
+}
+
+GTEST_TEST( VELOCITY_FIELD, velocity_bounds )
+{
+    const real3 magn {1.0_r, 1.0_r, -2.0_r};
+    const real3 invPeriod {0.3_r, 0.3_r, 0.3_r};
+    checkVelocityBound(VelocityFieldTaylorGreenVortex{magn, invPeriod});
+    checkVelocityBound(VelocityFieldConstant{{-1.04_r, 2.3_r, 0.12_r}});
+    checkVelocityBound(VelocityFieldNone{});
+
+    std::vector<std::unique_ptr<BaseVelocityField>> fields;
+    fields.push_back(std::make_unique<VelocityFieldConstant>(real3{18.42_r, 3.2_r, 1.34_r}));
+    fields.push_back(std::make_unique<VelocityFieldTaylorGreenVortex>(magn, invPeriod));
+    checkVelocityBound(VelocityFieldSum{std::move(fields)});
+}
+
 int main(int argc, char **argv)
 {
     ::testing::InitGoogleTest(&argc, argv);